@@ -26,6 +26,8 @@
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
 // LOOP @<address, name> rx:<received events no.> dr:<dropped events no.>
 #define LOOP_DUMP_FORMAT              "LOOP @%p,%s rx:%" PRIu32 " dr:%" PRIu32 "\n"
+// lane <priority> lat:<events dispatched within 16, 64, 256, 1024, 4096, 16384, 65536 us and later>
+#define LANE_DUMP_FORMAT              "  LANE %d lat:%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n"
 // handler @<address> ev:<base, id> inv:<times invoked> time:<runtime>
 #define HANDLER_DUMP_FORMAT           "  HANDLER @%p ev:%s,%s inv:%" PRIu32 " time:%lld us\n"
 
@@ -102,6 +104,7 @@ static int esp_event_dump_prepare(void)
     // Reserve slightly more memory than computed
     int allowance = 3;
     int size = (((loops + allowance) * (sizeof(LOOP_DUMP_FORMAT) + 10 + 20 + 2 * 11)) +
+                ((loops + allowance) * ESP_EVENT_LOOP_PRIORITY_LANES_MAX * (sizeof(LANE_DUMP_FORMAT) + 3 + ESP_EVENT_LATENCY_BUCKETS * 11)) +
                 ((handlers + allowance) * (sizeof(HANDLER_DUMP_FORMAT) + 10 + 2 * 20 + 11 + 20)));
 
     return size;
@@ -159,6 +162,19 @@ static void handler_execute(esp_event_loop_instance_t* loop, esp_event_handler_n
 #endif
 }
 
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+static void loop_record_latency(esp_event_loop_instance_t* loop, uint8_t lane, int64_t latency)
+{
+    int bucket = 0;
+
+    for (int64_t limit = 16; bucket < ESP_EVENT_LATENCY_BUCKETS - 1 && latency >= limit; limit *= 4) {
+        bucket++;
+    }
+
+    loop->latency[lane][bucket]++;
+}
+#endif
+
 static esp_err_t handler_instances_add(esp_event_handler_nodes_t* handlers, esp_event_handler_t event_handler, void* event_handler_arg, esp_event_handler_instance_context_t **handler_ctx, bool legacy)
 {
     esp_event_handler_node_t *handler_instance = esp_event_calloc(1, sizeof(*handler_instance));
@@ -315,6 +331,223 @@ static esp_err_t loop_node_add_handler(esp_event_loop_node_t* loop_node,
     }
 }
 
+static bool loop_execute_handlers(esp_event_loop_instance_t* loop, esp_event_post_instance_t post)
+{
+    bool exec = false;
+
+    esp_event_handler_node_t *handler, *temp_handler;
+    esp_event_loop_node_t *loop_node, *temp_node;
+    esp_event_base_node_t *base_node, *temp_base;
+    esp_event_id_node_t *id_node, *temp_id_node;
+
+    SLIST_FOREACH_SAFE(loop_node, &(loop->loop_nodes), next, temp_node) {
+        // Execute loop level handlers
+        SLIST_FOREACH_SAFE(handler, &(loop_node->handlers), next, temp_handler) {
+            if (!handler->unregistered) {
+                handler_execute(loop, handler, post);
+                exec |= true;
+            }
+        }
+
+        SLIST_FOREACH_SAFE(base_node, &(loop_node->base_nodes), next, temp_base) {
+            if (base_node->base == post.base) {
+                // Execute base level handlers
+                SLIST_FOREACH_SAFE(handler, &(base_node->handlers), next, temp_handler) {
+                    if (!handler->unregistered) {
+                        handler_execute(loop, handler, post);
+                        exec |= true;
+                    }
+                }
+
+                SLIST_FOREACH_SAFE(id_node, &(base_node->id_nodes), next, temp_id_node) {
+                    if (id_node->id == post.id) {
+                        // Execute id level handlers
+                        SLIST_FOREACH_SAFE(handler, &(id_node->handlers), next, temp_handler) {
+                            if (!handler->unregistered) {
+                                handler_execute(loop, handler, post);
+                                exec |= true;
+                            }
+                        }
+                        // Skip to next base node
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return exec;
+}
+
+#if CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX
+
+static inline uint32_t dispatch_index_hash(esp_event_base_t base, int32_t id)
+{
+    uint32_t hash = ((uint32_t)(uintptr_t) base ^ ((uint32_t) id * 0x9E3779B1)) * 0x85EBCA6B;
+    return hash ^ (hash >> 16);
+}
+
+static void dispatch_index_clear(esp_event_loop_instance_t* loop)
+{
+    esp_event_dispatch_index_t* index = &(loop->dispatch_index);
+
+    if (index->dispatching) {
+        // The handlers of the event being dispatched are still in use, clear the index once the dispatch ends
+        index->stale = true;
+        return;
+    }
+
+    for (uint32_t i = 0; i < index->size; i++) {
+        free(index->entries[i].handlers);
+    }
+    if (index->entries != NULL) {
+        memset(index->entries, 0, index->size * sizeof(*index->entries));
+    }
+    index->used = 0;
+    index->stale = false;
+}
+
+// Collects the handlers matching an event, in the order loop_execute_handlers() executes them.
+// Returns the number of handlers, handlers can be NULL to count them only.
+static uint32_t dispatch_index_collect(esp_event_loop_instance_t* loop, esp_event_base_t base, int32_t id, esp_event_handler_node_t** handlers)
+{
+    uint32_t num = 0;
+
+    esp_event_handler_node_t *handler;
+    esp_event_loop_node_t *loop_node;
+    esp_event_base_node_t *base_node;
+    esp_event_id_node_t *id_node;
+
+    SLIST_FOREACH(loop_node, &(loop->loop_nodes), next) {
+        SLIST_FOREACH(handler, &(loop_node->handlers), next) {
+            if (handlers) {
+                handlers[num] = handler;
+            }
+            num++;
+        }
+
+        SLIST_FOREACH(base_node, &(loop_node->base_nodes), next) {
+            if (base_node->base == base) {
+                SLIST_FOREACH(handler, &(base_node->handlers), next) {
+                    if (handlers) {
+                        handlers[num] = handler;
+                    }
+                    num++;
+                }
+
+                SLIST_FOREACH(id_node, &(base_node->id_nodes), next) {
+                    if (id_node->id == id) {
+                        SLIST_FOREACH(handler, &(id_node->handlers), next) {
+                            if (handlers) {
+                                handlers[num] = handler;
+                            }
+                            num++;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return num;
+}
+
+static esp_event_dispatch_entry_t* dispatch_index_find_slot(esp_event_dispatch_index_t* index, esp_event_base_t base, int32_t id)
+{
+    uint32_t mask = index->size - 1;
+
+    for (uint32_t i = dispatch_index_hash(base, id) & mask;; i = (i + 1) & mask) {
+        esp_event_dispatch_entry_t* entry = &(index->entries[i]);
+        if (entry->base == NULL || (entry->base == base && entry->id == id)) {
+            return entry;
+        }
+    }
+}
+
+static bool dispatch_index_grow(esp_event_dispatch_index_t* index)
+{
+    uint32_t size = index->size ? index->size * 2 : 8;
+    esp_event_dispatch_entry_t* entries = esp_event_calloc(size, sizeof(*entries));
+
+    if (entries == NULL) {
+        return false;
+    }
+
+    esp_event_dispatch_entry_t* old_entries = index->entries;
+    uint32_t old_size = index->size;
+
+    index->entries = entries;
+    index->size = size;
+    for (uint32_t i = 0; i < old_size; i++) {
+        if (old_entries[i].base != NULL) {
+            *dispatch_index_find_slot(index, old_entries[i].base, old_entries[i].id) = old_entries[i];
+        }
+    }
+    free(old_entries);
+
+    return true;
+}
+
+// Returns the handlers of an event, indexing them when the event is dispatched for the first time.
+// Returns NULL if the index can't be used, in which case the handlers are found by walking the lists.
+static esp_event_dispatch_entry_t* dispatch_index_get(esp_event_loop_instance_t* loop, esp_event_base_t base, int32_t id)
+{
+    esp_event_dispatch_index_t* index = &(loop->dispatch_index);
+
+    if (index->dispatching) {
+        // The loop is run from one of its handlers, the index can't be updated
+        return NULL;
+    }
+
+    if (index->size) {
+        esp_event_dispatch_entry_t* entry = dispatch_index_find_slot(index, base, id);
+        if (entry->base != NULL) {
+            return entry;
+        }
+    }
+
+    if (index->used >= CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX_SIZE) {
+        // The events indexed first stay indexed, the others are dispatched by walking the lists
+        return NULL;
+    }
+
+    // Keep the table at most half full
+    if ((index->used + 1) * 2 > index->size && !dispatch_index_grow(index)) {
+        return NULL;
+    }
+
+    esp_event_handler_node_t** handlers = NULL;
+    uint32_t handlers_num = dispatch_index_collect(loop, base, id, NULL);
+
+    if (handlers_num) {
+        handlers = esp_event_calloc(handlers_num, sizeof(*handlers));
+        if (handlers == NULL) {
+            return NULL;
+        }
+        dispatch_index_collect(loop, base, id, handlers);
+    }
+
+    esp_event_dispatch_entry_t* entry = dispatch_index_find_slot(index, base, id);
+    entry->base = base;
+    entry->id = id;
+    entry->handlers = handlers;
+    entry->handlers_num = handlers_num;
+    index->used++;
+
+    return entry;
+}
+
+static void dispatch_index_delete(esp_event_loop_instance_t* loop)
+{
+    dispatch_index_clear(loop);
+    free(loop->dispatch_index.entries);
+    loop->dispatch_index.entries = NULL;
+    loop->dispatch_index.size = 0;
+}
+
+#endif // CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX
+
 static esp_err_t handler_instances_remove(esp_event_handler_nodes_t* handlers, esp_event_handler_instance_context_t* handler_ctx, bool legacy)
 {
     esp_event_handler_node_t *it, *temp;
@@ -399,6 +632,9 @@ static esp_err_t loop_remove_handler(esp_event_remove_handler_context_t* ctx)
                 SLIST_REMOVE(&(ctx->loop->loop_nodes), it, esp_event_loop_node, next);
                 free(it);
             }
+#if CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX
+            dispatch_index_clear(ctx->loop);
+#endif
             return ESP_OK;
         }
     }
@@ -439,8 +675,109 @@ static void loop_node_remove_all_handler(esp_event_loop_node_t* loop_node)
     }
 }
 
-static void inline __attribute__((always_inline)) post_instance_delete(esp_event_post_instance_t* post)
+#define PAYLOAD_POOL_MAP_BITS   32
+#define PAYLOAD_POOL_ALIGN      8
+
+static esp_err_t payload_pool_create(esp_event_payload_pool_t* pool, size_t block_size, uint32_t blocks_num)
+{
+    block_size = (block_size + PAYLOAD_POOL_ALIGN - 1) & ~(PAYLOAD_POOL_ALIGN - 1);
+    uint32_t map_words = (blocks_num + PAYLOAD_POOL_MAP_BITS - 1) / PAYLOAD_POOL_MAP_BITS;
+
+    pool->blocks = esp_event_calloc(blocks_num, block_size);
+    // The counters and the map are updated with atomic instructions, which don't work on external RAM on all targets
+    pool->refs = heap_caps_calloc(blocks_num + map_words, sizeof(atomic_uint_least32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (pool->blocks == NULL || pool->refs == NULL) {
+        free(pool->blocks);
+        free(pool->refs);
+        memset(pool, 0, sizeof(*pool));
+        return ESP_ERR_NO_MEM;
+    }
+
+    pool->free_map = pool->refs + blocks_num;
+    for (uint32_t i = 0; i < map_words; i++) {
+        uint32_t bits = blocks_num - i * PAYLOAD_POOL_MAP_BITS;
+        atomic_init(&pool->free_map[i], bits >= PAYLOAD_POOL_MAP_BITS ? UINT32_MAX : (1U << bits) - 1);
+    }
+    pool->block_size = block_size;
+    pool->blocks_num = blocks_num;
+
+    return ESP_OK;
+}
+
+static void payload_pool_delete(esp_event_payload_pool_t* pool)
+{
+    free(pool->blocks);
+    free(pool->refs);
+    memset(pool, 0, sizeof(*pool));
+}
+
+// Returns a free block holding one reference, or NULL if the data doesn't fit in a block or all blocks are in use
+static void* payload_pool_alloc(esp_event_payload_pool_t* pool, size_t size)
+{
+    if (size > pool->block_size) {
+        return NULL;
+    }
+
+    uint32_t map_words = (pool->blocks_num + PAYLOAD_POOL_MAP_BITS - 1) / PAYLOAD_POOL_MAP_BITS;
+
+    for (uint32_t i = 0; i < map_words; i++) {
+        uint_least32_t bits = atomic_load(&pool->free_map[i]);
+        while (bits != 0) {
+            uint_least32_t bit = bits & (~bits + 1);
+            // On failure, bits is updated with the current value of the map
+            if (atomic_compare_exchange_weak(&pool->free_map[i], &bits, bits & ~bit)) {
+                uint32_t block = i * PAYLOAD_POOL_MAP_BITS + __builtin_ctz(bit);
+                atomic_store(&pool->refs[block], 1);
+                return pool->blocks + block * pool->block_size;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// Returns the index of the block at ptr, or -1 if ptr isn't a block of the pool
+static int32_t payload_pool_block(esp_event_payload_pool_t* pool, const void* ptr)
+{
+    if (pool->blocks == NULL || (const uint8_t*) ptr < pool->blocks) {
+        return -1;
+    }
+
+    size_t offset = (const uint8_t*) ptr - pool->blocks;
+    if (offset % pool->block_size != 0 || offset / pool->block_size >= pool->blocks_num) {
+        return -1;
+    }
+
+    return offset / pool->block_size;
+}
+
+static esp_err_t payload_pool_release(esp_event_payload_pool_t* pool, const void* ptr)
 {
+    int32_t block = payload_pool_block(pool, ptr);
+
+    if (block < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint_least32_t refs = atomic_load(&pool->refs[block]);
+    do {
+        if (refs == 0) {
+            return ESP_ERR_INVALID_STATE;
+        }
+    } while (!atomic_compare_exchange_weak(&pool->refs[block], &refs, refs - 1));
+
+    if (refs == 1) {
+        atomic_fetch_or(&pool->free_map[block / PAYLOAD_POOL_MAP_BITS], 1U << (block % PAYLOAD_POOL_MAP_BITS));
+    }
+
+    return ESP_OK;
+}
+
+static void inline __attribute__((always_inline)) post_instance_delete(esp_event_loop_instance_t* loop, esp_event_post_instance_t* post)
+{
+    if (post->data_pooled) {
+        payload_pool_release(&(loop->payload_pool), post->data.ptr);
+    } else
 #if CONFIG_ESP_EVENT_POST_FROM_ISR
     if (post->data_allocated)
 #endif
@@ -450,6 +787,59 @@ static void inline __attribute__((always_inline)) post_instance_delete(esp_event
     memset(post, 0, sizeof(*post));
 }
 
+static esp_err_t post_instance_send(esp_event_loop_instance_t* loop, esp_event_post_instance_t* post, uint8_t lane, TickType_t ticks_to_wait)
+{
+    BaseType_t result = pdFALSE;
+    QueueHandle_t queue = loop->queues[lane];
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    post->time = esp_timer_get_time();
+#endif
+
+    // Find the task that currently executes the loop. It is safe to query loop->task since it is
+    // not mutated since loop creation. ENSURE THIS REMAINS TRUE.
+    if (loop->task == NULL) {
+        // The loop has no dedicated task. Find out what task is currently running it.
+        result = xSemaphoreTakeRecursive(loop->mutex, ticks_to_wait);
+
+        if (result == pdTRUE) {
+            if (loop->running_task != xTaskGetCurrentTaskHandle()) {
+                xSemaphoreGiveRecursive(loop->mutex);
+                result = xQueueSendToBack(queue, post, ticks_to_wait);
+            } else {
+                xSemaphoreGiveRecursive(loop->mutex);
+                result = xQueueSendToBack(queue, post, 0);
+            }
+        }
+    } else {
+        // The loop has a dedicated task.
+        if (loop->task != xTaskGetCurrentTaskHandle()) {
+            result = xQueueSendToBack(queue, post, ticks_to_wait);
+        } else {
+            result = xQueueSendToBack(queue, post, 0);
+        }
+    }
+
+    if (result != pdTRUE) {
+        post_instance_delete(loop, post);
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+        atomic_fetch_add(&loop->events_dropped, 1);
+#endif
+        return ESP_ERR_TIMEOUT;
+    }
+
+    if (loop->lanes_signal != NULL) {
+        xSemaphoreGive(loop->lanes_signal);
+    }
+
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    atomic_fetch_add(&loop->events_received, 1);
+#endif
+
+    return ESP_OK;
+}
+
 static esp_err_t find_and_unregister_handler(esp_event_remove_handler_context_t* ctx)
 {
     esp_event_handler_node_t *handler_to_unregister = NULL;
@@ -548,6 +938,37 @@ static esp_err_t find_and_unregister_handler(esp_event_remove_handler_context_t*
     return esp_event_post_to(ctx->loop, esp_event_handler_cleanup, 0, ctx, sizeof(esp_event_remove_handler_context_t), portMAX_DELAY);
 }
 
+// Receives the next event to dispatch, from the lane of highest priority which has events waiting
+static bool loop_receive(esp_event_loop_instance_t* loop, esp_event_post_instance_t* post, uint8_t* lane, TickType_t ticks_to_wait)
+{
+    if (loop->lanes_num == 1) {
+        *lane = 0;
+        return xQueueReceive(loop->queues[0], post, ticks_to_wait) == pdTRUE;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t remaining = ticks_to_wait;
+
+    while (true) {
+        for (int i = loop->lanes_num - 1; i >= 0; i--) {
+            if (xQueueReceive(loop->queues[i], post, 0) == pdTRUE) {
+                *lane = i;
+                return true;
+            }
+        }
+
+        // The signal may have been given for events which were received already, wait again until the time is up
+        if (remaining == 0 || xSemaphoreTake(loop->lanes_signal, remaining) != pdTRUE) {
+            return false;
+        }
+
+        if (ticks_to_wait != portMAX_DELAY) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            remaining = elapsed < ticks_to_wait ? ticks_to_wait - elapsed : 0;
+        }
+    }
+}
+
 /* ---------------------------- Public API --------------------------------- */
 
 esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, esp_event_loop_handle_t* event_loop)
@@ -562,6 +983,11 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
         return ESP_ERR_INVALID_ARG;
     }
 
+    if (event_loop_args->priority_lanes > ESP_EVENT_LOOP_PRIORITY_LANES_MAX) {
+        ESP_LOGE(TAG, "too many priority lanes");
+        return ESP_ERR_INVALID_ARG;
+    }
+
     esp_event_loop_instance_t* loop;
     esp_err_t err = ESP_ERR_NO_MEM; // most likely error
 
@@ -571,14 +997,25 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
         return err;
     }
 
+    loop->lanes_num = event_loop_args->priority_lanes > 1 ? event_loop_args->priority_lanes : 1;
+    for (int lane = 0; lane < loop->lanes_num; lane++) {
 #if CONFIG_ESP_EVENT_LOOP_IN_EXT_RAM && !CONFIG_ESP_EVENT_POST_FROM_IRAM_ISR
-    loop->queue = xQueueCreateWithCaps(event_loop_args->queue_size, sizeof(esp_event_post_instance_t), MALLOC_CAP_SPIRAM);
+        loop->queues[lane] = xQueueCreateWithCaps(event_loop_args->queue_size, sizeof(esp_event_post_instance_t), MALLOC_CAP_SPIRAM);
 #else
-    loop->queue = xQueueCreate(event_loop_args->queue_size, sizeof(esp_event_post_instance_t));
+        loop->queues[lane] = xQueueCreate(event_loop_args->queue_size, sizeof(esp_event_post_instance_t));
 #endif // CONFIG_ESP_EVENT_LOOP_IN_EXT_RAM && !CONFIG_ESP_EVENT_POST_FROM_IRAM_ISR
-    if (loop->queue == NULL) {
-        ESP_LOGE(TAG, "create event loop queue failed");
-        goto on_err;
+        if (loop->queues[lane] == NULL) {
+            ESP_LOGE(TAG, "create event loop queue failed");
+            goto on_err;
+        }
+    }
+
+    if (loop->lanes_num > 1) {
+        loop->lanes_signal = xSemaphoreCreateBinary();
+        if (loop->lanes_signal == NULL) {
+            ESP_LOGE(TAG, "create event loop lanes signal failed");
+            goto on_err;
+        }
     }
 
     loop->mutex = xSemaphoreCreateRecursiveMutex();
@@ -587,6 +1024,20 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
         goto on_err;
     }
 
+    if (event_loop_args->payload_pool_block_size != 0) {
+        if (event_loop_args->payload_pool_blocks == 0) {
+            ESP_LOGE(TAG, "payload pool has no blocks");
+            err = ESP_ERR_INVALID_ARG;
+            goto on_err;
+        }
+
+        if (payload_pool_create(&(loop->payload_pool), event_loop_args->payload_pool_block_size,
+                                event_loop_args->payload_pool_blocks) != ESP_OK) {
+            ESP_LOGE(TAG, "create event loop payload pool failed");
+            goto on_err;
+        }
+    }
+
     SLIST_INIT(&(loop->loop_nodes));
 
     // Create the loop task if requested
@@ -639,18 +1090,26 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
     return ESP_OK;
 
 on_err:
-    if (loop->queue != NULL) {
+    for (int lane = 0; lane < loop->lanes_num; lane++) {
+        if (loop->queues[lane] != NULL) {
 #if CONFIG_ESP_EVENT_LOOP_IN_EXT_RAM && !CONFIG_ESP_EVENT_POST_FROM_IRAM_ISR
-        vQueueDeleteWithCaps(loop->queue);
+            vQueueDeleteWithCaps(loop->queues[lane]);
 #else
-        vQueueDelete(loop->queue);
+            vQueueDelete(loop->queues[lane]);
 #endif
+        }
+    }
+
+    if (loop->lanes_signal != NULL) {
+        vSemaphoreDelete(loop->lanes_signal);
     }
 
     if (loop->mutex != NULL) {
         vSemaphoreDelete(loop->mutex);
     }
 
+    payload_pool_delete(&(loop->payload_pool));
+
     free(loop);
 
     return err;
@@ -662,6 +1121,8 @@ on_err:
 // indicate that the difference is not that substantial, especially considering the additional
 // pointers per node of rbtrees. Code for the rbtree implementation of the event loop library is archived
 // in feature/esp_event_loop_library_rbtrees if needed.
+// With CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX, the lists are walked once per event and the handlers found are kept
+// in a hash table, so that the following dispatches of the event take constant time.
 esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t ticks_to_run)
 {
     assert(event_loop);
@@ -677,94 +1138,93 @@ esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t tick
     int64_t remaining_ticks = ticks_to_run;
 #endif
 
-    while (xQueueReceive(loop->queue, &post, remaining_ticks) == pdTRUE) {
-        // The event has already been unqueued, so ensure it gets executed.
-        xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
-
-        // check if the event retrieve from the queue is the internal event that is
-        // triggered when a handler needs to be removed..
-        if (post.base == esp_event_handler_cleanup) {
-            assert(post.data.ptr != NULL);
-            esp_event_remove_handler_context_t* ctx = (esp_event_remove_handler_context_t*)post.data.ptr;
-            loop_remove_handler(ctx);
+    uint8_t lane;
 
-            // if the handler unregistration request came from legacy code,
-            // we have to free handler_ctx pointer since it points to memory
-            // allocated by esp_event_handler_unregister_with_internal
-            if (ctx->legacy) {
-                free(ctx->handler_ctx);
-            }
-        }
+    while (loop_receive(loop, &post, &lane, remaining_ticks)) {
+        // The event has already been unqueued, so ensure it gets executed. The events that are already
+        // waiting are dispatched in the same batch, without releasing the mutex in between.
+        xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
 
         loop->running_task = xTaskGetCurrentTaskHandle();
 
-        bool exec = false;
+        bool expired = false;
+        uint32_t batch = 0;
 
-        esp_event_handler_node_t *handler, *temp_handler;
-        esp_event_loop_node_t *loop_node, *temp_node;
-        esp_event_base_node_t *base_node, *temp_base;
-        esp_event_id_node_t *id_node, *temp_id_node;
+        do {
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+            loop_record_latency(loop, lane, esp_timer_get_time() - post.time);
+#endif
 
-        SLIST_FOREACH_SAFE(loop_node, &(loop->loop_nodes), next, temp_node) {
-            // Execute loop level handlers
-            SLIST_FOREACH_SAFE(handler, &(loop_node->handlers), next, temp_handler) {
-                if (!handler->unregistered) {
-                    handler_execute(loop, handler, post);
-                    exec |= true;
+            // check if the event retrieve from the queue is the internal event that is
+            // triggered when a handler needs to be removed..
+            if (post.base == esp_event_handler_cleanup) {
+                assert(post.data.ptr != NULL);
+                esp_event_remove_handler_context_t* ctx = (esp_event_remove_handler_context_t*)post.data.ptr;
+                loop_remove_handler(ctx);
+
+                // if the handler unregistration request came from legacy code,
+                // we have to free handler_ctx pointer since it points to memory
+                // allocated by esp_event_handler_unregister_with_internal
+                if (ctx->legacy) {
+                    free(ctx->handler_ctx);
                 }
             }
 
-            SLIST_FOREACH_SAFE(base_node, &(loop_node->base_nodes), next, temp_base) {
-                if (base_node->base == post.base) {
-                    // Execute base level handlers
-                    SLIST_FOREACH_SAFE(handler, &(base_node->handlers), next, temp_handler) {
-                        if (!handler->unregistered) {
-                            handler_execute(loop, handler, post);
-                            exec |= true;
-                        }
-                    }
+            bool exec = false;
 
-                    SLIST_FOREACH_SAFE(id_node, &(base_node->id_nodes), next, temp_id_node) {
-                        if (id_node->id == post.id) {
-                            // Execute id level handlers
-                            SLIST_FOREACH_SAFE(handler, &(id_node->handlers), next, temp_handler) {
-                                if (!handler->unregistered) {
-                                    handler_execute(loop, handler, post);
-                                    exec |= true;
-                                }
-                            }
-                            // Skip to next base node
-                            break;
-                        }
+#if CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX
+            esp_event_dispatch_entry_t* entry = dispatch_index_get(loop, post.base, post.id);
+
+            if (entry != NULL) {
+                esp_event_handler_node_t** handlers = entry->handlers;
+                uint32_t handlers_num = entry->handlers_num;
+
+                loop->dispatch_index.dispatching++;
+                for (uint32_t i = 0; i < handlers_num; i++) {
+                    if (!handlers[i]->unregistered) {
+                        handler_execute(loop, handlers[i], post);
+                        exec |= true;
                     }
                 }
+                loop->dispatch_index.dispatching--;
+
+                if (loop->dispatch_index.stale) {
+                    dispatch_index_clear(loop);
+                }
+            } else
+#endif
+            {
+                exec = loop_execute_handlers(loop, post);
             }
-        }
 
-        esp_event_base_t base = post.base;
-        int32_t id = post.id;
+            if (!exec) {
+                // No handlers were registered, not even loop/base level handlers
+                ESP_LOGD(TAG, "no handlers have been registered for event %s:%"PRIu32" posted to loop %p", post.base, post.id, event_loop);
+            }
 
-        post_instance_delete(&post);
+            post_instance_delete(loop, &post);
 
-        if (ticks_to_run != portMAX_DELAY) {
-            end = xTaskGetTickCount();
-            remaining_ticks -= end - marker;
-            // If the ticks to run expired, return to the caller
-            if (remaining_ticks <= 0) {
-                xSemaphoreGiveRecursive(loop->mutex);
-                break;
-            } else {
-                marker = end;
+            if (ticks_to_run != portMAX_DELAY) {
+                end = xTaskGetTickCount();
+                remaining_ticks -= end - marker;
+                // If the ticks to run expired, return to the caller
+                if (remaining_ticks <= 0) {
+                    expired = true;
+                    break;
+                } else {
+                    marker = end;
+                }
             }
-        }
+        } while (++batch < CONFIG_ESP_EVENT_LOOP_BATCH_SIZE && loop_receive(loop, &post, &lane, 0));
 
-        loop->running_task = NULL;
+        if (!expired) {
+            loop->running_task = NULL;
+        }
 
         xSemaphoreGiveRecursive(loop->mutex);
 
-        if (!exec) {
-            // No handlers were registered, not even loop/base level handlers
-            ESP_LOGD(TAG, "no handlers have been registered for event %s:%"PRIu32" posted to loop %p", base, id, event_loop);
+        if (expired) {
+            break;
         }
     }
 
@@ -805,18 +1265,32 @@ esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
         free(it);
     }
 
-    // Drop existing posts on the queue
+#if CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX
+    dispatch_index_delete(loop);
+#endif
+
+    // Drop existing posts on the queues
     esp_event_post_instance_t post;
-    while (xQueueReceive(loop->queue, &post, 0) == pdTRUE) {
-        post_instance_delete(&post);
+    for (int lane = 0; lane < loop->lanes_num; lane++) {
+        while (xQueueReceive(loop->queues[lane], &post, 0) == pdTRUE) {
+            post_instance_delete(loop, &post);
+        }
     }
 
+    // Buffers retained by handlers become invalid
+    payload_pool_delete(&(loop->payload_pool));
+
     // Cleanup loop
+    for (int lane = 0; lane < loop->lanes_num; lane++) {
 #if CONFIG_ESP_EVENT_LOOP_IN_EXT_RAM && !CONFIG_ESP_EVENT_POST_FROM_IRAM_ISR
-    vQueueDeleteWithCaps(loop->queue);
+        vQueueDeleteWithCaps(loop->queues[lane]);
 #else
-    vQueueDelete(loop->queue);
+        vQueueDelete(loop->queues[lane]);
 #endif
+    }
+    if (loop->lanes_signal != NULL) {
+        vSemaphoreDelete(loop->lanes_signal);
+    }
     free(loop);
     // Free loop mutex before deleting
     xSemaphoreGiveRecursive(loop_mutex);
@@ -883,6 +1357,12 @@ esp_err_t esp_event_handler_register_with_internal(esp_event_loop_handle_t event
         err = loop_node_add_handler(last_loop_node, event_base, event_id, event_handler, event_handler_arg, handler_ctx_arg, legacy);
     }
 
+#if CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX
+    if (err == ESP_OK) {
+        dispatch_index_clear(loop);
+    }
+#endif
+
 on_err:
     xSemaphoreGiveRecursive(loop->mutex);
     return err;
@@ -956,6 +1436,12 @@ esp_err_t esp_event_handler_instance_unregister_with(esp_event_loop_handle_t eve
 
 esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t event_base, int32_t event_id,
                             const void* event_data, size_t event_data_size, TickType_t ticks_to_wait)
+{
+    return esp_event_priority_post_to(event_loop, event_base, event_id, event_data, event_data_size, 0, ticks_to_wait);
+}
+
+esp_err_t esp_event_priority_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t event_base, int32_t event_id,
+                                     const void* event_data, size_t event_data_size, uint8_t priority, TickType_t ticks_to_wait)
 {
     assert(event_loop);
 
@@ -965,15 +1451,24 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
 
     esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
 
+    if (priority >= loop->lanes_num) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
     esp_event_post_instance_t post;
     memset((void*)(&post), 0, sizeof(post));
 
     if (event_data != NULL && event_data_size != 0) {
 #if CONFIG_ESP_EVENT_POST_FROM_ISR
         if (event_data_size > sizeof(post.data.val)) {
-            post.data.ptr = calloc(1, event_data_size);
-            if (post.data.ptr == NULL) {
-                return ESP_ERR_NO_MEM;
+            post.data.ptr = payload_pool_alloc(&(loop->payload_pool), event_data_size);
+            if (post.data.ptr != NULL) {
+                post.data_pooled = true;
+            } else {
+                post.data.ptr = calloc(1, event_data_size);
+                if (post.data.ptr == NULL) {
+                    return ESP_ERR_NO_MEM;
+                }
             }
             post.data_allocated = true;
             memcpy(post.data.ptr, event_data, event_data_size);
@@ -982,11 +1477,17 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
         }
         post.data_set = true;
 #else // !CONFIG_ESP_EVENT_POST_FROM_ISR
-        // Make persistent copy of event data on heap.
-        void* event_data_copy = esp_event_calloc(1, event_data_size);
+        // Make persistent copy of event data in the payload pool of the loop, or on heap.
+        void* event_data_copy = payload_pool_alloc(&(loop->payload_pool), event_data_size);
 
-        if (event_data_copy == NULL) {
-            return ESP_ERR_NO_MEM;
+        if (event_data_copy != NULL) {
+            post.data_pooled = true;
+        } else {
+            event_data_copy = esp_event_calloc(1, event_data_size);
+
+            if (event_data_copy == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
         }
 
         memcpy(event_data_copy, event_data, event_data_size);
@@ -996,48 +1497,93 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
     post.base = event_base;
     post.id = event_id;
 
-    BaseType_t result = pdFALSE;
+    return post_instance_send(loop, &post, priority, ticks_to_wait);
+}
 
-    // Find the task that currently executes the loop. It is safe to query loop->task since it is
-    // not mutated since loop creation. ENSURE THIS REMAINS TRUE.
-    if (loop->task == NULL) {
-        // The loop has no dedicated task. Find out what task is currently running it.
-        result = xSemaphoreTakeRecursive(loop->mutex, ticks_to_wait);
+esp_err_t esp_event_post_acquire(esp_event_loop_handle_t event_loop, size_t event_data_size, void** event_data)
+{
+    assert(event_loop);
 
-        if (result == pdTRUE) {
-            if (loop->running_task != xTaskGetCurrentTaskHandle()) {
-                xSemaphoreGiveRecursive(loop->mutex);
-                result = xQueueSendToBack(loop->queue, &post, ticks_to_wait);
-            } else {
-                xSemaphoreGiveRecursive(loop->mutex);
-                result = xQueueSendToBack(loop->queue, &post, 0);
-            }
-        }
-    } else {
-        // The loop has a dedicated task.
-        if (loop->task != xTaskGetCurrentTaskHandle()) {
-            result = xQueueSendToBack(loop->queue, &post, ticks_to_wait);
-        } else {
-            result = xQueueSendToBack(loop->queue, &post, 0);
-        }
+    if (event_data == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    if (result != pdTRUE) {
-        post_instance_delete(&post);
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
 
-#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
-        atomic_fetch_add(&loop->events_dropped, 1);
-#endif
-        return ESP_ERR_TIMEOUT;
+    if (loop->payload_pool.blocks == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
     }
 
-#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
-    atomic_fetch_add(&loop->events_received, 1);
+    if (event_data_size > loop->payload_pool.block_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    *event_data = payload_pool_alloc(&(loop->payload_pool), event_data_size);
+
+    return *event_data != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_event_post_commit(esp_event_loop_handle_t event_loop, esp_event_base_t event_base, int32_t event_id,
+                                void* event_data, TickType_t ticks_to_wait)
+{
+    assert(event_loop);
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+
+    if (payload_pool_block(&(loop->payload_pool), event_data) < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (event_base == ESP_EVENT_ANY_BASE || event_id == ESP_EVENT_ANY_ID) {
+        payload_pool_release(&(loop->payload_pool), event_data);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_event_post_instance_t post;
+    memset((void*)(&post), 0, sizeof(post));
+
+    post.data.ptr = event_data;
+    post.data_pooled = true;
+#if CONFIG_ESP_EVENT_POST_FROM_ISR
+    post.data_allocated = true;
+    post.data_set = true;
 #endif
+    post.base = event_base;
+    post.id = event_id;
+
+    return post_instance_send(loop, &post, 0, ticks_to_wait);
+}
+
+esp_err_t esp_event_payload_retain(esp_event_loop_handle_t event_loop, const void* event_data)
+{
+    assert(event_loop);
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+    int32_t block = payload_pool_block(&(loop->payload_pool), event_data);
+
+    if (block < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint_least32_t refs = atomic_load(&(loop->payload_pool.refs[block]));
+    do {
+        if (refs == 0) {
+            return ESP_ERR_INVALID_STATE;
+        }
+    } while (!atomic_compare_exchange_weak(&(loop->payload_pool.refs[block]), &refs, refs + 1));
 
     return ESP_OK;
 }
 
+esp_err_t esp_event_payload_release(esp_event_loop_handle_t event_loop, const void* event_data)
+{
+    assert(event_loop);
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+
+    return payload_pool_release(&(loop->payload_pool), event_data);
+}
+
 #if CONFIG_ESP_EVENT_POST_FROM_ISR
 esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t event_base, int32_t event_id,
                                 const void* event_data, size_t event_data_size, BaseType_t* task_unblocked)
@@ -1067,11 +1613,15 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop, esp_event_ba
 
     BaseType_t result = pdFALSE;
 
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    post.time = esp_timer_get_time();
+#endif
+
     // Post the event from an ISR,
-    result = xQueueSendToBackFromISR(loop->queue, &post, task_unblocked);
+    result = xQueueSendToBackFromISR(loop->queues[0], &post, task_unblocked);
 
     if (result != pdTRUE) {
-        post_instance_delete(&post);
+        post_instance_delete(loop, &post);
 
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
         atomic_fetch_add(&loop->events_dropped, 1);
@@ -1079,6 +1629,10 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop, esp_event_ba
         return ESP_FAIL;
     }
 
+    if (loop->lanes_signal != NULL) {
+        xSemaphoreGiveFromISR(loop->lanes_signal, task_unblocked);
+    }
+
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     atomic_fetch_add(&loop->events_received, 1);
 #endif
@@ -1117,6 +1671,12 @@ esp_err_t esp_event_dump(FILE* file)
         PRINT_DUMP_INFO(dst, sz, LOOP_DUMP_FORMAT, loop_it, loop_it->task != NULL ? loop_it->name : "none",
                         events_received, events_dropped);
 
+        for (int lane = 0; lane < loop_it->lanes_num; lane++) {
+            uint32_t* latency = loop_it->latency[lane];
+            PRINT_DUMP_INFO(dst, sz, LANE_DUMP_FORMAT, lane, latency[0], latency[1], latency[2], latency[3],
+                            latency[4], latency[5], latency[6], latency[7]);
+        }
+
         int sz_bak = sz;
 
         SLIST_FOREACH(loop_node_it, &(loop_it->loop_nodes), next) {
@@ -8,6 +8,9 @@
 */
 
 #include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
 #include "esp_event.h"
 
 #include <catch2/catch_test_macros.hpp>
@@ -17,6 +20,32 @@
 extern "C" {
 #include "Mocktask.h"
 #include "Mockqueue.h"
+
+// Count the allocations of the event loop library by interposing the allocation functions of glibc
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+static bool s_count_allocations;
+static size_t s_allocations;
+
+void *malloc(size_t size)
+{
+    s_allocations += s_count_allocations;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    s_allocations += s_count_allocations;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    s_allocations += s_count_allocations;
+    return __libc_realloc(ptr, size);
+}
 }
 
 namespace {
@@ -40,6 +69,30 @@ static esp_event_loop_args_t test_event_get_default_loop_args(void)
 
 void dummy_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data) { }
 
+std::vector<int> s_handler_calls;
+
+void record_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    s_handler_calls.push_back(static_cast<int>(reinterpret_cast<intptr_t>(event_handler_arg)));
+}
+
+std::vector<int> post_and_run(esp_event_loop_handle_t loop, esp_event_base_t base, int32_t id)
+{
+    s_handler_calls.clear();
+    CHECK(esp_event_post_to(loop, base, id, nullptr, 0, 0) == ESP_OK);
+    CHECK(esp_event_loop_run(loop, 10) == ESP_OK);
+    return s_handler_calls;
+}
+
+void* handler_arg(int value)
+{
+    return reinterpret_cast<void*>(static_cast<intptr_t>(value));
+}
+
+const char* BASE_A = "base_a";
+const char* BASE_B = "base_b";
+const char* BASE_C = "base_c";
+
 }
 
 // TODO: IDF-2693, function definition just to satisfy linker, implement esp_common instead
@@ -149,3 +202,333 @@ TEST_CASE("registering with ANY_BASE but specific ID fails")
                                           dummy_handler,
                                           nullptr) == ESP_ERR_INVALID_ARG);
 }
+
+TEST_CASE("handlers are dispatched in registration order")
+{
+    MockEventQueue queue;
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+
+    esp_event_handler_instance_t any_instance;
+    CHECK(esp_event_handler_register_with(loop, BASE_A, 1, record_handler, handler_arg(1)) == ESP_OK);
+    CHECK(esp_event_handler_register_with(loop, BASE_A, ESP_EVENT_ANY_ID, record_handler, handler_arg(2)) == ESP_OK);
+    CHECK(esp_event_handler_instance_register_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, record_handler, handler_arg(3), &any_instance) == ESP_OK);
+    CHECK(esp_event_handler_register_with(loop, BASE_B, 1, record_handler, handler_arg(4)) == ESP_OK);
+    CHECK(esp_event_handler_instance_register_with(loop, BASE_A, 1, record_handler, handler_arg(5), nullptr) == ESP_OK);
+    CHECK(esp_event_handler_instance_register_with(loop, BASE_A, ESP_EVENT_ANY_ID, record_handler, handler_arg(6), nullptr) == ESP_OK);
+    CHECK(esp_event_handler_instance_register_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, record_handler, handler_arg(7), nullptr) == ESP_OK);
+
+    // dispatched twice, the second time from the dispatch index if enabled
+    for (int i = 0; i < 2; i++) {
+        CHECK(post_and_run(loop, BASE_A, 1) == std::vector<int> {1, 2, 3, 5, 6, 7});
+        CHECK(post_and_run(loop, BASE_A, 2) == std::vector<int> {2, 3, 6, 7});
+        CHECK(post_and_run(loop, BASE_B, 1) == std::vector<int> {3, 4, 7});
+        CHECK(post_and_run(loop, BASE_C, 1) == std::vector<int> {3, 7});
+    }
+
+    CHECK(esp_event_handler_instance_unregister_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, any_instance) == ESP_OK);
+    CHECK(post_and_run(loop, BASE_A, 1) == std::vector<int> {1, 2, 5, 6, 7});
+    CHECK(post_and_run(loop, BASE_C, 1) == std::vector<int> {7});
+
+    // the new handler is added after the others, unregistering removes the first handler which matches
+    CHECK(esp_event_handler_register_with(loop, BASE_A, 1, record_handler, handler_arg(8)) == ESP_OK);
+    CHECK(esp_event_handler_unregister_with(loop, BASE_A, 1, record_handler) == ESP_OK);
+    CHECK(post_and_run(loop, BASE_A, 1) == std::vector<int> {2, 5, 6, 7, 8});
+
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+
+TEST_CASE("dispatch performance with many registered events")
+{
+    // as many events as the default size of the dispatch index
+    const int BASES = 4;
+    const int IDS_PER_BASE = 16;
+    const int EVENTS = 200000;
+    const char* bases[BASES] = {"bench_base_0", "bench_base_1", "bench_base_2", "bench_base_3"};
+
+    MockEventQueue queue;
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+
+    static int s_calls;
+    auto count_handler = [](void* arg, esp_event_base_t base, int32_t id, void* data) {
+        s_calls++;
+    };
+    s_calls = 0;
+    for (int b = 0; b < BASES; b++) {
+        for (int id = 0; id < IDS_PER_BASE; id++) {
+            REQUIRE(esp_event_handler_instance_register_with(loop, bases[b], id, count_handler, nullptr, nullptr) == ESP_OK);
+        }
+        REQUIRE(esp_event_handler_instance_register_with(loop, bases[b], ESP_EVENT_ANY_ID, count_handler, nullptr, nullptr) == ESP_OK);
+    }
+    REQUIRE(esp_event_handler_instance_register_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, count_handler, nullptr, nullptr) == ESP_OK);
+
+    // only the time spent in esp_event_loop_run() is measured, posting to the mocked queue is slower than dispatching
+    std::chrono::nanoseconds elapsed(0);
+    for (int i = 0; i < EVENTS;) {
+        // spread the events over all the bases and ids
+        for (; i < EVENTS; i++) {
+            if (esp_event_post_to(loop, bases[i % BASES], (i * 7) % IDS_PER_BASE, nullptr, 0, 0) != ESP_OK) {
+                break;
+            }
+        }
+        auto start = std::chrono::steady_clock::now();
+        esp_event_loop_run(loop, 10);
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    // id level, base level and loop level handler for each event
+    CHECK(s_calls == 3 * EVENTS);
+    printf("dispatching %d events to %d registered event ids: %lld ns per event\n",
+           EVENTS, BASES * IDS_PER_BASE, (long long)(elapsed.count() / EVENTS));
+
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+
+namespace {
+
+struct test_payload_t {
+    uint32_t seq;
+    uint8_t data[60];
+};
+
+uint32_t s_payload_seq_sum;
+
+void payload_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    s_payload_seq_sum += static_cast<test_payload_t*>(event_data)->seq;
+}
+
+// Posts events with a payload, QUEUE_SIZE at a time, and returns the number of allocations per posted event
+double allocations_per_post(esp_event_loop_handle_t loop, bool acquire)
+{
+    const int EVENTS = 10 * QUEUE_SIZE;
+    test_payload_t payload = {};
+
+    // the first dispatch of an event allocates its entry in the dispatch index
+    esp_event_post_to(loop, BASE_A, 1, &payload, sizeof(payload), 0);
+    esp_event_loop_run(loop, 10);
+
+    s_payload_seq_sum = 0;
+    s_allocations = 0;
+    s_count_allocations = true;
+    for (int i = 0; i < EVENTS; i++) {
+        if (acquire) {
+            void* event_data;
+            esp_event_post_acquire(loop, sizeof(test_payload_t), &event_data);
+            static_cast<test_payload_t*>(event_data)->seq = i;
+            esp_event_post_commit(loop, BASE_A, 1, event_data, 0);
+        } else {
+            payload.seq = i;
+            esp_event_post_to(loop, BASE_A, 1, &payload, sizeof(payload), 0);
+        }
+        if (i % QUEUE_SIZE == QUEUE_SIZE - 1) {
+            esp_event_loop_run(loop, 10);
+        }
+    }
+    s_count_allocations = false;
+
+    CHECK(s_payload_seq_sum == EVENTS * (EVENTS - 1) / 2);
+    return static_cast<double>(s_allocations) / EVENTS;
+}
+
+}
+
+TEST_CASE("events are posted without allocations with a payload pool")
+{
+    MockEventQueue queue;
+    esp_event_loop_handle_t loop;
+    esp_event_loop_handle_t pool_loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+    REQUIRE(esp_event_handler_register_with(loop, BASE_A, 1, payload_handler, nullptr) == ESP_OK);
+
+    double heap_allocations = allocations_per_post(loop, false);
+
+    loop_args.payload_pool_block_size = sizeof(test_payload_t);
+    loop_args.payload_pool_blocks = QUEUE_SIZE;
+    REQUIRE(esp_event_loop_create(&loop_args, &pool_loop) == ESP_OK);
+    REQUIRE(esp_event_handler_register_with(pool_loop, BASE_A, 1, payload_handler, nullptr) == ESP_OK);
+
+    double pool_allocations = allocations_per_post(pool_loop, false);
+    double acquire_allocations = allocations_per_post(pool_loop, true);
+
+    printf("allocations per post: %.2f from the heap, %.2f with a payload pool, %.2f with acquire/commit\n",
+           heap_allocations, pool_allocations, acquire_allocations);
+    CHECK(heap_allocations >= 1);
+    CHECK(pool_allocations == 0);
+    CHECK(acquire_allocations == 0);
+
+    CHECK(esp_event_loop_delete(pool_loop) == ESP_OK);
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+
+TEST_CASE("payload pool blocks are acquired and released")
+{
+    const uint32_t BLOCKS = 40;
+
+    MockEventQueue queue;
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    void* event_data;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+    CHECK(esp_event_post_acquire(loop, 4, &event_data) == ESP_ERR_NOT_SUPPORTED);
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+
+    loop_args.payload_pool_block_size = 16;
+    CHECK(esp_event_loop_create(&loop_args, &loop) == ESP_ERR_INVALID_ARG);
+
+    loop_args.payload_pool_blocks = BLOCKS;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+    CHECK(esp_event_post_acquire(loop, 17, &event_data) == ESP_ERR_INVALID_SIZE);
+    CHECK(esp_event_post_acquire(loop, 16, nullptr) == ESP_ERR_INVALID_ARG);
+
+    std::vector<void*> blocks;
+    while (esp_event_post_acquire(loop, 16, &event_data) == ESP_OK) {
+        memset(event_data, 0xa5, 16);
+        blocks.push_back(event_data);
+    }
+    CHECK(blocks.size() == BLOCKS);
+
+    uint8_t local[16];
+    CHECK(esp_event_payload_retain(loop, local) == ESP_ERR_INVALID_ARG);
+    CHECK(esp_event_payload_release(loop, static_cast<uint8_t*>(blocks[0]) + 1) == ESP_ERR_INVALID_ARG);
+    CHECK(esp_event_post_commit(loop, BASE_A, 1, local, 0) == ESP_ERR_INVALID_ARG);
+
+    // events which can't be posted release their data
+    CHECK(esp_event_post_commit(loop, BASE_A, ESP_EVENT_ANY_ID, blocks[0], 0) == ESP_ERR_INVALID_ARG);
+    CHECK(esp_event_payload_release(loop, blocks[0]) == ESP_ERR_INVALID_STATE);
+    for (uint32_t i = 1; i <= QUEUE_SIZE; i++) {
+        CHECK(esp_event_post_commit(loop, BASE_A, 1, blocks[i], 0) == ESP_OK);
+    }
+    CHECK(esp_event_post_commit(loop, BASE_A, 1, blocks[QUEUE_SIZE + 1], 0) == ESP_ERR_TIMEOUT);
+
+    CHECK(esp_event_post_acquire(loop, 16, &event_data) == ESP_OK);
+    CHECK(esp_event_post_acquire(loop, 16, &event_data) == ESP_OK);
+    CHECK(esp_event_post_acquire(loop, 16, &event_data) == ESP_ERR_NO_MEM);
+
+    // once dispatched, the data of the posted events is released
+    CHECK(esp_event_loop_run(loop, 10) == ESP_OK);
+    for (uint32_t i = 0; i < QUEUE_SIZE; i++) {
+        CHECK(esp_event_post_acquire(loop, 16, &event_data) == ESP_OK);
+    }
+    CHECK(esp_event_post_acquire(loop, 16, &event_data) == ESP_ERR_NO_MEM);
+
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+
+TEST_CASE("handlers can retain the event data of a payload pool")
+{
+    MockEventQueue queue;
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    loop_args.payload_pool_block_size = sizeof(test_payload_t);
+    loop_args.payload_pool_blocks = 1;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+
+    static test_payload_t* s_retained;
+    auto retain_handler = [](void* arg, esp_event_base_t base, int32_t id, void* data) {
+        if (esp_event_payload_retain(static_cast<esp_event_loop_handle_t>(arg), data) == ESP_OK) {
+            s_retained = static_cast<test_payload_t*>(data);
+        }
+    };
+    s_retained = nullptr;
+    REQUIRE(esp_event_handler_register_with(loop, BASE_A, 1, retain_handler, loop) == ESP_OK);
+
+    test_payload_t payload = {};
+    payload.seq = 42;
+    CHECK(esp_event_post_to(loop, BASE_A, 1, &payload, sizeof(payload), 0) == ESP_OK);
+    // the pool has a single block, the data of the second event is allocated from the heap
+    CHECK(esp_event_post_to(loop, BASE_A, 1, &payload, sizeof(payload), 0) == ESP_OK);
+    CHECK(esp_event_loop_run(loop, 10) == ESP_OK);
+
+    REQUIRE(s_retained != nullptr);
+    CHECK(s_retained->seq == 42);
+    void* event_data;
+    CHECK(esp_event_post_acquire(loop, sizeof(test_payload_t), &event_data) == ESP_ERR_NO_MEM);
+    CHECK(esp_event_payload_release(loop, s_retained) == ESP_OK);
+    CHECK(esp_event_post_acquire(loop, sizeof(test_payload_t), &event_data) == ESP_OK);
+    CHECK(event_data == s_retained);
+    CHECK(esp_event_payload_release(loop, event_data) == ESP_OK);
+
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+
+TEST_CASE("events are dispatched by priority lane")
+{
+    MockEventQueue queue;
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    loop_args.priority_lanes = ESP_EVENT_LOOP_PRIORITY_LANES_MAX + 1;
+    CHECK(esp_event_loop_create(&loop_args, &loop) == ESP_ERR_INVALID_ARG);
+
+    loop_args.priority_lanes = 0;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+    CHECK(esp_event_priority_post_to(loop, BASE_A, 1, nullptr, 0, 1, 0) == ESP_ERR_INVALID_ARG);
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+
+    loop_args.priority_lanes = 3;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+    auto record_id_handler = [](void* arg, esp_event_base_t base, int32_t id, void* data) {
+        s_handler_calls.push_back(id);
+    };
+    REQUIRE(esp_event_handler_register_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, record_id_handler, nullptr) == ESP_OK);
+
+    s_handler_calls.clear();
+    CHECK(esp_event_post_to(loop, BASE_A, 1, nullptr, 0, 0) == ESP_OK);
+    CHECK(esp_event_priority_post_to(loop, BASE_A, 2, nullptr, 0, 0, 0) == ESP_OK);
+    CHECK(esp_event_priority_post_to(loop, BASE_A, 3, nullptr, 0, 2, 0) == ESP_OK);
+    CHECK(esp_event_priority_post_to(loop, BASE_A, 4, nullptr, 0, 1, 0) == ESP_OK);
+    CHECK(esp_event_priority_post_to(loop, BASE_A, 5, nullptr, 0, 2, 0) == ESP_OK);
+    CHECK(esp_event_priority_post_to(loop, BASE_A, 6, nullptr, 0, 3, 0) == ESP_ERR_INVALID_ARG);
+    CHECK(esp_event_loop_run(loop, 10) == ESP_OK);
+    CHECK(s_handler_calls == std::vector<int> {3, 5, 4, 1, 2});
+
+    // each lane has its own queue
+    for (uint32_t i = 0; i < QUEUE_SIZE; i++) {
+        CHECK(esp_event_priority_post_to(loop, BASE_A, 1, nullptr, 0, 0, 0) == ESP_OK);
+    }
+    CHECK(esp_event_priority_post_to(loop, BASE_A, 1, nullptr, 0, 0, 0) == ESP_ERR_TIMEOUT);
+    CHECK(esp_event_priority_post_to(loop, BASE_A, 7, nullptr, 0, 1, 0) == ESP_OK);
+    s_handler_calls.clear();
+    CHECK(esp_event_loop_run(loop, 10) == ESP_OK);
+    CHECK(s_handler_calls.size() == QUEUE_SIZE + 1);
+    CHECK(s_handler_calls[0] == 7);
+
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
+
+TEST_CASE("events are dispatched in batches")
+{
+    MockEventQueue queue;
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(esp_event_loop_create(&loop_args, &loop) == ESP_OK);
+    REQUIRE(esp_event_handler_register_with(loop, BASE_A, 1, dummy_handler, nullptr) == ESP_OK);
+
+    for (uint32_t i = 0; i < QUEUE_SIZE; i++) {
+        CHECK(esp_event_post_to(loop, BASE_A, 1, nullptr, 0, 0) == ESP_OK);
+    }
+
+    // the loop mutex is taken once per batch
+    MockEventQueue::mutex_takes = 0;
+    CHECK(esp_event_loop_run(loop, 10) == ESP_OK);
+    CHECK(MockEventQueue::mutex_takes == (QUEUE_SIZE + CONFIG_ESP_EVENT_LOOP_BATCH_SIZE - 1) / CONFIG_ESP_EVENT_LOOP_BATCH_SIZE);
+
+    // a run limited to 0 ticks dispatches a single event
+    CHECK(esp_event_post_to(loop, BASE_A, 1, nullptr, 0, 0) == ESP_OK);
+    CHECK(esp_event_post_to(loop, BASE_A, 1, nullptr, 0, 0) == ESP_OK);
+    CHECK(esp_event_loop_run(loop, 0) == ESP_OK);
+    CHECK(MockEventQueue::queues[0].count == 1);
+
+    CHECK(esp_event_loop_delete(loop) == ESP_OK);
+}
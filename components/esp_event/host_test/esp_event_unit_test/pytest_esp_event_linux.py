@@ -6,6 +6,14 @@ from pytest_embedded_idf.utils import idf_parametrize
 
 
 @pytest.mark.host_test
+@pytest.mark.parametrize(
+    'config',
+    [
+        'default',
+        'no_dispatch_index',
+    ],
+    indirect=True,
+)
 @idf_parametrize('target', ['linux'], indirect=['target'])
 def test_esp_event_linux(dut: Dut) -> None:
     dut.expect_exact('All tests passed', timeout=5)
@@ -7,6 +7,8 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 
+#include <cstring>
+#include <vector>
 #include "esp_event.h"
 
 #include <catch2/catch_test_macros.hpp>
@@ -147,3 +149,114 @@ struct MockTask : public CMockFix {
 
     TaskHandle_t task;
 };
+
+/**
+ * Emulates the queues, semaphores and the mutex of event loops without a dedicated task, so that the events posted to
+ * the loops are dispatched by esp_event_loop_run(). The mutex can always be taken, the number of times it is taken
+ * recursively is counted. The queue storage is allocated when a queue is created, sending and receiving don't allocate
+ * memory.
+ */
+struct MockEventQueue : public CMockFix {
+    MockEventQueue()
+    {
+        queues.clear();
+        queues.reserve(16);
+        mutex_takes = 0;
+        xQueueGenericCreate_Stub(create_queue);
+        xQueueCreateMutex_IgnoreAndReturn(MUTEX);
+        vQueueDelete_Ignore();
+        xQueueTakeMutexRecursive_Stub(take_mutex);
+        xQueueGiveMutexRecursive_IgnoreAndReturn(pdTRUE);
+        xQueueSemaphoreTake_Stub(take_semaphore);
+        xQueueGenericSend_Stub(send);
+        xQueueReceive_Stub(receive);
+        xTaskGetTickCount_IgnoreAndReturn(0);
+        xTaskGetCurrentTaskHandle_IgnoreAndReturn(nullptr);
+    }
+
+    ~MockEventQueue()
+    {
+        xQueueGenericCreate_Stub(nullptr);
+        xQueueCreateMutex_StopIgnore();
+        vQueueDelete_StopIgnore();
+        xQueueTakeMutexRecursive_Stub(nullptr);
+        xQueueGiveMutexRecursive_StopIgnore();
+        xQueueSemaphoreTake_Stub(nullptr);
+        xQueueGenericSend_Stub(nullptr);
+        xQueueReceive_Stub(nullptr);
+        xTaskGetTickCount_StopIgnore();
+        xTaskGetCurrentTaskHandle_StopIgnore();
+    }
+
+    struct Queue {
+        std::vector<uint8_t> storage;
+        UBaseType_t length;
+        UBaseType_t item_size;
+        UBaseType_t head;
+        UBaseType_t count;
+    };
+
+    static Queue *find(QueueHandle_t handle)
+    {
+        size_t index = reinterpret_cast<uintptr_t>(handle) / HANDLE_STEP - 1;
+        return index < queues.size() ? &queues[index] : nullptr;
+    }
+
+    static QueueHandle_t create_queue(const UBaseType_t length, const UBaseType_t item_size, const uint8_t type, int num_calls)
+    {
+        queues.push_back(Queue {std::vector<uint8_t>(length * item_size), length, item_size, 0, 0});
+        return reinterpret_cast<QueueHandle_t>(queues.size() * HANDLE_STEP);
+    }
+
+    static BaseType_t send(QueueHandle_t handle, const void *const item, TickType_t ticks_to_wait, const BaseType_t position, int num_calls)
+    {
+        Queue *queue = find(handle);
+        if (queue == nullptr) {
+            return pdTRUE; // mutex given
+        }
+        if (queue->count >= queue->length) {
+            return errQUEUE_FULL;
+        }
+        if (queue->item_size) {
+            memcpy(&queue->storage[((queue->head + queue->count) % queue->length) * queue->item_size], item, queue->item_size);
+        }
+        queue->count++;
+        return pdTRUE;
+    }
+
+    static BaseType_t receive(QueueHandle_t handle, void *const buffer, TickType_t ticks_to_wait, int num_calls)
+    {
+        Queue *queue = find(handle);
+        if (queue == nullptr || queue->count == 0) {
+            return pdFALSE;
+        }
+        memcpy(buffer, &queue->storage[queue->head * queue->item_size], queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        return pdTRUE;
+    }
+
+    static BaseType_t take_semaphore(QueueHandle_t handle, TickType_t ticks_to_wait, int num_calls)
+    {
+        Queue *queue = find(handle);
+        if (queue == nullptr) {
+            return pdTRUE; // mutex taken
+        }
+        if (queue->count == 0) {
+            return pdFALSE;
+        }
+        queue->count--;
+        return pdTRUE;
+    }
+
+    static BaseType_t take_mutex(QueueHandle_t mutex, TickType_t ticks_to_wait, int num_calls)
+    {
+        mutex_takes++;
+        return pdTRUE;
+    }
+
+    static inline const QueueHandle_t MUTEX = reinterpret_cast<QueueHandle_t>(0x1000000);
+    static inline const uintptr_t HANDLE_STEP = 0x100;
+    static inline std::vector<Queue> queues;
+    static inline int mutex_takes;
+};
@@ -18,6 +18,9 @@
 extern "C" {
 #endif
 
+/// Maximum number of priority lanes of an event loop
+#define ESP_EVENT_LOOP_PRIORITY_LANES_MAX   4
+
 /// Configuration for creating event loops
 typedef struct {
     int32_t queue_size;                         /**< size of the event loop queue */
@@ -27,6 +30,15 @@ typedef struct {
     uint32_t task_stack_size;                   /**< stack size of the event loop task, ignored if task name is NULL */
     BaseType_t task_core_id;                    /**< core to which the event loop task is pinned to,
                                                         ignored if task name is NULL */
+    size_t payload_pool_block_size;             /**< size of the blocks of the payload pool of the event loop, the
+                                                        largest event data posted without allocating memory; if 0,
+                                                        the event loop has no payload pool */
+    uint32_t payload_pool_blocks;               /**< number of blocks of the payload pool, ignored if
+                                                        payload_pool_block_size is 0 */
+    uint8_t priority_lanes;                     /**< number of priority lanes of the event loop, at most
+                                                        ESP_EVENT_LOOP_PRIORITY_LANES_MAX; each lane has a queue of
+                                                        queue_size events, see esp_event_priority_post_to();
+                                                        0 is the same as 1 */
 } esp_event_loop_args_t;
 
 /**
@@ -395,6 +407,117 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop,
                             size_t event_data_size,
                             TickType_t ticks_to_wait);
 
+/**
+ * @brief Posts an event to a priority lane of the specified event loop.
+ *
+ * This function behaves in the same manner as esp_event_post_to, which posts to the lane of priority 0. Events
+ * posted to a lane of higher priority are dispatched before the events waiting in lanes of lower priority. Events of
+ * the same lane are dispatched in the order they were posted.
+ *
+ * @param[in] event_loop the event loop to post to, must not be NULL
+ * @param[in] event_base the event base that identifies the event
+ * @param[in] event_id the event ID that identifies the event
+ * @param[in] event_data the data, specific to the event occurrence, that gets passed to the handler
+ * @param[in] event_data_size the size of the event data
+ * @param[in] priority the priority lane to post to, from 0 (lowest) to the number of lanes of the event loop minus one
+ * @param[in] ticks_to_wait number of ticks to block on a full lane
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_TIMEOUT: Time to wait for the lane to unblock expired
+ *  - ESP_ERR_INVALID_ARG: Invalid combination of event base and event ID, the event loop has no such lane
+ *  - Others: Fail
+ */
+esp_err_t esp_event_priority_post_to(esp_event_loop_handle_t event_loop,
+                                     esp_event_base_t event_base,
+                                     int32_t event_id,
+                                     const void *event_data,
+                                     size_t event_data_size,
+                                     uint8_t priority,
+                                     TickType_t ticks_to_wait);
+
+/**
+ * @brief Acquires a buffer from the payload pool of an event loop, to post an event without copying its data.
+ *
+ * The event data is written to the buffer, which is then posted with esp_event_post_commit(), or returned to the
+ * pool with esp_event_payload_release() if the event isn't posted. This function doesn't block.
+ *
+ * @param[in] event_loop the event loop to post to, must not be NULL
+ * @param[in] event_data_size the size of the event data
+ * @param[out] event_data the buffer to write the event data to
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_INVALID_ARG: event_data is NULL
+ *  - ESP_ERR_INVALID_SIZE: event_data_size is larger than the blocks of the payload pool
+ *  - ESP_ERR_NOT_SUPPORTED: the event loop has no payload pool
+ *  - ESP_ERR_NO_MEM: all the blocks of the payload pool are in use
+ */
+esp_err_t esp_event_post_acquire(esp_event_loop_handle_t event_loop,
+                                 size_t event_data_size,
+                                 void **event_data);
+
+/**
+ * @brief Posts an event whose data was written to a buffer acquired with esp_event_post_acquire().
+ *
+ * The handlers receive the buffer itself as event data. The reference to the buffer held by the caller is handed
+ * over to the event loop, which releases it once the handlers have run, or before returning if the event can't be
+ * posted. The caller must not access the buffer after calling this function.
+ *
+ * @param[in] event_loop the event loop to post to, must not be NULL
+ * @param[in] event_base the event base that identifies the event
+ * @param[in] event_id the event ID that identifies the event
+ * @param[in] event_data the buffer returned by esp_event_post_acquire()
+ * @param[in] ticks_to_wait number of ticks to block on a full event queue
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_TIMEOUT: Time to wait for event queue to unblock expired
+ *  - ESP_ERR_INVALID_ARG: Invalid combination of event base and event ID,
+ *                          event_data isn't a buffer of the payload pool of the event loop
+ */
+esp_err_t esp_event_post_commit(esp_event_loop_handle_t event_loop,
+                                esp_event_base_t event_base,
+                                int32_t event_id,
+                                void *event_data,
+                                TickType_t ticks_to_wait);
+
+/**
+ * @brief Takes a reference to event data held in the payload pool of an event loop.
+ *
+ * A handler can call this function to keep using the event data it received after it returns, without copying it.
+ * The data remains valid until esp_event_payload_release() is called once for each reference taken, or until the
+ * event loop is deleted.
+ *
+ * Events posted with esp_event_post_commit() always have their data in the payload pool. Events posted with
+ * esp_event_post_to() have it in the pool if it fits in a block and a block is free, unless it fits in the inline
+ * storage of events (see CONFIG_ESP_EVENT_POST_FROM_ISR_SIZE).
+ *
+ * @param[in] event_loop the event loop the event was posted to, must not be NULL
+ * @param[in] event_data the event data
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_INVALID_ARG: event_data isn't a buffer of the payload pool of the event loop
+ *  - ESP_ERR_INVALID_STATE: the buffer isn't in use
+ */
+esp_err_t esp_event_payload_retain(esp_event_loop_handle_t event_loop, const void *event_data);
+
+/**
+ * @brief Releases a reference to a buffer of the payload pool of an event loop.
+ *
+ * The buffer returns to the pool once all the references to it have been released.
+ *
+ * @param[in] event_loop the event loop the buffer belongs to, must not be NULL
+ * @param[in] event_data the buffer, as returned by esp_event_post_acquire() or received by a handler
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_INVALID_ARG: event_data isn't a buffer of the payload pool of the event loop
+ *  - ESP_ERR_INVALID_STATE: the buffer isn't in use
+ */
+esp_err_t esp_event_payload_release(esp_event_loop_handle_t event_loop, const void *event_data);
+
 #if CONFIG_ESP_EVENT_POST_FROM_ISR
 /**
  * @brief Special variant of esp_event_post for posting events from interrupt handlers.
@@ -462,10 +585,14 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop,
  *
  @verbatim
        event loop
+           lane
+           ...
            handler
            handler
            ...
        event loop
+           lane
+           ...
            handler
            handler
            ...
@@ -480,6 +607,12 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop,
            total_received - number of successfully posted events
            total_dropped - number of events unsuccessfully posted due to queue being full
 
+   lane
+       format: LANE priority lat:<16,<64,<256,<1024,<4096,<16384,<65536,>=65536
+       where:
+           priority - priority of the lane, see esp_event_priority_post_to()
+           <16 ... >=65536 - number of events posted to the lane by time from posting to dispatch, in microseconds
+
    handler
        format: address ev:base,id inv:total_invoked run:total_runtime
        where:
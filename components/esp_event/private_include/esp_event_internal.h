@@ -18,6 +18,11 @@ extern "C" {
 
 typedef SLIST_HEAD(base_nodes, base_node) base_nodes_t;
 
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+/// Number of buckets of the latency histograms, bucket n counts latencies below 16 * 4^n us, the last one the others
+#define ESP_EVENT_LATENCY_BUCKETS   8
+#endif
+
 typedef struct esp_event_handler_context {
     esp_event_handler_t handler;                                    /**< event handler function*/
     void* arg;
@@ -66,19 +71,61 @@ typedef struct esp_event_loop_node {
 
 typedef SLIST_HEAD(esp_event_loop_nodes, esp_event_loop_node) esp_event_loop_nodes_t;
 
+#if CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX
+/// Handlers executed for an event, in dispatch order
+typedef struct esp_event_dispatch_entry {
+    esp_event_base_t base;                                          /**< base of the event, NULL for a free slot */
+    int32_t id;                                                     /**< id of the event */
+    esp_event_handler_node_t** handlers;                            /**< handlers matching the event, including
+                                                                            base and loop level handlers */
+    uint32_t handlers_num;                                          /**< number of handlers */
+} esp_event_dispatch_entry_t;
+
+/// Index of the handlers by event, filled when events are dispatched
+typedef struct esp_event_dispatch_index {
+    esp_event_dispatch_entry_t* entries;                            /**< open addressing hash table */
+    uint32_t size;                                                  /**< number of slots, a power of two */
+    uint32_t used;                                                  /**< number of indexed events */
+    uint32_t dispatching;                                           /**< nesting depth of dispatches using the index */
+    bool stale;                                                     /**< the handlers changed during a dispatch,
+                                                                            the index must be cleared once it ends */
+} esp_event_dispatch_index_t;
+#endif
+
+/// Pool of event data buffers, see esp_event_post_acquire()
+typedef struct esp_event_payload_pool {
+    uint8_t* blocks;                                                /**< memory of the blocks, NULL if the loop
+                                                                            has no payload pool */
+    size_t block_size;                                              /**< size of each block, 0 if the loop has
+                                                                            no payload pool */
+    uint32_t blocks_num;                                            /**< number of blocks */
+    atomic_uint_least32_t* refs;                                    /**< number of references to each block */
+    atomic_uint_least32_t* free_map;                                /**< one bit per block, set if it is free */
+} esp_event_payload_pool_t;
+
 /// Event loop
 typedef struct esp_event_loop_instance {
     const char* name;                                               /**< name of this event loop */
-    QueueHandle_t queue;                                            /**< event queue */
+    QueueHandle_t queues[ESP_EVENT_LOOP_PRIORITY_LANES_MAX];        /**< event queue of each priority lane,
+                                                                            from the lowest priority */
+    uint8_t lanes_num;                                              /**< number of priority lanes */
+    SemaphoreHandle_t lanes_signal;                                 /**< for loops with several lanes, given
+                                                                            when an event is posted */
     TaskHandle_t task;                                              /**< task that consumes the event queue */
     TaskHandle_t running_task;                                      /**< for loops with no dedicated task, the
                                                                             task that consumes the queue */
     SemaphoreHandle_t mutex;                                        /**< mutex for updating the events linked list */
     esp_event_loop_nodes_t loop_nodes;                              /**< set of linked lists containing the
                                                                             registered handlers for the loop */
+#if CONFIG_ESP_EVENT_LOOP_DISPATCH_INDEX
+    esp_event_dispatch_index_t dispatch_index;                      /**< handlers of the dispatched events */
+#endif
+    esp_event_payload_pool_t payload_pool;                          /**< buffers for the data of posted events */
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     atomic_uint_least32_t events_received;                          /**< number of events successfully posted to the loop */
     atomic_uint_least32_t events_dropped;                           /**< number of events dropped due to queue being full */
+    uint32_t latency[ESP_EVENT_LOOP_PRIORITY_LANES_MAX][ESP_EVENT_LATENCY_BUCKETS]; /**< number of events of each lane
+                                                                            by time from posting to dispatch */
     SLIST_ENTRY(esp_event_loop_instance) next;                      /**< next event loop in the list */
 #endif
 } esp_event_loop_instance_t;
@@ -102,6 +149,8 @@ typedef union esp_event_post_data {
 
 /// Event posted to the event queue
 typedef struct esp_event_post_instance {
+    bool data_pooled;                                                /**< indicates whether data is a buffer of the
+                                                                            payload pool of the loop */
 #if CONFIG_ESP_EVENT_POST_FROM_ISR
     bool data_allocated;                                             /**< indicates whether data is allocated from heap */
     bool data_set;                                                   /**< indicates if data is null */
@@ -109,6 +158,9 @@ typedef struct esp_event_post_instance {
     esp_event_base_t base;                                           /**< the event base */
     int32_t id;                                                      /**< the event id */
     esp_event_post_data_t data;                                      /**< data associated with the event */
+#ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
+    int64_t time;                                                    /**< time the event was posted at */
+#endif
 } esp_event_post_instance_t;
 
 #ifdef __cplusplus
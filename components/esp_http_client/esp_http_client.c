@@ -23,6 +23,13 @@
 #include "errno.h"
 #include "esp_random.h"
 #include "esp_tls.h"
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "psa/crypto.h"
+
+#define HTTP_POOL_DIGEST_LEN PSA_HASH_LENGTH(PSA_ALG_SHA_256)
+#endif
 
 #ifdef CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
 #include "esp_transport_ssl.h"
@@ -142,6 +149,10 @@ struct esp_http_client {
 #ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
     session_ticket_state_t      session_ticket_state;
 #endif
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+    esp_http_client_config_t    *transport_cfg;     /*!< Settings the transports were made with, NULL if the client doesn't use the pool */
+    uint8_t                     transport_cfg_digest[HTTP_POOL_DIGEST_LEN]; /*!< Digest of the data the TLS settings of transport_cfg point to */
+#endif
 };
 
 typedef struct esp_http_client esp_http_client_t;
@@ -190,6 +201,7 @@ static const char *HTTP_METHOD_MAPPING[] = {
 
 esp_err_t esp_http_client_request_send(esp_http_client_handle_t client, int write_len);
 static esp_err_t esp_http_client_connect(esp_http_client_handle_t client);
+static esp_err_t http_client_close(esp_http_client_handle_t client, bool reuse);
 static esp_err_t esp_http_client_send_post_data(esp_http_client_handle_t client);
 
 static esp_err_t http_dispatch_event(esp_http_client_t *client, esp_http_client_event_id_t event_id, void *data, int len)
@@ -835,67 +847,10 @@ static esp_err_t http_convert_addr_family_to_tls(esp_http_client_addr_type_t htt
     return ret;
 }
 
-esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
-{
-
-    esp_http_client_handle_t client;
-    esp_tls_addr_family_t addr_family = ESP_TLS_AF_UNSPEC;
-    esp_err_t ret = ESP_OK;
-    esp_transport_handle_t tcp = NULL;
-    char *host_name;
-    bool _success;
-
-    _success = (
-                   (client                         = calloc(1, sizeof(esp_http_client_t)))           &&
-                   (client->parser                 = calloc(1, sizeof(struct http_parser)))          &&
-                   (client->parser_settings        = calloc(1, sizeof(struct http_parser_settings))) &&
-                   (client->auth_data              = calloc(1, sizeof(esp_http_auth_data_t)))        &&
-                   (client->request                = calloc(1, sizeof(esp_http_data_t)))             &&
-                   (client->request->headers       = http_header_init())                             &&
-                   (client->request->buffer        = calloc(1, sizeof(esp_http_buffer_t)))           &&
-                   (client->response               = calloc(1, sizeof(esp_http_data_t)))             &&
-#if CONFIG_ESP_HTTP_CLIENT_SAVE_RESPONSE_HEADERS
-                   (client->response->headers      = http_header_init())                             &&
-#endif // CONFIG_ESP_HTTP_CLIENT_SAVE_RESPONSE_HEADERS
-                   (client->response->buffer       = calloc(1, sizeof(esp_http_buffer_t)))
-               );
-
-    if (!_success) {
-        ESP_LOGE(TAG, "Error allocate memory");
-        goto error;
-    }
-
-    _success = (
-                   (client->transport_list = esp_transport_list_init()) &&
-                   (tcp = esp_transport_tcp_init()) &&
-                   (esp_transport_set_default_port(tcp, DEFAULT_HTTP_PORT) == ESP_OK) &&
-                   (esp_transport_list_add(client->transport_list, tcp, "http") == ESP_OK)
-               );
-    if (!_success) {
-        ESP_LOGE(TAG, "Error initialize transport");
-        goto error;
-    }
-    ESP_GOTO_ON_ERROR(http_convert_addr_family_to_tls(config->addr_type, &addr_family), error, TAG, "Failed to convert addr type %d", config->addr_type);
-    esp_transport_ssl_set_addr_family(tcp, addr_family);
-
-    ESP_GOTO_ON_FALSE(init_common_tcp_transport(client, config, tcp), ESP_FAIL, error, TAG, "Failed to set TCP config");
-
 #ifdef CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
-    esp_transport_handle_t ssl = NULL;
-    _success = (
-                   (ssl = esp_transport_ssl_init()) &&
-                   (esp_transport_set_default_port(ssl, DEFAULT_HTTPS_PORT) == ESP_OK) &&
-                   (esp_transport_list_add(client->transport_list, ssl, "https") == ESP_OK)
-               );
-
-    if (!_success) {
-        ESP_LOGE(TAG, "Error initialize SSL Transport");
-        goto error;
-    }
-    esp_transport_ssl_set_addr_family(ssl, addr_family);
-
-    ESP_GOTO_ON_FALSE(init_common_tcp_transport(client, config, ssl), ESP_FAIL, error, TAG, "Failed to set SSL config");
-
+/* Sets the TLS settings of the config on the SSL transport, which keeps the pointers to its data */
+static void http_client_set_ssl_config(esp_transport_handle_t ssl, const esp_http_client_config_t *config)
+{
     if (config->crt_bundle_attach != NULL) {
 #ifdef CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
         esp_transport_ssl_crt_bundle_attach(ssl, config->crt_bundle_attach);
@@ -941,18 +896,6 @@ esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *co
     }
 #endif
 
-#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
-    if (config->save_client_session) {
-        client->session_ticket_state = SESSION_TICKET_NOT_SAVED;
-    }
-#endif
-
-#if CONFIG_ESP_HTTP_CLIENT_ENABLE_CUSTOM_TRANSPORT
-    if (config->transport) {
-        client->transport = config->transport;
-    }
-#endif
-
     if (config->client_key_pem) {
         if (!config->client_key_len) {
             esp_transport_ssl_set_client_key_data(ssl, config->client_key_pem, strlen(config->client_key_pem));
@@ -982,6 +925,418 @@ esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *co
     if (config->common_name) {
         esp_transport_ssl_set_common_name(ssl, config->common_name);
     }
+}
+#endif
+
+/* Creates the transports of the client, for the schemes it supports */
+static esp_err_t http_client_init_transports(esp_http_client_handle_t client, const esp_http_client_config_t *config)
+{
+    esp_tls_addr_family_t addr_family = ESP_TLS_AF_UNSPEC;
+    esp_transport_handle_t tcp = NULL;
+    bool _success;
+
+    _success = (
+                   (client->transport_list = esp_transport_list_init()) &&
+                   (tcp = esp_transport_tcp_init()) &&
+                   (esp_transport_set_default_port(tcp, DEFAULT_HTTP_PORT) == ESP_OK) &&
+                   (esp_transport_list_add(client->transport_list, tcp, "http") == ESP_OK)
+               );
+    if (!_success) {
+        ESP_LOGE(TAG, "Error initialize transport");
+        return ESP_FAIL;
+    }
+    ESP_RETURN_ON_ERROR(http_convert_addr_family_to_tls(config->addr_type, &addr_family), TAG, "Failed to convert addr type %d", config->addr_type);
+    esp_transport_ssl_set_addr_family(tcp, addr_family);
+
+    ESP_RETURN_ON_FALSE(init_common_tcp_transport(client, config, tcp), ESP_FAIL, TAG, "Failed to set TCP config");
+
+#ifdef CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
+    esp_transport_handle_t ssl = NULL;
+    _success = (
+                   (ssl = esp_transport_ssl_init()) &&
+                   (esp_transport_set_default_port(ssl, DEFAULT_HTTPS_PORT) == ESP_OK) &&
+                   (esp_transport_list_add(client->transport_list, ssl, "https") == ESP_OK)
+               );
+
+    if (!_success) {
+        ESP_LOGE(TAG, "Error initialize SSL Transport");
+        return ESP_FAIL;
+    }
+    esp_transport_ssl_set_addr_family(ssl, addr_family);
+
+    ESP_RETURN_ON_FALSE(init_common_tcp_transport(client, config, ssl), ESP_FAIL, TAG, "Failed to set SSL config");
+
+    http_client_set_ssl_config(ssl, config);
+#endif
+    return ESP_OK;
+}
+
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+/* An idle connection, kept for the next client that sends requests to the same server */
+typedef struct {
+    char                        *scheme;            /*!< Scheme of the server, followed by its host in the same allocation. NULL for a free slot */
+    const char                  *host;              /*!< Host of the server */
+    int                         port;               /*!< Port of the server */
+    esp_http_client_config_t    transport_cfg;      /*!< Settings the transports were made with, its pointers may not be valid anymore */
+    uint8_t                     transport_cfg_digest[HTTP_POOL_DIGEST_LEN]; /*!< Digest of the data the TLS settings pointed to */
+    esp_transport_list_handle_t transport_list;     /*!< Transports of the client that made the connection */
+    esp_transport_handle_t      transport;          /*!< The connected transport of the list */
+    TickType_t                  idle_since;         /*!< When the connection was put in the pool */
+} http_pool_conn_t;
+
+static http_pool_conn_t s_pool[CONFIG_ESP_HTTP_CLIENT_POOL_SIZE];
+static portMUX_TYPE s_pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Only the clients that make their connections the same way can share them */
+static bool http_pool_supported(esp_http_client_handle_t client, const esp_http_client_config_t *config)
+{
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (config->save_client_session) {
+        return false;
+    }
+#endif
+    /* The interface name is only known by pointer, which may not outlive the client */
+    return !config->is_async && client->transport == NULL && config->if_name == NULL;
+}
+
+/* Adds data to the digest, after its kind and its length, so that fields which
+ * follow each other can't be mixed up */
+static psa_status_t http_pool_digest_data(psa_hash_operation_t *operation, const char *data, size_t len)
+{
+    enum { DATA_NONE, DATA_BYTES, DATA_STRING } kind = data ? DATA_BYTES : DATA_NONE;
+    /* PEM data and strings may be given with their length counting the
+     * terminating NUL, or without a length, they are the same string then */
+    if (data && len == 0) {
+        kind = DATA_STRING;
+        len = strlen(data);
+    } else if (data && strnlen(data, len) == len - 1) {
+        kind = DATA_STRING;
+        len--;
+    }
+    uint32_t data_len = len;
+    uint8_t header[1 + sizeof(data_len)] = { kind };
+    memcpy(&header[1], &data_len, sizeof(data_len));
+    psa_status_t status = psa_hash_update(operation, header, sizeof(header));
+    if (status == PSA_SUCCESS && len > 0) {
+        status = psa_hash_update(operation, (const uint8_t *)data, len);
+    }
+    return status;
+}
+
+/* Computes a SHA-256 digest of the data the TLS settings point to, which the
+ * clients may have in different buffers, and which may be gone once the client
+ * that made a pooled connection has been cleaned up */
+static esp_err_t http_pool_digest_transports(const esp_http_client_config_t *config, uint8_t digest[HTTP_POOL_DIGEST_LEN])
+{
+    psa_hash_operation_t operation = PSA_HASH_OPERATION_INIT;
+    size_t digest_len = 0;
+    psa_status_t status = psa_hash_setup(&operation, PSA_ALG_SHA_256);
+    if (status == PSA_SUCCESS) {
+        status = http_pool_digest_data(&operation, config->cert_pem, config->cert_len);
+    }
+    if (status == PSA_SUCCESS) {
+        status = http_pool_digest_data(&operation, config->client_cert_pem, config->client_cert_len);
+    }
+    if (status == PSA_SUCCESS) {
+        status = http_pool_digest_data(&operation, config->client_key_pem, config->client_key_len);
+    }
+    if (status == PSA_SUCCESS) {
+        /* The password is only used when its length is given */
+        status = http_pool_digest_data(&operation, config->client_key_password_len > 0 ? config->client_key_password : NULL,
+                                       config->client_key_password_len);
+    }
+    if (status == PSA_SUCCESS) {
+        status = http_pool_digest_data(&operation, config->common_name, 0);
+    }
+#if CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
+    for (const char **proto = config->alpn_protos; proto && *proto && status == PSA_SUCCESS; proto++) {
+        status = http_pool_digest_data(&operation, *proto, 0);
+    }
+#endif
+    if (status == PSA_SUCCESS) {
+        status = psa_hash_finish(&operation, digest, HTTP_POOL_DIGEST_LEN, &digest_len);
+    }
+    psa_hash_abort(&operation);
+    return status == PSA_SUCCESS && digest_len == HTTP_POOL_DIGEST_LEN ? ESP_OK : ESP_FAIL;
+}
+
+static bool http_pool_same_transports(const esp_http_client_config_t *a, const uint8_t *a_digest,
+                                      const esp_http_client_config_t *b, const uint8_t *b_digest)
+{
+    return memcmp(a_digest, b_digest, HTTP_POOL_DIGEST_LEN) == 0 &&
+           a->tls_version == b->tls_version &&
+#ifdef CONFIG_MBEDTLS_HARDWARE_ECDSA_SIGN
+           a->use_ecdsa_peripheral == b->use_ecdsa_peripheral && a->ecdsa_curve == b->ecdsa_curve &&
+           a->ecdsa_key_efuse_blk == b->ecdsa_key_efuse_blk && a->ecdsa_key_efuse_blk_high == b->ecdsa_key_efuse_blk_high &&
+#endif
+           a->use_global_ca_store == b->use_global_ca_store &&
+           a->skip_cert_common_name_check == b->skip_cert_common_name_check &&
+           a->crt_bundle_attach == b->crt_bundle_attach &&
+           a->keep_alive_enable == b->keep_alive_enable &&
+           (!a->keep_alive_enable || (a->keep_alive_idle == b->keep_alive_idle &&
+                                      a->keep_alive_interval == b->keep_alive_interval &&
+                                      a->keep_alive_count == b->keep_alive_count)) &&
+#if CONFIG_ESP_TLS_USE_SECURE_ELEMENT
+           a->use_secure_element == b->use_secure_element &&
+#endif
+#if CONFIG_ESP_TLS_USE_DS_PERIPHERAL
+           a->ds_data == b->ds_data &&
+#endif
+#if CONFIG_MBEDTLS_DYNAMIC_BUFFER
+           a->tls_dyn_buf_strategy == b->tls_dyn_buf_strategy &&
+#endif
+           a->addr_type == b->addr_type;
+}
+
+static bool http_pool_same_server(const http_pool_conn_t *conn, const char *scheme, const char *host, int port,
+                                  const esp_http_client_config_t *transport_cfg, const uint8_t *transport_cfg_digest)
+{
+    return conn->port == port &&
+           strcasecmp(conn->scheme, scheme) == 0 &&
+           strcasecmp(conn->host, host) == 0 &&
+           http_pool_same_transports(&conn->transport_cfg, conn->transport_cfg_digest, transport_cfg, transport_cfg_digest);
+}
+
+static void http_pool_conn_destroy(http_pool_conn_t *conn)
+{
+    esp_transport_close(conn->transport);
+    esp_transport_list_destroy(conn->transport_list);
+    free(conn->scheme);
+}
+
+/* Takes the connection in the given slot out of the pool, with the pool locked */
+static void http_pool_take(int slot, http_pool_conn_t *conn)
+{
+    *conn = s_pool[slot];
+    memset(&s_pool[slot], 0, sizeof(http_pool_conn_t));
+}
+
+/* Closes the connections that have been idle for too long */
+static void http_pool_expire(void)
+{
+    const TickType_t timeout = pdMS_TO_TICKS(CONFIG_ESP_HTTP_CLIENT_POOL_IDLE_TIMEOUT_MS);
+    http_pool_conn_t conn;
+    bool found;
+
+    do {
+        found = false;
+        TickType_t now = xTaskGetTickCount();
+        portENTER_CRITICAL(&s_pool_lock);
+        for (int i = 0; i < CONFIG_ESP_HTTP_CLIENT_POOL_SIZE; i++) {
+            if (s_pool[i].scheme && now - s_pool[i].idle_since >= timeout) {
+                http_pool_take(i, &conn);
+                found = true;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&s_pool_lock);
+        if (found) {
+            ESP_LOGD(TAG, "Close idle connection to %s:%d", conn.host, conn.port);
+            http_pool_conn_destroy(&conn);
+        }
+    } while (found);
+}
+
+/* Gives the client a pooled connection to its server, if there is one that
+ * the server hasn't closed yet */
+static bool http_pool_acquire(esp_http_client_handle_t client)
+{
+    http_pool_conn_t conn;
+
+    http_pool_expire();
+    while (true) {
+        /* The connection used last is the least likely to have been closed */
+        int slot = -1;
+        TickType_t now = xTaskGetTickCount();
+        portENTER_CRITICAL(&s_pool_lock);
+        for (int i = 0; i < CONFIG_ESP_HTTP_CLIENT_POOL_SIZE; i++) {
+            if (s_pool[i].scheme &&
+                    http_pool_same_server(&s_pool[i], client->connection_info.scheme, client->connection_info.host,
+                                          client->connection_info.port, client->transport_cfg,
+                                          client->transport_cfg_digest) &&
+                    (slot < 0 || now - s_pool[i].idle_since < now - s_pool[slot].idle_since)) {
+                slot = i;
+            }
+        }
+        if (slot >= 0) {
+            http_pool_take(slot, &conn);
+        }
+        portEXIT_CRITICAL(&s_pool_lock);
+        if (slot < 0) {
+            return false;
+        }
+        /* An idle connection has nothing to read, unless the server closed it */
+        if (esp_transport_poll_read(conn.transport, 0) == 0) {
+            break;
+        }
+        ESP_LOGD(TAG, "Pooled connection to %s:%d was closed by the server", conn.host, conn.port);
+        http_pool_conn_destroy(&conn);
+    }
+    free(conn.scheme);
+
+    if (client->transport_list) {
+        esp_transport_list_destroy(client->transport_list);
+    }
+    client->transport_list = conn.transport_list;
+    client->transport = conn.transport;
+    /* The transports may still point to the keep-alive settings, certificates and keys of the
+     * client that made them, which may be gone, so point them to those of this client */
+    esp_transport_handle_t t = esp_transport_list_get_transport(client->transport_list, "http");
+    if (t) {
+        init_common_tcp_transport(client, client->transport_cfg, t);
+    }
+#ifdef CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
+    t = esp_transport_list_get_transport(client->transport_list, "https");
+    if (t) {
+        init_common_tcp_transport(client, client->transport_cfg, t);
+        http_client_set_ssl_config(t, client->transport_cfg);
+    }
+#endif
+    return true;
+}
+
+/* Moves the connection of the client to the pool, if it is ready for another request */
+static bool http_pool_release(esp_http_client_handle_t client)
+{
+    if (client->transport_cfg == NULL || client->transport == NULL || client->transport_list == NULL) {
+        return false;
+    }
+    bool idle = client->state == HTTP_STATE_CONNECTED && !client->first_line_prepared;
+    bool done = client->state >= HTTP_STATE_RES_ON_DATA_START && http_should_keep_alive(client->parser) &&
+                esp_http_client_is_complete_data_received(client);
+    if (!idle && !done) {
+        return false;
+    }
+
+    size_t scheme_len = strlen(client->connection_info.scheme);
+    http_pool_conn_t conn = {
+        .scheme = malloc(scheme_len + 1 + strlen(client->connection_info.host) + 1),
+        .port = client->connection_info.port,
+        .transport_cfg = *client->transport_cfg,
+        .transport_list = client->transport_list,
+        .transport = client->transport,
+        .idle_since = xTaskGetTickCount(),
+    };
+    if (conn.scheme == NULL) {
+        return false;
+    }
+    memcpy(conn.transport_cfg_digest, client->transport_cfg_digest, HTTP_POOL_DIGEST_LEN);
+    strcpy(conn.scheme, client->connection_info.scheme);
+    conn.host = strcpy(conn.scheme + scheme_len + 1, client->connection_info.host);
+
+    ESP_LOGD(TAG, "Keep connection to %s:%d in the pool", conn.host, conn.port);
+    /* Make room by dropping the connection idle for the longest time, to the
+     * same server if it has too many already, else to any server */
+    http_pool_conn_t evicted = { 0 };
+    int free_slot = -1, oldest = -1, oldest_same = -1, same = 0;
+    portENTER_CRITICAL(&s_pool_lock);
+    for (int i = 0; i < CONFIG_ESP_HTTP_CLIENT_POOL_SIZE; i++) {
+        if (s_pool[i].scheme == NULL) {
+            free_slot = i;
+            continue;
+        }
+        if (oldest < 0 || conn.idle_since - s_pool[i].idle_since > conn.idle_since - s_pool[oldest].idle_since) {
+            oldest = i;
+        }
+        if (http_pool_same_server(&s_pool[i], conn.scheme, conn.host, conn.port, &conn.transport_cfg,
+                                  conn.transport_cfg_digest)) {
+            same++;
+            if (oldest_same < 0 || conn.idle_since - s_pool[i].idle_since > conn.idle_since - s_pool[oldest_same].idle_since) {
+                oldest_same = i;
+            }
+        }
+    }
+    int slot = same >= CONFIG_ESP_HTTP_CLIENT_POOL_MAX_PER_HOST ? oldest_same : free_slot >= 0 ? free_slot : oldest;
+    if (slot != free_slot) {
+        http_pool_take(slot, &evicted);
+    }
+    s_pool[slot] = conn;
+    portEXIT_CRITICAL(&s_pool_lock);
+
+    if (evicted.scheme) {
+        http_pool_conn_destroy(&evicted);
+    }
+    client->transport_list = NULL;
+    client->transport = NULL;
+    return true;
+}
+
+esp_err_t esp_http_client_pool_flush(void)
+{
+    http_pool_conn_t conn;
+    for (int i = 0; i < CONFIG_ESP_HTTP_CLIENT_POOL_SIZE; i++) {
+        portENTER_CRITICAL(&s_pool_lock);
+        http_pool_take(i, &conn);
+        portEXIT_CRITICAL(&s_pool_lock);
+        if (conn.scheme) {
+            http_pool_conn_destroy(&conn);
+        }
+    }
+    return ESP_OK;
+}
+#endif // CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+
+    esp_http_client_handle_t client;
+    esp_err_t ret = ESP_OK;
+    char *host_name;
+    bool _success;
+
+    _success = (
+                   (client                         = calloc(1, sizeof(esp_http_client_t)))           &&
+                   (client->parser                 = calloc(1, sizeof(struct http_parser)))          &&
+                   (client->parser_settings        = calloc(1, sizeof(struct http_parser_settings))) &&
+                   (client->auth_data              = calloc(1, sizeof(esp_http_auth_data_t)))        &&
+                   (client->request                = calloc(1, sizeof(esp_http_data_t)))             &&
+                   (client->request->headers       = http_header_init())                             &&
+                   (client->request->buffer        = calloc(1, sizeof(esp_http_buffer_t)))           &&
+                   (client->response               = calloc(1, sizeof(esp_http_data_t)))             &&
+#if CONFIG_ESP_HTTP_CLIENT_SAVE_RESPONSE_HEADERS
+                   (client->response->headers      = http_header_init())                             &&
+#endif // CONFIG_ESP_HTTP_CLIENT_SAVE_RESPONSE_HEADERS
+                   (client->response->buffer       = calloc(1, sizeof(esp_http_buffer_t)))
+               );
+
+    if (!_success) {
+        ESP_LOGE(TAG, "Error allocate memory");
+        goto error;
+    }
+
+    if (http_client_init_transports(client, config) != ESP_OK) {
+        goto error;
+    }
+
+#ifdef CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (config->save_client_session) {
+        client->session_ticket_state = SESSION_TICKET_NOT_SAVED;
+    }
+#endif
+
+#if CONFIG_ESP_HTTP_CLIENT_ENABLE_CUSTOM_TRANSPORT
+    if (config->transport) {
+        client->transport = config->transport;
+    }
+#endif
+#endif
+
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+    if (http_pool_supported(client, config)) {
+        /* Kept to make the transports again once they went to the pool */
+        client->transport_cfg = malloc(sizeof(esp_http_client_config_t));
+        if (client->transport_cfg == NULL) {
+            ESP_LOGE(TAG, "Error allocate memory");
+            goto error;
+        }
+        *client->transport_cfg = *config;
+        if (http_pool_digest_transports(config, client->transport_cfg_digest) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to compute the digest of the TLS settings, the connection won't be pooled");
+            free(client->transport_cfg);
+            client->transport_cfg = NULL;
+        }
+    }
 #endif
 
     if (_set_config(client, config) != ESP_OK) {
@@ -1129,6 +1484,9 @@ esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
     free(client->current_header_value);
     free(client->location);
     free(client->auth_header);
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+    free(client->transport_cfg);
+#endif
     free(client);
     return ESP_OK;
 }
@@ -1232,7 +1590,7 @@ esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *u
         }
         /* Free cached data if any, as we are closing this connection */
         esp_http_client_cached_buf_cleanup(client->response->buffer);
-        esp_http_client_close(client);
+        http_client_close(client, false);
     }
 
     if (old_host) {
@@ -1257,7 +1615,7 @@ esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *u
     if (old_port != client->connection_info.port) {
         /* Free cached data if any, as we are closing this connection */
         esp_http_client_cached_buf_cleanup(client->response->buffer);
-        esp_http_client_close(client);
+        http_client_close(client, false);
     }
 
     if (purl.field_data[UF_USERINFO].len) {
@@ -1656,6 +2014,25 @@ static esp_err_t esp_http_client_connect(esp_http_client_handle_t client)
         return err;
     }
     if (client->state < HTTP_STATE_CONNECTED) {
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+        if (client->transport_cfg) {
+            if (http_pool_acquire(client)) {
+                ESP_LOGD(TAG, "Reuse connection to: %s://%s:%d", client->connection_info.scheme, client->connection_info.host, client->connection_info.port);
+                client->state = HTTP_STATE_CONNECTED;
+                http_dispatch_event(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+                http_dispatch_event_to_event_loop(HTTP_EVENT_ON_CONNECTED, &client, sizeof(esp_http_client_handle_t));
+                return ESP_OK;
+            }
+            /* The transports went to the pool along with the previous connection */
+            if (client->transport_list == NULL && (err = http_client_init_transports(client, client->transport_cfg)) != ESP_OK) {
+                if (client->transport_list) {
+                    esp_transport_list_destroy(client->transport_list);
+                    client->transport_list = NULL;
+                }
+                return err;
+            }
+        }
+#endif
         /* Select transport only if not already set (e.g., async retry or custom transport) */
         if (!client->transport) {
             ESP_LOGD(TAG, "Begin connect to: %s://%s:%d", client->connection_info.scheme, client->connection_info.host, client->connection_info.port);
@@ -1899,17 +2276,28 @@ int esp_http_client_write(esp_http_client_handle_t client, const char *buffer, i
     return widx;
 }
 
-esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+static esp_err_t http_client_close(esp_http_client_handle_t client, bool reuse)
 {
     if (client->state > HTTP_STATE_INIT) {
         http_dispatch_event(client, HTTP_EVENT_DISCONNECTED, esp_transport_get_error_handle(client->transport), 0);
         http_dispatch_event_to_event_loop(HTTP_EVENT_DISCONNECTED, &client, sizeof(esp_http_client_handle_t));
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+        if (reuse && http_pool_release(client)) {
+            client->state = HTTP_STATE_INIT;
+            return ESP_OK;
+        }
+#endif
         client->state = HTTP_STATE_INIT;
         return esp_transport_close(client->transport);
     }
     return ESP_OK;
 }
 
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    return http_client_close(client, true);
+}
+
 esp_err_t esp_http_client_clear_response_buffer(esp_http_client_handle_t client)
 {
     if (client == NULL) {
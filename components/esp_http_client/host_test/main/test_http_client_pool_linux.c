@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "esp_http_client.h"
+#include "unity.h"
+
+#define TEST_SERVER_PORT    8124
+#define TEST_URL            "http://127.0.0.1:8124/ping"
+#define TEST_ROUNDS         5
+
+static const char response[] = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\npong";
+static const char cert[] = "-----BEGIN CERTIFICATE-----\nAAAA\n-----END CERTIFICATE-----\n";
+static const char other_cert[] = "-----BEGIN CERTIFICATE-----\nBBBB\n-----END CERTIFICATE-----\n";
+
+/* The test is the server, on a non-blocking listening socket, so that it can
+ * tell whether a request came on a new connection */
+static int server_start(void)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(TEST_SERVER_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    TEST_ASSERT_EQUAL(0, bind(fd, (struct sockaddr *)&addr, sizeof(addr)));
+    TEST_ASSERT_EQUAL(0, listen(fd, 4));
+    TEST_ASSERT_EQUAL(0, fcntl(fd, F_SETFL, O_NONBLOCK));
+    return fd;
+}
+
+/* Returns the connection the client has made since the last call, or -1 if it hasn't made one */
+static int server_accept(int listen_fd)
+{
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+        TEST_ASSERT_TRUE(errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    return fd;
+}
+
+/* Reads a request on the connection, returns false if the client closed it */
+static bool server_recv_request(int fd)
+{
+    char buf[256];
+    size_t len = 0;
+    while (len < sizeof(buf) - 1) {
+        int ret = recv(fd, buf + len, sizeof(buf) - 1 - len, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        TEST_ASSERT_GREATER_OR_EQUAL(0, ret);
+        if (ret == 0) {
+            return false;
+        }
+        len += ret;
+        buf[len] = '\0';
+        if (strstr(buf, "\r\n\r\n")) {
+            TEST_ASSERT_EQUAL(0, strncmp(buf, "GET /ping ", 10));
+            return true;
+        }
+    }
+    TEST_FAIL_MESSAGE("Request too long");
+    return false;
+}
+
+/* Sends a request with a new client and cleans it up, which leaves its connection in the pool.
+ * Returns the connection the request came on, *conn_fd if the client reused it. */
+static int do_request(int listen_fd, int conn_fd, const char *cert_pem, size_t cert_len)
+{
+    esp_http_client_config_t config = {
+        .url = TEST_URL,
+        .cert_pem = cert_pem,
+        .cert_len = cert_len,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_open(client, 0));
+
+    int fd = server_accept(listen_fd);
+    if (fd < 0) {
+        fd = conn_fd;
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+    TEST_ASSERT_TRUE(server_recv_request(fd));
+    TEST_ASSERT_EQUAL(sizeof(response) - 1, send(fd, response, sizeof(response) - 1, 0));
+
+    char body[8];
+    TEST_ASSERT_EQUAL(4, esp_http_client_fetch_headers(client));
+    TEST_ASSERT_EQUAL(200, esp_http_client_get_status_code(client));
+    TEST_ASSERT_EQUAL(4, esp_http_client_read(client, body, sizeof(body)));
+    TEST_ASSERT_EQUAL_MEMORY("pong", body, 4);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(client));
+    return fd;
+}
+
+TEST_CASE("Clients cleaned up leave their connection to the next client", "[esp_http_client][pool]")
+{
+    int listen_fd = server_start();
+    int fd = do_request(listen_fd, -1, NULL, 0);
+    for (int i = 0; i < TEST_ROUNDS; i++) {
+        TEST_ASSERT_EQUAL(fd, do_request(listen_fd, fd, NULL, 0));
+    }
+
+    /* Flushing the pool closes the connection, the next client makes a new one */
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_pool_flush());
+    TEST_ASSERT_FALSE(server_recv_request(fd));
+    int new_fd = do_request(listen_fd, -1, NULL, 0);
+    TEST_ASSERT_NOT_EQUAL(fd, new_fd);
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_pool_flush());
+    close(fd);
+    close(new_fd);
+    close(listen_fd);
+}
+
+TEST_CASE("Pooled connections are matched by the contents of the certificates", "[esp_http_client][pool]")
+{
+    int listen_fd = server_start();
+
+    /* The certificate of the client that made the connection is freed before the
+     * connection is reused by a client which gives the same one with its length */
+    char *cert_copy = strdup(cert);
+    TEST_ASSERT_NOT_NULL(cert_copy);
+    int fd = do_request(listen_fd, -1, cert_copy, 0);
+    free(cert_copy);
+    TEST_ASSERT_EQUAL(fd, do_request(listen_fd, fd, cert, sizeof(cert)));
+
+    /* A client with another certificate or with none doesn't take it */
+    int other_fd = do_request(listen_fd, -1, other_cert, 0);
+    TEST_ASSERT_NOT_EQUAL(fd, other_fd);
+    int plain_fd = do_request(listen_fd, -1, NULL, 0);
+    TEST_ASSERT_NOT_EQUAL(fd, plain_fd);
+    TEST_ASSERT_NOT_EQUAL(other_fd, plain_fd);
+
+    /* Each connection is still there for a client with the same settings */
+    TEST_ASSERT_EQUAL(fd, do_request(listen_fd, fd, cert, 0));
+    TEST_ASSERT_EQUAL(other_fd, do_request(listen_fd, other_fd, other_cert, sizeof(other_cert)));
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_pool_flush());
+    close(fd);
+    close(other_fd);
+    close(plain_fd);
+    close(listen_fd);
+}
+
+void app_main(void)
+{
+    printf("Running esp_http_client linux host test app\n");
+    unity_run_menu();
+}
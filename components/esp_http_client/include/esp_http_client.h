@@ -750,6 +750,9 @@ int64_t esp_http_client_get_content_range(esp_http_client_handle_t client);
 /**
  * @brief      Close http connection, still kept all http request resources
  *
+ * @note       With CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL, a kept-alive connection whose response has
+ *             been read completely is not closed but left in the pool, for the next request to the same server.
+ *
  * @param[in]  client  The esp_http_client handle
  *
  * @return
@@ -785,6 +788,19 @@ esp_err_t esp_http_client_clear_response_buffer(esp_http_client_handle_t client)
  */
 esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
 
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL || __DOXYGEN__
+/**
+ * @brief      Close the idle connections of the connection pool
+ *
+ *             Connections are otherwise closed once they have been idle for CONFIG_ESP_HTTP_CLIENT_POOL_IDLE_TIMEOUT_MS,
+ *             when the next client looks for a connection. Call this e.g. before the network interface goes down.
+ *
+ * @return
+ *     - ESP_OK
+ */
+esp_err_t esp_http_client_pool_flush(void);
+#endif
+
 /**
  * @brief      Get transport type
  *
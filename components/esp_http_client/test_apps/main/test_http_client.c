@@ -4,13 +4,20 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <esp_system.h>
 #include <esp_http_client.h>
 
 #include "unity.h"
 #include "test_utils.h"
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_http_server.h"
+#endif
 
 #define HOST  "httpbin.org"
 #define USERNAME  "user"
@@ -221,6 +228,157 @@ TEST_CASE("esp_http_client_close() and cleanup() should not dispatch duplicate d
     TEST_ASSERT_LESS_OR_EQUAL(1, disconnect_event_count);
 }
 
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+/* The connection pool is tested against a server on the loopback interface,
+ * which counts the connections it accepts */
+#define POOL_TEST_PORT      8123
+#define POOL_TEST_URL       "http://127.0.0.1:8123"
+#define POOL_TEST_ROUNDS    10
+#define POOL_TEST_CLIENTS   (CONFIG_ESP_HTTP_CLIENT_POOL_MAX_PER_HOST + 1)
+
+static int pool_test_accepted;
+
+static esp_err_t pool_test_open(httpd_handle_t hd, int sockfd)
+{
+    pool_test_accepted++;
+    return ESP_OK;
+}
+
+static esp_err_t pool_test_ping(httpd_req_t *req)
+{
+    return httpd_resp_sendstr(req, "pong");
+}
+
+/* Closes the connection after the response, which keeps it alive as far as the client knows */
+static esp_err_t pool_test_close(httpd_req_t *req)
+{
+    httpd_resp_sendstr(req, "pong");
+    return httpd_sess_trigger_close(req->handle, httpd_req_to_sockfd(req));
+}
+
+static httpd_handle_t pool_test_start_server(void)
+{
+    static const httpd_uri_t ping_uri = { .uri = "/ping", .method = HTTP_GET, .handler = pool_test_ping };
+    static const httpd_uri_t close_uri = { .uri = "/close", .method = HTTP_GET, .handler = pool_test_close };
+
+    test_case_uses_tcpip();
+    httpd_handle_t hd = NULL;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = POOL_TEST_PORT;
+    config.open_fn = pool_test_open;
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_start(&hd, &config));
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &ping_uri));
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &close_uri));
+    pool_test_accepted = 0;
+    return hd;
+}
+
+static void pool_test_stop_server(httpd_handle_t hd)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_pool_flush());
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+}
+
+/* Makes a request with a new client, which is left for the caller to clean up */
+static esp_http_client_handle_t pool_test_get_with_cert(const char *path, const char *cert_pem, size_t cert_len)
+{
+    char url[64];
+    snprintf(url, sizeof(url), "%s%s", POOL_TEST_URL, path);
+    esp_http_client_config_t config = {
+        .url = url,
+        .cert_pem = cert_pem,
+        .cert_len = cert_len,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_perform(client));
+    TEST_ASSERT_EQUAL(200, esp_http_client_get_status_code(client));
+    return client;
+}
+
+static esp_http_client_handle_t pool_test_get(const char *path)
+{
+    return pool_test_get_with_cert(path, NULL, 0);
+}
+
+TEST_CASE("esp_http_client_cleanup() leaves the connection to the next client", "[esp_http_client]")
+{
+    httpd_handle_t hd = pool_test_start_server();
+    for (int i = 0; i < POOL_TEST_ROUNDS; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(pool_test_get("/ping")));
+    }
+    TEST_ASSERT_EQUAL(1, pool_test_accepted);
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_pool_flush());
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(pool_test_get("/ping")));
+    TEST_ASSERT_EQUAL(2, pool_test_accepted);
+    pool_test_stop_server(hd);
+}
+
+TEST_CASE("esp_http_client doesn't reuse a pooled connection the server has closed", "[esp_http_client]")
+{
+    httpd_handle_t hd = pool_test_start_server();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(pool_test_get("/close")));
+    /* Let the server close the connection */
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(pool_test_get("/ping")));
+    TEST_ASSERT_EQUAL(2, pool_test_accepted);
+    pool_test_stop_server(hd);
+}
+
+TEST_CASE("esp_http_client pool keeps a limited number of connections to a server", "[esp_http_client]")
+{
+    esp_http_client_handle_t clients[POOL_TEST_CLIENTS];
+    httpd_handle_t hd = pool_test_start_server();
+    for (int i = 0; i < POOL_TEST_CLIENTS; i++) {
+        clients[i] = pool_test_get("/ping");
+    }
+    TEST_ASSERT_EQUAL(POOL_TEST_CLIENTS, pool_test_accepted);
+    for (int i = 0; i < POOL_TEST_CLIENTS; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(clients[i]));
+    }
+
+    /* Only CONFIG_ESP_HTTP_CLIENT_POOL_MAX_PER_HOST connections were kept */
+    for (int i = 0; i < POOL_TEST_CLIENTS; i++) {
+        clients[i] = pool_test_get("/ping");
+    }
+    TEST_ASSERT_EQUAL(POOL_TEST_CLIENTS + 1, pool_test_accepted);
+    for (int i = 0; i < POOL_TEST_CLIENTS; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(clients[i]));
+    }
+    pool_test_stop_server(hd);
+}
+
+TEST_CASE("esp_http_client pool compares the certificates of the clients by contents", "[esp_http_client]")
+{
+    static const char cert[] = "-----BEGIN CERTIFICATE-----\nAAAA\n-----END CERTIFICATE-----\n";
+    static const char other_cert[] = "-----BEGIN CERTIFICATE-----\nBBBB\n-----END CERTIFICATE-----\n";
+    char *cert_copy = strdup(cert);
+    TEST_ASSERT_NOT_NULL(cert_copy);
+
+    httpd_handle_t hd = pool_test_start_server();
+    /* The certificate of the client that made the connection is gone by the time it is reused,
+     * and the next client gives the same certificate with its length */
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(pool_test_get_with_cert("/ping", cert_copy, 0)));
+    free(cert_copy);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(pool_test_get_with_cert("/ping", cert, sizeof(cert))));
+    TEST_ASSERT_EQUAL(1, pool_test_accepted);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(pool_test_get_with_cert("/ping", other_cert, 0)));
+    TEST_ASSERT_EQUAL(2, pool_test_accepted);
+    pool_test_stop_server(hd);
+}
+
+TEST_CASE("esp_http_client closes pooled connections after the idle timeout", "[esp_http_client]")
+{
+    httpd_handle_t hd = pool_test_start_server();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(pool_test_get("/ping")));
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_ESP_HTTP_CLIENT_POOL_IDLE_TIMEOUT_MS + 100));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_cleanup(pool_test_get("/ping")));
+    TEST_ASSERT_EQUAL(2, pool_test_accepted);
+    pool_test_stop_server(hd);
+}
+#endif // CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+
 void app_main(void)
 {
     unity_run_menu();
@@ -0,0 +1,516 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_http_server.h"
+#include "esp_httpd_priv.h"
+#include "unity.h"
+
+#define TEST_SERVER_PORT    8123
+#define TEST_CLIENTS        500
+#define TEST_ROUNDS         20
+#define TEST_TIMEOUT_MS     10000
+
+/* The slow handler stands for a handler waiting on I/O, e.g. reading a file */
+#define TEST_SLOW_CLIENTS   32
+#define TEST_SLOW_ROUNDS    5
+#define TEST_SLOW_DELAY_MS  5
+#define TEST_WORKERS        4
+
+/* Routing microbenchmark, a REST API with a path parameter in every route */
+#define TEST_ROUTES         64
+#define TEST_LOOKUPS        200000
+
+/* Keep-alive requests made to check that the server doesn't allocate */
+#define TEST_ALLOC_CLIENTS  8
+#define TEST_ALLOC_ROUNDS   20
+
+static const char ping_request[] = "GET /ping HTTP/1.1\r\nHost: localhost\r\n\r\n";
+static const char slow_request[] = "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n";
+static const char response_body[] = "pong";
+
+static esp_err_t ping_handler(httpd_req_t *req)
+{
+    return httpd_resp_send(req, response_body, HTTPD_RESP_USE_STRLEN);
+}
+
+static esp_err_t slow_handler(httpd_req_t *req)
+{
+    vTaskDelay(pdMS_TO_TICKS(TEST_SLOW_DELAY_MS));
+    return httpd_resp_send(req, response_body, HTTPD_RESP_USE_STRLEN);
+}
+
+/* Uses the request headers, the query and the response headers, as a typical handler does */
+static esp_err_t session_handler(httpd_req_t *req)
+{
+    char value[16];
+    size_t value_len = sizeof(value);
+    if (httpd_req_get_hdr_value_str(req, "User-Agent", value, sizeof(value)) != ESP_OK ||
+        httpd_req_get_cookie_val(req, "sid", value, &value_len) != ESP_OK || strcmp(value, "1234") != 0 ||
+        httpd_req_get_url_query_str(req, value, sizeof(value)) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    return httpd_resp_send(req, response_body, HTTPD_RESP_USE_STRLEN);
+}
+
+static const httpd_uri_t ping_uri = {
+    .uri      = "/ping",
+    .method   = HTTP_GET,
+    .handler  = ping_handler,
+};
+
+static const httpd_uri_t slow_uri = {
+    .uri      = "/slow",
+    .method   = HTTP_GET,
+    .handler  = slow_handler,
+};
+
+static const httpd_uri_t session_uri = {
+    .uri      = "/session",
+    .method   = HTTP_GET,
+    .handler  = session_handler,
+};
+
+static esp_err_t dev_cfg_handler(httpd_req_t *req)
+{
+    char id[8];
+    char unused[8];
+    /* Fail the request, and thus close the connection, on a wrong value */
+    if (httpd_req_get_path_param(req, "id", id, sizeof(id)) != ESP_OK || strcmp(id, "42") != 0 ||
+        httpd_req_get_path_param(req, "cfg", unused, sizeof(unused)) != ESP_ERR_NOT_FOUND ||
+        httpd_req_get_path_param(req, "id", unused, 2) != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send(req, response_body, HTTPD_RESP_USE_STRLEN);
+}
+
+static const httpd_uri_t dev_cfg_uri = {
+    .uri      = "/api/dev/{id}/cfg",
+    .method   = HTTP_GET,
+    .handler  = dev_cfg_handler,
+};
+
+static const httpd_uri_t api_uri = {
+    .uri      = "/api/*",
+    .method   = HTTP_GET,
+    .handler  = ping_handler,
+};
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void raise_fd_limit(rlim_t needed)
+{
+    struct rlimit rl;
+    TEST_ASSERT_EQUAL(0, getrlimit(RLIMIT_NOFILE, &rl));
+    if (rl.rlim_cur < needed) {
+        TEST_ASSERT_MESSAGE(rl.rlim_max == RLIM_INFINITY || rl.rlim_max >= needed, "RLIMIT_NOFILE is too low for this test");
+        rl.rlim_cur = needed;
+        TEST_ASSERT_EQUAL(0, setrlimit(RLIMIT_NOFILE, &rl));
+    }
+}
+
+static int connect_client(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(TEST_SERVER_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+    int ret;
+    do {
+        ret = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+    } while (ret < 0 && errno == EINTR);
+    TEST_ASSERT_EQUAL_MESSAGE(0, ret, strerror(errno));
+    /* The server runs in a task of the same priority, so never block the scheduler in a socket call */
+    TEST_ASSERT_EQUAL(0, fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK));
+    return fd;
+}
+
+static void send_request(int fd, const char *request)
+{
+    size_t sent = 0;
+    while (sent < strlen(request)) {
+        ssize_t ret = send(fd, request + sent, strlen(request) - sent, 0);
+        if (ret < 0) {
+            TEST_ASSERT_MESSAGE(errno == EAGAIN || errno == EINTR, strerror(errno));
+            vTaskDelay(1);
+            continue;
+        }
+        sent += ret;
+    }
+}
+
+/* Reads a complete response on a keep-alive connection, the server answers with a fixed size body */
+static void recv_response(int fd, int64_t deadline)
+{
+    char buf[256];
+    size_t len = 0;
+    while (len < strlen(response_body) || memcmp(buf + len - strlen(response_body), response_body, strlen(response_body))) {
+        TEST_ASSERT_MESSAGE(now_us() < deadline, "timeout waiting for a response");
+        ssize_t ret = recv(fd, buf + len, sizeof(buf) - 1 - len, 0);
+        if (ret < 0) {
+            TEST_ASSERT_MESSAGE(errno == EAGAIN || errno == EINTR, strerror(errno));
+            vTaskDelay(1);
+            continue;
+        }
+        TEST_ASSERT_NOT_EQUAL_MESSAGE(0, ret, "connection closed by the server");
+        len += ret;
+        TEST_ASSERT_LESS_THAN(sizeof(buf) - 1, len);
+    }
+    buf[len] = '\0';
+    TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 200 OK", buf, strlen("HTTP/1.1 200 OK"));
+}
+
+static httpd_handle_t start_router_server(int max_uri_handlers)
+{
+    httpd_handle_t hd = NULL;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = TEST_SERVER_PORT;
+    config.max_uri_handlers = max_uri_handlers;
+    config.uri_match_fn = httpd_uri_match_wildcard;
+    config.task_priority = uxTaskPriorityGet(NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_start(&hd, &config));
+    return hd;
+}
+
+static httpd_handle_t start_test_server(int clients, int workers)
+{
+    /* Client and server ends of every connection, plus the server's own sockets */
+    raise_fd_limit(2 * clients + 64);
+
+    httpd_handle_t hd = NULL;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = TEST_SERVER_PORT;
+    config.max_open_sockets = clients + 8;
+    config.backlog_conn = clients;
+    config.max_uri_handlers = 3;
+    config.worker_count = workers;
+    /* Time-slice with the test task, see connect_client() */
+    config.task_priority = uxTaskPriorityGet(NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_start(&hd, &config));
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &ping_uri));
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &slow_uri));
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &session_uri));
+    return hd;
+}
+
+/* Runs rounds of requests over all the connections and returns the request rate */
+static int64_t run_requests(const int *fds, int clients, int rounds, const char *request)
+{
+    int64_t start = now_us();
+    for (int round = 0; round < rounds; round++) {
+        /* Keep a request in flight on every connection at the same time */
+        for (int i = 0; i < clients; i++) {
+            send_request(fds[i], request);
+        }
+        int64_t deadline = now_us() + TEST_TIMEOUT_MS * 1000LL;
+        for (int i = 0; i < clients; i++) {
+            recv_response(fds[i], deadline);
+        }
+    }
+    int64_t elapsed_us = now_us() - start;
+
+    int64_t rate = clients * rounds * 1000000LL / (elapsed_us ? elapsed_us : 1);
+    printf("%d clients, %d requests in %lld ms, %lld req/s\n", clients, clients * rounds,
+           (long long)(elapsed_us / 1000), (long long)rate);
+    return rate;
+}
+
+static int64_t run_clients(int clients, int workers, int rounds, const char *request)
+{
+    static int fds[TEST_CLIENTS];
+    TEST_ASSERT_LESS_THAN(TEST_CLIENTS + 1, clients);
+
+    httpd_handle_t hd = start_test_server(clients, workers);
+    for (int i = 0; i < clients; i++) {
+        fds[i] = connect_client();
+    }
+    int64_t rate = run_requests(fds, clients, rounds, request);
+    for (int i = 0; i < clients; i++) {
+        close(fds[i]);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+    return rate;
+}
+
+TEST_CASE("Server handles 500 concurrent keep-alive clients", "[esp_http_server]")
+{
+    run_clients(TEST_CLIENTS, 0, TEST_ROUNDS, ping_request);
+}
+
+TEST_CASE("Server handles 500 concurrent keep-alive clients with workers", "[esp_http_server]")
+{
+    run_clients(TEST_CLIENTS, TEST_WORKERS, TEST_ROUNDS, ping_request);
+}
+
+TEST_CASE("Workers process slow requests concurrently", "[esp_http_server]")
+{
+    printf("1 worker: ");
+    int64_t rate_single = run_clients(TEST_SLOW_CLIENTS, 1, TEST_SLOW_ROUNDS, slow_request);
+    printf("%d workers: ", TEST_WORKERS);
+    int64_t rate_multi = run_clients(TEST_SLOW_CLIENTS, TEST_WORKERS, TEST_SLOW_ROUNDS, slow_request);
+
+    /* Each worker waits in its own handler, so the rate grows with the number of workers */
+    TEST_ASSERT_GREATER_THAN(rate_single * 3 / 2, rate_multi);
+}
+
+TEST_CASE("Router passes path parameters to the handler", "[esp_http_server]")
+{
+    httpd_handle_t hd = start_router_server(2);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &dev_cfg_uri));
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &api_uri));
+
+    int fd = connect_client();
+    int64_t deadline = now_us() + TEST_TIMEOUT_MS * 1000LL;
+    send_request(fd, "GET /api/dev/42/cfg?verbose=1 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    recv_response(fd, deadline);
+    /* Handled by the wildcard handler, registered after the one with the parameter */
+    send_request(fd, "GET /api/dev/42/cfg/more HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    recv_response(fd, deadline);
+    close(fd);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+}
+
+/* Templates as matched before path parameters were supported, then with them */
+static const struct {
+    const char *template;
+    const char *uri;
+    bool match;
+} wildcard_cases[] = {
+    { "*",                  "",                     true  },
+    { "?",                  "",                     false },
+    { "/api/?",             "/api",                 true  },
+    { "/api/?",             "/api/",                true  },
+    { "/api/?",             "/apix",                false },
+    { "/api/*",             "/api/status",          true  },
+    { "/api/*",             "/api",                 false },
+    { "/api/?*",            "/api",                 true  },
+    { "/api/?*",            "/api/status",          true  },
+    { "/api/?*",            "/apix",                false },
+    { "/api/*?",            "/api",                 true  },
+    { "/api/*/cfg",         "/api/*/cfg",           true  },
+    { "/api/*/cfg",         "/api/12/cfg",          false },
+    { "/api/status",        "/api/status",          true  },
+    { "/api/status",        "/api/statu",           false },
+    /* A path parameter matches any non empty segment, including its own literal text */
+    { "/api/dev/{id}/cfg",  "/api/dev/12/cfg",      true  },
+    { "/api/dev/{id}/cfg",  "/api/dev/{id}/cfg",    true  },
+    { "/api/dev/{id}/cfg",  "/api/dev//cfg",        false },
+    { "/api/dev/{id}/cfg",  "/api/dev/12/13/cfg",   false },
+    { "/api/dev/{id}",      "/api/dev/12/",         false },
+    { "/api/dev/{id}/?",    "/api/dev/12/",         true  },
+    { "/api/dev/{id}/*",    "/api/dev/12/cfg",      true  },
+    { "/api/dev/{id}/*",    "/api/dev/12",          false },
+    /* Braces which don't span a whole segment are taken literally */
+    { "/api/dev/x{id}",     "/api/dev/x12",         false },
+    { "/api/dev/x{id}",     "/api/dev/x{id}",       true  },
+    { "/api/dev/{}/cfg",    "/api/dev/12/cfg",      false },
+    { "/api/dev/{}/cfg",    "/api/dev/{}/cfg",      true  },
+};
+
+#if CONFIG_HTTPD_URI_ROUTER
+static bool router_matches(httpd_handle_t handle, const char *uri)
+{
+    struct httpd_data *hd = (struct httpd_data *) handle;
+    httpd_uri_t *handler = NULL;
+    httpd_err_code_t err;
+    xSemaphoreTake(hd->hd_calls_lock, portMAX_DELAY);
+    bool found = httpd_router_find(hd, uri, strlen(uri), HTTP_GET, &err, &handler);
+    xSemaphoreGive(hd->hd_calls_lock);
+    TEST_ASSERT_TRUE(found);
+    return handler != NULL;
+}
+#endif /* CONFIG_HTTPD_URI_ROUTER */
+
+TEST_CASE("Wildcard templates match as before, along with path parameters", "[esp_http_server]")
+{
+#if CONFIG_HTTPD_URI_ROUTER
+    httpd_handle_t hd = start_router_server(1);
+#endif
+    for (int i = 0; i < sizeof(wildcard_cases) / sizeof(wildcard_cases[0]); i++) {
+        const char *template = wildcard_cases[i].template;
+        const char *uri = wildcard_cases[i].uri;
+        TEST_ASSERT_EQUAL_MESSAGE(wildcard_cases[i].match, httpd_uri_match_wildcard(template, uri, strlen(uri)), template);
+#if CONFIG_HTTPD_URI_ROUTER
+        /* The router agrees with the matcher it stands for */
+        httpd_uri_t route = {
+            .uri      = template,
+            .method   = HTTP_GET,
+            .handler  = ping_handler,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &route));
+        TEST_ASSERT_EQUAL_MESSAGE(wildcard_cases[i].match, router_matches(hd, uri), template);
+        TEST_ASSERT_EQUAL(ESP_OK, httpd_unregister_uri_handler(hd, template, HTTP_GET));
+#endif
+    }
+#if CONFIG_HTTPD_URI_ROUTER
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+#endif
+}
+
+static bool handler_entered;
+static bool handler_released;
+
+static esp_err_t unregistered_handler(httpd_req_t *req)
+{
+    __atomic_store_n(&handler_entered, true, __ATOMIC_SEQ_CST);
+    while (!__atomic_load_n(&handler_released, __ATOMIC_SEQ_CST)) {
+        vTaskDelay(1);
+    }
+    /* The template of the handler is still there, though it has been unregistered meanwhile */
+    char id[8];
+    if (httpd_req_get_path_param(req, "id", id, sizeof(id)) != ESP_OK || strcmp(id, "42") != 0) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send(req, response_body, HTTPD_RESP_USE_STRLEN);
+}
+
+TEST_CASE("Handler unregistered while it runs is freed once it returns", "[esp_http_server]")
+{
+    const httpd_uri_t dev_uri = {
+        .uri      = "/dev/{id}",
+        .method   = HTTP_GET,
+        .handler  = unregistered_handler,
+    };
+    handler_entered = false;
+    handler_released = false;
+    httpd_handle_t hd = start_router_server(1);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &dev_uri));
+
+    int fd = connect_client();
+    int64_t deadline = now_us() + TEST_TIMEOUT_MS * 1000LL;
+    send_request(fd, "GET /dev/42 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    while (!__atomic_load_n(&handler_entered, __ATOMIC_SEQ_CST)) {
+        TEST_ASSERT_MESSAGE(now_us() < deadline, "timeout waiting for the handler");
+        vTaskDelay(1);
+    }
+
+    /* Doesn't wait for the handler, whose slot can be taken again at once */
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_unregister_uri_handler(hd, dev_uri.uri, HTTP_GET));
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &ping_uri));
+    __atomic_store_n(&handler_released, true, __ATOMIC_SEQ_CST);
+    recv_response(fd, deadline);
+
+    close(fd);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+}
+
+#if CONFIG_HTTPD_URI_ROUTER
+/* The lookup of the server before the router, kept as a reference */
+static const char *scan_handlers(char templates[][32], int count, const char *uri, size_t len)
+{
+    for (int i = 0; i < count; i++) {
+        if (httpd_uri_match_wildcard(templates[i], uri, len)) {
+            return templates[i];
+        }
+    }
+    return NULL;
+}
+
+TEST_CASE("Router looks up handlers faster than scanning them", "[esp_http_server]")
+{
+    static char templates[TEST_ROUTES][32];
+    static char uris[TEST_ROUTES][32];
+
+    httpd_handle_t hd = start_router_server(TEST_ROUTES);
+    for (int i = 0; i < TEST_ROUTES; i++) {
+        snprintf(templates[i], sizeof(templates[i]), "/api/v1/res%02d/{id}/cfg", i);
+        snprintf(uris[i], sizeof(uris[i]), "/api/v1/res%02d/%d/cfg", i, i * 7);
+        httpd_uri_t route = {
+            .uri      = templates[i],
+            .method   = HTTP_GET,
+            .handler  = ping_handler,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &route));
+    }
+
+    int64_t start = now_us();
+    for (int i = 0; i < TEST_LOOKUPS; i++) {
+        const char *uri = uris[i % TEST_ROUTES];
+        TEST_ASSERT_EQUAL_PTR(templates[i % TEST_ROUTES], scan_handlers(templates, TEST_ROUTES, uri, strlen(uri)));
+    }
+    int64_t scan_us = now_us() - start;
+
+    start = now_us();
+    for (int i = 0; i < TEST_LOOKUPS; i++) {
+        const char *uri = uris[i % TEST_ROUTES];
+        httpd_uri_t *handler = NULL;
+        httpd_err_code_t err;
+        TEST_ASSERT_TRUE(httpd_router_find(hd, uri, strlen(uri), HTTP_GET, &err, &handler));
+        TEST_ASSERT_NOT_NULL(handler);
+        TEST_ASSERT_EQUAL_STRING(templates[i % TEST_ROUTES], handler->uri);
+    }
+    int64_t router_us = now_us() - start;
+
+    printf("%d routes: scan %lld ns/lookup, router %lld ns/lookup\n", TEST_ROUTES,
+           (long long)(scan_us * 1000 / TEST_LOOKUPS), (long long)(router_us * 1000 / TEST_LOOKUPS));
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+    TEST_ASSERT_LESS_THAN(scan_us, router_us * 2);
+}
+#endif /* CONFIG_HTTPD_URI_ROUTER */
+
+#if CONFIG_HTTPD_SESS_ARENA && CONFIG_HTTPD_ALLOC_STATS
+static const char session_request[] = "GET /session?lang=en HTTP/1.1\r\nHost: localhost\r\n"
+                                      "User-Agent: test\r\nCookie: theme=dark; sid=1234\r\n\r\n";
+
+static void check_no_alloc(int workers)
+{
+    static int fds[TEST_ALLOC_CLIENTS];
+    httpd_handle_t hd = start_test_server(TEST_ALLOC_CLIENTS, workers);
+    for (int i = 0; i < TEST_ALLOC_CLIENTS; i++) {
+        fds[i] = connect_client();
+    }
+    /* The first request of each session allocates its buffer */
+    run_requests(fds, TEST_ALLOC_CLIENTS, 1, session_request);
+
+    uint32_t allocs = httpd_get_alloc_count();
+    run_requests(fds, TEST_ALLOC_CLIENTS, TEST_ALLOC_ROUNDS, session_request);
+    uint32_t steady_allocs = httpd_get_alloc_count() - allocs;
+    printf("%" PRIu32 " allocations for %d requests\n", steady_allocs, TEST_ALLOC_CLIENTS * TEST_ALLOC_ROUNDS);
+
+    for (int i = 0; i < TEST_ALLOC_CLIENTS; i++) {
+        close(fds[i]);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+    TEST_ASSERT_EQUAL(0, steady_allocs);
+}
+
+TEST_CASE("Keep-alive requests don't allocate from the heap", "[esp_http_server]")
+{
+    check_no_alloc(0);
+}
+
+TEST_CASE("Keep-alive requests don't allocate from the heap with workers", "[esp_http_server]")
+{
+    check_no_alloc(TEST_WORKERS);
+}
+#endif /* CONFIG_HTTPD_SESS_ARENA && CONFIG_HTTPD_ALLOC_STATS */
+
+void app_main(void)
+{
+    printf("Running esp_http_server linux host test app\n");
+    unity_run_menu();
+}
@@ -0,0 +1,332 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/param.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_http_server.h"
+#include "unity.h"
+
+#define TEST_SERVER_PORT    8124
+#define TEST_FILE_SIZE      (8 * 1024 * 1024)
+#define TEST_FILE_ROUNDS    4
+/* Block size of the file server example */
+#define TEST_CHUNK_SIZE     8192
+#define TEST_TIMEOUT_S      10
+
+/* Byte at a given offset of the test file and of the mapped region */
+#define TEST_BYTE(off)      ((uint8_t) ((off) % 251))
+
+static char file_path[] = "/tmp/httpd_send_file_XXXXXX";
+static uint8_t *mapped;
+
+static esp_err_t chunked_handler(httpd_req_t *req)
+{
+    /* The way the file server example sends a file */
+    static char chunk[TEST_CHUNK_SIZE];
+    int fd = open(file_path, O_RDONLY);
+    if (fd < 0) {
+        return ESP_FAIL;
+    }
+    ssize_t len;
+    do {
+        do {
+            len = read(fd, chunk, sizeof(chunk));
+        } while (len < 0 && errno == EINTR);
+        if (len < 0 || httpd_resp_send_chunk(req, chunk, len) != ESP_OK) {
+            close(fd);
+            return ESP_FAIL;
+        }
+    } while (len > 0);
+    close(fd);
+    return ESP_OK;
+}
+
+static esp_err_t send_file_handler(httpd_req_t *req)
+{
+    int fd = open(file_path, O_RDONLY);
+    if (fd < 0) {
+        return ESP_FAIL;
+    }
+    esp_err_t ret = httpd_resp_send_file(req, fd, 0, HTTPD_RESP_USE_FILE_SIZE);
+    close(fd);
+    return ret;
+}
+
+static esp_err_t mapped_handler(httpd_req_t *req)
+{
+    return httpd_resp_send_mapped(req, mapped, TEST_FILE_SIZE);
+}
+
+static const httpd_uri_t file_uris[] = {
+    { .uri = "/chunked", .method = HTTP_GET, .handler = chunked_handler },
+    { .uri = "/sendfile", .method = HTTP_GET, .handler = send_file_handler },
+    { .uri = "/mapped", .method = HTTP_GET, .handler = mapped_handler },
+};
+
+/* Response as seen by the client */
+struct test_response {
+    int status;
+    size_t body_len;
+    size_t content_range_first;
+    bool valid;                     /*!< The body has the bytes of the file at the offset of the Content-Range */
+};
+
+/* Buffered reader of the client */
+struct test_reader {
+    int fd;
+    char buf[16384];
+    size_t pos;
+    size_t len;
+};
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool reader_fill(struct test_reader *rd)
+{
+    if (rd->pos < rd->len) {
+        return true;
+    }
+    ssize_t ret;
+    do {
+        ret = recv(rd->fd, rd->buf, sizeof(rd->buf), 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0) {
+        return false;
+    }
+    rd->pos = 0;
+    rd->len = ret;
+    return true;
+}
+
+static bool reader_line(struct test_reader *rd, char *line, size_t size)
+{
+    size_t len = 0;
+    while (reader_fill(rd)) {
+        char c = rd->buf[rd->pos++];
+        if (c == '\n') {
+            line[len > 0 && line[len - 1] == '\r' ? len - 1 : len] = '\0';
+            return true;
+        }
+        if (len + 1 < size) {
+            line[len++] = c;
+        }
+    }
+    return false;
+}
+
+/* Reads len bytes of the body, checking them against the file from offset */
+static bool reader_body(struct test_reader *rd, size_t len, size_t *offset, bool *valid)
+{
+    while (len > 0) {
+        if (!reader_fill(rd)) {
+            return false;
+        }
+        size_t n = MIN(len, rd->len - rd->pos);
+        for (size_t i = 0; i < n; i++) {
+            if ((uint8_t) rd->buf[rd->pos + i] != TEST_BYTE(*offset + i)) {
+                *valid = false;
+            }
+        }
+        rd->pos += n;
+        *offset += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool read_response(struct test_reader *rd, struct test_response *resp)
+{
+    char line[256];
+    long long content_len = -1;
+    bool chunked = false;
+
+    memset(resp, 0, sizeof(*resp));
+    if (!reader_line(rd, line, sizeof(line)) || sscanf(line, "HTTP/1.1 %d", &resp->status) != 1) {
+        return false;
+    }
+    while (reader_line(rd, line, sizeof(line)) && line[0]) {
+        sscanf(line, "Content-Length: %lld", &content_len);
+        sscanf(line, "Content-Range: bytes %zu-", &resp->content_range_first);
+        if (strcmp(line, "Transfer-Encoding: chunked") == 0) {
+            chunked = true;
+        }
+    }
+
+    size_t offset = resp->content_range_first;
+    resp->valid = true;
+    if (!chunked) {
+        resp->body_len = content_len;
+        return content_len >= 0 && reader_body(rd, content_len, &offset, &resp->valid);
+    }
+    size_t chunk_len;
+    do {
+        if (!reader_line(rd, line, sizeof(line)) || sscanf(line, "%zx", &chunk_len) != 1 ||
+            !reader_body(rd, chunk_len, &offset, &resp->valid) || !reader_line(rd, line, sizeof(line))) {
+            return false;
+        }
+        resp->body_len += chunk_len;
+    } while (chunk_len > 0);
+    return true;
+}
+
+/* Client running in a thread of the host, as it blocks in the socket calls */
+struct test_client {
+    const char *request;
+    int rounds;
+    struct test_response resp;
+    bool ok;
+    int64_t elapsed_us;
+    volatile bool done;
+};
+
+static void *client_thread(void *arg)
+{
+    struct test_client *client = arg;
+    struct test_reader *rd = calloc(1, sizeof(struct test_reader));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(TEST_SERVER_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    struct timeval tv = { .tv_sec = TEST_TIMEOUT_S };
+    rd->fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(rd->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    client->ok = connect(rd->fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+
+    int64_t start = now_us();
+    for (int i = 0; client->ok && i < client->rounds; i++) {
+        client->ok = send(rd->fd, client->request, strlen(client->request), 0) == strlen(client->request) &&
+                     read_response(rd, &client->resp);
+    }
+    client->elapsed_us = now_us() - start;
+
+    close(rd->fd);
+    free(rd);
+    client->done = true;
+    return NULL;
+}
+
+static void run_client(struct test_client *client)
+{
+    /* The thread must not take the signals driving the FreeRTOS scheduler */
+    sigset_t all, old;
+    pthread_t thread;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    int ret = pthread_create(&thread, NULL, client_thread, client);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    TEST_ASSERT_EQUAL(0, ret);
+
+    /* Let the server task run meanwhile */
+    while (!client->done) {
+        vTaskDelay(1);
+    }
+    pthread_join(thread, NULL);
+    TEST_ASSERT_MESSAGE(client->ok, "request failed");
+}
+
+static void get(const char *request, int expected_status, size_t expected_len, size_t expected_first)
+{
+    struct test_client client = { .request = request, .rounds = 1 };
+    run_client(&client);
+    TEST_ASSERT_EQUAL(expected_status, client.resp.status);
+    TEST_ASSERT_EQUAL(expected_len, client.resp.body_len);
+    TEST_ASSERT_EQUAL(expected_first, client.resp.content_range_first);
+    TEST_ASSERT_MESSAGE(client.resp.valid, "wrong body");
+}
+
+static int64_t download_rate(const char *request)
+{
+    struct test_client client = { .request = request, .rounds = TEST_FILE_ROUNDS };
+    run_client(&client);
+    TEST_ASSERT_EQUAL(200, client.resp.status);
+    TEST_ASSERT_EQUAL(TEST_FILE_SIZE, client.resp.body_len);
+    TEST_ASSERT_MESSAGE(client.resp.valid, "wrong body");
+
+    int64_t rate = (int64_t) TEST_FILE_SIZE * TEST_FILE_ROUNDS / (client.elapsed_us ? client.elapsed_us : 1);
+    printf("%d x %d bytes in %lld ms, %lld MB/s\n", TEST_FILE_ROUNDS, TEST_FILE_SIZE,
+           (long long)(client.elapsed_us / 1000), (long long)rate);
+    return rate;
+}
+
+static httpd_handle_t start_file_server(void)
+{
+    mapped = malloc(TEST_FILE_SIZE);
+    TEST_ASSERT_NOT_NULL(mapped);
+    for (size_t i = 0; i < TEST_FILE_SIZE; i++) {
+        mapped[i] = TEST_BYTE(i);
+    }
+    int fd = mkstemp(file_path);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+    TEST_ASSERT_EQUAL(TEST_FILE_SIZE, write(fd, mapped, TEST_FILE_SIZE));
+    close(fd);
+
+    httpd_handle_t hd = NULL;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = TEST_SERVER_PORT;
+    config.ctrl_port += 1;
+    config.task_priority = uxTaskPriorityGet(NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_start(&hd, &config));
+    for (int i = 0; i < sizeof(file_uris) / sizeof(file_uris[0]); i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &file_uris[i]));
+    }
+    return hd;
+}
+
+static void stop_file_server(httpd_handle_t hd)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+    unlink(file_path);
+    strcpy(file_path + strlen(file_path) - 6, "XXXXXX");
+    free(mapped);
+}
+
+TEST_CASE("Send file honours byte ranges", "[esp_http_server]")
+{
+    httpd_handle_t hd = start_file_server();
+    get("GET /sendfile HTTP/1.1\r\nHost: localhost\r\nRange: bytes=100-199\r\n\r\n", 206, 100, 100);
+    get("GET /sendfile HTTP/1.1\r\nHost: localhost\r\nRange: bytes=-10\r\n\r\n", 206, 10, TEST_FILE_SIZE - 10);
+    get("GET /sendfile HTTP/1.1\r\nHost: localhost\r\nRange: bytes=8388600-\r\n\r\n", 206, 8, 8388600);
+    get("GET /sendfile HTTP/1.1\r\nHost: localhost\r\nRange: bytes=8388608-\r\n\r\n", 416, 0, 0);
+    /* Multiple ranges are not supported, the whole file is sent */
+    get("GET /sendfile HTTP/1.1\r\nHost: localhost\r\nRange: bytes=0-1,4-5\r\n\r\n", 200, TEST_FILE_SIZE, 0);
+    get("GET /mapped HTTP/1.1\r\nHost: localhost\r\nRange: bytes=5000-5999\r\n\r\n", 206, 1000, 5000);
+    get("GET /mapped HTTP/1.1\r\nHost: localhost\r\n\r\n", 200, TEST_FILE_SIZE, 0);
+    stop_file_server(hd);
+}
+
+TEST_CASE("Send file is not slower than sending chunks", "[esp_http_server]")
+{
+    httpd_handle_t hd = start_file_server();
+    printf("chunked: ");
+    int64_t rate_chunked = download_rate("GET /chunked HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    printf("send file: ");
+    int64_t rate_send_file = download_rate("GET /sendfile HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    printf("mapped: ");
+    download_rate("GET /mapped HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    stop_file_server(hd);
+
+    /* The gain is modest over loopback, so only fail on a clear regression */
+    TEST_ASSERT_GREATER_OR_EQUAL(rate_chunked * 3 / 4, rate_send_file);
+}
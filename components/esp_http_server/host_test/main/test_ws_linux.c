@@ -0,0 +1,558 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "psa/crypto.h"
+#include "esp_http_server.h"
+#include "esp_httpd_priv.h"
+#include "unity.h"
+
+#define TEST_SERVER_PORT    8125
+#define TEST_TIMEOUT_MS     10000
+#define TEST_WS_MAX_LEN     (128 * 1024)
+
+/* Live dashboard pushed to the clients with httpd_ws_broadcast() */
+#define TEST_WS_CLIENTS     32
+#define TEST_WS_MESSAGES    20
+#define TEST_WS_LARGE_LEN   60000
+#define TEST_WS_LARGE_MESSAGES  64
+
+/* Unmasking microbenchmark, a second of a 1-4 MB/s telemetry stream per round */
+#define TEST_UNMASK_LEN     (1024 * 1024)
+#define TEST_UNMASK_ROUNDS  64
+
+static const uint8_t mask_key[4] = { 0x12, 0x34, 0x56, 0x78 };
+
+/* The byte loop httpd_ws_unmask_payload() used to be */
+static void unmask_bytes(uint8_t *payload, size_t len, const uint8_t *key, size_t mask_offset)
+{
+    for (size_t idx = 0; idx < len; idx++) {
+        payload[idx] = (payload[idx] ^ key[(idx + mask_offset) % 4]);
+    }
+}
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+TEST_CASE("WebSocket unmasking matches the byte loop", "[esp_http_server]")
+{
+    uint8_t input[300];
+    uint8_t expected[sizeof(input)];
+    uint8_t actual[sizeof(input) + 8];
+    for (size_t i = 0; i < sizeof(input); i++) {
+        input[i] = rand();
+    }
+
+    /* Every alignment of the payload, offset in the mask key and length around the word size */
+    for (size_t align = 0; align < 8; align++) {
+        for (size_t mask_offset = 0; mask_offset < 8; mask_offset++) {
+            for (size_t len = 0; len < sizeof(input); len += (len < 40 ? 1 : 37)) {
+                memcpy(expected, input, len);
+                unmask_bytes(expected, len, mask_key, mask_offset);
+                memcpy(actual + align, input, len);
+                httpd_ws_unmask_payload(actual + align, len, mask_key, mask_offset);
+                TEST_ASSERT_EQUAL_MEMORY(expected, actual + align, len);
+            }
+        }
+    }
+}
+
+static int64_t unmask_rate(void (*unmask)(uint8_t *, size_t, const uint8_t *, size_t), uint8_t *buf)
+{
+    int64_t start = now_us();
+    for (int i = 0; i < TEST_UNMASK_ROUNDS; i++) {
+        /* Odd offsets, as for a payload following a header of 2 + 4 bytes */
+        unmask(buf + 6, TEST_UNMASK_LEN, mask_key, i);
+    }
+    int64_t elapsed_us = now_us() - start;
+
+    int64_t rate = (int64_t) TEST_UNMASK_LEN * TEST_UNMASK_ROUNDS / (elapsed_us ? elapsed_us : 1);
+    printf("%d x %d bytes in %lld us, %lld MB/s\n", TEST_UNMASK_ROUNDS, TEST_UNMASK_LEN,
+           (long long)elapsed_us, (long long)rate);
+    return rate;
+}
+
+TEST_CASE("WebSocket unmasking is faster than the byte loop", "[esp_http_server]")
+{
+    uint8_t *buf = calloc(1, TEST_UNMASK_LEN + 8);
+    TEST_ASSERT_NOT_NULL(buf);
+    printf("byte loop: ");
+    int64_t rate_bytes = unmask_rate(unmask_bytes, buf);
+    printf("httpd_ws_unmask_payload: ");
+    int64_t rate_words = unmask_rate(httpd_ws_unmask_payload, buf);
+    free(buf);
+
+    TEST_ASSERT_GREATER_THAN(rate_bytes, rate_words);
+}
+
+/* Server side sockets of the clients that asked not to get broadcasts */
+static int muted_fds[TEST_WS_CLIENTS];
+static int muted_count;
+
+/* Set while a handler holds its session, until the test releases it */
+static bool handler_waiting;
+static bool handler_released;
+
+/* Results of the broadcasts, reported by the server task */
+static int bcast_sent;
+static int bcast_dropped;
+static int bcast_failed;
+
+static esp_err_t echo_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        /* Handshake */
+        return ESP_OK;
+    }
+    httpd_ws_frame_t frame = { 0 };
+    esp_err_t ret = httpd_ws_recv_frame_zero_copy(req, &frame, TEST_WS_MAX_LEN);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (frame.len == 4 && memcmp(frame.payload, "mute", 4) == 0 && muted_count < TEST_WS_CLIENTS) {
+        muted_fds[muted_count++] = httpd_req_to_sockfd(req);
+    }
+    /* "wait" is echoed once released, "hold" is not echoed */
+    if (frame.len == 4 && (memcmp(frame.payload, "wait", 4) == 0 || memcmp(frame.payload, "hold", 4) == 0)) {
+        __atomic_store_n(&handler_waiting, true, __ATOMIC_SEQ_CST);
+        while (!__atomic_load_n(&handler_released, __ATOMIC_SEQ_CST)) {
+            vTaskDelay(1);
+        }
+        __atomic_store_n(&handler_waiting, false, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&handler_released, false, __ATOMIC_SEQ_CST);
+        if (frame.payload[0] == 'h') {
+            return ESP_OK;
+        }
+    }
+    return httpd_ws_send_frame(req, &frame);
+}
+
+static void count_results(esp_err_t err, int fd, void *arg)
+{
+    int *counter = (err == ESP_OK) ? &bcast_sent : (err == ESP_ERR_TIMEOUT) ? &bcast_dropped : &bcast_failed;
+    __atomic_add_fetch(counter, 1, __ATOMIC_SEQ_CST);
+}
+
+static bool not_muted(httpd_handle_t hd, int fd, void *arg)
+{
+    (*(int *)arg)++;
+    for (int i = 0; i < muted_count; i++) {
+        if (muted_fds[i] == fd) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const httpd_uri_t echo_uri = {
+    .uri          = "/ws",
+    .method       = HTTP_GET,
+    .handler      = echo_handler,
+    .is_websocket = true,
+};
+
+/* A small receive buffer, set before connecting so that it also limits the TCP window */
+static int connect_client_with_rcvbuf(int rcvbuf)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(TEST_SERVER_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+    if (rcvbuf > 0) {
+        TEST_ASSERT_EQUAL(0, setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)));
+    }
+    int ret;
+    do {
+        ret = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+    } while (ret < 0 && errno == EINTR);
+    TEST_ASSERT_EQUAL_MESSAGE(0, ret, strerror(errno));
+    /* The server runs in a task of the same priority, so never block the scheduler in a socket call */
+    TEST_ASSERT_EQUAL(0, fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK));
+    return fd;
+}
+
+static int connect_client(void)
+{
+    return connect_client_with_rcvbuf(0);
+}
+
+static void send_all(int fd, const uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t ret = send(fd, buf, len, 0);
+        if (ret < 0) {
+            TEST_ASSERT_MESSAGE(errno == EAGAIN || errno == EINTR, strerror(errno));
+            vTaskDelay(1);
+            continue;
+        }
+        buf += ret;
+        len -= ret;
+    }
+}
+
+static void recv_all(int fd, uint8_t *buf, size_t len)
+{
+    int64_t deadline = now_us() + TEST_TIMEOUT_MS * 1000LL;
+    while (len > 0) {
+        TEST_ASSERT_MESSAGE(now_us() < deadline, "timeout waiting for the server");
+        ssize_t ret = recv(fd, buf, len, 0);
+        if (ret < 0) {
+            TEST_ASSERT_MESSAGE(errno == EAGAIN || errno == EINTR, strerror(errno));
+            vTaskDelay(1);
+            continue;
+        }
+        TEST_ASSERT_NOT_EQUAL_MESSAGE(0, ret, "connection closed by the server");
+        buf += ret;
+        len -= ret;
+    }
+}
+
+static void handshake(int fd)
+{
+    static const char request[] = "GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+                                  "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                                  "Sec-WebSocket-Version: 13\r\n\r\n";
+    send_all(fd, (const uint8_t *)request, strlen(request));
+
+    /* Read up to the end of the response headers */
+    char buf[256];
+    size_t len = 0;
+    while (len < 4 || memcmp(buf + len - 4, "\r\n\r\n", 4) != 0) {
+        TEST_ASSERT_LESS_THAN(sizeof(buf) - 1, len);
+        recv_all(fd, (uint8_t *)buf + len, 1);
+        len++;
+    }
+    buf[len] = '\0';
+    TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 101 Switching Protocols", buf, strlen("HTTP/1.1 101 Switching Protocols"));
+}
+
+/* Sends a masked binary frame */
+static void send_frame(int fd, const uint8_t *payload, size_t len)
+{
+    uint8_t *frame = malloc(len + 14);
+    TEST_ASSERT_NOT_NULL(frame);
+    size_t hdr_len = 2;
+    frame[0] = 0x80 | HTTPD_WS_TYPE_BINARY;
+    if (len < 126) {
+        frame[1] = 0x80 | len;
+    } else if (len <= UINT16_MAX) {
+        frame[1] = 0x80 | 126;
+        frame[2] = len >> 8;
+        frame[3] = len;
+        hdr_len = 4;
+    } else {
+        frame[1] = 0x80 | 127;
+        for (int i = 0; i < 8; i++) {
+            frame[2 + i] = (uint64_t) len >> (8 * (7 - i));
+        }
+        hdr_len = 10;
+    }
+    memcpy(frame + hdr_len, mask_key, sizeof(mask_key));
+    hdr_len += sizeof(mask_key);
+    memcpy(frame + hdr_len, payload, len);
+    unmask_bytes(frame + hdr_len, len, mask_key, 0);
+    send_all(fd, frame, hdr_len + len);
+    free(frame);
+}
+
+/* Receives a binary frame of the server, which is not masked, and returns its length */
+static size_t recv_frame(int fd, uint8_t *payload, size_t max_len)
+{
+    uint8_t hdr[10];
+    recv_all(fd, hdr, 2);
+    TEST_ASSERT_EQUAL_HEX8(0x80 | HTTPD_WS_TYPE_BINARY, hdr[0]);
+    size_t len = hdr[1];
+    if (len == 126) {
+        recv_all(fd, hdr + 2, 2);
+        len = (hdr[2] << 8) | hdr[3];
+    } else if (len == 127) {
+        recv_all(fd, hdr + 2, 8);
+        len = 0;
+        for (int i = 0; i < 8; i++) {
+            len = (len << 8) | hdr[2 + i];
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(max_len, len);
+    recv_all(fd, payload, len);
+    return len;
+}
+
+/* Sends a frame and checks that the server echoes its payload */
+static void echo(int fd, const uint8_t *payload, size_t len)
+{
+    uint8_t *echoed = malloc(len + 1);
+    TEST_ASSERT_NOT_NULL(echoed);
+    TEST_ASSERT_EQUAL(len, (send_frame(fd, payload, len), recv_frame(fd, echoed, len)));
+    TEST_ASSERT_EQUAL_MEMORY(payload, echoed, len);
+    free(echoed);
+}
+
+static httpd_handle_t start_ws_server_with_workers(int clients, int workers)
+{
+    /* The handshake hashes the key of the client with PSA */
+    TEST_ASSERT_EQUAL(PSA_SUCCESS, psa_crypto_init());
+
+    httpd_handle_t hd = NULL;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = TEST_SERVER_PORT;
+    config.ctrl_port += 2;
+    config.max_open_sockets = clients;
+    config.worker_count = workers;
+    config.task_priority = uxTaskPriorityGet(NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_start(&hd, &config));
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_register_uri_handler(hd, &echo_uri));
+    muted_count = 0;
+    bcast_sent = 0;
+    bcast_dropped = 0;
+    bcast_failed = 0;
+    return hd;
+}
+
+static httpd_handle_t start_ws_server(int clients)
+{
+    return start_ws_server_with_workers(clients, 0);
+}
+
+/* Waits for the server task to have reported the results of the broadcasts to the given number of clients */
+static void wait_results(int count)
+{
+    int64_t deadline = now_us() + TEST_TIMEOUT_MS * 1000LL;
+    while (__atomic_load_n(&bcast_sent, __ATOMIC_SEQ_CST) + __atomic_load_n(&bcast_dropped, __ATOMIC_SEQ_CST) +
+           __atomic_load_n(&bcast_failed, __ATOMIC_SEQ_CST) < count) {
+        TEST_ASSERT_MESSAGE(now_us() < deadline, "timeout waiting for the broadcast");
+        vTaskDelay(1);
+    }
+}
+
+TEST_CASE("WebSocket frames are received in place", "[esp_http_server]")
+{
+    httpd_handle_t hd = start_ws_server(1);
+
+    /* The payloads start at different offsets of the test data */
+    uint8_t *payload = malloc(TEST_WS_MAX_LEN + 16);
+    TEST_ASSERT_NOT_NULL(payload);
+    for (size_t i = 0; i < TEST_WS_MAX_LEN + 16; i++) {
+        payload[i] = rand();
+    }
+
+    int fd = connect_client();
+    handshake(fd);
+    /* Growing and shrinking frames, in every length encoding, reuse the buffer of the session */
+    static const size_t lens[] = { 0, 1, 125, 126, 1000, UINT16_MAX + 1, 7, TEST_WS_MAX_LEN, 300 };
+    for (int i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        echo(fd, payload + i, lens[i]);
+    }
+    close(fd);
+
+    free(payload);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+}
+
+TEST_CASE("WebSocket broadcast reaches the selected clients", "[esp_http_server]")
+{
+    static int fds[TEST_WS_CLIENTS];
+    httpd_handle_t hd = start_ws_server(TEST_WS_CLIENTS);
+    for (int i = 0; i < TEST_WS_CLIENTS; i++) {
+        fds[i] = connect_client();
+        handshake(fds[i]);
+        if (i % 4 == 0) {
+            echo(fds[i], (const uint8_t *)"mute", 4);
+        }
+    }
+
+    int filter_calls = 0;
+    for (int n = 0; n < TEST_WS_MESSAGES; n++) {
+        char message[32];
+        httpd_ws_frame_t frame = {
+            .type = HTTPD_WS_TYPE_BINARY,
+            .payload = (uint8_t *)message,
+            .len = snprintf(message, sizeof(message), "update %d", n),
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, httpd_ws_broadcast(hd, &frame, not_muted, count_results, &filter_calls));
+    }
+
+    /* The frames come in order, once to every client that is not muted */
+    for (int i = 0; i < TEST_WS_CLIENTS; i++) {
+        if (i % 4 == 0) {
+            continue;
+        }
+        for (int n = 0; n < TEST_WS_MESSAGES; n++) {
+            char expected[32];
+            char message[32];
+            size_t len = recv_frame(fds[i], (uint8_t *)message, sizeof(message) - 1);
+            message[len] = '\0';
+            snprintf(expected, sizeof(expected), "update %d", n);
+            TEST_ASSERT_EQUAL_STRING(expected, message);
+        }
+    }
+    TEST_ASSERT_EQUAL(TEST_WS_CLIENTS * TEST_WS_MESSAGES, filter_calls);
+    wait_results((TEST_WS_CLIENTS - TEST_WS_CLIENTS / 4) * TEST_WS_MESSAGES);
+    TEST_ASSERT_EQUAL((TEST_WS_CLIENTS - TEST_WS_CLIENTS / 4) * TEST_WS_MESSAGES, bcast_sent);
+
+    /* Nothing for the muted clients, checked after an echo that follows the broadcasts */
+    for (int i = 0; i < TEST_WS_CLIENTS; i += 4) {
+        echo(fds[i], (const uint8_t *)"ping", 4);
+    }
+    for (int i = 0; i < TEST_WS_CLIENTS; i++) {
+        close(fds[i]);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+}
+
+TEST_CASE("WebSocket broadcast is not held up by a client that does not read", "[esp_http_server]")
+{
+    static uint8_t payload[TEST_WS_LARGE_LEN];
+    httpd_handle_t hd = start_ws_server(2);
+    int reader = connect_client();
+    handshake(reader);
+
+    /* The server soon can't send to this client */
+    int stalled = connect_client_with_rcvbuf(4096);
+    handshake(stalled);
+
+    int64_t start = now_us();
+    for (int n = 0; n < TEST_WS_LARGE_MESSAGES; n++) {
+        memset(payload, n, sizeof(payload));
+        httpd_ws_frame_t frame = {
+            .type = HTTPD_WS_TYPE_BINARY,
+            .payload = payload,
+            .len = sizeof(payload),
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, httpd_ws_broadcast(hd, &frame, NULL, count_results, NULL));
+        TEST_ASSERT_EQUAL(sizeof(payload), recv_frame(reader, payload, sizeof(payload)));
+        TEST_ASSERT_EACH_EQUAL_HEX8(n, payload, sizeof(payload));
+    }
+    int64_t elapsed_us = now_us() - start;
+    printf("%d x %d bytes in %lld ms\n", TEST_WS_LARGE_MESSAGES, TEST_WS_LARGE_LEN, (long long)(elapsed_us / 1000));
+    /* Waiting for the stalled client would take the send timeout of the server */
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    TEST_ASSERT_LESS_THAN(config.send_wait_timeout * 1000000LL, elapsed_us);
+
+    /* The stalled client got whole frames in order, apart from the remainder of the last one that
+     * the server keeps until it can send again, and missed some */
+    size_t buf_len = 0;
+    size_t buf_size = TEST_WS_LARGE_MESSAGES * (TEST_WS_LARGE_LEN + 4);
+    uint8_t *buf = malloc(buf_size);
+    TEST_ASSERT_NOT_NULL(buf);
+    for (int idle = 0; idle < 10 && buf_len < buf_size; ) {
+        ssize_t ret = recv(stalled, buf + buf_len, buf_size - buf_len, 0);
+        if (ret > 0) {
+            buf_len += ret;
+            idle = 0;
+        } else {
+            TEST_ASSERT_MESSAGE(ret < 0 && (errno == EAGAIN || errno == EINTR), "connection closed by the server");
+            vTaskDelay(1);
+            idle++;
+        }
+    }
+    int last = -1;
+    int received = 0;
+    for (size_t off = 0; off + 4 + TEST_WS_LARGE_LEN <= buf_len; off += 4 + TEST_WS_LARGE_LEN) {
+        TEST_ASSERT_EQUAL_HEX8(0x80 | HTTPD_WS_TYPE_BINARY, buf[off]);
+        TEST_ASSERT_EQUAL_HEX8(126, buf[off + 1]);
+        TEST_ASSERT_EQUAL(TEST_WS_LARGE_LEN, (buf[off + 2] << 8) | buf[off + 3]);
+        uint8_t n = buf[off + 4];
+        TEST_ASSERT_GREATER_THAN(last, n);
+        TEST_ASSERT_EACH_EQUAL_HEX8(n, buf + off + 4, TEST_WS_LARGE_LEN);
+        last = n;
+        received++;
+    }
+    free(buf);
+    printf("stalled client got %d of %d frames\n", received, TEST_WS_LARGE_MESSAGES);
+    TEST_ASSERT_LESS_THAN(TEST_WS_LARGE_MESSAGES, received);
+
+    /* The frames it missed were reported, the one it got a part of was not */
+    wait_results(2 * TEST_WS_LARGE_MESSAGES);
+    TEST_ASSERT_EQUAL(0, bcast_failed);
+    int stalled_sent = bcast_sent - TEST_WS_LARGE_MESSAGES;
+    TEST_ASSERT_EQUAL(TEST_WS_LARGE_MESSAGES, stalled_sent + bcast_dropped);
+    TEST_ASSERT_GREATER_OR_EQUAL(received, stalled_sent);
+    TEST_ASSERT_LESS_OR_EQUAL(received + 1, stalled_sent);
+
+    close(stalled);
+    close(reader);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+}
+
+static void broadcast_text(httpd_handle_t hd, const char *text)
+{
+    httpd_ws_frame_t frame = {
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = (uint8_t *)text,
+        .len = strlen(text),
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_ws_broadcast(hd, &frame, NULL, count_results, NULL));
+}
+
+static void recv_text(int fd, const char *expected)
+{
+    char message[32];
+    size_t len = recv_frame(fd, (uint8_t *)message, sizeof(message) - 1);
+    message[len] = '\0';
+    TEST_ASSERT_EQUAL_STRING(expected, message);
+}
+
+/* Sends a frame that the handler holds in the worker until released */
+static void hold_worker(int fd, const char *payload)
+{
+    int64_t deadline = now_us() + TEST_TIMEOUT_MS * 1000LL;
+    send_frame(fd, (const uint8_t *)payload, strlen(payload));
+    while (!__atomic_load_n(&handler_waiting, __ATOMIC_SEQ_CST)) {
+        TEST_ASSERT_MESSAGE(now_us() < deadline, "timeout waiting for the handler");
+        vTaskDelay(1);
+    }
+}
+
+TEST_CASE("WebSocket broadcast reaches the clients held by a worker", "[esp_http_server]")
+{
+    httpd_handle_t hd = start_ws_server_with_workers(2, 1);
+    int busy = connect_client();
+    handshake(busy);
+    int idle = connect_client();
+    handshake(idle);
+
+    /* The frame is left for the client of the worker, which sends it before its own */
+    hold_worker(busy, "wait");
+    broadcast_text(hd, "update 0");
+    recv_text(idle, "update 0");
+    wait_results(2);
+    __atomic_store_n(&handler_released, true, __ATOMIC_SEQ_CST);
+    recv_text(busy, "update 0");
+    recv_text(busy, "wait");
+
+    /* Or the server sends it once the worker is done, if the handler doesn't send anything */
+    hold_worker(busy, "hold");
+    broadcast_text(hd, "update 1");
+    recv_text(idle, "update 1");
+    wait_results(4);
+    __atomic_store_n(&handler_released, true, __ATOMIC_SEQ_CST);
+    recv_text(busy, "update 1");
+    TEST_ASSERT_EQUAL(4, bcast_sent);
+
+    /* Nothing else came */
+    echo(busy, (const uint8_t *)"ping", 4);
+    echo(idle, (const uint8_t *)"ping", 4);
+    close(busy);
+    close(idle);
+    TEST_ASSERT_EQUAL(ESP_OK, httpd_stop(hd));
+}
@@ -0,0 +1,19 @@
+# SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Unlicense OR CC0-1.0
+import pytest
+from pytest_embedded import Dut
+from pytest_embedded_idf.utils import idf_parametrize
+
+
+@pytest.mark.host_test
+@pytest.mark.parametrize(
+    'config',
+    [
+        'default',
+        'poll',
+    ],
+    indirect=True,
+)
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_http_server_linux(dut: Dut) -> None:
+    dut.run_all_single_board_cases(timeout=120)
@@ -58,6 +58,8 @@ initializer that should be kept in sync
         .stack_size         = 4096,                     \
         .core_id            = tskNO_AFFINITY,           \
         .task_caps          = (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT),       \
+        .worker_count       = 0,                        \
+        .worker_core_id     = tskNO_AFFINITY,           \
         .max_req_hdr_len    = CONFIG_HTTPD_MAX_REQ_HDR_LEN,    \
         .max_uri_len        = CONFIG_HTTPD_MAX_URI_LEN,        \
         .server_port        = 80,                       \
@@ -99,6 +101,10 @@ initializer that should be kept in sync
  * for setting buffer length to string length */
 #define HTTPD_RESP_USE_STRLEN -1
 
+/* Symbol to be used as length parameter in httpd_resp_send_file()
+ * for sending up to the end of the file */
+#define HTTPD_RESP_USE_FILE_SIZE -1
+
 /* ************** Group: Initialization ************** */
 /** @name Initialization
  * APIs related to the Initialization of the web server
@@ -179,6 +185,27 @@ typedef struct httpd_config {
     BaseType_t  core_id;            /*!< The core the HTTP server task will run on */
     uint32_t    task_caps;          /*!< The memory capabilities to use when allocating the HTTP server task's stack */
 
+    /**
+     * Number of worker tasks processing the requests. With 0, the requests are
+     * processed by the server task itself.
+     *
+     * The server task hands each ready session to a worker, a session always goes
+     * to the same worker and is handed over again only once its previous request
+     * has been processed, so requests on a connection are processed in order.
+     * The workers use the priority, stack size and stack memory capabilities of
+     * the server task.
+     *
+     * @note Work queued with httpd_queue_work() still runs in the server task,
+     *       concurrently with the request handlers.
+     */
+    uint8_t     worker_count;
+
+    /**
+     * The core the worker tasks are pinned to. With tskNO_AFFINITY, the workers
+     * are pinned to the cores in turn (worker i runs on core i % portNUM_PROCESSORS).
+     */
+    BaseType_t  worker_core_id;
+
     /**
      * Size limits for the header and URI buffers respectively.
      * These are just limits, allocation would depend upon actual size of URI/header.
@@ -292,6 +319,11 @@ typedef struct httpd_config {
      *
      * Users can implement their own matching functions (See description
      * of the `httpd_uri_match_func_t` function prototype)
+     *
+     * With the first two options, the handlers are looked up in a prefix
+     * tree if CONFIG_HTTPD_URI_ROUTER is enabled, otherwise and with custom
+     * functions they are scanned in the order of their registration. Either
+     * way the first registered handler matching the request is used.
      */
     httpd_uri_match_func_t uri_match_fn;
 } httpd_config_t;
@@ -1096,6 +1128,32 @@ esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, siz
  */
 esp_err_t httpd_req_get_cookie_val(httpd_req_t *req, const char *cookie_name, char *val, size_t *val_size);
 
+/**
+ * @brief   Get the value of a path parameter of the request URI
+ *
+ * @note
+ *  - Path parameters are the {name} segments of the URI template of the handler,
+ *    they are only defined when uri_match_fn is httpd_uri_match_wildcard()
+ *  - The value is not URL decoded
+ *  - This API is supposed to be called only from the context of
+ *    a URI handler where httpd_req_t* request pointer is valid
+ *  - If actual value size is greater than val_size, then the value is truncated,
+ *    accompanied by truncation error as return value.
+ *
+ * @param[in]  r         The request being responded to
+ * @param[in]  name      Name of the path parameter, without the braces
+ * @param[out] val       Pointer to the buffer into which the value will be copied if the parameter is found
+ * @param[in]  val_size  Size of the user buffer "val"
+ *
+ * @return
+ *  - ESP_OK : Parameter is found in the URI and copied to buffer
+ *  - ESP_ERR_NOT_FOUND          : Parameter not found
+ *  - ESP_ERR_INVALID_ARG        : Null arguments
+ *  - ESP_ERR_HTTPD_INVALID_REQ  : Invalid HTTP request pointer
+ *  - ESP_ERR_HTTPD_RESULT_TRUNC : Value string truncated
+ */
+esp_err_t httpd_req_get_path_param(httpd_req_t *r, const char *name, char *val, size_t val_size);
+
 /**
  * @brief Test if a URI matches the given wildcard template.
  *
@@ -1111,6 +1169,12 @@ esp_err_t httpd_req_get_cookie_val(httpd_req_t *req, const char *cookie_name, ch
  *
  * The special characters '?' and '*' anywhere else in the template will be taken literally.
  *
+ * A whole path segment written as {name} is a path parameter, matching any non empty segment,
+ * and its value can be read in the handler with httpd_req_get_path_param(). For example
+ * /api/dev/{id}/cfg matches /api/dev/12/cfg, but not /api/dev//cfg or /api/dev/12/13/cfg.
+ * Such a segment used to match only the same literal text, which it still does. Braces that
+ * don't span a whole segment, as in /api/dev/x{id}, are taken literally.
+ *
  * @param[in] uri_template   URI template (pattern)
  * @param[in] uri_to_match   URI to be matched
  * @param[in] match_upto     how many characters of the URI buffer to test
@@ -1198,6 +1262,63 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len);
  */
 esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len);
 
+/**
+ * @brief   API to send a part of a file as a complete HTTP response.
+ *
+ * The file is read straight into the socket, without going through a
+ * buffer of the caller or the chunked encoding, and the response has a
+ * Content-Length header. On the Linux target the host kernel copies the
+ * data with sendfile(), otherwise it is read in blocks of
+ * CONFIG_HTTPD_SEND_FILE_BUF_SIZE bytes.
+ *
+ * If the status is 200 OK, the response advertises byte ranges, and a
+ * single byte range asked by the client with a Range request header is
+ * answered with 206 Partial Content, or 416 Range Not Satisfiable if it
+ * lies outside of the file part.
+ *
+ * @note
+ * - This API is supposed to be called only from the context of
+ *   a URI handler where httpd_req_t* request pointer is valid.
+ * - Once this API is called, the request has been responded.
+ *   No additional data can then be sent for the request.
+ * - The file position of fd is not defined after this call.
+ *
+ * @param[in] r         The request being responded to
+ * @param[in] fd        File descriptor of a file opened for reading, e.g. on FAT, SPIFFS or LittleFS
+ * @param[in] offset    Start of the part of the file to send
+ * @param[in] len       Length of the part, HTTPD_RESP_USE_FILE_SIZE to send up to the end of the file
+ *
+ * @return
+ *  - ESP_OK : On successfully sending the response packet
+ *  - ESP_ERR_INVALID_ARG       : Null request pointer, invalid file descriptor, offset or length
+ *  - ESP_ERR_HTTPD_RESP_HDR    : Essential headers are too large for internal buffer
+ *  - ESP_ERR_HTTPD_RESP_SEND   : Error in raw send, or in reading the file
+ *  - ESP_ERR_HTTPD_ALLOC_MEM   : Unable to allocate the buffer for reading the file
+ *  - ESP_ERR_HTTPD_INVALID_REQ : Invalid request
+ */
+esp_err_t httpd_resp_send_file(httpd_req_t *r, int fd, off_t offset, ssize_t len);
+
+/**
+ * @brief   API to send a memory region as a complete HTTP response.
+ *
+ * Same as httpd_resp_send(), with the byte range support of
+ * httpd_resp_send_file(). This suits a partition mapped into memory
+ * with esp_partition_mmap(), which is sent without being copied.
+ *
+ * @param[in] r         The request being responded to
+ * @param[in] data      Start of the memory region
+ * @param[in] len       Length of the memory region
+ *
+ * @return
+ *  - ESP_OK : On successfully sending the response packet
+ *  - ESP_ERR_INVALID_ARG       : Null request pointer or data
+ *  - ESP_ERR_HTTPD_RESP_HDR    : Essential headers are too large for internal buffer
+ *  - ESP_ERR_HTTPD_RESP_SEND   : Error in raw send
+ *  - ESP_ERR_HTTPD_ALLOC_MEM   : Unable to allocate the buffer for the headers
+ *  - ESP_ERR_HTTPD_INVALID_REQ : Invalid request
+ */
+esp_err_t httpd_resp_send_mapped(httpd_req_t *r, const void *data, size_t len);
+
 /**
  * @brief   API to send a complete string as HTTP response.
  *
@@ -1243,10 +1364,12 @@ static inline esp_err_t httpd_resp_sendstr_chunk(httpd_req_t *r, const char *str
 /* Some commonly used status codes */
 #define HTTPD_200      "200 OK"                     /*!< HTTP Response 200 */
 #define HTTPD_204      "204 No Content"             /*!< HTTP Response 204 */
+#define HTTPD_206      "206 Partial Content"        /*!< HTTP Response 206 */
 #define HTTPD_207      "207 Multi-Status"           /*!< HTTP Response 207 */
 #define HTTPD_400      "400 Bad Request"            /*!< HTTP Response 400 */
 #define HTTPD_404      "404 Not Found"              /*!< HTTP Response 404 */
 #define HTTPD_408      "408 Request Timeout"        /*!< HTTP Response 408 */
+#define HTTPD_416      "416 Range Not Satisfiable"  /*!< HTTP Response 416 */
 #define HTTPD_500      "500 Internal Server Error"  /*!< HTTP Response 500 */
 
 /**
@@ -1771,6 +1894,16 @@ typedef struct httpd_ws_frame {
  */
 typedef void (*transfer_complete_cb)(esp_err_t err, int socket, void *arg);
 
+/**
+ * @brief Selects the clients of httpd_ws_broadcast()
+ *
+ * @param[in] handle    Server instance data
+ * @param[in] socket    Socket descriptor of a WebSocket client
+ * @param[in] arg       User data passed to httpd_ws_broadcast()
+ * @return  true to send the frame to this client
+ */
+typedef bool (*httpd_ws_broadcast_filter_t)(httpd_handle_t handle, int socket, void *arg);
+
 /**
  * @brief Receive and parse a WebSocket frame
  *
@@ -1808,6 +1941,33 @@ esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *pkt, size_t ma
  */
 esp_err_t httpd_ws_recv_frame_part(httpd_req_t *req, httpd_ws_frame_t *pkt, size_t max_len);
 
+/**
+ * @brief Receive and parse a WebSocket frame without a buffer of the caller
+ *
+ * The payload is received into a buffer of the session and unmasked in
+ * place, and pkt->payload is set to point to it. This saves allocating a
+ * buffer and receiving the frame header and payload with separate calls of
+ * httpd_ws_recv_frame() for every frame. For a frame without payload,
+ * pkt->len is 0 and pkt->payload may be NULL.
+ *
+ * @note    The payload is valid until the next frame of the session is received,
+ *          or the session is closed. The buffer grows to the largest frame received
+ *          and is kept until the session is closed, so max_len should bound the frame
+ *          size the application accepts.
+ *
+ * @param[in]   req         Current request
+ * @param[out]  pkt         WebSocket packet, with len set to 0
+ * @param[in]   max_len     Maximum length of the payload
+ * @return
+ *  - ESP_OK                    : On successful
+ *  - ESP_FAIL                  : Socket errors occurs
+ *  - ESP_ERR_INVALID_SIZE      : The payload is longer than max_len
+ *  - ESP_ERR_NO_MEM            : Failed to grow the buffer of the session
+ *  - ESP_ERR_INVALID_STATE     : Handshake was already done beforehand
+ *  - ESP_ERR_INVALID_ARG       : Argument is invalid (null or non-WebSocket)
+ */
+esp_err_t httpd_ws_recv_frame_zero_copy(httpd_req_t *req, httpd_ws_frame_t *pkt, size_t max_len);
+
 /**
  * @brief Construct and send a WebSocket frame
  * @param[in]   req     Current request
@@ -1826,6 +1986,10 @@ esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *pkt);
  *
  * This API should rarely be called directly, with an exception of asynchronous send using httpd_queue_work.
  *
+ * The rest of a broadcast frame still pending for the client is sent first. Called
+ * from another task than the one of the server, this waits for the server task
+ * to send it, see httpd_ws_broadcast().
+ *
  * @param[in] hd      Server instance data
  * @param[in] fd      Socket descriptor for sending data
  * @param[in] frame     WebSocket frame
@@ -1879,6 +2043,45 @@ esp_err_t httpd_ws_send_data(httpd_handle_t handle, int socket, httpd_ws_frame_t
 esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket, httpd_ws_frame_t *frame,
                                    transfer_complete_cb callback, void *arg);
 
+/**
+ * @brief Sends a frame to several websocket clients asynchronously
+ *
+ * The frame is encoded and copied once, and sent to all the clients by a
+ * single work item of the server task, with one send per client.
+ *
+ * A client that can't take the frame yet does not hold up the others. If
+ * none of the frame fits in its socket, the frame is dropped for this client.
+ * If only a part of it does, the rest is sent with the next broadcast or
+ * frame sent to this client, and the next broadcast frame is dropped for it
+ * if the client still can't take the rest by then. The frame is left pending
+ * the same way for a client whose request is being processed by a worker task,
+ * and sent once the worker is done with it or sends a frame to it.
+ *
+ * The callback, if any, is called in the server task for each selected client,
+ * with the socket of the client and:
+ *  - ESP_OK when the frame was sent, or left pending as above
+ *  - ESP_ERR_TIMEOUT when the frame was dropped for a client that couldn't take it
+ *  - ESP_FAIL when sending failed, the session is closed then
+ *
+ * @note    The clients are sent the frame without blocking only if the send
+ *          function of their sessions honours MSG_DONTWAIT. The send function of
+ *          esp_https_server ignores the flags and blocks, so a client that is slow
+ *          to read holds up the server task and the other clients there.
+ *
+ * @param[in] handle    Server instance data
+ * @param[in] frame     Websocket frame, may be released when this function returns
+ * @param[in] filter    Selects the clients in the server task, NULL to send to all websocket clients
+ * @param[in] callback  Reports the result for each selected client, may be NULL
+ * @param[in] arg       User data passed to the filter and to the callback
+ * @return
+ *  - ESP_OK                    : On successfully queueing the frame
+ *  - ESP_FAIL                  : Unable to queue the work for the server task
+ *  - ESP_ERR_NO_MEM            : Unable to allocate memory
+ *  - ESP_ERR_INVALID_ARG       : Null arguments
+ */
+esp_err_t httpd_ws_broadcast(httpd_handle_t handle, const httpd_ws_frame_t *frame,
+                             httpd_ws_broadcast_filter_t filter, transfer_complete_cb callback, void *arg);
+
 #endif /* CONFIG_HTTPD_WS_SUPPORT || __DOXYGEN__ */
 /** End of WebSocket related stuff
  * @}
@@ -1922,6 +2125,20 @@ esp_err_t httpd_get_raw_req_data(httpd_req_t *req, char *buf, size_t buf_len);
  */
 esp_http_server_event_id_t httpd_get_server_state(httpd_handle_t handle);
 
+#if CONFIG_HTTPD_ALLOC_STATS || __DOXYGEN__
+/**
+ * @brief Get the number of heap allocations made by the HTTP servers
+ *
+ * Counts the allocations of all the server instances since boot, including
+ * reallocations. Allocations made by the handlers are not counted.
+ *
+ * @note Only available with CONFIG_HTTPD_ALLOC_STATS enabled
+ *
+ * @return Number of allocations
+ */
+uint32_t httpd_get_alloc_count(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,8 @@
 #include <esp_err.h>
 
 #include <esp_http_server.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include "osal.h"
 #include "sdkconfig.h"
 
@@ -38,6 +40,17 @@ extern "C" {
 /* Formats a log string to prepend context function name */
 #define LOG_FMT(x)      "%s: " x, __func__
 
+/* Heap allocations of the server, counted with CONFIG_HTTPD_ALLOC_STATS */
+#if CONFIG_HTTPD_ALLOC_STATS
+void *httpd_malloc(size_t size);
+void *httpd_calloc(size_t n, size_t size);
+void *httpd_realloc(void *ptr, size_t size);
+#else
+#define httpd_malloc(size)          malloc(size)
+#define httpd_calloc(n, size)       calloc(n, size)
+#define httpd_realloc(ptr, size)    realloc(ptr, size)
+#endif
+
 /**
  * @brief Control message data structure for internal use. Sent to control socket.
  */
@@ -45,6 +58,8 @@ struct httpd_ctrl_data {
     enum httpd_ctrl_msg {
         HTTPD_CTRL_SHUTDOWN,
         HTTPD_CTRL_WORK,
+        HTTPD_CTRL_ASYNC_DONE,
+        HTTPD_CTRL_WORKER_DONE,
         HTTPD_CTRL_MAX,
     } hc_msg;
     httpd_work_fn_t hc_work;
@@ -83,12 +98,23 @@ struct sock_db {
     char pending_data[PARSER_BLOCK_SIZE];   /*!< Buffer for pending data to be received */
     size_t pending_len;                     /*!< Length of pending data to be received */
     bool for_async_req;                     /*!< If true, the socket will not be LRU purged */
+    bool async_done;                        /*!< Set once the async request has completed, until the server task watches the socket again */
+    bool poll_pending;                      /*!< Set if the session still had pending data after it was processed */
+    bool in_worker;                         /*!< Set by the server task while a worker holds the session, from the hand-off until the result is picked up */
+    bool close_deferred;                    /*!< Set if the session must be closed once the worker has released it */
+#if CONFIG_HTTPD_SESS_ARENA
+    char *arena;                            /*!< Buffer of the requests of this session, kept between requests */
+#endif
 #ifdef CONFIG_HTTPD_WS_SUPPORT
     bool ws_handshake_done;                 /*!< True if it has done WebSocket handshake (if this socket is a valid WS) */
     bool ws_close;                          /*!< Set to true to close the socket later (when WS Close frame received) */
     esp_err_t (*ws_handler)(httpd_req_t *r);   /*!< WebSocket handler, leave to null if it's not WebSocket */
     bool ws_control_frames;                         /*!< WebSocket flag indicating that control frames should be passed to user handlers */
     void *ws_user_ctx;                         /*!< Pointer to user context data which will be available to handler for websocket*/
+    uint8_t *ws_rx_buf;                     /*!< Buffer of httpd_ws_recv_frame_zero_copy(), kept for the next frames */
+    size_t ws_rx_buf_size;                  /*!< Size of ws_rx_buf */
+    struct httpd_ws_bcast *ws_bcast;        /*!< Broadcast frame the client couldn't take at once or got while in a worker, set by the server task only */
+    size_t ws_bcast_sent;                   /*!< Length of ws_bcast already sent */
 #endif
 };
 
@@ -103,6 +129,10 @@ struct httpd_req_aux {
     size_t          scratch_cur_size;               /*!< Scratch buffer cur size (By default this value is set to CONFIG_HTTPD_MAX_URI_LEN, overwrite is possible) */
     size_t          max_req_hdr_len;             /*!< Header buffer size limit */
     size_t          max_uri_len;             /*!< URI buffer size limit */
+    char           *arena;                          /*!< Buffer of the session holding the scratch buffer, NULL to allocate from the heap */
+    size_t          arena_size;                     /*!< Size of arena */
+    size_t          arena_used;                     /*!< Bytes of arena in use, from its start */
+    size_t          arena_last;                     /*!< Offset of the last allocation from arena */
     size_t          remaining_len;                  /*!< Amount of data remaining to be fetched */
     char           *status;                         /*!< HTTP response's status code */
     char           *content_type;                   /*!< HTTP response's content type */
@@ -114,6 +144,8 @@ struct httpd_req_aux {
         const char *value;
     } *resp_hdrs;                                   /*!< Additional headers in response packet */
     struct http_parser_url url_parse_res;           /*!< URL parsing result, used for retrieving URL elements */
+    const char     *uri_template;                   /*!< Template of the matched handler if it may have path parameters */
+    httpd_uri_t    *uri_handler;                    /*!< Matched handler, referenced until the request is done with it */
 #ifdef CONFIG_HTTPD_WS_SUPPORT
     bool ws_handshake_detect;                       /*!< WebSocket handshake detection flag */
     httpd_ws_type_t ws_type;                        /*!< WebSocket frame type */
@@ -122,6 +154,26 @@ struct httpd_req_aux {
 #endif
 };
 
+/**
+ * @brief   Worker task processing requests on behalf of the server task
+ */
+struct httpd_worker {
+    struct httpd_data *hd;                  /*!< Server instance data */
+    othread_t handle;                       /*!< Worker task */
+    QueueHandle_t queue;                    /*!< Sessions handed over by the server task, NULL to stop the worker */
+    struct httpd_req req;                   /*!< The request processed by this worker */
+    struct httpd_req_aux req_aux;           /*!< Additional data about the request kept unexposed */
+};
+
+/**
+ * @brief   Result of the processing of a session by a worker, a NULL session
+ *          tells that the worker has stopped
+ */
+struct httpd_worker_result {
+    struct sock_db *session;                /*!< Processed session */
+    esp_err_t ret;                          /*!< Return value of httpd_sess_process() */
+};
+
 /**
  * @brief   Server data for each instance. This is exposed publicly as
  *          httpd_handle_t but internal structure/members are kept private.
@@ -136,10 +188,20 @@ struct httpd_data {
     int msg_fd;                             /*!< Ctrl message sender FD */
     struct thread_data hd_td;               /*!< Information for the HTTPD thread */
     struct sock_db *hd_sd;                  /*!< The socket database */
+    struct httpd_poll *hd_poll;             /*!< State of the readiness polling backend */
     int hd_sd_active_count;                 /*!< The number of the active sockets */
+    int hd_sd_pending_count;                /*!< The number of sessions with poll_pending set */
+    bool hd_async_done;                     /*!< Set along with async_done of a session, cleared by the server task before re-arming the sessions */
     httpd_uri_t **hd_calls;                 /*!< Registered URI handlers */
+    SemaphoreHandle_t hd_calls_lock;        /*!< Guards hd_calls, the URI tree and the references to the handlers */
+#ifdef CONFIG_HTTPD_URI_ROUTER
+    struct httpd_router *hd_router;         /*!< Tree of the URI handlers, NULL if they are scanned linearly */
+#endif
     struct httpd_req hd_req;                /*!< The current HTTPD request */
     struct httpd_req_aux hd_req_aux;        /*!< Additional data about the HTTPD request kept unexposed */
+    struct httpd_worker *hd_workers;        /*!< Worker tasks, NULL if requests are processed by the server task */
+    QueueHandle_t hd_worker_results;        /*!< Sessions processed by the workers, to be picked up by the server task */
+    bool hd_worker_wakeup;                  /*!< Set by the worker which wakes the server task up, cleared by the server task before picking up the results */
     uint64_t lru_counter;                   /*!< LRU counter */
     esp_http_server_event_id_t http_server_state;              /*!< HTTPD server state */
 
@@ -227,16 +289,20 @@ esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd);
  *
  * @param[in] hd      Server instance data
  * @param[in] session Session
+ * @param[in] r       Request storage of the calling task
+ * @param[in] ra      Additional request data storage of the calling task
  *
  * @return
  *  - ESP_OK    : on successfully receiving, parsing and responding to a request
  *  - ESP_FAIL  : in case of failure in any of the stages of processing
  */
-esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *session);
+esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *session,
+                             httpd_req_t *r, struct httpd_req_aux *ra);
 
 /**
  * @brief   Remove client descriptor from the session / socket database
- *          and close the connection for this client.
+ *          and close the connection for this client. A session held by a
+ *          worker is closed once the server task picks up its result.
  *
  * @param[in] hd      Server instance data
  * @param[in] session Session
@@ -320,6 +386,143 @@ void httpd_sess_close_all(struct httpd_data *hd);
  * @}
  */
 
+/****************** Group : Readiness Polling ********************/
+/** @name Readiness Polling
+ * Methods for waiting for activity on the server's sockets, implemented
+ * by the backend selected with CONFIG_HTTPD_POLL_BACKEND
+ * @{
+ */
+
+/**
+ * @brief Sockets found ready by httpd_poll_wait()
+ */
+struct httpd_poll_result {
+    bool ctrl_ready;                /*!< A control message can be received */
+    bool listen_ready;              /*!< A new connection can be accepted */
+    int sess_count;                 /*!< Number of ready sessions */
+    struct sock_db **sessions;      /*!< Ready sessions, owned by the backend */
+};
+
+/**
+ * @brief   Initializes the polling backend and registers the listening
+ *          and control sockets with it
+ *
+ * @param[in] hd  Server instance data
+ *
+ * @return
+ *  - ESP_OK                 : on success
+ *  - ESP_ERR_HTTPD_ALLOC_MEM: if memory allocation failed
+ *  - ESP_FAIL               : if the backend could not be created
+ */
+esp_err_t httpd_poll_init(struct httpd_data *hd);
+
+/**
+ * @brief   Releases the polling backend. All sessions must have been
+ *          deleted before calling this.
+ *
+ * @param[in] hd  Server instance data
+ */
+void httpd_poll_deinit(struct httpd_data *hd);
+
+/**
+ * @brief   Starts watching a session for incoming data. Does nothing if the
+ *          session is closed, busy in an async request or a worker, or
+ *          already watched.
+ *
+ * @param[in] hd      Server instance data
+ * @param[in] session Session
+ */
+void httpd_poll_add(struct httpd_data *hd, struct sock_db *session);
+
+/**
+ * @brief   Stops watching a session, e.g. before it is closed or while it
+ *          is busy in an async request or a worker
+ *
+ * @param[in] hd      Server instance data
+ * @param[in] session Session
+ */
+void httpd_poll_del(struct httpd_data *hd, struct sock_db *session);
+
+/**
+ * @brief   Waits for activity on the server's sockets
+ *
+ * @param[in]  hd         Server instance data
+ * @param[in]  listen     Whether to watch the listening socket for new connections
+ * @param[in]  timeout_ms Time to wait in milliseconds, -1 to wait forever
+ * @param[out] result     Ready sockets
+ *
+ * @return
+ *  - Number of ready sockets (0 on timeout or if interrupted by a signal)
+ *  - -1 on error, errno is set accordingly
+ */
+int httpd_poll_wait(struct httpd_data *hd, bool listen, int timeout_ms, struct httpd_poll_result *result);
+
+/** End of Group : Readiness Polling
+ * @}
+ */
+
+/****************** Group : Workers ********************/
+/** @name Workers
+ * Methods for processing the requests in worker tasks, enabled with
+ * httpd_config_t::worker_count
+ * @{
+ */
+
+/**
+ * @brief   Creates the worker tasks. Does nothing if worker_count is 0.
+ *
+ * @param[in] hd  Server instance data
+ *
+ * @return
+ *  - ESP_OK                 : on success
+ *  - ESP_ERR_HTTPD_ALLOC_MEM: if memory allocation failed
+ *  - ESP_ERR_HTTPD_TASK     : if a worker task could not be created
+ */
+esp_err_t httpd_workers_init(struct httpd_data *hd);
+
+/**
+ * @brief   Asks the workers to exit once they are done with the sessions
+ *          already handed over. Each worker then posts a result with a NULL
+ *          session, after which it doesn't access the server data anymore.
+ *
+ * @param[in] hd  Server instance data
+ */
+void httpd_workers_stop(struct httpd_data *hd);
+
+/**
+ * @brief   Releases the workers, all of them must have stopped
+ *
+ * @param[in] hd  Server instance data
+ */
+void httpd_workers_deinit(struct httpd_data *hd);
+
+/**
+ * @brief   Hands a session over to its worker, which processes a request
+ *          from it and posts the result. The session is marked in_worker
+ *          until the server task picks up the result.
+ *
+ * @param[in] hd      Server instance data
+ * @param[in] session Session with data to be processed
+ */
+void httpd_worker_dispatch(struct httpd_data *hd, struct sock_db *session);
+
+/**
+ * @brief   Picks up the result of a worker
+ *
+ * @param[in]  hd     Server instance data
+ * @param[out] result Processed session and return value of its processing
+ * @param[in]  wait   Ticks to wait for a result
+ *
+ * @return
+ *  - true  : if a result was picked up
+ *  - false : otherwise
+ */
+bool httpd_worker_get_result(struct httpd_data *hd, struct httpd_worker_result *result, TickType_t wait);
+
+/** End of Group : Workers
+ * @}
+ */
+
 /****************** Group : URI Handling ********************/
 /** @name URI Handling
  * Methods for accessing URI handlers
@@ -331,12 +534,13 @@ void httpd_sess_close_all(struct httpd_data *hd);
  *          and invokes the appropriate one if found
  *
  * @param[in] hd  Server instance data for which handler needs to be invoked
+ * @param[in] r   The parsed request
  *
  * @return
  *  - ESP_OK    : if handler found and executed successfully
  *  - ESP_FAIL  : otherwise
  */
-esp_err_t httpd_uri(struct httpd_data *hd);
+esp_err_t httpd_uri(struct httpd_data *hd, httpd_req_t *r);
 
 /**
  * @brief   Unregister all URI handlers
@@ -345,6 +549,90 @@ esp_err_t httpd_uri(struct httpd_data *hd);
  */
 void httpd_unregister_all_uri_handlers(struct httpd_data *hd);
 
+/**
+ * @brief   Takes another reference to the handler of a request, e.g. for
+ *          an async copy of the request. An unregistered handler is freed
+ *          once its last reference is released.
+ *
+ * @param[in] hd       Server instance data
+ * @param[in] handler  Handler of the request, may be NULL
+ */
+void httpd_uri_handler_ref(struct httpd_data *hd, httpd_uri_t *handler);
+
+/**
+ * @brief   Releases a reference to the handler of a request
+ *
+ * @param[in] hd       Server instance data
+ * @param[in] handler  Handler of the request, may be NULL
+ */
+void httpd_uri_handler_unref(struct httpd_data *hd, httpd_uri_t *handler);
+
+/**
+ * @brief   Splits a wildcard URI template into its mandatory part and
+ *          its trailing special characters
+ *
+ * @param[in]  template  URI template
+ * @param[out] exact_len Length of the mandatory part, the optional character follows it
+ * @param[out] asterisk  Whether the template allows any characters at the end
+ * @param[out] quest     Whether the template has an optional character
+ *
+ * @return
+ *  - true  : if the template is valid
+ *  - false : otherwise, it never matches
+ */
+bool httpd_uri_template_parse(const char *template, size_t *exact_len, bool *asterisk, bool *quest);
+
+/**
+ * @brief   Checks if a path parameter such as "{id}" starts at a position
+ *          of the mandatory part of a wildcard URI template
+ *
+ * @param[in] template  URI template
+ * @param[in] pos       Position in the template
+ * @param[in] end       Length of the mandatory part of the template
+ *
+ * @return Length of the path parameter with its braces, 0 if there is none
+ */
+size_t httpd_uri_param_len(const char *template, size_t pos, size_t end);
+
+#ifdef CONFIG_HTTPD_URI_ROUTER
+/**
+ * @brief   Rebuilds the tree used to look up the URI handlers, to be called
+ *          each time the registered handlers change, with hd_calls_lock held
+ *
+ * @param[in] hd  Server instance data
+ *
+ * @return
+ *  - ESP_OK        : if the tree was built, or isn't used with this matching function
+ *  - ESP_ERR_NO_MEM: if it failed, the handlers are then scanned linearly
+ */
+esp_err_t httpd_router_update(struct httpd_data *hd);
+
+/**
+ * @brief   Looks up the handler for a URI and a method in the tree, with
+ *          hd_calls_lock held
+ *
+ * @param[in]  hd       Server instance data
+ * @param[in]  uri      URI path
+ * @param[in]  uri_len  Length of the URI path
+ * @param[in]  method   Method of the request
+ * @param[out] err      Set to 404 or 405 if no handler was found (optional)
+ * @param[out] handler  The handler found, NULL if none
+ *
+ * @return
+ *  - true  : if the tree was used
+ *  - false : if the handlers must be scanned linearly instead
+ */
+bool httpd_router_find(struct httpd_data *hd, const char *uri, size_t uri_len,
+                       httpd_method_t method, httpd_err_code_t *err, httpd_uri_t **handler);
+
+/**
+ * @brief   Frees the tree of the URI handlers
+ *
+ * @param[in] hd  Server instance data
+ */
+void httpd_router_delete(struct httpd_data *hd);
+#endif /* CONFIG_HTTPD_URI_ROUTER */
+
 /**
  * @brief   Validates the request to prevent users from calling APIs, that are to
  *          be called only inside a URI handler, outside the handler context
@@ -385,25 +673,52 @@ bool httpd_validate_req_ptr(httpd_req_t *r);
  * http_recv() after this reads the body of the request.
  *
  * @param[in] hd  Server instance data
+ * @param[in] r   Request storage to fill
+ * @param[in] ra  Additional request data storage to fill
  * @param[in] sd  Pointer to socket which is needed for receiving TCP packets.
  *
  * @return
  *  - ESP_OK    : if request packet is valid
  *  - ESP_FAIL  : otherwise
  */
-esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd);
+esp_err_t httpd_req_new(struct httpd_data *hd, httpd_req_t *r, struct httpd_req_aux *ra, struct sock_db *sd);
 
 /**
  * @brief   For an HTTP request, resets the resources allocated for it and
  *          purges any data left to be received
  *
  * @param[in] hd  Server instance data
+ * @param[in] r   The request to reset
  *
  * @return
  *  - ESP_OK    : if request packet deleted and resources cleaned.
  *  - ESP_FAIL  : otherwise.
  */
-esp_err_t httpd_req_delete(struct httpd_data *hd);
+esp_err_t httpd_req_delete(struct httpd_data *hd, httpd_req_t *r);
+
+/**
+ * @brief   Allocates temporary memory for a request, from the buffer of its
+ *          session if there is room left, else from the heap
+ *
+ * @note    The memory is released with httpd_req_free(). Memory taken from the
+ *          session is reclaimed after the request even if it isn't, but only the
+ *          last allocation is reclaimed at once by httpd_req_free().
+ *
+ * @param[in] r     The request
+ * @param[in] size  Size to allocate
+ *
+ * @return
+ *  - The memory, or NULL if the heap is exhausted
+ */
+void *httpd_req_alloc(httpd_req_t *r, size_t size);
+
+/**
+ * @brief   Releases memory allocated by httpd_req_alloc()
+ *
+ * @param[in] r     The request
+ * @param[in] ptr   The memory, may be NULL
+ */
+void httpd_req_free(httpd_req_t *r, void *ptr);
 
 /** End of Group : Parsing
  * @}
@@ -548,6 +863,37 @@ esp_err_t httpd_ws_respond_server_handshake(httpd_req_t *req, const char *suppor
  */
 esp_err_t httpd_ws_get_frame_type(httpd_req_t *req);
 
+/**
+ * @brief   Unmask a part of the payload of a WebSocket frame in place
+ *
+ * @param[in,out] payload       Part of the payload
+ * @param[in]     len           Length of the part
+ * @param[in]     mask_key      Mask key of the frame
+ * @param[in]     mask_offset   Offset of the part in the payload
+ */
+void httpd_ws_unmask_payload(uint8_t *payload, size_t len, const uint8_t *mask_key, size_t mask_offset);
+
+/**
+ * @brief   Release the broadcast frame still pending on a session
+ *
+ * @param[in] sess  Session
+ */
+void httpd_ws_bcast_drop(struct sock_db *sess);
+
+/**
+ * @brief   Send the broadcast frame pending on a session, as far as the client
+ *          takes it without blocking. Called by the server task once a
+ *          request of the session has been processed, e.g. by a worker.
+ *
+ * @param[in] hd    Server instance data
+ * @param[in] sess  Session with a broadcast frame pending
+ *
+ * @return
+ *  - ESP_OK   : The frame was sent, or the rest is still pending
+ *  - ESP_FAIL : Failed to send, the session is to be closed
+ */
+esp_err_t httpd_ws_bcast_send_pending(struct httpd_data *hd, struct sock_db *sess);
+
 /**
  * @brief   Trigger an httpd session close externally
  *
@@ -21,7 +21,12 @@
 #include "freertos/semphr.h"
 #endif
 
-#if defined(CONFIG_LWIP_MAX_SOCKETS)
+#if CONFIG_IDF_TARGET_LINUX && !CONFIG_LWIP_ENABLE
+/* The host's sockets are used, their number is only limited by the OS (and by FD_SETSIZE for select) */
+#if CONFIG_HTTPD_POLL_BACKEND_SELECT
+#define HTTPD_MAX_SOCKETS FD_SETSIZE
+#endif
+#elif defined(CONFIG_LWIP_MAX_SOCKETS)
 #define HTTPD_MAX_SOCKETS CONFIG_LWIP_MAX_SOCKETS
 #else
 /* LwIP component is not included into the build, use a default value */
@@ -32,11 +37,6 @@ static const int DEFAULT_KEEP_ALIVE_IDLE = 5;
 static const int DEFAULT_KEEP_ALIVE_INTERVAL= 5;
 static const int DEFAULT_KEEP_ALIVE_COUNT= 3;
 
-typedef struct {
-    fd_set *fdset;
-    struct httpd_data *hd;
-} process_session_context_t;
-
 static const char *TAG = "httpd";
 
 #ifdef CONFIG_HTTPD_ENABLE_EVENTS
@@ -231,6 +231,14 @@ static void httpd_process_ctrl_msg(struct httpd_data *hd)
             (*msg.hc_work)(msg.hc_work_arg);
         }
         break;
+    case HTTPD_CTRL_ASYNC_DONE:
+        /* Nothing to do, the sessions of completed async requests are re-armed on every iteration */
+        ESP_LOGD(TAG, LOG_FMT("async done"));
+        break;
+    case HTTPD_CTRL_WORKER_DONE:
+        /* Nothing to do, the results of the workers are picked up on every iteration */
+        ESP_LOGD(TAG, LOG_FMT("worker done"));
+        break;
     case HTTPD_CTRL_SHUTDOWN:
         ESP_LOGD(TAG, LOG_FMT("shutdown"));
         hd->hd_td.status = THREAD_STOPPING;
@@ -243,30 +251,105 @@ static void httpd_process_ctrl_msg(struct httpd_data *hd)
 #endif
 }
 
-// Called for each session from httpd_server
-static int httpd_process_session(struct sock_db *session, void *context)
+// Called once a request of a session has been processed, by the server task or by a worker
+static void httpd_session_processed(struct httpd_data *hd, struct sock_db *session, esp_err_t ret)
 {
-    if ((!session) || (!context)) {
-        return 0;
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    // Send the broadcast frame left for the client while a worker had the session
+    if (ret == ESP_OK && !session->close_deferred && session->ws_bcast) {
+        ret = httpd_ws_bcast_send_pending(hd, session);
     }
-
-    if (session->fd < 0) {
-        return 1;
+#endif
+    if (ret != ESP_OK || session->close_deferred) {
+        httpd_sess_delete(hd, session); // Delete session
+        return;
     }
+    session->lru_counter = ++hd->lru_counter;
 
-    // session is busy in an async task, do not process here.
     if (session->for_async_req) {
-        return 1;
+        // The request was handed over to an async task, which will re-arm the session when done
+        httpd_poll_del(hd, session);
+        return;
+    }
+    httpd_poll_add(hd, session);
+    if (httpd_sess_pending(hd, session)) {
+        // Data is buffered that the socket won't signal, process it on the next iteration
+        session->poll_pending = true;
+        hd->hd_sd_pending_count++;
+    }
+}
+
+// Called for each ready or pending session from httpd_server
+static void httpd_process_session(struct httpd_data *hd, struct sock_db *session)
+{
+    if (session->poll_pending) {
+        session->poll_pending = false;
+        hd->hd_sd_pending_count--;
+    }
+
+    // session was closed or is busy in an async task or a worker, do not process here.
+    if (session->fd < 0 || session->for_async_req || session->in_worker) {
+        return;
+    }
+
+    if (hd->hd_workers) {
+        // Stop watching the socket until the worker is done with the request
+        httpd_poll_del(hd, session);
+        httpd_worker_dispatch(hd, session);
+        return;
     }
 
-    process_session_context_t *ctx = (process_session_context_t *)context;
-    int fd = session->fd;
+    ESP_LOGD(TAG, LOG_FMT("processing socket %d"), session->fd);
+    httpd_session_processed(hd, session, httpd_sess_process(hd, session, &hd->hd_req, &hd->hd_req_aux));
+}
+
+// Picks up the sessions processed by the workers
+static void httpd_process_worker_results(struct httpd_data *hd)
+{
+    struct httpd_worker_result result;
+    __atomic_store_n(&hd->hd_worker_wakeup, false, __ATOMIC_SEQ_CST);
+    while (httpd_worker_get_result(hd, &result, 0)) {
+        result.session->in_worker = false;
+        httpd_session_processed(hd, result.session, result.ret);
+    }
+}
+
+// Enum function watching the sessions of completed async requests again
+static int httpd_rearm_async_session(struct sock_db *session, void *context)
+{
+    struct httpd_data *hd = (struct httpd_data *)context;
+    if (__atomic_exchange_n(&session->async_done, false, __ATOMIC_ACQ_REL)) {
+        httpd_poll_add(hd, session);
+    }
+    return 1;
+}
 
-    if (FD_ISSET(fd, ctx->fdset) || httpd_sess_pending(ctx->hd, session)) {
-        ESP_LOGD(TAG, LOG_FMT("processing socket %d"), fd);
-        if (httpd_sess_process(ctx->hd, session) != ESP_OK) {
-            httpd_sess_delete(ctx->hd, session); // Delete session
+// Stops the workers, processing the results they post until they have all exited
+static void httpd_stop_workers(struct httpd_data *hd)
+{
+    httpd_workers_stop(hd);
+    int running = hd->config.worker_count;
+    struct httpd_worker_result result;
+    while (running && httpd_worker_get_result(hd, &result, portMAX_DELAY)) {
+        if (!result.session) {
+            running--;
+            continue;
         }
+        result.session->in_worker = false;
+        httpd_session_processed(hd, result.session, result.ret);
+    }
+    httpd_workers_deinit(hd);
+}
+
+// Enum function processing sessions that had pending data after the previous iteration
+static int httpd_process_pending_session(struct sock_db *session, void *context)
+{
+    struct httpd_data *hd = (struct httpd_data *)context;
+    if (hd->hd_sd_pending_count == 0) {
+        return 0;
+    }
+    if (session->poll_pending) {
+        httpd_process_session(hd, session);
     }
     return 1;
 }
@@ -274,32 +357,22 @@ static int httpd_process_session(struct sock_db *session, void *context)
 /* Manage in-coming connection or data requests */
 static esp_err_t httpd_server(struct httpd_data *hd)
 {
-    fd_set read_set;
-    FD_ZERO(&read_set);
-    if (hd->config.lru_purge_enable || httpd_is_sess_available(hd)) {
-        /* Only listen for new connections if server has capacity to
-         * handle more (or when LRU purge is enabled, in which case
-         * older connections will be closed) */
-        FD_SET(hd->listen_fd, &read_set);
-    }
-    FD_SET(hd->ctrl_fd, &read_set);
-
-    int tmp_max_fd;
-    httpd_sess_set_descriptors(hd, &read_set, &tmp_max_fd);
-    int maxfd = MAX(hd->listen_fd, tmp_max_fd);
-    tmp_max_fd = maxfd;
-    maxfd = MAX(hd->ctrl_fd, tmp_max_fd);
-
-    ESP_LOGD(TAG, LOG_FMT("doing select maxfd+1 = %d"), maxfd + 1);
-    int active_cnt = select(maxfd + 1, &read_set, NULL, NULL, NULL);
+    /* Only listen for new connections if server has capacity to
+     * handle more (or when LRU purge is enabled, in which case
+     * older connections will be closed) */
+    bool listen = hd->config.lru_purge_enable || httpd_is_sess_available(hd);
+
+    /* Don't block if sessions still have pending data to be processed */
+    struct httpd_poll_result ready;
+    int active_cnt = httpd_poll_wait(hd, listen, hd->hd_sd_pending_count ? 0 : -1, &ready);
     if (active_cnt < 0) {
-        ESP_LOGE(TAG, LOG_FMT("error in select (%d)"), errno);
+        ESP_LOGE(TAG, LOG_FMT("error in poll (%d)"), errno);
         httpd_sess_delete_invalid(hd);
         return ESP_OK;
     }
 
     /* Case0: Do we have a control message? */
-    if (FD_ISSET(hd->ctrl_fd, &read_set)) {
+    if (ready.ctrl_ready) {
         ESP_LOGD(TAG, LOG_FMT("processing ctrl message"));
         httpd_process_ctrl_msg(hd);
         if (hd->hd_td.status == THREAD_STOPPING) {
@@ -308,17 +381,33 @@ static esp_err_t httpd_server(struct httpd_data *hd)
         }
     }
 
-    /* Case1: Do we have any activity on the current data
-     * sessions? */
-    process_session_context_t context = {
-        .fdset = &read_set,
-        .hd = hd
-    };
-    httpd_sess_enum(hd, httpd_process_session, &context);
+    /* Case1: Have workers finished processing sessions?
+     * These are picked up on every iteration, as the wakeup
+     * through the control socket can be lost if it is full */
+    if (hd->hd_workers) {
+        httpd_process_worker_results(hd);
+    }
+
+    /* Have async requests completed? The flag is cleared before
+     * the sessions are visited, so that a session marked meanwhile
+     * is re-armed now or on the next iteration */
+    if (__atomic_exchange_n(&hd->hd_async_done, false, __ATOMIC_SEQ_CST)) {
+        httpd_sess_enum(hd, httpd_rearm_async_session, hd);
+    }
 
-    /* Case2: Do we have any incoming connection requests to
+    /* Case2: Do we have any activity on the current data
+     * sessions? Only the sessions reported ready by the
+     * backend and the ones with pending data are visited */
+    for (int i = 0; i < ready.sess_count; i++) {
+        httpd_process_session(hd, ready.sessions[i]);
+    }
+    if (hd->hd_sd_pending_count) {
+        httpd_sess_enum(hd, httpd_process_pending_session, hd);
+    }
+
+    /* Case3: Do we have any incoming connection requests to
      * process? */
-    if (FD_ISSET(hd->listen_fd, &read_set)) {
+    if (ready.listen_ready) {
         ESP_LOGD(TAG, LOG_FMT("processing listen socket %d"), hd->listen_fd);
         if (httpd_accept_conn(hd, hd->listen_fd) != ESP_OK) {
             ESP_LOGW(TAG, LOG_FMT("error accepting new connection"));
@@ -343,9 +432,13 @@ static void httpd_thread(void *arg)
     }
 
     ESP_LOGD(TAG, LOG_FMT("web server exiting"));
+    if (hd->hd_workers) {
+        httpd_stop_workers(hd);
+    }
     close(hd->msg_fd);
     cs_free_ctrl_sock(hd->ctrl_fd);
     httpd_sess_close_all(hd);
+    httpd_poll_deinit(hd);
     close(hd->listen_fd);
     hd->hd_td.status = THREAD_STOPPED;
     httpd_os_thread_delete();
@@ -445,18 +538,18 @@ static esp_err_t httpd_server_init(struct httpd_data *hd)
 static struct httpd_data *httpd_create(const httpd_config_t *config)
 {
     /* Allocate memory for httpd instance data */
-    struct httpd_data *hd = calloc(1, sizeof(struct httpd_data));
+    struct httpd_data *hd = httpd_calloc(1, sizeof(struct httpd_data));
     if (!hd) {
         ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP server instance"));
         return NULL;
     }
-    hd->hd_calls = calloc(config->max_uri_handlers, sizeof(httpd_uri_t *));
+    hd->hd_calls = httpd_calloc(config->max_uri_handlers, sizeof(httpd_uri_t *));
     if (!hd->hd_calls) {
         ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP URI handlers"));
         free(hd);
         return NULL;
     }
-    hd->hd_sd = calloc(config->max_open_sockets, sizeof(struct sock_db));
+    hd->hd_sd = httpd_calloc(config->max_open_sockets, sizeof(struct sock_db));
     if (!hd->hd_sd) {
         ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP session data"));
         free(hd->hd_calls);
@@ -464,7 +557,7 @@ static struct httpd_data *httpd_create(const httpd_config_t *config)
         return NULL;
     }
     struct httpd_req_aux *ra = &hd->hd_req_aux;
-    ra->resp_hdrs = calloc(config->max_resp_headers, sizeof(struct resp_hdr));
+    ra->resp_hdrs = httpd_calloc(config->max_resp_headers, sizeof(struct resp_hdr));
     if (!ra->resp_hdrs) {
         ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP response headers"));
         free(hd->hd_sd);
@@ -472,7 +565,7 @@ static struct httpd_data *httpd_create(const httpd_config_t *config)
         free(hd);
         return NULL;
     }
-    hd->err_handler_fns = calloc(HTTPD_ERR_CODE_MAX, sizeof(httpd_err_handler_func_t));
+    hd->err_handler_fns = httpd_calloc(HTTPD_ERR_CODE_MAX, sizeof(httpd_err_handler_func_t));
     if (!hd->err_handler_fns) {
         ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP error handlers"));
         free(ra->resp_hdrs);
@@ -481,6 +574,16 @@ static struct httpd_data *httpd_create(const httpd_config_t *config)
         free(hd);
         return NULL;
     }
+    hd->hd_calls_lock = xSemaphoreCreateMutex();
+    if (!hd->hd_calls_lock) {
+        ESP_LOGE(TAG, LOG_FMT("Failed to create the lock of the HTTP URI handlers"));
+        free(hd->err_handler_fns);
+        free(ra->resp_hdrs);
+        free(hd->hd_sd);
+        free(hd->hd_calls);
+        free(hd);
+        return NULL;
+    }
     /* Save the configuration for this instance */
     hd->config = *config;
     return hd;
@@ -497,6 +600,7 @@ static void httpd_delete(struct httpd_data *hd)
     /* Free registered URI handlers */
     httpd_unregister_all_uri_handlers(hd);
     free(hd->hd_calls);
+    vSemaphoreDelete(hd->hd_calls_lock);
     free(hd);
 }
 
@@ -516,12 +620,14 @@ esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
      *     3) for receiving control messages over UDP
      * So the total number of required sockets is max_open_sockets + 3
      */
+#ifdef HTTPD_MAX_SOCKETS
     if (HTTPD_MAX_SOCKETS < config->max_open_sockets + 3) {
         ESP_LOGE(TAG, "Config option max_open_sockets is too large (max allowed %d, 3 sockets used by HTTP server internally)\n\t"
                  "Either decrease this or configure LWIP_MAX_SOCKETS to a larger value",
                  HTTPD_MAX_SOCKETS - 3);
         return ESP_ERR_INVALID_ARG;
     }
+#endif
 
     struct httpd_data *hd = httpd_create(config);
     if (hd == NULL) {
@@ -547,6 +653,20 @@ esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
     }
 
     httpd_sess_init(hd);
+    esp_err_t ret = httpd_poll_init(hd);
+    if (ret == ESP_OK) {
+        ret = httpd_workers_init(hd);
+        if (ret != ESP_OK) {
+            httpd_poll_deinit(hd);
+        }
+    }
+    if (ret != ESP_OK) {
+        close(hd->msg_fd);
+        cs_free_ctrl_sock(hd->ctrl_fd);
+        close(hd->listen_fd);
+        httpd_delete(hd);
+        return ret;
+    }
     if (httpd_os_thread_create(&hd->hd_td.handle, "httpd",
                                hd->config.stack_size,
                                hd->config.task_priority,
@@ -554,6 +674,10 @@ esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
                                hd->config.core_id,
                                hd->config.task_caps) != ESP_OK) {
         /* Failed to launch task */
+        if (hd->hd_workers) {
+            httpd_stop_workers(hd);
+        }
+        httpd_poll_deinit(hd);
         httpd_delete(hd);
         return ESP_ERR_HTTPD_TASK;
     }
@@ -623,3 +747,31 @@ esp_http_server_event_id_t httpd_get_server_state(httpd_handle_t handle)
     }
     return hd->http_server_state;
 }
+
+#if CONFIG_HTTPD_ALLOC_STATS
+/* Shared by all the servers, and updated by their worker tasks too */
+static uint32_t httpd_alloc_count;
+
+void *httpd_malloc(size_t size)
+{
+    __atomic_add_fetch(&httpd_alloc_count, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void *httpd_calloc(size_t n, size_t size)
+{
+    __atomic_add_fetch(&httpd_alloc_count, 1, __ATOMIC_RELAXED);
+    return calloc(n, size);
+}
+
+void *httpd_realloc(void *ptr, size_t size)
+{
+    __atomic_add_fetch(&httpd_alloc_count, 1, __ATOMIC_RELAXED);
+    return realloc(ptr, size);
+}
+
+uint32_t httpd_get_alloc_count(void)
+{
+    return __atomic_load_n(&httpd_alloc_count, __ATOMIC_RELAXED);
+}
+#endif
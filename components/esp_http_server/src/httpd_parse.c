@@ -503,9 +503,10 @@ static int read_block(httpd_req_t *req, http_parser *parser, size_t offset, size
     size_t at_offset = parser_data->last.at - raux->scratch;
     /* Allocate the buffer according to offset and buf_len. Offset is
        from where the reading will start and buf_len is till what length
-       the buffer will be read.
+       the buffer will be read. The buffer of the session already has the
+       largest size.
     */
-    char *new_scratch = (char *) realloc(raux->scratch, offset + buf_len);
+    char *new_scratch = raux->arena ? raux->scratch : (char *) httpd_realloc(raux->scratch, offset + buf_len);
     if (new_scratch == NULL) {
         free(raux->scratch);
         raux->scratch = NULL;
@@ -647,9 +648,8 @@ static void parse_init(httpd_req_t *r, http_parser *parser, parser_data_t *data)
 
 /* Function that receives TCP data and runs parser on it
  */
-static esp_err_t httpd_parse_req(struct httpd_data *hd)
+static esp_err_t httpd_parse_req(struct httpd_data *hd, httpd_req_t *r)
 {
-    httpd_req_t *r = &hd->hd_req;
     int blk_len,  offset;
     http_parser   parser = {};
     parser_data_t parser_data = {};
@@ -689,7 +689,7 @@ static esp_err_t httpd_parse_req(struct httpd_data *hd)
     } while (parser_data.status != PARSING_COMPLETE);
 
     ESP_LOGD(TAG, LOG_FMT("parsing complete"));
-    return httpd_uri(hd);
+    return httpd_uri(hd, r);
 }
 
 static void init_req(httpd_req_t *r, httpd_config_t *config)
@@ -716,6 +716,11 @@ static void init_req_aux(struct httpd_req_aux *ra, httpd_config_t *config)
     ra->resp_hdrs_count = 0;
     ra->scratch = NULL;
     ra->scratch_cur_size = 0;
+    ra->arena = NULL;
+    ra->arena_size = 0;
+    ra->arena_used = 0;
+    ra->arena_last = 0;
+    ra->uri_template = NULL;
     ra->max_req_hdr_len = (config->max_req_hdr_len > 0) ? config->max_req_hdr_len : CONFIG_HTTPD_MAX_REQ_HDR_LEN;
     ra->max_uri_len = (config->max_uri_len > 0) ? config->max_uri_len : CONFIG_HTTPD_MAX_URI_LEN;
     ra->scratch_size_limit = ra->max_uri_len;
@@ -749,8 +754,12 @@ static void httpd_req_cleanup(httpd_req_t *r)
 
     /* Clear out the request and request_aux structures */
     ra->sd = NULL;
-    free(ra->scratch);
+    if (ra->arena == NULL) {
+        free(ra->scratch);
+    }
     ra->scratch = NULL;
+    ra->arena = NULL;
+    ra->arena_used = 0;
     ra->scratch_size_limit = 0;
     ra->scratch_cur_size = 0;
     r->handle = NULL;
@@ -758,19 +767,44 @@ static void httpd_req_cleanup(httpd_req_t *r)
     r->user_ctx = NULL;
 }
 
+/* Keeps the allocations from the buffer of the session aligned for any type */
+#define HTTPD_REQ_ALIGN(size)   (((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+#if CONFIG_HTTPD_SESS_ARENA
+/* Lays out the buffer of the session for a request: the scratch buffer,
+ * in its largest size, then the memory for httpd_req_alloc() */
+static void httpd_req_arena_init(struct httpd_req_aux *ra, struct sock_db *sd)
+{
+    size_t scratch_size = HTTPD_REQ_ALIGN(MAX(ra->max_uri_len, ra->max_req_hdr_len));
+    size_t arena_size = scratch_size + ra->max_req_hdr_len;
+
+    if (sd->arena == NULL) {
+        /* Kept until the session is closed. Without it, the request
+         * allocates from the heap as it goes */
+        sd->arena = httpd_malloc(arena_size);
+        if (sd->arena == NULL) {
+            return;
+        }
+    }
+    ra->arena = sd->arena;
+    ra->arena_size = arena_size;
+    ra->arena_used = scratch_size;
+    ra->arena_last = scratch_size;
+    ra->scratch = sd->arena;
+}
+#endif
+
 /* Function that processes incoming TCP data and
  * updates the http request data httpd_req_t
  */
-esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd)
+esp_err_t httpd_req_new(struct httpd_data *hd, httpd_req_t *r, struct httpd_req_aux *ra, struct sock_db *sd)
 {
-    httpd_req_t *r = &hd->hd_req;
     init_req(r, &hd->config);
-    init_req_aux(&hd->hd_req_aux, &hd->config);
+    init_req_aux(ra, &hd->config);
     r->handle = hd;
-    r->aux = &hd->hd_req_aux;
+    r->aux = ra;
 
     /* Associate the request to the socket */
-    struct httpd_req_aux *ra = r->aux;
     ra->sd = sd;
 
     /* Set defaults */
@@ -831,8 +865,12 @@ esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd)
     }
 #endif
 
+#if CONFIG_HTTPD_SESS_ARENA
+    httpd_req_arena_init(ra, sd);
+#endif
+
     /* Parse request */
-    ret = httpd_parse_req(hd);
+    ret = httpd_parse_req(hd, r);
     if (ret != ESP_OK) {
         httpd_req_cleanup(r);
     }
@@ -841,9 +879,8 @@ esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd)
 
 /* Function that resets the http request data
  */
-esp_err_t httpd_req_delete(struct httpd_data *hd)
+esp_err_t httpd_req_delete(struct httpd_data *hd, httpd_req_t *r)
 {
-    httpd_req_t *r = &hd->hd_req;
     struct httpd_req_aux *ra = r->aux;
 
     /* Finish off reading any pending/leftover data */
@@ -874,6 +911,31 @@ esp_err_t httpd_req_delete(struct httpd_data *hd)
     return ESP_OK;
 }
 
+void *httpd_req_alloc(httpd_req_t *r, size_t size)
+{
+    struct httpd_req_aux *ra = r->aux;
+    if (ra->arena && HTTPD_REQ_ALIGN(size) <= ra->arena_size - ra->arena_used) {
+        ra->arena_last = ra->arena_used;
+        ra->arena_used += HTTPD_REQ_ALIGN(size);
+        return ra->arena + ra->arena_last;
+    }
+    return httpd_malloc(size);
+}
+
+void httpd_req_free(httpd_req_t *r, void *ptr)
+{
+    struct httpd_req_aux *ra = r->aux;
+    char *p = ptr;
+    if (ra->arena && p >= ra->arena && p < ra->arena + ra->arena_size) {
+        /* Only the last allocation can be given back before the request ends */
+        if (p == ra->arena + ra->arena_last) {
+            ra->arena_used = ra->arena_last;
+        }
+        return;
+    }
+    free(ptr);
+}
+
 /* Validates the request to prevent users from calling APIs, that are to
  * be called only inside URI handler, outside the handler context
  */
@@ -883,10 +945,16 @@ bool httpd_validate_req_ptr(httpd_req_t *r)
         struct httpd_data *hd = (struct httpd_data *) r->handle;
         if (hd) {
             /* Check if this function is running in the context of
-             * the correct httpd server thread */
-            if (httpd_os_thread_handle() == hd->hd_td.handle) {
+             * the correct httpd server thread or of one of its workers */
+            othread_t current = httpd_os_thread_handle();
+            if (current == hd->hd_td.handle) {
                 return true;
             }
+            for (int i = 0; hd->hd_workers && i < hd->config.worker_count; i++) {
+                if (current == hd->hd_workers[i].handle) {
+                    return true;
+                }
+            }
         }
     }
     return false;
@@ -1206,7 +1274,7 @@ esp_err_t httpd_req_get_cookie_val(httpd_req_t *req, const char *cookie_name, ch
     if (hdr_len_cookie <= 0) {
         return ESP_ERR_NOT_FOUND;
     }
-    cookie_str = malloc(hdr_len_cookie + 1);
+    cookie_str = httpd_req_alloc(req, hdr_len_cookie + 1);
     if (cookie_str == NULL) {
         ESP_LOGE(TAG, "Failed to allocate memory for cookie string");
         return ESP_ERR_NO_MEM;
@@ -1214,12 +1282,12 @@ esp_err_t httpd_req_get_cookie_val(httpd_req_t *req, const char *cookie_name, ch
 
     if (httpd_req_get_hdr_value_str(req, "Cookie", cookie_str, hdr_len_cookie + 1) != ESP_OK) {
         ESP_LOGW(TAG, "Cookie not found in header uri:[%s]", req->uri);
-        free(cookie_str);
+        httpd_req_free(req, cookie_str);
         return ESP_ERR_NOT_FOUND;
     }
 
     ret = httpd_cookie_key_value(cookie_str, cookie_name, val, val_size);
-    free(cookie_str);
+    httpd_req_free(req, cookie_str);
     return ret;
 
 }
@@ -0,0 +1,338 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <esp_log.h>
+#include <esp_err.h>
+
+#include <esp_http_server.h>
+#include "esp_httpd_priv.h"
+
+#if CONFIG_HTTPD_POLL_BACKEND_EPOLL
+#include <sys/epoll.h>
+#elif CONFIG_HTTPD_POLL_BACKEND_POLL
+#include <sys/poll.h>
+#endif
+
+static const char *TAG = "httpd_poll";
+
+/* The control and listening sockets are registered with the backend
+ * before the sessions, the socket of session i is registered as
+ * HTTPD_POLL_SESS_INDEX + i */
+#define HTTPD_POLL_CTRL_INDEX       0
+#define HTTPD_POLL_LISTEN_INDEX     1
+#define HTTPD_POLL_SESS_INDEX       2
+
+struct httpd_poll {
+    struct sock_db **ready;         /*!< Ready sessions returned by httpd_poll_wait() */
+#if CONFIG_HTTPD_POLL_BACKEND_EPOLL
+    int epoll_fd;                   /*!< epoll instance */
+    bool listen_watched;            /*!< Whether the listening socket is currently watched */
+    bool *sess_watched;             /*!< Whether the socket of each session is currently registered */
+    struct epoll_event *events;     /*!< Events returned by epoll_wait() */
+#elif CONFIG_HTTPD_POLL_BACKEND_POLL
+    struct pollfd *pfds;            /*!< Control, listening and session sockets, -1 if not watched */
+#endif
+};
+
+static inline int httpd_poll_sess_index(struct httpd_data *hd, struct sock_db *session)
+{
+    return session - hd->hd_sd;
+}
+
+#if CONFIG_HTTPD_POLL_BACKEND_EPOLL
+
+static int httpd_poll_ctl(struct httpd_poll *hp, int op, int fd, uint32_t events, int index)
+{
+    struct epoll_event ev = {
+        .events = events,
+        .data.u32 = index,
+    };
+    return epoll_ctl(hp->epoll_fd, op, fd, &ev);
+}
+
+static esp_err_t httpd_poll_backend_init(struct httpd_data *hd, struct httpd_poll *hp)
+{
+    hp->sess_watched = httpd_calloc(hd->config.max_open_sockets, sizeof(bool));
+    hp->events = httpd_calloc(hd->config.max_open_sockets + HTTPD_POLL_SESS_INDEX, sizeof(struct epoll_event));
+    if (!hp->sess_watched || !hp->events) {
+        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for epoll events"));
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    hp->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (hp->epoll_fd < 0) {
+        ESP_LOGE(TAG, LOG_FMT("error in epoll_create1 (%d)"), errno);
+        return ESP_FAIL;
+    }
+    /* The listening socket is registered without events and armed by httpd_poll_wait() */
+    if (httpd_poll_ctl(hp, EPOLL_CTL_ADD, hd->ctrl_fd, EPOLLIN, HTTPD_POLL_CTRL_INDEX) < 0 ||
+            httpd_poll_ctl(hp, EPOLL_CTL_ADD, hd->listen_fd, 0, HTTPD_POLL_LISTEN_INDEX) < 0) {
+        ESP_LOGE(TAG, LOG_FMT("error in epoll_ctl (%d)"), errno);
+        close(hp->epoll_fd);
+        hp->epoll_fd = -1;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void httpd_poll_backend_deinit(struct httpd_poll *hp)
+{
+    if (hp->epoll_fd >= 0) {
+        close(hp->epoll_fd);
+    }
+    free(hp->events);
+    free(hp->sess_watched);
+}
+
+static void httpd_poll_backend_add(struct httpd_data *hd, struct httpd_poll *hp, struct sock_db *session)
+{
+    int index = httpd_poll_sess_index(hd, session);
+    if (hp->sess_watched[index]) {
+        return;
+    }
+    if (httpd_poll_ctl(hp, EPOLL_CTL_ADD, session->fd, EPOLLIN, HTTPD_POLL_SESS_INDEX + index) < 0) {
+        /* The session will be closed on the next failed receive */
+        ESP_LOGW(TAG, LOG_FMT("error in epoll_ctl for fd %d (%d)"), session->fd, errno);
+        return;
+    }
+    hp->sess_watched[index] = true;
+}
+
+static void httpd_poll_backend_del(struct httpd_data *hd, struct httpd_poll *hp, struct sock_db *session)
+{
+    int index = httpd_poll_sess_index(hd, session);
+    if (!hp->sess_watched[index]) {
+        return;
+    }
+    hp->sess_watched[index] = false;
+    if (httpd_poll_ctl(hp, EPOLL_CTL_DEL, session->fd, 0, 0) < 0) {
+        ESP_LOGD(TAG, LOG_FMT("error in epoll_ctl for fd %d (%d)"), session->fd, errno);
+    }
+}
+
+static int httpd_poll_backend_wait(struct httpd_data *hd, struct httpd_poll *hp, bool listen,
+                                   int timeout_ms, struct httpd_poll_result *result)
+{
+    if (listen != hp->listen_watched) {
+        if (httpd_poll_ctl(hp, EPOLL_CTL_MOD, hd->listen_fd, listen ? EPOLLIN : 0, HTTPD_POLL_LISTEN_INDEX) < 0) {
+            return -1;
+        }
+        hp->listen_watched = listen;
+    }
+
+    int max_events = hd->config.max_open_sockets + HTTPD_POLL_SESS_INDEX;
+    ESP_LOGD(TAG, LOG_FMT("doing epoll_wait"));
+    int active_cnt = epoll_wait(hp->epoll_fd, hp->events, max_events, timeout_ms);
+    if (active_cnt < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < active_cnt; i++) {
+        uint32_t index = hp->events[i].data.u32;
+        if (index == HTTPD_POLL_CTRL_INDEX) {
+            result->ctrl_ready = true;
+        } else if (index == HTTPD_POLL_LISTEN_INDEX) {
+            result->listen_ready = true;
+        } else {
+            result->sessions[result->sess_count++] = &hd->hd_sd[index - HTTPD_POLL_SESS_INDEX];
+        }
+    }
+    return active_cnt;
+}
+
+#elif CONFIG_HTTPD_POLL_BACKEND_POLL
+
+static esp_err_t httpd_poll_backend_init(struct httpd_data *hd, struct httpd_poll *hp)
+{
+    int nfds = hd->config.max_open_sockets + HTTPD_POLL_SESS_INDEX;
+    hp->pfds = httpd_calloc(nfds, sizeof(struct pollfd));
+    if (!hp->pfds) {
+        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for poll descriptors"));
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    for (int i = 0; i < nfds; i++) {
+        hp->pfds[i].fd = -1;
+        hp->pfds[i].events = POLLIN;
+    }
+    hp->pfds[HTTPD_POLL_CTRL_INDEX].fd = hd->ctrl_fd;
+    return ESP_OK;
+}
+
+static void httpd_poll_backend_deinit(struct httpd_poll *hp)
+{
+    free(hp->pfds);
+}
+
+static void httpd_poll_backend_add(struct httpd_data *hd, struct httpd_poll *hp, struct sock_db *session)
+{
+    hp->pfds[HTTPD_POLL_SESS_INDEX + httpd_poll_sess_index(hd, session)].fd = session->fd;
+}
+
+static void httpd_poll_backend_del(struct httpd_data *hd, struct httpd_poll *hp, struct sock_db *session)
+{
+    hp->pfds[HTTPD_POLL_SESS_INDEX + httpd_poll_sess_index(hd, session)].fd = -1;
+}
+
+static int httpd_poll_backend_wait(struct httpd_data *hd, struct httpd_poll *hp, bool listen,
+                                   int timeout_ms, struct httpd_poll_result *result)
+{
+    int nfds = hd->config.max_open_sockets + HTTPD_POLL_SESS_INDEX;
+    hp->pfds[HTTPD_POLL_LISTEN_INDEX].fd = listen ? hd->listen_fd : -1;
+
+    ESP_LOGD(TAG, LOG_FMT("doing poll nfds = %d"), nfds);
+    int active_cnt = poll(hp->pfds, nfds, timeout_ms);
+    if (active_cnt < 0) {
+        return -1;
+    }
+
+    /* Stop looking once all the ready descriptors have been found */
+    for (int i = 0, found = 0; i < nfds && found < active_cnt; i++) {
+        if (hp->pfds[i].fd < 0 || hp->pfds[i].revents == 0) {
+            continue;
+        }
+        found++;
+        if (i == HTTPD_POLL_CTRL_INDEX) {
+            result->ctrl_ready = true;
+        } else if (i == HTTPD_POLL_LISTEN_INDEX) {
+            result->listen_ready = true;
+        } else {
+            /* Errors and hang-ups are reported by the next receive on the session */
+            result->sessions[result->sess_count++] = &hd->hd_sd[i - HTTPD_POLL_SESS_INDEX];
+        }
+    }
+    return active_cnt;
+}
+
+#else /* CONFIG_HTTPD_POLL_BACKEND_SELECT */
+
+static esp_err_t httpd_poll_backend_init(struct httpd_data *hd, struct httpd_poll *hp)
+{
+    return ESP_OK;
+}
+
+static void httpd_poll_backend_deinit(struct httpd_poll *hp)
+{
+}
+
+/* The descriptor set is rebuilt from the socket database on every wakeup */
+static void httpd_poll_backend_add(struct httpd_data *hd, struct httpd_poll *hp, struct sock_db *session)
+{
+}
+
+static void httpd_poll_backend_del(struct httpd_data *hd, struct httpd_poll *hp, struct sock_db *session)
+{
+}
+
+static int httpd_poll_backend_wait(struct httpd_data *hd, struct httpd_poll *hp, bool listen,
+                                   int timeout_ms, struct httpd_poll_result *result)
+{
+    fd_set read_set;
+    FD_ZERO(&read_set);
+    if (listen) {
+        FD_SET(hd->listen_fd, &read_set);
+    }
+    FD_SET(hd->ctrl_fd, &read_set);
+
+    int tmp_max_fd;
+    httpd_sess_set_descriptors(hd, &read_set, &tmp_max_fd);
+    int maxfd = MAX(hd->listen_fd, tmp_max_fd);
+    tmp_max_fd = maxfd;
+    maxfd = MAX(hd->ctrl_fd, tmp_max_fd);
+
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    ESP_LOGD(TAG, LOG_FMT("doing select maxfd+1 = %d"), maxfd + 1);
+    int active_cnt = select(maxfd + 1, &read_set, NULL, NULL, (timeout_ms < 0) ? NULL : &tv);
+    if (active_cnt < 0) {
+        return -1;
+    }
+
+    result->ctrl_ready = FD_ISSET(hd->ctrl_fd, &read_set);
+    result->listen_ready = FD_ISSET(hd->listen_fd, &read_set);
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        struct sock_db *session = &hd->hd_sd[i];
+        if (session->fd >= 0 && !session->for_async_req && !session->in_worker && FD_ISSET(session->fd, &read_set)) {
+            result->sessions[result->sess_count++] = session;
+        }
+    }
+    return active_cnt;
+}
+
+#endif /* CONFIG_HTTPD_POLL_BACKEND_SELECT */
+
+esp_err_t httpd_poll_init(struct httpd_data *hd)
+{
+    struct httpd_poll *hp = httpd_calloc(1, sizeof(struct httpd_poll));
+    if (!hp) {
+        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for polling backend"));
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+#if CONFIG_HTTPD_POLL_BACKEND_EPOLL
+    hp->epoll_fd = -1;
+#endif
+    hp->ready = httpd_calloc(hd->config.max_open_sockets, sizeof(struct sock_db *));
+    esp_err_t ret = hp->ready ? httpd_poll_backend_init(hd, hp) : ESP_ERR_HTTPD_ALLOC_MEM;
+    if (ret != ESP_OK) {
+        httpd_poll_backend_deinit(hp);
+        free(hp->ready);
+        free(hp);
+        return ret;
+    }
+    hd->hd_poll = hp;
+    return ESP_OK;
+}
+
+void httpd_poll_deinit(struct httpd_data *hd)
+{
+    struct httpd_poll *hp = hd->hd_poll;
+    if (!hp) {
+        return;
+    }
+    httpd_poll_backend_deinit(hp);
+    free(hp->ready);
+    free(hp);
+    hd->hd_poll = NULL;
+}
+
+void httpd_poll_add(struct httpd_data *hd, struct sock_db *session)
+{
+    if (!hd->hd_poll || session->fd < 0 || session->for_async_req || session->in_worker) {
+        return;
+    }
+    httpd_poll_backend_add(hd, hd->hd_poll, session);
+}
+
+void httpd_poll_del(struct httpd_data *hd, struct sock_db *session)
+{
+    if (session->poll_pending) {
+        session->poll_pending = false;
+        hd->hd_sd_pending_count--;
+    }
+    if (!hd->hd_poll || session->fd < 0) {
+        return;
+    }
+    httpd_poll_backend_del(hd, hd->hd_poll, session);
+}
+
+int httpd_poll_wait(struct httpd_data *hd, bool listen, int timeout_ms, struct httpd_poll_result *result)
+{
+    result->ctrl_ready = false;
+    result->listen_ready = false;
+    result->sess_count = 0;
+    result->sessions = hd->hd_poll->ready;
+
+    int active_cnt = httpd_poll_backend_wait(hd, hd->hd_poll, listen, timeout_ms, result);
+    if (active_cnt < 0 && errno == EINTR) {
+        /* Interrupted by a signal, nothing is ready */
+        return 0;
+    }
+    return active_cnt;
+}
@@ -0,0 +1,388 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_err.h>
+
+#include <esp_http_server.h>
+#include "esp_httpd_priv.h"
+
+#ifdef CONFIG_HTTPD_URI_ROUTER
+
+static const char *TAG = "httpd_router";
+
+/* Methods are kept as bitmaps in the nodes to quickly tell whether a
+ * handler may match, methods which don't fit share a bit */
+#define HTTPD_ROUTER_METHOD_ANY     (1ULL << 63)
+#define HTTPD_ROUTER_METHOD_OTHER   (1ULL << 62)
+
+/**
+ * @brief   Registered URI handler ending at a node of the tree
+ */
+struct httpd_route {
+    const httpd_uri_t *handler;             /*!< The handler, owned by hd_calls */
+    httpd_method_t method;                  /*!< Method of the handler */
+    int order;                              /*!< Index in hd_calls, the first registered handler wins */
+    bool prefix;                            /*!< Matches any characters following, for templates ending with '*' */
+};
+
+/**
+ * @brief   Node of the radix tree. The edges are labelled with the literal
+ *          parts of the templates, a path parameter has an edge of its own
+ *          matching a whole path segment.
+ */
+struct httpd_router_node {
+    const char *label;                      /*!< Characters leading to this node, points into the templates copied after the root */
+    size_t label_len;                       /*!< Length of the label */
+    struct httpd_router_node **children;    /*!< Children, their labels start with distinct characters */
+    size_t child_count;                     /*!< Number of children */
+    struct httpd_router_node *param;        /*!< Child matching a path parameter */
+    struct httpd_route *routes;             /*!< Handlers ending at this node */
+    size_t route_count;                     /*!< Number of handlers */
+    uint64_t methods;                       /*!< Methods of the handlers matching up to this node */
+    uint64_t prefix_methods;                /*!< Methods of the handlers matching from this node onwards */
+};
+
+/**
+ * @brief   URI router of a server instance, guarded by hd_calls_lock
+ */
+struct httpd_router {
+    struct httpd_router_node *root;         /*!< The tree, NULL if the handlers are scanned linearly */
+};
+
+/**
+ * @brief   Best handler found so far during a lookup
+ */
+struct httpd_router_match {
+    const httpd_uri_t *handler;             /*!< Handler matching the URI and the method */
+    int order;                              /*!< Index of the handler in hd_calls */
+    bool uri_found;                         /*!< A handler matches the URI, with any method */
+};
+
+static uint64_t httpd_router_method_bit(int method)
+{
+    if (method == HTTP_ANY) {
+        return HTTPD_ROUTER_METHOD_ANY;
+    }
+    if (method >= 0 && method < 62) {
+        return 1ULL << method;
+    }
+    return HTTPD_ROUTER_METHOD_OTHER;
+}
+
+static void httpd_router_node_free(struct httpd_router_node *node)
+{
+    if (!node) {
+        return;
+    }
+    for (size_t i = 0; i < node->child_count; i++) {
+        httpd_router_node_free(node->children[i]);
+    }
+    httpd_router_node_free(node->param);
+    free(node->children);
+    free(node->routes);
+    free(node);
+}
+
+static struct httpd_router_node *httpd_router_child(const struct httpd_router_node *node, char c)
+{
+    for (size_t i = 0; i < node->child_count; i++) {
+        if (node->children[i]->label[0] == c) {
+            return node->children[i];
+        }
+    }
+    return NULL;
+}
+
+static struct httpd_router_node *httpd_router_add_child(struct httpd_router_node *node,
+                                                        const char *label, size_t label_len)
+{
+    struct httpd_router_node *child = httpd_calloc(1, sizeof(struct httpd_router_node));
+    struct httpd_router_node **children = httpd_realloc(node->children,
+                                                  (node->child_count + 1) * sizeof(struct httpd_router_node *));
+    if (!child || !children) {
+        free(child);
+        /* The old array is still valid if realloc failed */
+        node->children = children ? children : node->children;
+        return NULL;
+    }
+    child->label = label;
+    child->label_len = label_len;
+    children[node->child_count++] = child;
+    node->children = children;
+    return child;
+}
+
+/* Walks down the literal characters of a template, adding the missing nodes */
+static struct httpd_router_node *httpd_router_insert_literal(struct httpd_router_node *node,
+                                                             const char *str, size_t len)
+{
+    while (len) {
+        struct httpd_router_node *child = httpd_router_child(node, str[0]);
+        if (!child) {
+            return httpd_router_add_child(node, str, len);
+        }
+
+        size_t common = 1;
+        while (common < child->label_len && common < len && child->label[common] == str[common]) {
+            common++;
+        }
+        if (common < child->label_len) {
+            /* Split the edge, the new node takes the place of the child */
+            struct httpd_router_node *split = httpd_calloc(1, sizeof(struct httpd_router_node));
+            if (!split) {
+                return NULL;
+            }
+            split->children = httpd_malloc(sizeof(struct httpd_router_node *));
+            if (!split->children) {
+                free(split);
+                return NULL;
+            }
+            split->label = child->label;
+            split->label_len = common;
+            split->children[0] = child;
+            split->child_count = 1;
+            child->label += common;
+            child->label_len -= common;
+            for (size_t i = 0; i < node->child_count; i++) {
+                if (node->children[i] == child) {
+                    node->children[i] = split;
+                }
+            }
+            child = split;
+        }
+        node = child;
+        str += common;
+        len -= common;
+    }
+    return node;
+}
+
+/* Walks down a template, where path parameters are recognized only if params is set */
+static struct httpd_router_node *httpd_router_insert_template(struct httpd_router_node *node,
+                                                              const char *template, size_t len,
+                                                              bool params)
+{
+    size_t pos = 0;
+    while (node && pos < len) {
+        size_t param_len = params ? httpd_uri_param_len(template, pos, len) : 0;
+        if (param_len) {
+            if (!node->param) {
+                node->param = httpd_calloc(1, sizeof(struct httpd_router_node));
+            }
+            node = node->param;
+            pos += param_len;
+            continue;
+        }
+
+        /* Literal characters up to the next path parameter */
+        size_t end = pos + 1;
+        while (end < len && !(params && httpd_uri_param_len(template, end, len))) {
+            end++;
+        }
+        node = httpd_router_insert_literal(node, template + pos, end - pos);
+        pos = end;
+    }
+    return node;
+}
+
+static esp_err_t httpd_router_add_route(struct httpd_router_node *node,
+                                        const httpd_uri_t *handler, int order, bool prefix)
+{
+    if (!node) {
+        return ESP_ERR_NO_MEM;
+    }
+    struct httpd_route *routes = httpd_realloc(node->routes, (node->route_count + 1) * sizeof(struct httpd_route));
+    if (!routes) {
+        return ESP_ERR_NO_MEM;
+    }
+    routes[node->route_count++] = (struct httpd_route) {
+        .handler = handler,
+        .method = handler->method,
+        .order = order,
+        .prefix = prefix,
+    };
+    node->routes = routes;
+    if (prefix) {
+        node->prefix_methods |= httpd_router_method_bit(handler->method);
+    } else {
+        node->methods |= httpd_router_method_bit(handler->method);
+    }
+    return ESP_OK;
+}
+
+/* Adds a handler to the tree so that it matches the same URIs as with the uri_match_fn */
+static esp_err_t httpd_router_add(struct httpd_router_node *root, const httpd_uri_t *handler,
+                                  const char *template, int order, bool wildcard)
+{
+    if (!wildcard) {
+        return httpd_router_add_route(httpd_router_insert_template(root, template, strlen(template), false),
+                                      handler, order, false);
+    }
+
+    size_t exact_len;
+    bool asterisk, quest;
+    if (!httpd_uri_template_parse(template, &exact_len, &asterisk, &quest)) {
+        /* Never matches anything */
+        return ESP_OK;
+    }
+
+    struct httpd_router_node *node = httpd_router_insert_template(root, template, exact_len, true);
+    if (!quest) {
+        return httpd_router_add_route(node, handler, order, asterisk);
+    }
+
+    /* Without and with the optional character, which is always a literal */
+    esp_err_t ret = httpd_router_add_route(node, handler, order, false);
+    if (ret == ESP_OK) {
+        node = httpd_router_insert_literal(node, template + exact_len, 1);
+        ret = httpd_router_add_route(node, handler, order, asterisk);
+    }
+    return ret;
+}
+
+static void httpd_router_match_routes(const struct httpd_router_node *node, bool prefix,
+                                      int method, struct httpd_router_match *match)
+{
+    const uint64_t methods = prefix ? node->prefix_methods : node->methods;
+    if (!methods) {
+        return;
+    }
+    match->uri_found = true;
+    if (!(methods & (httpd_router_method_bit(method) | HTTPD_ROUTER_METHOD_ANY))) {
+        return;
+    }
+    for (size_t i = 0; i < node->route_count; i++) {
+        const struct httpd_route *route = &node->routes[i];
+        if (route->prefix == prefix && route->order < match->order &&
+            (route->method == method || route->method == HTTP_ANY)) {
+            match->handler = route->handler;
+            match->order = route->order;
+        }
+    }
+}
+
+/* Collects the handlers matching the URI from the given node. The walk only
+ * forks where a path parameter and a literal both match the next segment. */
+static void httpd_router_lookup(const struct httpd_router_node *node,
+                                const char *uri, size_t pos, size_t len,
+                                int method, struct httpd_router_match *match)
+{
+    while (node) {
+        httpd_router_match_routes(node, true, method, match);
+        if (pos == len) {
+            httpd_router_match_routes(node, false, method, match);
+            return;
+        }
+
+        const struct httpd_router_node *child = httpd_router_child(node, uri[pos]);
+        if (child && (child->label_len > len - pos || memcmp(child->label, uri + pos, child->label_len))) {
+            child = NULL;
+        }
+        if (node->param && uri[pos] != '/') {
+            size_t end = pos + 1;
+            while (end < len && uri[end] != '/') {
+                end++;
+            }
+            if (!child) {
+                node = node->param;
+                pos = end;
+                continue;
+            }
+            httpd_router_lookup(node->param, uri, end, len, method, match);
+        }
+        if (!child) {
+            return;
+        }
+        node = child;
+        pos += child->label_len;
+    }
+}
+
+esp_err_t httpd_router_update(struct httpd_data *hd)
+{
+    const bool wildcard = hd->config.uri_match_fn == httpd_uri_match_wildcard;
+    if (hd->config.uri_match_fn && !wildcard) {
+        /* Custom matching functions can only be used by scanning the handlers */
+        return ESP_OK;
+    }
+
+    if (!hd->hd_router) {
+        hd->hd_router = httpd_calloc(1, sizeof(struct httpd_router));
+        if (!hd->hd_router) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    /* The tree is rebuilt on every change, so that the order of the handlers is
+     * kept. It keeps its own copy of the templates, so that it never refers to
+     * the memory of a handler being unregistered. */
+    size_t strings_len = 0;
+    for (int i = 0; i < hd->config.max_uri_handlers && hd->hd_calls[i]; i++) {
+        strings_len += strlen(hd->hd_calls[i]->uri) + 1;
+    }
+    esp_err_t ret = ESP_OK;
+    struct httpd_router_node *root = httpd_calloc(1, sizeof(struct httpd_router_node) + strings_len);
+    if (!root) {
+        ret = ESP_ERR_NO_MEM;
+    }
+    char *strings = root ? (char *) (root + 1) : NULL;
+    for (int i = 0; root && i < hd->config.max_uri_handlers && hd->hd_calls[i]; i++) {
+        const char *template = strcpy(strings, hd->hd_calls[i]->uri);
+        strings += strlen(template) + 1;
+        ret = httpd_router_add(root, hd->hd_calls[i], template, i, wildcard);
+        if (ret != ESP_OK) {
+            httpd_router_node_free(root);
+            root = NULL;
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, LOG_FMT("failed to build the URI tree, falling back to scanning the handlers"));
+    }
+
+    /* Lookups hold hd_calls_lock too, none of them is using the old tree */
+    httpd_router_node_free(hd->hd_router->root);
+    hd->hd_router->root = root;
+    return ret;
+}
+
+bool httpd_router_find(struct httpd_data *hd, const char *uri, size_t uri_len,
+                       httpd_method_t method, httpd_err_code_t *err, httpd_uri_t **handler)
+{
+    struct httpd_router *router = hd->hd_router;
+    if (!router) {
+        return false;
+    }
+
+    if (!router->root) {
+        return false;
+    }
+    struct httpd_router_match match = {
+        .order = hd->config.max_uri_handlers,
+    };
+    httpd_router_lookup(router->root, uri, 0, uri_len, method, &match);
+
+    ESP_LOGD(TAG, LOG_FMT("%.*s: handler %d"), (int) uri_len, uri, match.handler ? match.order : -1);
+    if (err) {
+        *err = match.handler ? 0 : (match.uri_found ? HTTPD_405_METHOD_NOT_ALLOWED : HTTPD_404_NOT_FOUND);
+    }
+    *handler = (httpd_uri_t *) match.handler;
+    return true;
+}
+
+void httpd_router_delete(struct httpd_data *hd)
+{
+    if (!hd->hd_router) {
+        return;
+    }
+    httpd_router_node_free(hd->hd_router->root);
+    free(hd->hd_router);
+    hd->hd_router = NULL;
+}
+
+#endif /* CONFIG_HTTPD_URI_ROUTER */
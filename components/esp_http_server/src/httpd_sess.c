@@ -88,7 +88,7 @@ static int enum_function(struct sock_db *session, void *context)
         break;
     // Set descriptor
     case HTTPD_TASK_SET_DESCRIPTOR:
-        if (session->fd != -1 && !session->for_async_req) {
+        if (session->fd != -1 && !session->for_async_req && !session->in_worker) {
             FD_SET(session->fd, ctx->fdset);
             if (session->fd > ctx->max_fd) {
                 ctx->max_fd = session->fd;
@@ -97,7 +97,8 @@ static int enum_function(struct sock_db *session, void *context)
         break;
     // Delete invalid session
     case HTTPD_TASK_DELETE_INVALID:
-        if (!fd_is_valid(session->fd)) {
+        // Sessions in use by a worker are checked once it is done with them
+        if (!session->in_worker && !fd_is_valid(session->fd)) {
             ESP_LOGW(TAG, LOG_FMT("Closing invalid socket %d"), session->fd);
             httpd_sess_delete(ctx->hd, session);
         }
@@ -109,7 +110,7 @@ static int enum_function(struct sock_db *session, void *context)
             return 0;
         }
         // Only close sockets that are not in use
-        if (session->for_async_req == false) {
+        if (session->for_async_req == false && session->in_worker == false) {
             // Check/update lowest lru
             if (session->lru_counter < ctx->lru_counter) {
                 ctx->lru_counter = session->lru_counter;
@@ -144,6 +145,11 @@ static void httpd_sess_close(void *arg)
         ESP_LOGD(TAG, "Skipping session close for %d as it seems to be a race condition", sock_db->fd);
         return;
     }
+    if (sock_db->in_worker) {
+        // The session is closed once the worker is done with it
+        sock_db->close_deferred = true;
+        return;
+    }
     sock_db->lru_socket = false;
     struct httpd_data *hd = (struct httpd_data *) sock_db->handle;
     hd->http_server_state = HTTP_SERVER_EVENT_DISCONNECTED;
@@ -164,7 +170,31 @@ struct sock_db *httpd_sess_get_free(struct httpd_data *hd)
 
 bool httpd_is_sess_available(struct httpd_data *hd)
 {
-    return httpd_sess_get_free(hd) ? true : false;
+    // A free slot exists as long as not all of them are active
+    return hd && (hd->hd_sd_active_count < hd->config.max_open_sockets);
+}
+
+// Get the request being processed on a socket by the calling task, if it is the server task or a worker.
+// The requests of the other workers may be cleaned up, and their sessions closed, at any time.
+static httpd_req_t *httpd_sess_get_req(struct httpd_data *hd, int sockfd)
+{
+    othread_t current = httpd_os_thread_handle();
+    httpd_req_t *r = NULL;
+    struct httpd_req_aux *ra = NULL;
+    if (current == hd->hd_td.handle) {
+        r = &hd->hd_req;
+        ra = &hd->hd_req_aux;
+    }
+    for (int i = 0; !r && hd->hd_workers && i < hd->config.worker_count; i++) {
+        if (current == hd->hd_workers[i].handle) {
+            r = &hd->hd_workers[i].req;
+            ra = &hd->hd_workers[i].req_aux;
+        }
+    }
+    if ((r) && (ra->sd) && (ra->sd->fd == sockfd)) {
+        return r;
+    }
+    return NULL;
 }
 
 struct sock_db *httpd_sess_get(struct httpd_data *hd, int sockfd)
@@ -175,8 +205,9 @@ struct sock_db *httpd_sess_get(struct httpd_data *hd, int sockfd)
 
     // Check if called inside a request handler, and the session sockfd in use is same as the parameter
     // => Just return the pointer to the sock_db corresponding to the request
-    if ((hd->hd_req_aux.sd) && (hd->hd_req_aux.sd->fd == sockfd)) {
-        return hd->hd_req_aux.sd;
+    httpd_req_t *r = httpd_sess_get_req(hd, sockfd);
+    if (r) {
+        return ((struct httpd_req_aux *) r->aux)->sd;
     }
 
     enum_context_t context = {
@@ -223,6 +254,8 @@ esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd)
         }
     }
 
+    // Start watching the socket for requests
+    httpd_poll_add(hd, session);
 
     ESP_LOGD(TAG, LOG_FMT("active sockets: %d"), hd->hd_sd_active_count);
     return ESP_OK;
@@ -270,9 +303,9 @@ void *httpd_sess_get_ctx(httpd_handle_t handle, int sockfd)
     // Check if the function has been called from inside a
     // request handler, in which case fetch the context from
     // the httpd_req_t structure
-    struct httpd_data *hd = (struct httpd_data *) handle;
-    if (hd->hd_req_aux.sd == session) {
-        return hd->hd_req.sess_ctx;
+    httpd_req_t *r = httpd_sess_get_req((struct httpd_data *) handle, sockfd);
+    if (r) {
+        return r->sess_ctx;
     }
     return session->ctx;
 }
@@ -287,17 +320,17 @@ void httpd_sess_set_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free
     // Check if the function has been called from inside a
     // request handler, in which case set the context inside
     // the httpd_req_t structure
-    struct httpd_data *hd = (struct httpd_data *) handle;
-    if (hd->hd_req_aux.sd == session) {
-        if (hd->hd_req.sess_ctx != ctx) {
+    httpd_req_t *r = httpd_sess_get_req((struct httpd_data *) handle, sockfd);
+    if (r) {
+        if (r->sess_ctx != ctx) {
             // Don't free previous context if it is in sockdb
             // as it will be freed inside httpd_req_cleanup()
-            if (session->ctx != hd->hd_req.sess_ctx) {
-                httpd_sess_free_ctx(&hd->hd_req.sess_ctx, hd->hd_req.free_ctx); // Free previous context
+            if (session->ctx != r->sess_ctx) {
+                httpd_sess_free_ctx(&r->sess_ctx, r->free_ctx); // Free previous context
             }
-            hd->hd_req.sess_ctx = ctx;
+            r->sess_ctx = ctx;
         }
-        hd->hd_req.free_ctx = free_fn;
+        r->free_ctx = free_fn;
         return;
     }
 
@@ -358,8 +391,16 @@ void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session)
     if ((!hd) || (!session) || (session->fd < 0)) {
         return;
     }
+    if (session->in_worker) {
+        // The worker holds the session until its result is picked up, it is closed then
+        session->close_deferred = true;
+        return;
+    }
 
     ESP_LOGD(TAG, LOG_FMT("fd = %d"), session->fd);
+    // Stop watching the socket before it is closed
+    httpd_poll_del(hd, session);
+
     if (hd->config.enable_so_linger) {
         struct linger so_linger = {
             .l_onoff = true,
@@ -382,6 +423,21 @@ void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session)
     // clear all contexts
     httpd_sess_clear_ctx(session);
 
+#if CONFIG_HTTPD_SESS_ARENA
+    // free the buffer of the requests
+    free(session->arena);
+    session->arena = NULL;
+#endif
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    // free the WebSocket receive buffer
+    free(session->ws_rx_buf);
+    session->ws_rx_buf = NULL;
+    session->ws_rx_buf_size = 0;
+    // release the broadcast frame it didn't take
+    httpd_ws_bcast_drop(session);
+#endif
+
     // mark session slot as available
     session->fd = -1;
 
@@ -420,22 +476,22 @@ bool httpd_sess_pending(struct httpd_data *hd, struct sock_db *session)
  * value is returned, everything related to this socket will be
  * cleaned up and the socket will be closed.
  */
-esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *session)
+esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *session,
+                             httpd_req_t *r, struct httpd_req_aux *ra)
 {
     if ((!hd) || (!session)) {
         return ESP_FAIL;
     }
 
     ESP_LOGD(TAG, LOG_FMT("httpd_req_new"));
-    if (httpd_req_new(hd, session) != ESP_OK) {
+    if (httpd_req_new(hd, r, ra, session) != ESP_OK) {
         return ESP_FAIL;
     }
     ESP_LOGD(TAG, LOG_FMT("httpd_req_delete"));
-    if (httpd_req_delete(hd) != ESP_OK) {
+    if (httpd_req_delete(hd, r) != ESP_OK) {
         return ESP_FAIL;
     }
     ESP_LOGD(TAG, LOG_FMT("success"));
-    session->lru_counter = ++hd->lru_counter;
     return ESP_OK;
 }
 
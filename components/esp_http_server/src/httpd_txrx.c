@@ -6,6 +6,8 @@
 
 
 #include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <esp_log.h>
 #include <esp_err.h>
 
@@ -13,6 +15,9 @@
 #include "esp_httpd_priv.h"
 #include <netinet/tcp.h>
 #include "ctrl_sock.h"
+#if CONFIG_IDF_TARGET_LINUX && !CONFIG_LWIP_ENABLE
+#include <sys/sendfile.h>
+#endif
 
 static const char *TAG = "httpd_txrx";
 
@@ -83,6 +88,36 @@ static esp_err_t httpd_send_all(httpd_req_t *r, const char *buf, size_t buf_len)
     return ESP_OK;
 }
 
+/* Sends the headers set with httpd_resp_set_hdr() and ends the header section */
+static esp_err_t httpd_send_additional_hdrs(httpd_req_t *r)
+{
+    struct httpd_req_aux *ra = r->aux;
+    const char *colon_separator = ": ";
+    const char *cr_lf_seperator = "\r\n";
+
+    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
+        /* Send header field */
+        if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        /* Send ': ' */
+        if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        /* Send header value */
+        if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        /* Send CR + LF */
+        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+
+    /* End header section */
+    return httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator));
+}
+
 static size_t httpd_recv_pending(httpd_req_t *r, char *buf, size_t buf_len)
 {
     struct httpd_req_aux *ra = r->aux;
@@ -263,8 +298,6 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
 
     struct httpd_req_aux *ra = r->aux;
     const char *httpd_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
 
     if (buf_len == HTTPD_RESP_USE_STRLEN) {
         buf_len = strlen(buf);
@@ -278,7 +311,7 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
     if (required_size > ra->max_req_hdr_len) {
         return ESP_ERR_HTTPD_RESP_HDR;
     }
-    char *res_buf = malloc(required_size); /* Temporary buffer to store the headers */
+    char *res_buf = httpd_req_alloc(r, required_size); /* Temporary buffer to store the headers */
     if (res_buf == NULL) {
         ESP_LOGE(TAG, "Unable to allocate httpd send buffer");
         return ESP_ERR_HTTPD_ALLOC_MEM;
@@ -286,38 +319,17 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
 
     esp_err_t ret = snprintf(res_buf, required_size, httpd_hdr_str, ra->status, ra->content_type, buf_len);
     if (ret < 0 || ret >= required_size) {
-        free(res_buf);
+        httpd_req_free(r, res_buf);
         return ESP_ERR_HTTPD_RESP_HDR;
     }
     ESP_LOGD(TAG, "httpd send buffer size = %d", strlen(res_buf));
     ret = httpd_send_all(r, res_buf, strlen(res_buf));
-    free(res_buf);
+    httpd_req_free(r, res_buf);
     if (ret != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
 
-    /* Sending additional headers based on set_header */
-    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-        /* Send header field */
-        if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send ': ' */
-        if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send header value */
-        if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send CR + LF */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-    }
-
-    /* End header section */
-    if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+    if (httpd_send_additional_hdrs(r) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
     struct httpd_data *hd = (struct httpd_data *) r->handle;
@@ -356,8 +368,6 @@ esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len
     struct httpd_req_aux *ra = r->aux;
     struct httpd_data *hd = (struct httpd_data *) r->handle;
     const char *httpd_chunked_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
 
     /* Request headers are no longer available */
     ra->req_hdrs_count = 0;
@@ -368,46 +378,25 @@ esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len
         if (required_size > ra->max_req_hdr_len) {
             return ESP_ERR_HTTPD_RESP_HDR;
         }
-        char *res_buf = malloc(required_size); /* Temporary buffer to store the headers */
+        char *res_buf = httpd_req_alloc(r, required_size); /* Temporary buffer to store the headers */
         if (res_buf == NULL) {
             ESP_LOGE(TAG, "Unable to allocate httpd send chunk buffer");
             return ESP_ERR_HTTPD_ALLOC_MEM;
         }
         esp_err_t ret = snprintf(res_buf, required_size, httpd_chunked_hdr_str, ra->status, ra->content_type);
         if (ret < 0 || ret >= required_size) {
-            free(res_buf);
+            httpd_req_free(r, res_buf);
             return ESP_ERR_HTTPD_RESP_HDR;
         }
         ESP_LOGD(TAG, "httpd send chunk buffer size = %d", strlen(res_buf));
         /* Size of essential headers is limited by scratch buffer size */
         ret = httpd_send_all(r, res_buf, strlen(res_buf));
-        free(res_buf);
+        httpd_req_free(r, res_buf);
         if (ret != ESP_OK) {
             return ESP_ERR_HTTPD_RESP_SEND;
         }
 
-        /* Sending additional headers based on set_header */
-        for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-            /* Send header field */
-            if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send ': ' */
-            if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send header value */
-            if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send CR + LF */
-            if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-        }
-
-        /* End header section */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+        if (httpd_send_additional_hdrs(r) != ESP_OK) {
             return ESP_ERR_HTTPD_RESP_SEND;
         }
         ra->first_chunk_sent = true;
@@ -440,6 +429,234 @@ esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len
     return ESP_OK;
 }
 
+/* Parses a Range header for a single byte range of an entity of the given size.
+ * Returns 1 for a valid range, -1 for an unsatisfiable one, and 0 if the header
+ * is to be ignored, e.g. for multiple ranges, which are not supported */
+static int httpd_parse_range(const char *range, uint64_t size, uint64_t *first, uint64_t *last)
+{
+    const char *prefix = "bytes=";
+    if (strncmp(range, prefix, strlen(prefix)) != 0 || strchr(range, ',')) {
+        return 0;
+    }
+    range += strlen(prefix);
+
+    char *end;
+    if (*range == '-') {
+        /* Suffix range, the last bytes of the entity */
+        uint64_t suffix = strtoull(range + 1, &end, 10);
+        if (end == range + 1 || *end != '\0') {
+            return 0;
+        }
+        if (suffix == 0 || size == 0) {
+            return -1;
+        }
+        *first = suffix < size ? size - suffix : 0;
+        *last = size - 1;
+        return 1;
+    }
+
+    if (*range < '0' || *range > '9') {
+        return 0;
+    }
+    *first = strtoull(range, &end, 10);
+    if (*end != '-') {
+        return 0;
+    }
+    range = end + 1;
+    *last = size - 1;
+    if (*range != '\0') {
+        if (*range < '0' || *range > '9') {
+            return 0;
+        }
+        *last = strtoull(range, &end, 10);
+        if (*end != '\0' || *last < *first) {
+            return 0;
+        }
+    }
+    if (*first >= size) {
+        return -1;
+    }
+    *last = MIN(*last, size - 1);
+    return 1;
+}
+
+/* Sends the body of a file response, from the memory if data is set, else from the file */
+static esp_err_t httpd_send_file_body(httpd_req_t *r, int fd, const char *data, off_t offset, size_t len)
+{
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (data) {
+        return httpd_send_all(r, data + offset, len);
+    }
+
+#if CONFIG_IDF_TARGET_LINUX && !CONFIG_LWIP_ENABLE
+    /* The host kernel copies the file straight into the socket, unless the
+     * data has to go through a custom send function, e.g. for TLS */
+    struct httpd_req_aux *ra = r->aux;
+    if (ra->sd->send_fn == httpd_default_send) {
+        while (len > 0) {
+            ssize_t ret = sendfile(ra->sd->fd, fd, &offset, len);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                if (ret < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                    /* Not supported for this file, offset is left unchanged */
+                    break;
+                }
+                ESP_LOGD(TAG, LOG_FMT("error in sendfile (%d)"), errno);
+                return ESP_FAIL;
+            }
+            len -= ret;
+        }
+        if (len == 0) {
+            return ESP_OK;
+        }
+    }
+#endif
+
+    if (lseek(fd, offset, SEEK_SET) != offset) {
+        ESP_LOGD(TAG, LOG_FMT("error in lseek (%d)"), errno);
+        return ESP_FAIL;
+    }
+    char *buf = httpd_req_alloc(r, MIN(len, CONFIG_HTTPD_SEND_FILE_BUF_SIZE));
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "Unable to allocate httpd send file buffer");
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    esp_err_t ret = ESP_OK;
+    while (len > 0) {
+        /* The network stack copies the data it is given, so the buffer
+         * can be refilled while the previous block is being transmitted */
+        ssize_t read_len = read(fd, buf, MIN(len, CONFIG_HTTPD_SEND_FILE_BUF_SIZE));
+        if (read_len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read_len <= 0) {
+            ESP_LOGD(TAG, LOG_FMT("error in read (%d)"), read_len < 0 ? errno : 0);
+            ret = ESP_FAIL;
+            break;
+        }
+        ret = httpd_send_all(r, buf, read_len);
+        if (ret != ESP_OK) {
+            break;
+        }
+        len -= read_len;
+    }
+    httpd_req_free(r, buf);
+    return ret;
+}
+
+/* Sends a complete response with a part of a file or of a memory region as the
+ * body, honouring a Range header of the request */
+static esp_err_t httpd_resp_send_region(httpd_req_t *r, int fd, const char *data, off_t offset, size_t len)
+{
+    struct httpd_req_aux *ra = r->aux;
+    struct httpd_data *hd = (struct httpd_data *) r->handle;
+    const char *httpd_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %"NEWLIB_NANO_COMPAT_FORMAT"\r\n%s%s";
+    char range_hdr[64] = "";
+    const char *accept_ranges = "";
+
+    /* Ranges only apply to a successful response with the whole entity */
+    if (strcmp(ra->status, HTTPD_200) == 0) {
+        accept_ranges = "Accept-Ranges: bytes\r\n";
+        char range[48];
+        uint64_t first, last;
+        if (httpd_req_get_hdr_value_str(r, "Range", range, sizeof(range)) == ESP_OK) {
+            switch (httpd_parse_range(range, len, &first, &last)) {
+            case 1:
+                ra->status = HTTPD_206;
+                snprintf(range_hdr, sizeof(range_hdr),
+                         "Content-Range: bytes %"NEWLIB_NANO_COMPAT_FORMAT"-%"NEWLIB_NANO_COMPAT_FORMAT"/%"NEWLIB_NANO_COMPAT_FORMAT"\r\n",
+                         NEWLIB_NANO_COMPAT_CAST((size_t) first), NEWLIB_NANO_COMPAT_CAST((size_t) last),
+                         NEWLIB_NANO_COMPAT_CAST(len));
+                offset += first;
+                len = last - first + 1;
+                break;
+            case -1:
+                ra->status = HTTPD_416;
+                snprintf(range_hdr, sizeof(range_hdr), "Content-Range: bytes */%"NEWLIB_NANO_COMPAT_FORMAT"\r\n",
+                         NEWLIB_NANO_COMPAT_CAST(len));
+                len = 0;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    /* Request headers are no longer available */
+    ra->req_hdrs_count = 0;
+
+    /* Calculate the size of the headers. +1 for the null terminator */
+    size_t required_size = snprintf(NULL, 0, httpd_hdr_str, ra->status, ra->content_type,
+                                    NEWLIB_NANO_COMPAT_CAST(len), accept_ranges, range_hdr) + 1;
+    if (required_size > ra->max_req_hdr_len) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    char *res_buf = httpd_req_alloc(r, required_size); /* Temporary buffer to store the headers */
+    if (res_buf == NULL) {
+        ESP_LOGE(TAG, "Unable to allocate httpd send buffer");
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    snprintf(res_buf, required_size, httpd_hdr_str, ra->status, ra->content_type,
+             NEWLIB_NANO_COMPAT_CAST(len), accept_ranges, range_hdr);
+    esp_err_t ret = httpd_send_all(r, res_buf, strlen(res_buf));
+    httpd_req_free(r, res_buf);
+    if (ret != ESP_OK || httpd_send_additional_hdrs(r) != ESP_OK) {
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    hd->http_server_state = HTTP_SERVER_EVENT_HEADERS_SENT;
+    esp_http_server_dispatch_event(HTTP_SERVER_EVENT_HEADERS_SENT, &(ra->sd->fd), sizeof(int));
+
+    ret = httpd_send_file_body(r, fd, data, offset, len);
+    if (ret != ESP_OK) {
+        /* The headers are out, the connection can't be used for another response */
+        return ret == ESP_ERR_HTTPD_ALLOC_MEM ? ret : ESP_ERR_HTTPD_RESP_SEND;
+    }
+    esp_http_server_event_data evt_data = {
+        .fd = ra->sd->fd,
+        .data_len = len,
+    };
+    hd->http_server_state = HTTP_SERVER_EVENT_SENT_DATA;
+    esp_http_server_dispatch_event(HTTP_SERVER_EVENT_SENT_DATA, &evt_data, sizeof(esp_http_server_event_data));
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_file(httpd_req_t *r, int fd, off_t offset, ssize_t len)
+{
+    if (r == NULL || fd < 0 || offset < 0 || (len < 0 && len != HTTPD_RESP_USE_FILE_SIZE)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!httpd_valid_req(r)) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+
+    if (len == HTTPD_RESP_USE_FILE_SIZE) {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < offset) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        len = st.st_size - offset;
+    }
+    return httpd_resp_send_region(r, fd, NULL, offset, len);
+}
+
+esp_err_t httpd_resp_send_mapped(httpd_req_t *r, const void *data, size_t len)
+{
+    if (r == NULL || (data == NULL && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!httpd_valid_req(r)) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+
+    return httpd_resp_send_region(r, -1, data, 0, len);
+}
+
 esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *usr_msg)
 {
     esp_err_t ret;
@@ -661,14 +878,14 @@ esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out)
     }
 
     // alloc async req
-    httpd_req_t *async = malloc(sizeof(httpd_req_t));
+    httpd_req_t *async = httpd_malloc(sizeof(httpd_req_t));
     if (async == NULL) {
         return ESP_ERR_NO_MEM;
     }
     memcpy(async, r, sizeof(httpd_req_t));
 
     // alloc async aux
-    async->aux = malloc(sizeof(struct httpd_req_aux));
+    async->aux = httpd_malloc(sizeof(struct httpd_req_aux));
     if (async->aux == NULL) {
         free(async);
         return ESP_ERR_NO_MEM;
@@ -681,7 +898,7 @@ esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out)
     struct httpd_req_aux *r_aux = (struct httpd_req_aux *) r->aux;
 
     if (r_aux->scratch) {
-        async_aux->scratch = malloc(r_aux->scratch_cur_size);
+        async_aux->scratch = httpd_malloc(r_aux->scratch_cur_size);
         if (async_aux->scratch == NULL) {
             free(async_aux);
             free(async);
@@ -691,8 +908,10 @@ esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out)
     } else {
         async_aux->scratch = NULL;
     }
+    /* The copy outlives the request, so it allocates from the heap */
+    async_aux->arena = NULL;
 
-    async_aux->resp_hdrs = calloc(hd->config.max_resp_headers, sizeof(struct resp_hdr));
+    async_aux->resp_hdrs = httpd_calloc(hd->config.max_resp_headers, sizeof(struct resp_hdr));
     if (async_aux->resp_hdrs == NULL) {
         free(async_aux->scratch);
         free(async_aux);
@@ -701,6 +920,9 @@ esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out)
     }
     memcpy(async_aux->resp_hdrs, r_aux->resp_hdrs, hd->config.max_resp_headers * sizeof(struct resp_hdr));
 
+    // The copy keeps the matched handler (and its URI template) until it completes
+    httpd_uri_handler_ref(hd, async_aux->uri_handler);
+
     // Prevent the main thread from reading the rest of the request after the handler returns.
     r_aux->remaining_len = 0;
 
@@ -724,20 +946,23 @@ esp_err_t httpd_req_async_handler_complete(httpd_req_t *r)
     int port = hd->config.ctrl_port;
 
     struct httpd_req_aux *ra = r->aux;
-    ra->sd->for_async_req = false;
+    struct sock_db *sd = ra->sd;
+    sd->for_async_req = false;
     free(ra->scratch);
     ra->scratch = NULL;
     ra->scratch_cur_size = 0;
     ra->scratch_size_limit = 0;
     free(ra->resp_hdrs);
+    httpd_uri_handler_unref(hd, ra->uri_handler);
     free(r->aux);
     free(r);
 
-    // Send a dummy control message(httpd_ctrl_data) to unblock the main HTTP server task from the select() call.
-    // Since the current connection FD was marked as inactive for async requests, the main task
-    // will now re-add this FD to its select() descriptor list. This ensures that subsequent requests
-    // on the same FD are processed correctly
-    struct httpd_ctrl_data msg = {.hc_msg = HTTPD_CTRL_MAX};
+    // Mark the session for the main HTTP server task, which watches the FD again on its next iteration, so
+    // that subsequent requests on the same FD are processed. The sessions are re-armed on every iteration,
+    // the control message(httpd_ctrl_data) only unblocks the main task from waiting on its sockets.
+    __atomic_store_n(&sd->async_done, true, __ATOMIC_RELEASE);
+    __atomic_store_n(&hd->hd_async_done, true, __ATOMIC_SEQ_CST);
+    struct httpd_ctrl_data msg = {.hc_msg = HTTPD_CTRL_ASYNC_DONE};
     int ret = cs_send_to_ctrl_sock(msg_fd, port, &msg, sizeof(msg));
     if (ret < 0) {
         ESP_LOGW(TAG, LOG_FMT("failed to send socket notification"));
@@ -763,10 +988,13 @@ int httpd_req_to_sockfd(httpd_req_t *r)
     return ra->sd->fd;
 }
 
-static int httpd_sock_err(const char *ctx, int sockfd)
+static int httpd_sock_err(const char *ctx, int sockfd, int flags)
 {
     int errval;
-    ESP_LOGW(TAG, LOG_FMT("error in %s : %d"), ctx, errno);
+    /* A non-blocking call is expected to fail with EAGAIN */
+    if (!((flags & MSG_DONTWAIT) && errno == EAGAIN)) {
+        ESP_LOGW(TAG, LOG_FMT("error in %s : %d"), ctx, errno);
+    }
 
     switch (errno) {
     case EAGAIN:
@@ -792,9 +1020,14 @@ int httpd_default_send(httpd_handle_t hd, int sockfd, const char *buf, size_t bu
         return HTTPD_SOCK_ERR_INVALID;
     }
 
-    int ret = send(sockfd, buf, buf_len, flags);
+    int ret;
+    do {
+        /* A signal, e.g. the tick of the FreeRTOS Linux port, may interrupt
+         * a send waiting for room in the socket before it sent anything */
+        ret = send(sockfd, buf, buf_len, flags);
+    } while (ret < 0 && errno == EINTR);
     if (ret < 0) {
-        return httpd_sock_err("send", sockfd);
+        return httpd_sock_err("send", sockfd, flags);
     }
     return ret;
 }
@@ -808,7 +1041,7 @@ int httpd_default_recv(httpd_handle_t hd, int sockfd, char *buf, size_t buf_len,
 
     int ret = recv(sockfd, buf, buf_len, flags);
     if (ret < 0) {
-        return httpd_sock_err("recv", sockfd);
+        return httpd_sock_err("recv", sockfd, flags);
     }
     return ret;
 }
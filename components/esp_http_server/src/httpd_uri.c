@@ -15,22 +15,37 @@
 
 static const char *TAG = "httpd_uri";
 
+/**
+ * @brief   Registered URI handler, the copy of the one given by the user.
+ *          The requests running it hold references to it, so that it is
+ *          only freed by the last of them if it is unregistered meanwhile.
+ */
+struct httpd_uri_entry {
+    httpd_uri_t uri;                        /*!< The handler, first so that hd_calls points to the entry */
+    unsigned refs;                          /*!< Number of requests referencing the handler */
+    bool removed;                           /*!< Set once unregistered, the last reference frees it */
+};
+
+static inline struct httpd_uri_entry *httpd_uri_entry_of(httpd_uri_t *uri_handler)
+{
+    return (struct httpd_uri_entry *) uri_handler;
+}
+
 static bool httpd_uri_match_simple(const char *uri1, const char *uri2, size_t len2)
 {
     return strlen(uri1) == len2 &&          // First match lengths
         (strncmp(uri1, uri2, len2) == 0);   // Then match actual URIs
 }
 
-bool httpd_uri_match_wildcard(const char *template, const char *uri, size_t len)
+bool httpd_uri_template_parse(const char *template, size_t *exact_len, bool *asterisk, bool *quest)
 {
     const size_t tpl_len = strlen(template);
-    size_t exact_match_chars = tpl_len;
 
     /* Check for trailing question mark and asterisk */
     const char last = (const char) (tpl_len > 0 ? template[tpl_len - 1] : 0);
     const char prevlast = (const char) (tpl_len > 1 ? template[tpl_len - 2] : 0);
-    const bool asterisk = last == '*' || (prevlast == '*' && last == '?');
-    const bool quest = last == '?' || (prevlast == '?' && last == '*');
+    *asterisk = last == '*' || (prevlast == '*' && last == '?');
+    *quest = last == '?' || (prevlast == '?' && last == '*');
 
     /* Minimum template string length must be:
      *      0 : if neither of '*' and '?' are present
@@ -43,43 +58,106 @@ bool httpd_uri_match_wildcard(const char *template, const char *uri, size_t len)
      */
 
     /* abort in cases such as "?" with no preceding character (invalid template) */
-    if (exact_match_chars < asterisk + quest*2) {
+    if (tpl_len < *asterisk + *quest*2) {
         return false;
     }
 
     /* account for special characters and the optional character if "?" is used */
-    exact_match_chars -= asterisk + quest*2;
+    *exact_len = tpl_len - (*asterisk + *quest*2);
+    return true;
+}
+
+size_t httpd_uri_param_len(const char *template, size_t pos, size_t end)
+{
+    /* A path parameter is a whole path segment */
+    if (pos == 0 || template[pos - 1] != '/' || template[pos] != '{') {
+        return 0;
+    }
+    size_t i = pos + 1;
+    while (i < end && template[i] != '}' && template[i] != '{' && template[i] != '/') {
+        i++;
+    }
+    /* The name must not be empty, and the closing brace
+     * must end the segment */
+    if (i == pos + 1 || i == end || template[i] != '}' ||
+        (i + 1 < end && template[i + 1] != '/')) {
+        return 0;
+    }
+    return i + 1 - pos;
+}
+
+/* Matches the beginning of the URI against the first tpl_len characters
+ * of a template, returns the number of URI characters matched or -1 */
+static int httpd_uri_match_params(const char *template, size_t tpl_len,
+                                  const char *uri, size_t len)
+{
+    size_t t = 0, u = 0;
+    while (t < tpl_len) {
+        size_t param_len = httpd_uri_param_len(template, t, tpl_len);
+        if (param_len) {
+            /* Path parameter matches a non empty segment */
+            size_t start = u;
+            while (u < len && uri[u] != '/') {
+                u++;
+            }
+            if (u == start) {
+                return -1;
+            }
+            t += param_len;
+        } else {
+            if (u == len || template[t] != uri[u]) {
+                return -1;
+            }
+            t++;
+            u++;
+        }
+    }
+    return u;
+}
+
+bool httpd_uri_match_wildcard(const char *template, const char *uri, size_t len)
+{
+    size_t exact_match_chars;
+    bool asterisk, quest;
+
+    if (!httpd_uri_template_parse(template, &exact_match_chars, &asterisk, &quest)) {
+        return false;
+    }
 
-    if (len < exact_match_chars) {
+    /* Number of URI characters matched by the mandatory part of the template,
+     * which differs from exact_match_chars if it has path parameters */
+    const int ret = httpd_uri_match_params(template, exact_match_chars, uri, len);
+    if (ret < 0) {
         return false;
     }
+    const size_t matched = ret;
 
     if (!quest) {
-        if (!asterisk && len != exact_match_chars) {
-            /* no special characters and different length - strncmp would return false */
-            return false;
-        }
-        /* asterisk allows arbitrary trailing characters, we ignore these using
-         * exact_match_chars as the length limit */
-        return (strncmp(template, uri, exact_match_chars) == 0);
+        /* asterisk allows arbitrary trailing characters */
+        return asterisk || len == matched;
     } else {
         /* question mark present */
-        if (len > exact_match_chars && template[exact_match_chars] != uri[exact_match_chars]) {
+        if (len > matched && template[exact_match_chars] != uri[matched]) {
             /* the optional character is present, but different */
             return false;
         }
-        if (strncmp(template, uri, exact_match_chars) != 0) {
-            /* the mandatory part differs */
-            return false;
-        }
         /* Now we know the URI is longer than the required part of template,
          * the mandatory part matches, and if the optional character is present, it is correct.
          * Match is OK if we have asterisk, i.e. any trailing characters are OK, or if
          * there are no characters beyond the optional character. */
-        return asterisk || len <= exact_match_chars + 1;
+        return asterisk || len <= matched + 1;
     }
 }
 
+/* Keeps the lookup structures in sync with hd_calls */
+static void httpd_uri_handlers_changed(struct httpd_data *hd)
+{
+#ifdef CONFIG_HTTPD_URI_ROUTER
+    /* If the tree can't be built, lookups fall back to scanning hd_calls */
+    httpd_router_update(hd);
+#endif
+}
+
 /* Find handler with matching URI and method, and set
  * appropriate error code if URI or method not found */
 static httpd_uri_t* httpd_find_uri_handler(struct httpd_data *hd,
@@ -87,6 +165,13 @@ static httpd_uri_t* httpd_find_uri_handler(struct httpd_data *hd,
                                            httpd_method_t method,
                                            httpd_err_code_t *err)
 {
+#ifdef CONFIG_HTTPD_URI_ROUTER
+    httpd_uri_t *handler;
+    if (httpd_router_find(hd, uri, uri_len, method, err, &handler)) {
+        return handler;
+    }
+#endif
+
     if (err) {
         *err = HTTPD_404_NOT_FOUND;
     }
@@ -123,20 +208,14 @@ static httpd_uri_t* httpd_find_uri_handler(struct httpd_data *hd,
     return NULL;
 }
 
-esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
-                                     const httpd_uri_t *uri_handler)
+/* Adds a handler, with hd_calls_lock held */
+static esp_err_t httpd_add_uri_handler(struct httpd_data *hd, const httpd_uri_t *uri_handler)
 {
-    if (handle == NULL || uri_handler == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    struct httpd_data *hd = (struct httpd_data *) handle;
-
     /* Make sure another handler with matching URI and method
      * is not already registered. This will also catch cases
      * when a registered URI wildcard pattern already accounts
      * for the new URI being registered */
-    if (httpd_find_uri_handler(handle, uri_handler->uri,
+    if (httpd_find_uri_handler(hd, uri_handler->uri,
                                strlen(uri_handler->uri),
                                uri_handler->method, NULL) != NULL) {
         ESP_LOGW(TAG, LOG_FMT("handler %s with method %d already registered"),
@@ -147,18 +226,20 @@ esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
     for (int i = 0; i < hd->config.max_uri_handlers; i++) {
         if (hd->hd_calls[i] == NULL) {
             ESP_COMPILER_DIAGNOSTIC_PUSH_IGNORE("-Wanalyzer-malloc-leak") // False-positive detection. TODO GCC-366
-            hd->hd_calls[i] = malloc(sizeof(httpd_uri_t));
-            if (hd->hd_calls[i] == NULL) {
+            struct httpd_uri_entry *entry = httpd_calloc(1, sizeof(struct httpd_uri_entry));
+            if (entry == NULL) {
                 /* Failed to allocate memory */
                 return ESP_ERR_HTTPD_ALLOC_MEM;
             }
+            hd->hd_calls[i] = &entry->uri;
             ESP_COMPILER_DIAGNOSTIC_POP("-Wanalyzer-malloc-leak")
 
             /* Copy URI string */
             hd->hd_calls[i]->uri = strdup(uri_handler->uri);
             if (hd->hd_calls[i]->uri == NULL) {
                 /* Failed to allocate memory */
-                free(hd->hd_calls[i]);
+                free(entry);
+                hd->hd_calls[i] = NULL;
                 return ESP_ERR_HTTPD_ALLOC_MEM;
             }
 
@@ -180,7 +261,8 @@ esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
                 if (hd->hd_calls[i]->supported_subprotocol == NULL) {
                     /* Failed to allocate memory */
                     free((void *)hd->hd_calls[i]->uri);
-                    free(hd->hd_calls[i]);
+                    free(entry);
+                    hd->hd_calls[i] = NULL;
                     return ESP_ERR_HTTPD_ALLOC_MEM;
                 }
             } else {
@@ -188,6 +270,7 @@ esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
             }
 #endif
             ESP_LOGD(TAG, LOG_FMT("[%d] installed %s"), i, uri_handler->uri);
+            httpd_uri_handlers_changed(hd);
             return ESP_OK;
         }
         ESP_LOGD(TAG, LOG_FMT("[%d] exists %s"), i, hd->hd_calls[i]->uri);
@@ -196,6 +279,79 @@ esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
     return ESP_ERR_HTTPD_HANDLERS_FULL;
 }
 
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
+                                     const httpd_uri_t *uri_handler)
+{
+    if (handle == NULL || uri_handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct httpd_data *hd = (struct httpd_data *) handle;
+    xSemaphoreTake(hd->hd_calls_lock, portMAX_DELAY);
+    esp_err_t ret = httpd_add_uri_handler(hd, uri_handler);
+    xSemaphoreGive(hd->hd_calls_lock);
+    return ret;
+}
+
+static void httpd_free_uri_handler(httpd_uri_t *uri_handler)
+{
+    free((char*)uri_handler->uri);
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    free((char*)uri_handler->supported_subprotocol);
+#endif // CONFIG_HTTPD_WS_SUPPORT
+    free(httpd_uri_entry_of(uri_handler));
+}
+
+/* Removes the handler at the given index, with hd_calls_lock held. It is freed
+ * once the requests running it are done */
+static void httpd_remove_uri_handler(struct httpd_data *hd, int i)
+{
+    httpd_uri_t *removed = hd->hd_calls[i];
+    ESP_LOGD(TAG, LOG_FMT("[%d] removing %s"), i, removed->uri);
+
+    /* Shift the remaining non null handlers in the array
+     * forward by 1 so that order of insertion is maintained */
+    for (i += 1; i < hd->config.max_uri_handlers; i++) {
+        if (!hd->hd_calls[i]) {
+            break;
+        }
+        hd->hd_calls[i-1] = hd->hd_calls[i];
+    }
+    /* Nullify the following non null entry */
+    hd->hd_calls[i-1] = NULL;
+    httpd_uri_handlers_changed(hd);
+
+    struct httpd_uri_entry *entry = httpd_uri_entry_of(removed);
+    entry->removed = true;
+    if (entry->refs == 0) {
+        httpd_free_uri_handler(removed);
+    }
+}
+
+void httpd_uri_handler_ref(struct httpd_data *hd, httpd_uri_t *handler)
+{
+    if (!handler) {
+        return;
+    }
+    xSemaphoreTake(hd->hd_calls_lock, portMAX_DELAY);
+    httpd_uri_entry_of(handler)->refs++;
+    xSemaphoreGive(hd->hd_calls_lock);
+}
+
+void httpd_uri_handler_unref(struct httpd_data *hd, httpd_uri_t *handler)
+{
+    if (!handler) {
+        return;
+    }
+    struct httpd_uri_entry *entry = httpd_uri_entry_of(handler);
+    xSemaphoreTake(hd->hd_calls_lock, portMAX_DELAY);
+    if (--entry->refs == 0 && entry->removed) {
+        ESP_LOGD(TAG, LOG_FMT("freeing unregistered %s"), handler->uri);
+        httpd_free_uri_handler(handler);
+    }
+    xSemaphoreGive(hd->hd_calls_lock);
+}
+
 esp_err_t httpd_unregister_uri_handler(httpd_handle_t handle,
                                        const char *uri, httpd_method_t method)
 {
@@ -204,34 +360,19 @@ esp_err_t httpd_unregister_uri_handler(httpd_handle_t handle,
     }
 
     struct httpd_data *hd = (struct httpd_data *) handle;
+    xSemaphoreTake(hd->hd_calls_lock, portMAX_DELAY);
     for (int i = 0; i < hd->config.max_uri_handlers; i++) {
         if (!hd->hd_calls[i]) {
             break;
         }
         if ((hd->hd_calls[i]->method == method) &&       // First match methods
             (strcmp(hd->hd_calls[i]->uri, uri) == 0)) {  // Then match URI string
-            ESP_LOGD(TAG, LOG_FMT("[%d] removing %s"), i, hd->hd_calls[i]->uri);
-
-            free((char*)hd->hd_calls[i]->uri);
-#ifdef CONFIG_HTTPD_WS_SUPPORT
-            free((char*)hd->hd_calls[i]->supported_subprotocol);
-#endif // CONFIG_HTTPD_WS_SUPPORT
-            free(hd->hd_calls[i]);
-            hd->hd_calls[i] = NULL;
-
-            /* Shift the remaining non null handlers in the array
-             * forward by 1 so that order of insertion is maintained */
-            for (i += 1; i < hd->config.max_uri_handlers; i++) {
-                if (!hd->hd_calls[i]) {
-                    break;
-                }
-                hd->hd_calls[i-1] = hd->hd_calls[i];
-            }
-            /* Nullify the following non null entry */
-            hd->hd_calls[i-1] = NULL;
+            httpd_remove_uri_handler(hd, i);
+            xSemaphoreGive(hd->hd_calls_lock);
             return ESP_OK;
         }
     }
+    xSemaphoreGive(hd->hd_calls_lock);
     ESP_LOGW(TAG, LOG_FMT("handler %s with method %d not found"), uri, method);
     return ESP_ERR_NOT_FOUND;
 }
@@ -245,33 +386,18 @@ esp_err_t httpd_unregister_uri(httpd_handle_t handle, const char *uri)
     struct httpd_data *hd = (struct httpd_data *) handle;
     bool found = false;
 
-    int i = 0, j = 0; // For keeping count of removed entries
-    for (; i < hd->config.max_uri_handlers; i++) {
-        if (!hd->hd_calls[i]) {
-            break;
-        }
+    int i = 0;
+    xSemaphoreTake(hd->hd_calls_lock, portMAX_DELAY);
+    while (i < hd->config.max_uri_handlers && hd->hd_calls[i]) {
         if (strcmp(hd->hd_calls[i]->uri, uri) == 0) {   // Match URI strings
-            ESP_LOGD(TAG, LOG_FMT("[%d] removing %s"), i, uri);
-
-            free((char*)hd->hd_calls[i]->uri);
-#ifdef CONFIG_HTTPD_WS_SUPPORT
-            free((char*)hd->hd_calls[i]->supported_subprotocol);
-#endif // CONFIG_HTTPD_WS_SUPPORT
-            free(hd->hd_calls[i]);
-            hd->hd_calls[i] = NULL;
+            /* The next handler is shifted into this slot */
+            httpd_remove_uri_handler(hd, i);
             found = true;
-
-            j++; // Update count of removed entries
         } else {
-            /* Shift the remaining non null handlers in the array
-             * forward by j so that order of insertion is maintained */
-            hd->hd_calls[i-j] = hd->hd_calls[i];
+            i++;
         }
     }
-    /* Nullify the following non null entries */
-    for (int k = (i - j); k < i; k++) {
-        hd->hd_calls[k] = NULL;
-    }
+    xSemaphoreGive(hd->hd_calls_lock);
 
     if (!found) {
         ESP_LOGW(TAG, LOG_FMT("no handler found for URI %s"), uri);
@@ -279,40 +405,25 @@ esp_err_t httpd_unregister_uri(httpd_handle_t handle, const char *uri)
     return (found ? ESP_OK : ESP_ERR_NOT_FOUND);
 }
 
+/* Called once the server has stopped, no request references the handlers anymore */
 void httpd_unregister_all_uri_handlers(struct httpd_data *hd)
 {
+#ifdef CONFIG_HTTPD_URI_ROUTER
+    httpd_router_delete(hd);
+#endif
     for (unsigned i = 0; i < hd->config.max_uri_handlers; i++) {
         if (!hd->hd_calls[i]) {
             break;
         }
         ESP_LOGD(TAG, LOG_FMT("[%d] removing %s"), i, hd->hd_calls[i]->uri);
-
-        free((char*)hd->hd_calls[i]->uri);
-#ifdef CONFIG_HTTPD_WS_SUPPORT
-        free((char*)hd->hd_calls[i]->supported_subprotocol);
-#endif // CONFIG_HTTPD_WS_SUPPORT
-        free(hd->hd_calls[i]);
+        httpd_free_uri_handler(hd->hd_calls[i]);
         hd->hd_calls[i] = NULL;
     }
 }
 
-esp_err_t httpd_uri(struct httpd_data *hd)
+/* Runs the handler matched by the request, or responds with the error of the lookup */
+static esp_err_t httpd_uri_call(struct httpd_data *hd, httpd_req_t *req, httpd_uri_t *uri, httpd_err_code_t err)
 {
-    httpd_uri_t            *uri = NULL;
-    httpd_req_t            *req = &hd->hd_req;
-    struct http_parser_url *res = &hd->hd_req_aux.url_parse_res;
-
-    /* For conveying URI not found/method not allowed */
-    httpd_err_code_t err = 0;
-
-    ESP_LOGD(TAG, LOG_FMT("request for %s with type %d"), req->uri, req->method);
-
-    /* URL parser result contains offset and length of path string */
-    if (res->field_set & (1 << UF_PATH)) {
-        uri = httpd_find_uri_handler(hd, req->uri + res->field_data[UF_PATH].off,
-                                     res->field_data[UF_PATH].len, req->method, &err);
-    }
-
     /* If URI with method not found, respond with error code */
     if (uri == NULL) {
         switch (err) {
@@ -331,6 +442,11 @@ esp_err_t httpd_uri(struct httpd_data *hd)
     /* Attach user context data (passed during URI registration) into request */
     req->user_ctx = uri->user_ctx;
 
+    /* Path parameters are only defined by the wildcard templates */
+    if (hd->config.uri_match_fn == httpd_uri_match_wildcard) {
+        ((struct httpd_req_aux *) req->aux)->uri_template = uri->uri;
+    }
+
     /* Final step for a WebSocket handshake verification */
 #ifdef CONFIG_HTTPD_WS_SUPPORT
     struct httpd_req_aux   *aux = req->aux;
@@ -343,7 +459,7 @@ esp_err_t httpd_uri(struct httpd_data *hd)
 #endif /* CONFIG_HTTPD_WS_PRE_HANDSHAKE_CB_SUPPORT */
 
         ESP_LOGD(TAG, LOG_FMT("Responding WS handshake to sock %d"), aux->sd->fd);
-        esp_err_t ret = httpd_ws_respond_server_handshake(&hd->hd_req, uri->supported_subprotocol);
+        esp_err_t ret = httpd_ws_respond_server_handshake(req, uri->supported_subprotocol);
         if (ret != ESP_OK) {
             return ret;
         }
@@ -371,3 +487,85 @@ esp_err_t httpd_uri(struct httpd_data *hd)
     }
     return ESP_OK;
 }
+
+esp_err_t httpd_uri(struct httpd_data *hd, httpd_req_t *req)
+{
+    httpd_uri_t            *uri = NULL;
+    struct httpd_req_aux   *ra  = req->aux;
+    struct http_parser_url *res = &ra->url_parse_res;
+
+    /* For conveying URI not found/method not allowed */
+    httpd_err_code_t err = 0;
+
+    ESP_LOGD(TAG, LOG_FMT("request for %s with type %d"), req->uri, req->method);
+
+    /* URL parser result contains offset and length of path string. The
+     * handler is referenced so that it isn't freed while it runs, even if
+     * it is unregistered meanwhile. */
+    if (res->field_set & (1 << UF_PATH)) {
+        xSemaphoreTake(hd->hd_calls_lock, portMAX_DELAY);
+        uri = httpd_find_uri_handler(hd, req->uri + res->field_data[UF_PATH].off,
+                                     res->field_data[UF_PATH].len, req->method, &err);
+        if (uri) {
+            httpd_uri_entry_of(uri)->refs++;
+        }
+        xSemaphoreGive(hd->hd_calls_lock);
+    }
+
+    ra->uri_handler = uri;
+    esp_err_t ret = httpd_uri_call(hd, req, uri, err);
+    ra->uri_handler = NULL;
+    ra->uri_template = NULL;
+    httpd_uri_handler_unref(hd, uri);
+    return ret;
+}
+
+esp_err_t httpd_req_get_path_param(httpd_req_t *r, const char *name, char *val, size_t val_size)
+{
+    if (r == NULL || name == NULL || val == NULL || val_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!httpd_valid_req(r)) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+
+    struct httpd_req_aux   *ra  = r->aux;
+    struct http_parser_url *res = &ra->url_parse_res;
+    const char *template = ra->uri_template;
+    size_t exact_len;
+    bool asterisk, quest;
+    if (!template || !(res->field_set & (1 << UF_PATH)) ||
+        !httpd_uri_template_parse(template, &exact_len, &asterisk, &quest)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    /* Walk the template and the path together, as the template matched
+     * the path the segments line up */
+    const char *path = r->uri + res->field_data[UF_PATH].off;
+    const size_t path_len = res->field_data[UF_PATH].len;
+    size_t t = 0, p = 0;
+    while (t < exact_len && p < path_len) {
+        size_t param_len = httpd_uri_param_len(template, t, exact_len);
+        if (!param_len) {
+            t++;
+            p++;
+            continue;
+        }
+        size_t value_len = 0;
+        while (p + value_len < path_len && path[p + value_len] != '/') {
+            value_len++;
+        }
+        /* Name without the braces */
+        if (param_len - 2 == strlen(name) && strncmp(template + t + 1, name, param_len - 2) == 0) {
+            /* Copy value to the caller's buffer. */
+            size_t copy_len = MIN(value_len, val_size - 1);
+            memcpy(val, path + p, copy_len);
+            val[copy_len] = '\0';
+            return copy_len < value_len ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+        }
+        t += param_len;
+        p += value_len;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
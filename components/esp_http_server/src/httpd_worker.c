@@ -0,0 +1,169 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_err.h>
+
+#include <esp_http_server.h>
+#include "esp_httpd_priv.h"
+#include "ctrl_sock.h"
+
+static const char *TAG = "httpd_worker";
+
+static void httpd_worker_thread(void *arg)
+{
+    struct httpd_worker *worker = (struct httpd_worker *) arg;
+    struct httpd_data *hd = worker->hd;
+    struct httpd_worker_result result;
+
+    while (xQueueReceive(worker->queue, &result.session, portMAX_DELAY) == pdTRUE && result.session) {
+        ESP_LOGD(TAG, LOG_FMT("processing socket %d"), result.session->fd);
+        result.ret = httpd_sess_process(hd, result.session, &worker->req, &worker->req_aux);
+        xQueueSend(hd->hd_worker_results, &result, portMAX_DELAY);
+
+        /* Wake up the server task unless another worker already did and the
+         * server task hasn't picked up the results since. The flag is cleared
+         * before the results are picked up, so this result is either picked up
+         * then or the server task is woken up again. If the control socket is
+         * full, the server task is woken up anyway. */
+        if (!__atomic_exchange_n(&hd->hd_worker_wakeup, true, __ATOMIC_SEQ_CST)) {
+            struct httpd_ctrl_data msg = {.hc_msg = HTTPD_CTRL_WORKER_DONE};
+            cs_send_to_ctrl_sock(hd->msg_fd, hd->config.ctrl_port, &msg, sizeof(msg));
+        }
+    }
+
+    ESP_LOGD(TAG, LOG_FMT("worker exiting"));
+    /* Tell the server task that this worker won't touch the server data anymore */
+    result.session = NULL;
+    xQueueSend(hd->hd_worker_results, &result, portMAX_DELAY);
+    httpd_os_thread_delete();
+}
+
+/* Frees the workers, all the tasks must have stopped */
+static void httpd_workers_free(struct httpd_worker *workers, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (workers[i].queue) {
+            vQueueDelete(workers[i].queue);
+        }
+        free(workers[i].req_aux.resp_hdrs);
+    }
+    free(workers);
+}
+
+/* Asks the workers to exit once they are done with the sessions already handed over */
+static void httpd_workers_signal_stop(struct httpd_worker *workers, int count)
+{
+    struct sock_db *stop = NULL;
+    for (int i = 0; i < count; i++) {
+        xQueueSend(workers[i].queue, &stop, portMAX_DELAY);
+    }
+}
+
+/* Stops the first count workers and waits for them to exit, discarding their results */
+static void httpd_workers_join(struct httpd_data *hd, struct httpd_worker *workers, int count)
+{
+    httpd_workers_signal_stop(workers, count);
+    struct httpd_worker_result result;
+    while (count && xQueueReceive(hd->hd_worker_results, &result, portMAX_DELAY) == pdTRUE) {
+        if (!result.session) {
+            count--;
+        }
+    }
+}
+
+esp_err_t httpd_workers_init(struct httpd_data *hd)
+{
+    int count = hd->config.worker_count;
+    if (count == 0) {
+        return ESP_OK;
+    }
+
+    /* A session always goes to the same worker, and isn't handed over
+     * again before its result has been picked up, so the queues can
+     * never overflow */
+    int queue_len = (hd->config.max_open_sockets + count - 1) / count + 1;
+    hd->hd_worker_results = xQueueCreate(hd->config.max_open_sockets + count, sizeof(struct httpd_worker_result));
+    struct httpd_worker *workers = httpd_calloc(count, sizeof(struct httpd_worker));
+    if (!hd->hd_worker_results || !workers) {
+        goto alloc_fail;
+    }
+    for (int i = 0; i < count; i++) {
+        workers[i].hd = hd;
+        workers[i].queue = xQueueCreate(queue_len, sizeof(struct sock_db *));
+        workers[i].req_aux.resp_hdrs = httpd_calloc(hd->config.max_resp_headers, sizeof(struct resp_hdr));
+        if (!workers[i].queue || !workers[i].req_aux.resp_hdrs) {
+            goto alloc_fail;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "httpd_worker%d", i);
+        BaseType_t core_id = hd->config.worker_core_id;
+        if (core_id == tskNO_AFFINITY) {
+            core_id = i % portNUM_PROCESSORS;
+        }
+        if (httpd_os_thread_create(&workers[i].handle, name,
+                                   hd->config.stack_size,
+                                   hd->config.task_priority,
+                                   httpd_worker_thread, &workers[i],
+                                   core_id,
+                                   hd->config.task_caps) != ESP_OK) {
+            ESP_LOGE(TAG, LOG_FMT("Failed to launch worker %d"), i);
+            httpd_workers_join(hd, workers, i);
+            httpd_workers_free(workers, count);
+            vQueueDelete(hd->hd_worker_results);
+            hd->hd_worker_results = NULL;
+            return ESP_ERR_HTTPD_TASK;
+        }
+    }
+    hd->hd_workers = workers;
+    return ESP_OK;
+
+alloc_fail:
+    ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for workers"));
+    if (workers) {
+        httpd_workers_free(workers, count);
+    }
+    if (hd->hd_worker_results) {
+        vQueueDelete(hd->hd_worker_results);
+        hd->hd_worker_results = NULL;
+    }
+    return ESP_ERR_HTTPD_ALLOC_MEM;
+}
+
+void httpd_workers_stop(struct httpd_data *hd)
+{
+    if (hd->hd_workers) {
+        httpd_workers_signal_stop(hd->hd_workers, hd->config.worker_count);
+    }
+}
+
+void httpd_workers_deinit(struct httpd_data *hd)
+{
+    if (!hd->hd_workers) {
+        return;
+    }
+    httpd_workers_free(hd->hd_workers, hd->config.worker_count);
+    hd->hd_workers = NULL;
+    vQueueDelete(hd->hd_worker_results);
+    hd->hd_worker_results = NULL;
+}
+
+void httpd_worker_dispatch(struct httpd_data *hd, struct sock_db *session)
+{
+    struct httpd_worker *worker = &hd->hd_workers[(session - hd->hd_sd) % hd->config.worker_count];
+    session->in_worker = true;
+    xQueueSend(worker->queue, &session, portMAX_DELAY);
+}
+
+bool httpd_worker_get_result(struct httpd_data *hd, struct httpd_worker_result *result, TickType_t wait)
+{
+    return xQueueReceive(hd->hd_worker_results, result, wait) == pdTRUE;
+}
@@ -35,6 +35,19 @@ typedef struct {
     EventGroupHandle_t transfer_done;
 } async_transfer_t;
 
+/* A frame broadcast to several clients, encoded once. Sessions that couldn't
+ * take all of it at once keep a reference until they have sent the rest. Only
+ * the server task touches it and the frames pending on the sessions */
+struct httpd_ws_bcast {
+    unsigned refs;                          /*!< Sessions with the frame pending, plus the broadcast while running */
+    httpd_handle_t handle;                  /*!< Server handle */
+    httpd_ws_broadcast_filter_t filter;     /*!< Selects the clients, NULL for all */
+    transfer_complete_cb callback;          /*!< Reports the result for each client, may be NULL */
+    void *arg;                              /*!< Argument of the filter and the callback */
+    size_t len;                             /*!< Length of the header and payload */
+    uint8_t data[];                         /*!< Header followed by the payload */
+};
+
 static const char *TAG="httpd_ws";
 
 /*
@@ -252,18 +265,40 @@ static esp_err_t httpd_ws_check_req(httpd_req_t *req)
     return ESP_OK;
 }
 
-static esp_err_t httpd_ws_unmask_payload(uint8_t *payload, size_t len, const uint8_t *mask_key, size_t mask_offset)
+/* Machine word used to unmask the payload, may alias the bytes of the payload */
+typedef uintptr_t __attribute__((__may_alias__)) httpd_ws_mask_word_t;
+
+void httpd_ws_unmask_payload(uint8_t *payload, size_t len, const uint8_t *mask_key, size_t mask_offset)
 {
-    if (len < 1 || !payload) {
-        ESP_LOGW(TAG, LOG_FMT("Invalid payload provided"));
-        return ESP_ERR_INVALID_ARG;
+    size_t idx = 0;
+
+    /* Bytes up to the first aligned word */
+    for (; idx < len && ((uintptr_t)(payload + idx) % sizeof(httpd_ws_mask_word_t)) != 0; idx++) {
+        payload[idx] ^= mask_key[(idx + mask_offset) % 4];
     }
 
-    for (size_t idx = 0; idx < len; idx++) {
-        payload[idx] = (payload[idx] ^ mask_key[(idx + mask_offset) % 4]);
+    size_t words = (len - idx) / sizeof(httpd_ws_mask_word_t);
+    if (words > 0) {
+        /* The mask key repeats every 4 bytes, so a word of the key rotated
+         * to the current offset applies to every word from here on */
+        uint8_t key_bytes[sizeof(httpd_ws_mask_word_t)];
+        for (size_t i = 0; i < sizeof(key_bytes); i++) {
+            key_bytes[i] = mask_key[(idx + mask_offset + i) % 4];
+        }
+        httpd_ws_mask_word_t key;
+        memcpy(&key, key_bytes, sizeof(key));
+
+        httpd_ws_mask_word_t *word = (httpd_ws_mask_word_t *)(payload + idx);
+        for (size_t i = 0; i < words; i++) {
+            word[i] ^= key;
+        }
+        idx += words * sizeof(httpd_ws_mask_word_t);
     }
 
-    return ESP_OK;
+    /* Remaining bytes */
+    for (; idx < len; idx++) {
+        payload[idx] ^= mask_key[(idx + mask_offset) % 4];
+    }
 }
 
 static esp_err_t httpd_ws_recv_frame_internal(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len, bool partial)
@@ -403,6 +438,45 @@ esp_err_t httpd_ws_recv_frame_part(httpd_req_t *req, httpd_ws_frame_t *frame, si
     return httpd_ws_recv_frame_internal(req, frame, max_len, true);
 }
 
+esp_err_t httpd_ws_recv_frame_zero_copy(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len)
+{
+    if (!frame) {
+        ESP_LOGW(TAG, LOG_FMT("Frame pointer is invalid"));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Get the frame header first, to size the receive buffer of the session */
+    esp_err_t ret = httpd_ws_recv_frame_internal(req, frame, 0, false);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    struct sock_db *sd = ((struct httpd_req_aux *)req->aux)->sd;
+    if (frame->left_len == 0) {
+        /* A frame of len 0 would be taken for one whose header is still to be received */
+        frame->payload = sd->ws_rx_buf;
+        return ESP_OK;
+    }
+    if (frame->left_len > max_len) {
+        ESP_LOGW(TAG, LOG_FMT("WS Message too long"));
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (frame->left_len > sd->ws_rx_buf_size) {
+        /* The buffer is kept for the next frames, until the session is closed */
+        uint8_t *buf = httpd_realloc(sd->ws_rx_buf, frame->left_len);
+        if (buf == NULL) {
+            ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for WS receive buffer"));
+            return ESP_ERR_NO_MEM;
+        }
+        sd->ws_rx_buf = buf;
+        sd->ws_rx_buf_size = frame->left_len;
+    }
+
+    /* The payload is received and unmasked in place */
+    frame->payload = sd->ws_rx_buf;
+    return httpd_ws_recv_frame_internal(req, frame, frame->left_len, false);
+}
+
 esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame)
 {
     esp_err_t ret = httpd_ws_check_req(req);
@@ -412,16 +486,12 @@ esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame)
     return httpd_ws_send_frame_async(req->handle, httpd_req_to_sockfd(req), frame);
 }
 
-esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+/* Encodes the header of a frame sent by the server into header_buf of 10 bytes,
+ * and returns the length of the header */
+static uint8_t httpd_ws_encode_header(const httpd_ws_frame_t *frame, uint8_t *header_buf)
 {
-    if (!frame) {
-        ESP_LOGW(TAG, LOG_FMT("Argument is invalid"));
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    /* Prepare Tx buffer - maximum length is 14, which includes 2 bytes header, 8 bytes length, 4 bytes mask key */
     uint8_t tx_len = 0;
-    uint8_t header_buf[10] = {0 };
+    memset(header_buf, 0, 10);
     /* Set the `FIN` bit by default if message is not fragmented. Else, set it as per the `final` field */
     header_buf[0] |= (!frame->fragmented) ? HTTPD_WS_FIN_BIT : (frame->final? HTTPD_WS_FIN_BIT: HTTPD_WS_CONTINUE);
     header_buf[0] |= frame->type; /* Type (opcode): 4 bits */
@@ -450,11 +520,114 @@ esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t
     /* WebSocket server does not required to mask response payload, so leave the MASK bit as 0. */
     header_buf[1] &= (~HTTPD_WS_MASK_BIT);
 
+    return tx_len;
+}
+
+void httpd_ws_bcast_drop(struct sock_db *sess)
+{
+    if (sess->ws_bcast) {
+        if (--sess->ws_bcast->refs == 0) {
+            free(sess->ws_bcast);
+        }
+        /* Other tasks sending to the session check it, see httpd_ws_send_frame_async() */
+        __atomic_store_n(&sess->ws_bcast, NULL, __ATOMIC_RELEASE);
+        sess->ws_bcast_sent = 0;
+    }
+}
+
+/* Sends the rest of the broadcast frame pending on a session. With MSG_DONTWAIT
+ * in flags, returns ESP_ERR_TIMEOUT if the client can't take all of it yet */
+static esp_err_t httpd_ws_bcast_flush(httpd_handle_t hd, struct sock_db *sess, int flags)
+{
+    struct httpd_ws_bcast *bcast = sess->ws_bcast;
+    while (sess->ws_bcast_sent < bcast->len) {
+        int ret = sess->send_fn(hd, sess->fd, (const char *)bcast->data + sess->ws_bcast_sent,
+                                bcast->len - sess->ws_bcast_sent, flags);
+        if (ret < 0) {
+            return (ret == HTTPD_SOCK_ERR_TIMEOUT) ? ESP_ERR_TIMEOUT : ESP_FAIL;
+        }
+        sess->ws_bcast_sent += ret;
+    }
+    httpd_ws_bcast_drop(sess);
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_bcast_send_pending(struct httpd_data *hd, struct sock_db *sess)
+{
+    esp_err_t err = httpd_ws_bcast_flush(hd, sess, MSG_DONTWAIT);
+    if (err == ESP_ERR_TIMEOUT) {
+        /* The rest is sent with the next frame */
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, LOG_FMT("Failed to send WS broadcast frame to %d"), sess->fd);
+    }
+    return err;
+}
+
+static void httpd_ws_bcast_flush_cb(void *arg)
+{
+    async_transfer_t *trans = arg;
+    struct sock_db *sess = httpd_sess_get(trans->handle, trans->socket);
+    esp_err_t err = ESP_OK;
+    if (sess && sess->ws_bcast) {
+        err = httpd_ws_bcast_flush(trans->handle, sess, 0);
+    }
+    xEventGroupSetBits(trans->transfer_done, err ? WS_SEND_FAILED : WS_SEND_OK);
+}
+
+/* Has the server task send the rest of the broadcast frame pending on a session,
+ * for another task sending a frame to it, and waits for it */
+static esp_err_t httpd_ws_bcast_flush_queued(httpd_handle_t hd, int fd)
+{
+    async_transfer_t trans = {
+        .handle = hd,
+        .socket = fd,
+        .blocking = true,
+        .transfer_done = xEventGroupCreate(),
+    };
+    if (!trans.transfer_done) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = httpd_queue_work(hd, httpd_ws_bcast_flush_cb, &trans);
+    if (err == ESP_OK) {
+        EventBits_t status = xEventGroupWaitBits(trans.transfer_done, WS_SEND_OK | WS_SEND_FAILED,
+                                                 pdTRUE, pdFALSE, portMAX_DELAY);
+        err = (status & WS_SEND_OK) ? ESP_OK : ESP_FAIL;
+    }
+    vEventGroupDelete(trans.transfer_done);
+    return err;
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+{
+    if (!frame) {
+        ESP_LOGW(TAG, LOG_FMT("Argument is invalid"));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Prepare Tx buffer - maximum length is 14, which includes 2 bytes header, 8 bytes length, 4 bytes mask key */
+    uint8_t header_buf[10];
+    uint8_t tx_len = httpd_ws_encode_header(frame, header_buf);
+
     struct sock_db *sess = httpd_sess_get(hd, fd);
     if (!sess) {
         return ESP_ERR_INVALID_ARG;
     }
 
+    /* Finish off a broadcast frame the client couldn't take at once. Only the
+     * server task touches it, the other tasks have it sent there */
+    if (__atomic_load_n(&sess->ws_bcast, __ATOMIC_ACQUIRE)) {
+        struct httpd_data *data = (struct httpd_data *) hd;
+        esp_err_t err = (httpd_os_thread_handle() == data->hd_td.handle) ?
+                        httpd_ws_bcast_flush(hd, sess, 0) : httpd_ws_bcast_flush_queued(hd, fd);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, LOG_FMT("Failed to send WS broadcast frame"));
+            return ESP_FAIL;
+        }
+    }
+
     /* Send off header */
     if (sess->send_fn(hd, fd, (const char *)header_buf, tx_len, 0) < 0) {
         ESP_LOGW(TAG, LOG_FMT("Failed to send WS header"));
@@ -584,7 +757,7 @@ static void httpd_ws_send_cb(void *arg)
 
 esp_err_t httpd_ws_send_data(httpd_handle_t handle, int socket, httpd_ws_frame_t *frame)
 {
-    async_transfer_t *transfer = calloc(1, sizeof(async_transfer_t));
+    async_transfer_t *transfer = httpd_calloc(1, sizeof(async_transfer_t));
     if (transfer == NULL) {
         return ESP_ERR_NO_MEM;
     }
@@ -616,10 +789,104 @@ esp_err_t httpd_ws_send_data(httpd_handle_t handle, int socket, httpd_ws_frame_t
     return (status & WS_SEND_OK) ? ESP_OK : ESP_FAIL;
 }
 
+static void httpd_ws_broadcast_cb(void *arg)
+{
+    struct httpd_ws_bcast *bcast = arg;
+    struct httpd_data *hd = (struct httpd_data *) bcast->handle;
+
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        struct sock_db *sess = &hd->hd_sd[i];
+        if (sess->fd < 0 || !sess->ws_handshake_done || sess->ws_close) {
+            continue;
+        }
+        if (bcast->filter && !bcast->filter(bcast->handle, sess->fd, bcast->arg)) {
+            continue;
+        }
+
+        /* A client that is slow to read must not hold up the others. Its
+         * frame is dropped if the previous one is still on its way to it.
+         * Send functions which ignore MSG_DONTWAIT, like the one of
+         * esp_https_server, block here instead */
+        int fd = sess->fd;
+        esp_err_t err = ESP_OK;
+        if (sess->ws_bcast) {
+            err = sess->in_worker ? ESP_ERR_TIMEOUT : httpd_ws_bcast_flush(bcast->handle, sess, MSG_DONTWAIT);
+        }
+        if (err == ESP_OK) {
+            bcast->refs++;
+            sess->ws_bcast_sent = 0;
+            __atomic_store_n(&sess->ws_bcast, bcast, __ATOMIC_RELEASE);
+            /* A worker may be sending frames itself, so the frame is left
+             * pending until it sends one or gives the session back */
+            if (!sess->in_worker) {
+                err = httpd_ws_bcast_flush(bcast->handle, sess, MSG_DONTWAIT);
+                if (err == ESP_ERR_TIMEOUT && sess->ws_bcast_sent == 0) {
+                    /* None of the frame went out, so it can still be dropped */
+                    httpd_ws_bcast_drop(sess);
+                }
+            }
+        }
+        if (err == ESP_ERR_TIMEOUT) {
+            if (sess->ws_bcast == bcast) {
+                /* The rest of the frame is sent with the next one */
+                err = ESP_OK;
+            } else {
+                ESP_LOGD(TAG, LOG_FMT("client %d is busy, frame dropped"), fd);
+            }
+        } else if (err != ESP_OK) {
+            ESP_LOGW(TAG, LOG_FMT("Failed to send WS broadcast frame to %d"), fd);
+            httpd_ws_bcast_drop(sess);
+            httpd_sess_trigger_close_(bcast->handle, sess);
+        }
+        if (bcast->callback) {
+            bcast->callback(err, fd, bcast->arg);
+        }
+    }
+
+    /* Drop the reference of the broadcast itself */
+    if (--bcast->refs == 0) {
+        free(bcast);
+    }
+}
+
+esp_err_t httpd_ws_broadcast(httpd_handle_t handle, const httpd_ws_frame_t *frame,
+                             httpd_ws_broadcast_filter_t filter, transfer_complete_cb callback, void *arg)
+{
+    if (!handle || !frame || (frame->len > 0 && !frame->payload)) {
+        ESP_LOGW(TAG, LOG_FMT("Argument is invalid"));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t header_buf[10];
+    uint8_t tx_len = httpd_ws_encode_header(frame, header_buf);
+
+    /* Header and payload in one buffer, for a single send to every client */
+    struct httpd_ws_bcast *bcast = httpd_malloc(sizeof(struct httpd_ws_bcast) + tx_len + frame->len);
+    if (bcast == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    bcast->refs = 1;
+    bcast->handle = handle;
+    bcast->filter = filter;
+    bcast->callback = callback;
+    bcast->arg = arg;
+    bcast->len = tx_len + frame->len;
+    memcpy(bcast->data, header_buf, tx_len);
+    if (frame->len > 0) {
+        memcpy(bcast->data + tx_len, frame->payload, frame->len);
+    }
+
+    esp_err_t err = httpd_queue_work(handle, httpd_ws_broadcast_cb, bcast);
+    if (err != ESP_OK) {
+        free(bcast);
+    }
+    return err;
+}
+
 esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket, httpd_ws_frame_t *frame,
                                    transfer_complete_cb callback, void *arg)
 {
-    async_transfer_t *transfer = calloc(1, sizeof(async_transfer_t));
+    async_transfer_t *transfer = httpd_calloc(1, sizeof(async_transfer_t));
     if (transfer == NULL) {
         return ESP_ERR_NO_MEM;
     }
@@ -263,6 +263,19 @@ TEST_CASE("URI Wildcard Matcher Tests", "[HTTP SERVER]")
 
         {"/path/*/xxx", "/path/", false},
         {"/path/*/xxx", "/path/*/xxx", true},
+
+        {"/dev/{id}/cfg", "/dev/12/cfg", true},
+        {"/dev/{id}/cfg", "/dev/{id}/cfg", true},
+        {"/dev/{id}/cfg", "/dev//cfg", false},
+        {"/dev/{id}/cfg", "/dev/12/13/cfg", false},
+        {"/dev/{id}", "/dev/12", true},
+        {"/dev/{id}", "/dev/12/", false},
+        {"/dev/{id}/?", "/dev/12/", true},
+        {"/dev/{id}/*", "/dev/12/cfg", true},
+        {"/dev/{id}/*", "/dev/12", false},
+        {"/dev/{}/cfg", "/dev/12/cfg", false},
+        {"/dev/x{id}", "/dev/x12", false},
+        {"/dev/{id}x", "/dev/{id}x", true},
         {}
     };
 
@@ -42,6 +42,16 @@ typedef enum {
      */
     RINGBUF_TYPE_BYTEBUF,
     RINGBUF_TYPE_MAX,
+    /**
+     * Flag to OR with RINGBUF_TYPE_NOSPLIT or RINGBUF_TYPE_BYTEBUF for buffers
+     * that only ever have a single sender and a single receiver (task or ISR).
+     * Sending, receiving and returning items then don't enter a critical
+     * section unless the calling task has to block on a full or empty buffer.
+     * To tell a full buffer from an empty one, one byte of a byte buffer (or
+     * one 32-bit word of a no-split buffer) always stays unused.
+     * xRingbufferSendAcquire() is not supported on these buffers.
+     */
+    RINGBUF_TYPE_SPSC = 0x100,
 } RingbufferType_t;
 
 /**
@@ -65,6 +75,17 @@ typedef struct xSTATIC_RINGBUFFER {
     /** @endcond */
 } StaticRingbuffer_t;
 
+/**
+ * @brief Contiguous region of data retrieved from a byte buffer by xRingbufferReceiveVector()
+ *
+ * The layout of this struct matches struct iovec, so an array of retrieved
+ * regions can be passed to writev() or sendmsg() without copying the data.
+ */
+typedef struct {
+    void *pvData;       /**< Start of the region inside the ring buffer's storage area */
+    size_t xLength;     /**< Length of the region in bytes */
+} RingbufferVector_t;
+
 /**
  * @brief       Create a ring buffer
  *
@@ -188,7 +209,7 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer,
  * @note Only applicable for no-split ring buffers now, the actual size of
  *       memory that the item will occupy will be rounded up to the nearest 32-bit
  *       aligned size. This is done to ensure all items are always stored in 32-bit
- *       aligned fashion.
+ *       aligned fashion. Buffers created with RINGBUF_TYPE_SPSC are not supported.
  * @note An xItemSize of 0 will result in a buffer being acquired, but the buffer
  *       will have a size of 0.
  *
@@ -364,6 +385,57 @@ void *xRingbufferReceiveUpTo(RingbufHandle_t xRingbuffer,
  */
 void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemSize, size_t xMaxSize);
 
+/**
+ * @brief   Retrieve all readable regions of a byte buffer in a single call
+ *
+ * Attempt to retrieve up to xMaxSize bytes from a byte buffer. Unlike
+ * xRingbufferReceiveUpTo(), data that wraps around the end of the ring buffer
+ * is retrieved as well and is described by a second region. This function
+ * will block until there is data available for retrieval or until it times out.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the data from
+ * @param[out]  pxVectors       Array to which the retrieved regions will be written
+ * @param[in]   uxMaxVectors    Number of entries in pxVectors. The data of a byte buffer
+ *                              spans at most two regions, so more than 2 entries are never used.
+ * @param[in]   xMaxSize        Maximum number of bytes to retrieve in total, or 0 for no limit
+ * @param[in]   xTicksToWait    Ticks to wait for data in the ring buffer.
+ *
+ * @note    A call to vRingbufferReturnBytes() or vRingbufferReturnItem() is required after this to
+ *          free up the data retrieved.
+ * @note    This function should only be called on byte buffers
+ * @note    Byte buffers do not allow multiple retrievals before returning the data
+ *
+ * @return  Number of regions written to pxVectors, or 0 on timeout
+ */
+UBaseType_t xRingbufferReceiveVector(RingbufHandle_t xRingbuffer,
+                                     RingbufferVector_t *pxVectors,
+                                     UBaseType_t uxMaxVectors,
+                                     size_t xMaxSize,
+                                     TickType_t xTicksToWait);
+
+/**
+ * @brief   Retrieve all readable regions of a byte buffer in a single call. Call this from an ISR.
+ *
+ * Attempt to retrieve up to xMaxSize bytes from a byte buffer, including the data
+ * that wraps around the end of the ring buffer. This function will return immediately
+ * if there is no data available for retrieval.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the data from
+ * @param[out]  pxVectors       Array to which the retrieved regions will be written
+ * @param[in]   uxMaxVectors    Number of entries in pxVectors
+ * @param[in]   xMaxSize        Maximum number of bytes to retrieve in total, or 0 for no limit
+ *
+ * @note    A call to vRingbufferReturnBytesFromISR() or vRingbufferReturnItemFromISR() is required
+ *          after this to free up the data retrieved.
+ * @note    This function should only be called on byte buffers
+ *
+ * @return  Number of regions written to pxVectors, or 0 when the ring buffer is empty
+ */
+UBaseType_t xRingbufferReceiveVectorFromISR(RingbufHandle_t xRingbuffer,
+                                            RingbufferVector_t *pxVectors,
+                                            UBaseType_t uxMaxVectors,
+                                            size_t xMaxSize);
+
 /**
  * @brief   Return a previously-retrieved item to the ring buffer
  *
@@ -386,11 +458,41 @@ void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem);
  */
 void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken);
 
+/**
+ * @brief   Return the consumed part of the data previously retrieved from a byte buffer
+ *
+ * Frees the first xSize bytes of the data retrieved by the last call to
+ * xRingbufferReceiveVector() or xRingbufferReceiveUpTo(). The remaining bytes
+ * are not freed and will be retrieved again by the next receive call, which
+ * allows handling partial writes of a writev() or sendmsg() call.
+ *
+ * @param[in]   xRingbuffer Ring buffer the data was retrieved from
+ * @param[in]   xSize       Number of bytes consumed, must not exceed the number of bytes retrieved
+ *
+ * @note    This function should only be called on byte buffers
+ */
+void vRingbufferReturnBytes(RingbufHandle_t xRingbuffer, size_t xSize);
+
+/**
+ * @brief   Return the consumed part of the data previously retrieved from a byte buffer from an ISR
+ *
+ * @param[in]   xRingbuffer Ring buffer the data was retrieved from
+ * @param[in]   xSize       Number of bytes consumed, must not exceed the number of bytes retrieved
+ * @param[out]  pxHigherPriorityTaskWoken   Value pointed to will be set to pdTRUE
+ *                                          if the function woke up a higher priority task.
+ *
+ * @note    This function should only be called on byte buffers
+ */
+void vRingbufferReturnBytesFromISR(RingbufHandle_t xRingbuffer, size_t xSize, BaseType_t *pxHigherPriorityTaskWoken);
+
 /**
  * @brief   Reset a ring buffer back to its original empty state
  *
  * @param[in]   xRingbuffer     Ring buffer to reset
  *
+ * @note    For buffers created with RINGBUF_TYPE_SPSC, the sender and the receiver
+ *          must not access the buffer while it is reset.
+ *
  * @return ESP_ERR_INVALID_STATE if one or more items are not sent, completed or returned
  *         ESP_OK if the operation was successful
  */
@@ -27,6 +27,12 @@
 #define rbBUFFER_FULL_FLAG          ( ( UBaseType_t ) 4 )   //The ring buffer is currently full (write pointer == free pointer)
 #define rbBUFFER_STATIC_FLAG        ( ( UBaseType_t ) 8 )   //The ring buffer is statically allocated
 #define rbUSING_QUEUE_SET           ( ( UBaseType_t ) 16 )  //The ring buffer has been added to a queue set
+#define rbSPSC_FLAG                 ( ( UBaseType_t ) 32 )  //The ring buffer has a single producer and a single consumer
+#define rbSPSC_SEND_WAITING_FLAG    ( ( UBaseType_t ) 64 )  //A task is about to block or is blocked waiting to send to a SPSC ring buffer
+#define rbSPSC_RECV_WAITING_FLAG    ( ( UBaseType_t ) 128 ) //A task is about to block or is blocked waiting to receive from a SPSC ring buffer
+
+//Type of ring buffer without the RINGBUF_TYPE_SPSC flag
+#define rbBASE_TYPE( xBufferType )  ( ( RingbufferType_t ) ( ( xBufferType ) & ~RINGBUF_TYPE_SPSC ) )
 
 //Item flags
 #define rbITEM_FREE_FLAG            ( ( UBaseType_t ) 1 )   //Item has been retrieved and returned by application, free to overwrite
@@ -77,6 +83,20 @@ typedef struct RingbufferDefinition {
 
 _Static_assert(sizeof(StaticRingbuffer_t) == sizeof(Ringbuffer_t), "StaticRingbuffer_t != Ringbuffer_t");
 
+/*
+ * Single-producer/single-consumer (SPSC) ring buffers don't use the spinlock to
+ * send, receive or return items. Instead, each pointer is only ever written by
+ * one side:
+ *  - pucWrite (and pucAcquire, which always equals it) by the producer
+ *  - pucRead and pucFree by the consumer
+ * The producer publishes pucWrite with a release store after copying an item,
+ * and the consumer publishes pucFree with a release store after an item is
+ * returned. The write pointer never catches up with the free pointer, so that
+ * pucWrite == pucRead always means the buffer is empty, and rbBUFFER_FULL_FLAG
+ * and xItemsWaiting are not used. The spinlock and the task lists are only
+ * used by tasks that block on a full or empty buffer (see prvWaitSpsc()).
+ */
+
 // ------------------------------------------------ Forward Declares ---------------------------------------------------
 
 /*
@@ -183,8 +203,11 @@ static BaseType_t prvSendAcquireGeneric(Ringbuffer_t *pxRingbuffer,
 /*
 Generic function used to retrieve an item/data from ring buffers. If called on
 an allow-split buffer, and pvItem2 and xItemSize2 are not NULL, both parts of
-a split item will be retrieved. xMaxSize will only take effect if called on
-byte buffers. xItemSize must remain unchanged if no item is retrieved.
+a split item will be retrieved. If called on a byte buffer, and pvItem2 and
+xItemSize2 are not NULL, data that wraps around the end of the buffer will be
+retrieved as the second part (pvItem2 set to NULL if there is none). xMaxSize
+will only take effect if called on byte buffers, and limits the total size of
+both parts. xItemSize must remain unchanged if no item is retrieved.
 */
 static BaseType_t prvReceiveGeneric(Ringbuffer_t *pxRingbuffer,
                                     void **pvItem1,
@@ -202,6 +225,104 @@ static BaseType_t prvReceiveGenericFromISR(Ringbuffer_t *pxRingbuffer,
                                            size_t *xItemSize2,
                                            size_t xMaxSize);
 
+/*
+The following functions are used by SPSC ring buffers in place of the ones
+above. They may be called without a critical section, by the producer for the
+send side functions and by the consumer for the receive side functions.
+*/
+
+//Checks if an item/data is currently available for retrieval from a SPSC ring buffer
+static BaseType_t prvCheckItemAvailSpsc(Ringbuffer_t *pxRingbuffer);
+
+//Checks if an item will currently fit in a SPSC no-split ring buffer
+static BaseType_t prvCheckItemFitsSpscNoSplit(Ringbuffer_t *pxRingbuffer, size_t xItemSize);
+
+//Checks if an item will currently fit in a SPSC byte buffer
+static BaseType_t prvCheckItemFitsSpscByteBuf(Ringbuffer_t *pxRingbuffer, size_t xItemSize);
+
+//Copies an item to a SPSC no-split ring buffer and publishes it. Only call this function after calling prvCheckItemFitsSpscNoSplit()
+static void prvCopyItemSpscNoSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize);
+
+//Copies an item to a SPSC byte buffer and publishes it. Only call this function after calling prvCheckItemFitsSpscByteBuf()
+static void prvCopyItemSpscByteBuf(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize);
+
+//Retrieve item from a SPSC no-split ring buffer. Only call this function after calling prvCheckItemAvailSpsc()
+static void *prvGetItemSpscNoSplit(Ringbuffer_t *pxRingbuffer,
+                                   BaseType_t *pxIsSplit,
+                                   size_t xUnusedParam,
+                                   size_t *pxItemSize);
+
+//Retrieve data from a SPSC byte buffer. Only call this function after calling prvCheckItemAvailSpsc()
+static void *prvGetItemSpscByteBuf(Ringbuffer_t *pxRingbuffer,
+                                   BaseType_t *pxUnusedParam,
+                                   size_t xMaxSize,
+                                   size_t *pxItemSize);
+
+//Return an item to a SPSC no-split ring buffer, items may be returned in any order
+static void prvReturnItemSpscNoSplit(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
+
+//Return data to a SPSC byte buffer
+static void prvReturnItemSpscByteBuf(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
+
+//Get the maximum size an item that can currently have if sent to a SPSC no-split ring buffer
+static size_t prvGetCurMaxSizeSpscNoSplit(Ringbuffer_t *pxRingbuffer);
+
+//Get the maximum size an item that can currently have if sent to a SPSC byte buffer
+static size_t prvGetCurMaxSizeSpscByteBuf(Ringbuffer_t *pxRingbuffer);
+
+//Get the number of items (or bytes for byte buffers) waiting in a ring buffer
+static UBaseType_t prvGetItemsWaiting(Ringbuffer_t *pxRingbuffer);
+
+/*
+Retrieve the data that has wrapped around to the head of a (SPSC or regular)
+byte buffer, after xRetrievedSize bytes up to the tail have been retrieved.
+Returns NULL if there is no such data or xMaxSize has been reached.
+*/
+static void *prvGetWrappedItemByteBuf(Ringbuffer_t *pxRingbuffer,
+                                      size_t xMaxSize,
+                                      size_t xRetrievedSize,
+                                      size_t *pxItemSize);
+
+/*
+Return the first xSize bytes of the data retrieved from a (SPSC or regular)
+byte buffer. The read pointer is rewound over the remaining bytes so that they
+are retrieved again.
+*/
+static void prvReturnBytesByteBuf(Ringbuffer_t *pxRingbuffer, size_t xSize);
+
+/*
+Blocks the calling task until an item of xItemSize fits into (uxWaitFlag ==
+rbSPSC_SEND_WAITING_FLAG) or an item is available in (uxWaitFlag ==
+rbSPSC_RECV_WAITING_FLAG) a SPSC ring buffer. Returns pdFALSE on time-out.
+*/
+static BaseType_t prvWaitSpsc(Ringbuffer_t *pxRingbuffer,
+                              UBaseType_t uxWaitFlag,
+                              size_t xItemSize,
+                              TickType_t xTicksToWait);
+
+//Unblocks the task waiting on uxWaitFlag of a SPSC ring buffer, if there is one
+static void prvNotifySpsc(Ringbuffer_t *pxRingbuffer,
+                          UBaseType_t uxWaitFlag,
+                          BaseType_t xFromISR,
+                          BaseType_t *pxHigherPriorityTaskWoken);
+
+//Sends an item to a SPSC ring buffer, notifying the consumer or the queue set
+static BaseType_t prvSendGenericSpsc(Ringbuffer_t *pxRingbuffer,
+                                     const void *pvItem,
+                                     size_t xItemSize,
+                                     TickType_t xTicksToWait,
+                                     BaseType_t xFromISR,
+                                     BaseType_t *pxHigherPriorityTaskWoken);
+
+//Retrieves an item/data from a SPSC ring buffer, see prvReceiveGeneric() for the byte buffer second part
+static BaseType_t prvReceiveGenericSpsc(Ringbuffer_t *pxRingbuffer,
+                                        void **pvItem1,
+                                        void **pvItem2,
+                                        size_t *xItemSize1,
+                                        size_t *xItemSize2,
+                                        size_t xMaxSize,
+                                        TickType_t xTicksToWait);
+
 // ------------------------------------------------ Static Functions ---------------------------------------------------
 
 static void prvInitializeNewRingbuffer(size_t xBufferSize,
@@ -221,7 +342,29 @@ static void prvInitializeNewRingbuffer(size_t xBufferSize,
     pxNewRingbuffer->uxRingbufferFlags = 0;
 
     //Initialize type dependent values and function pointers
-    if (xBufferType == RINGBUF_TYPE_NOSPLIT) {
+    if (xBufferType == (RINGBUF_TYPE_NOSPLIT | RINGBUF_TYPE_SPSC)) {
+        pxNewRingbuffer->uxRingbufferFlags |= rbSPSC_FLAG;
+        pxNewRingbuffer->xCheckItemFits = prvCheckItemFitsSpscNoSplit;
+        pxNewRingbuffer->vCopyItem = prvCopyItemSpscNoSplit;
+        pxNewRingbuffer->pvGetItem = prvGetItemSpscNoSplit;
+        pxNewRingbuffer->vReturnItem = prvReturnItemSpscNoSplit;
+        /*
+         * Rounded down, so that an item of maximum size still fits into an
+         * empty buffer when the pointers point to the halfway point, and there
+         * is room left to keep the write pointer behind the free pointer.
+         */
+        pxNewRingbuffer->xMaxItemSize = ((pxNewRingbuffer->xSize / 2) & ~rbALIGN_MASK) - rbHEADER_SIZE;
+        pxNewRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeSpscNoSplit;
+    } else if (xBufferType == (RINGBUF_TYPE_BYTEBUF | RINGBUF_TYPE_SPSC)) {
+        pxNewRingbuffer->uxRingbufferFlags |= rbBYTE_BUFFER_FLAG | rbSPSC_FLAG;
+        pxNewRingbuffer->xCheckItemFits = prvCheckItemFitsSpscByteBuf;
+        pxNewRingbuffer->vCopyItem = prvCopyItemSpscByteBuf;
+        pxNewRingbuffer->pvGetItem = prvGetItemSpscByteBuf;
+        pxNewRingbuffer->vReturnItem = prvReturnItemSpscByteBuf;
+        //One byte always stays free to tell a full buffer from an empty one
+        pxNewRingbuffer->xMaxItemSize = pxNewRingbuffer->xSize - 1;
+        pxNewRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeSpscByteBuf;
+    } else if (xBufferType == RINGBUF_TYPE_NOSPLIT) {
         pxNewRingbuffer->xCheckItemFits = prvCheckItemFitsDefault;
         pxNewRingbuffer->vCopyItem = prvCopyItemNoSplit;
         pxNewRingbuffer->pvGetItem = prvGetItemDefault;
@@ -508,6 +651,9 @@ static void prvCopyItemByteBuf(Ringbuffer_t *pxRingbuffer, const uint8_t *pucIte
 
 static BaseType_t prvCheckItemAvail(Ringbuffer_t *pxRingbuffer)
 {
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return prvCheckItemAvailSpsc(pxRingbuffer);
+    }
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && pxRingbuffer->pucRead != pxRingbuffer->pucFree) {
         return pdFALSE;     //Byte buffers do not allow multiple retrievals before return
     }
@@ -574,10 +720,12 @@ static void *prvGetItemByteBuf(Ringbuffer_t *pxRingbuffer,
     //Check arguments and buffer state
     configASSERT((pxRingbuffer->xItemsWaiting > 0) && ((pxRingbuffer->pucRead != pxRingbuffer->pucWrite) || (pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG)));   //Check there are items to be read
     configASSERT(pxRingbuffer->pucRead >= pxRingbuffer->pucHead && pxRingbuffer->pucRead < pxRingbuffer->pucTail);    //Check read pointer is within bounds
-    configASSERT(pxRingbuffer->pucRead == pxRingbuffer->pucFree);
+    //Nothing else may be retrieved before return, unless retrieving data that wrapped around (see prvGetWrappedItemByteBuf())
+    configASSERT(pxRingbuffer->pucRead == pxRingbuffer->pucFree || pxRingbuffer->pucRead == pxRingbuffer->pucHead);
 
     uint8_t *ret = pxRingbuffer->pucRead;
-    if ((pxRingbuffer->pucRead > pxRingbuffer->pucWrite) || (pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG)) {     //Available data wraps around
+    if ((pxRingbuffer->pucRead > pxRingbuffer->pucWrite) ||
+            ((pxRingbuffer->pucRead == pxRingbuffer->pucWrite) && (pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG))) {     //Available data wraps around
         //Return contiguous piece from read pointer until buffer tail, or xMaxSize
         if (xMaxSize == 0 || pxRingbuffer->pucTail - pxRingbuffer->pucRead <= xMaxSize) {
             //All contiguous data from read pointer to tail
@@ -763,6 +911,319 @@ static size_t prvGetCurMaxSizeByteBuf(Ringbuffer_t *pxRingbuffer)
     return xFreeSize;
 }
 
+static BaseType_t prvCheckItemAvailSpsc(Ringbuffer_t *pxRingbuffer)
+{
+    if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && pxRingbuffer->pucRead != pxRingbuffer->pucFree) {
+        return pdFALSE;     //Byte buffers do not allow multiple retrievals before return
+    }
+    //The write pointer never catches up with the free pointer, so the buffer is empty if it equals the read pointer
+    return (pxRingbuffer->pucRead != __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_ACQUIRE)) ? pdTRUE : pdFALSE;
+}
+
+//Get where the header of an item of xItemSize would be stored in a SPSC no-split ring buffer, or NULL if it doesn't currently fit
+static uint8_t *prvGetItemPositionSpscNoSplit(Ringbuffer_t *pxRingbuffer, size_t xItemSize)
+{
+    uint8_t *pucWrite = __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_RELAXED);
+    uint8_t *pucFree = __atomic_load_n(&pxRingbuffer->pucFree, __ATOMIC_ACQUIRE);
+    size_t xTotalItemSize = rbALIGN_SIZE(xItemSize) + rbHEADER_SIZE;    //Rounded up aligned item size with header
+    configASSERT(rbCHECK_ALIGNED(pucWrite));                           //pucWrite is always aligned in no-split ring buffers
+    configASSERT(pucWrite >= pxRingbuffer->pucHead && pucWrite < pxRingbuffer->pucTail);   //Check write pointer is within bounds
+
+    //The write pointer must stay behind the free pointer, otherwise a full buffer would look empty
+    if (pucWrite < pucFree) {
+        //Free space does not wrap around
+        return (xTotalItemSize < pucFree - pucWrite) ? pucWrite : NULL;
+    }
+    //Free space wraps around (or the buffer is empty)
+    size_t xRemLen = pxRingbuffer->pucTail - pucWrite;
+    if (xTotalItemSize <= xRemLen) {
+        //If a header can't fit after the item, the write pointer wraps around to pucHead
+        if (pucFree != pxRingbuffer->pucHead || xRemLen - xTotalItemSize >= rbHEADER_SIZE) {
+            return pucWrite;    //Item fits without wrapping around
+        }
+    }
+    //Check if item fits by wrapping
+    return (xTotalItemSize < pucFree - pxRingbuffer->pucHead) ? pxRingbuffer->pucHead : NULL;
+}
+
+static BaseType_t prvCheckItemFitsSpscNoSplit(Ringbuffer_t *pxRingbuffer, size_t xItemSize)
+{
+    return (prvGetItemPositionSpscNoSplit(pxRingbuffer, xItemSize) != NULL) ? pdTRUE : pdFALSE;
+}
+
+static BaseType_t prvCheckItemFitsSpscByteBuf(Ringbuffer_t *pxRingbuffer, size_t xItemSize)
+{
+    return (xItemSize <= prvGetCurMaxSizeSpscByteBuf(pxRingbuffer)) ? pdTRUE : pdFALSE;
+}
+
+static void prvCopyItemSpscNoSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize)
+{
+    uint8_t *pucWrite = pxRingbuffer->pucWrite;
+    uint8_t *pucItemHeader = prvGetItemPositionSpscNoSplit(pxRingbuffer, xItemSize);
+    configASSERT(pucItemHeader != NULL);
+
+    //If the item is stored at the start of the buffer, set the remaining length as dummy data
+    if (pucItemHeader != pucWrite) {
+        ItemHeader_t *pxDummy = (ItemHeader_t *)pucWrite;
+        pxDummy->uxItemFlags = rbITEM_DUMMY_DATA_FLAG;
+        pxDummy->xItemLen = 0;
+    }
+    ItemHeader_t *pxHeader = (ItemHeader_t *)pucItemHeader;
+    pxHeader->xItemLen = xItemSize;
+    pxHeader->uxItemFlags = rbITEM_WRITTEN_FLAG;
+    memcpy(pucItemHeader + rbHEADER_SIZE, pucItem, xItemSize);
+
+    pucWrite = pucItemHeader + rbHEADER_SIZE + rbALIGN_SIZE(xItemSize);
+    //If current remaining length can't fit a header, wrap around write pointer
+    if (pxRingbuffer->pucTail - pucWrite < rbHEADER_SIZE) {
+        pucWrite = pxRingbuffer->pucHead;
+    }
+    //Publish the item to the consumer
+    pxRingbuffer->pucAcquire = pucWrite;
+    __atomic_store_n(&pxRingbuffer->pucWrite, pucWrite, __ATOMIC_RELEASE);
+}
+
+static void prvCopyItemSpscByteBuf(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize)
+{
+    uint8_t *pucWrite = pxRingbuffer->pucWrite;
+    size_t xRemLen = pxRingbuffer->pucTail - pucWrite;    //Length from pucWrite until end of buffer
+    if (xRemLen < xItemSize) {
+        //Copy as much as possible into remaining length
+        memcpy(pucWrite, pucItem, xRemLen);
+        pucItem += xRemLen;
+        xItemSize -= xRemLen;
+        pucWrite = pxRingbuffer->pucHead;
+    }
+    //Copy all or remaining portion of the item
+    memcpy(pucWrite, pucItem, xItemSize);
+    pucWrite += xItemSize;
+    if (pucWrite == pxRingbuffer->pucTail) {
+        pucWrite = pxRingbuffer->pucHead;
+    }
+    //Publish the data to the consumer
+    pxRingbuffer->pucAcquire = pucWrite;
+    __atomic_store_n(&pxRingbuffer->pucWrite, pucWrite, __ATOMIC_RELEASE);
+}
+
+static void *prvGetItemSpscNoSplit(Ringbuffer_t *pxRingbuffer,
+                                   BaseType_t *pxIsSplit,
+                                   size_t xUnusedParam,
+                                   size_t *pxItemSize)
+{
+    //Check arguments and buffer state
+    ItemHeader_t *pxHeader = (ItemHeader_t *)pxRingbuffer->pucRead;
+    configASSERT(rbCHECK_ALIGNED(pxRingbuffer->pucRead));           //pucRead is always aligned in no-split ring buffers
+    configASSERT(pxRingbuffer->pucRead >= pxRingbuffer->pucHead && pxRingbuffer->pucRead < pxRingbuffer->pucTail);      //Check read pointer is within bounds
+
+    //Wrap around if dummy data (dummy data indicates wrap around in no-split buffers)
+    if (pxHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+        pxRingbuffer->pucRead = pxRingbuffer->pucHead;
+        pxHeader = (ItemHeader_t *)pxRingbuffer->pucRead;
+    }
+    configASSERT(pxHeader->xItemLen <= pxRingbuffer->xMaxItemSize);
+
+    uint8_t *pcReturn = pxRingbuffer->pucRead + rbHEADER_SIZE;    //Get pointer to part of item containing data (point past the header)
+    *pxItemSize = pxHeader->xItemLen;
+    if (pxIsSplit != NULL) {
+        *pxIsSplit = pdFALSE;
+    }
+
+    pxRingbuffer->pucRead += rbHEADER_SIZE + rbALIGN_SIZE(pxHeader->xItemLen);   //Update pucRead
+    //Check if pucRead requires wrap around
+    if ((pxRingbuffer->pucTail - pxRingbuffer->pucRead) < rbHEADER_SIZE) {
+        pxRingbuffer->pucRead = pxRingbuffer->pucHead;
+    }
+    return (void *)pcReturn;
+}
+
+static void *prvGetItemSpscByteBuf(Ringbuffer_t *pxRingbuffer,
+                                   BaseType_t *pxUnusedParam,
+                                   size_t xMaxSize,
+                                   size_t *pxItemSize)
+{
+    uint8_t *pucWrite = __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_ACQUIRE);
+    uint8_t *ret = pxRingbuffer->pucRead;
+    configASSERT(ret != pucWrite);                                  //Check there is data to be read
+    configASSERT(ret == pxRingbuffer->pucFree || ret == pxRingbuffer->pucHead);
+
+    //Return contiguous data from read pointer until write pointer or buffer tail, limited to xMaxSize
+    size_t xSize = (pucWrite > ret) ? (size_t)(pucWrite - ret) : (size_t)(pxRingbuffer->pucTail - ret);
+    if (xMaxSize != 0 && xSize > xMaxSize) {
+        xSize = xMaxSize;
+    }
+    *pxItemSize = xSize;
+    pxRingbuffer->pucRead += xSize;
+    if (pxRingbuffer->pucRead == pxRingbuffer->pucTail) {
+        pxRingbuffer->pucRead = pxRingbuffer->pucHead;  //Wrap around read pointer
+    }
+    return (void *)ret;
+}
+
+static void prvReturnItemSpscNoSplit(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
+{
+    //Check arguments and buffer state
+    configASSERT(rbCHECK_ALIGNED(pucItem));
+    configASSERT(pucItem >= pxRingbuffer->pucHead);
+    configASSERT(pucItem <= pxRingbuffer->pucTail);     //Inclusive of pucTail in the case of zero length item at the very end
+
+    //Get and check header of the item
+    ItemHeader_t *pxCurHeader = (ItemHeader_t *)(pucItem - rbHEADER_SIZE);
+    configASSERT(pxCurHeader->xItemLen <= pxRingbuffer->xMaxItemSize);
+    configASSERT((pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) == 0); //Dummy items should never have been read
+    configASSERT((pxCurHeader->uxItemFlags & rbITEM_FREE_FLAG) == 0);       //Indicates item has already been returned before
+    pxCurHeader->uxItemFlags |= rbITEM_FREE_FLAG;                           //Mark as free
+
+    /*
+     * Items might not be returned in the order they were retrieved. Move the
+     * free pointer up to the next item that has not been returned, or up to the
+     * read pointer, skipping over dummy items.
+     */
+    uint8_t *pucFree = pxRingbuffer->pucFree;
+    while (pucFree != pxRingbuffer->pucRead) {
+        pxCurHeader = (ItemHeader_t *)pucFree;
+        if (pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+            pucFree = pxRingbuffer->pucHead;    //Wrap around due to dummy data
+        } else if (pxCurHeader->uxItemFlags & rbITEM_FREE_FLAG) {
+            pucFree += rbHEADER_SIZE + rbALIGN_SIZE(pxCurHeader->xItemLen);
+            //Check if pucFree requires wrap around
+            if ((pxRingbuffer->pucTail - pucFree) < rbHEADER_SIZE) {
+                pucFree = pxRingbuffer->pucHead;
+            }
+        } else {
+            break;
+        }
+    }
+    //Hand the space back to the producer
+    __atomic_store_n(&pxRingbuffer->pucFree, pucFree, __ATOMIC_RELEASE);
+}
+
+static void prvReturnItemSpscByteBuf(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
+{
+    //Check pointer points to address inside buffer
+    configASSERT((uint8_t *)pucItem >= pxRingbuffer->pucHead);
+    configASSERT((uint8_t *)pucItem < pxRingbuffer->pucTail);
+    //Free the read memory and hand it back to the producer
+    __atomic_store_n(&pxRingbuffer->pucFree, pxRingbuffer->pucRead, __ATOMIC_RELEASE);
+}
+
+static size_t prvGetCurMaxSizeSpscNoSplit(Ringbuffer_t *pxRingbuffer)
+{
+    uint8_t *pucWrite = __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_RELAXED);
+    uint8_t *pucFree = __atomic_load_n(&pxRingbuffer->pucFree, __ATOMIC_ACQUIRE);
+    BaseType_t xFreeSize;
+
+    //Must match prvGetItemPositionSpscNoSplit(): the write pointer stays at least one aligned word behind the free pointer
+    if (pucWrite < pucFree) {
+        xFreeSize = (pucFree - pucWrite) - (rbALIGN_MASK + 1);
+    } else {
+        //Select largest contiguous free space as no-split items require contiguous space
+        BaseType_t xSize1 = pxRingbuffer->pucTail - pucWrite;
+        BaseType_t xSize2 = (pucFree - pxRingbuffer->pucHead) - (rbALIGN_MASK + 1);
+        if (pucFree == pxRingbuffer->pucHead) {
+            xSize1 -= rbHEADER_SIZE;    //The write pointer must not wrap around onto the free pointer
+        }
+        xFreeSize = (xSize1 > xSize2) ? xSize1 : xSize2;
+    }
+
+    //No-split ring buffer items need space for a header
+    xFreeSize -= rbHEADER_SIZE;
+    if (xFreeSize < 0) {
+        xFreeSize = 0;
+    } else if (xFreeSize > pxRingbuffer->xMaxItemSize) {
+        //Limit free size to be within bounds
+        xFreeSize = pxRingbuffer->xMaxItemSize;
+    }
+    return xFreeSize;
+}
+
+static size_t prvGetCurMaxSizeSpscByteBuf(Ringbuffer_t *pxRingbuffer)
+{
+    uint8_t *pucWrite = __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_RELAXED);
+    uint8_t *pucFree = __atomic_load_n(&pxRingbuffer->pucFree, __ATOMIC_ACQUIRE);
+
+    //One byte always stays free, so that the write pointer never catches up with the free pointer
+    BaseType_t xFreeSize = (pucFree - pucWrite) - 1;
+    if (xFreeSize < 0) {
+        xFreeSize += pxRingbuffer->xSize;
+    }
+    return xFreeSize;
+}
+
+static UBaseType_t prvGetItemsWaiting(Ringbuffer_t *pxRingbuffer)
+{
+    if ((pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) == 0) {
+        return pxRingbuffer->xItemsWaiting;
+    }
+
+    //SPSC ring buffers don't keep count of the items, so count what lies between the read and write pointers
+    uint8_t *pucWrite = __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_ACQUIRE);
+    uint8_t *pucRead = pxRingbuffer->pucRead;
+    if (pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) {
+        return (pucWrite >= pucRead) ? (pucWrite - pucRead) : (pxRingbuffer->xSize - (pucRead - pucWrite));
+    }
+    UBaseType_t uxItemsWaiting = 0;
+    while (pucRead != pucWrite) {
+        ItemHeader_t *pxHeader = (ItemHeader_t *)pucRead;
+        if (pxHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+            pucRead = pxRingbuffer->pucHead;
+            continue;
+        }
+        uxItemsWaiting++;
+        pucRead += rbHEADER_SIZE + rbALIGN_SIZE(pxHeader->xItemLen);
+        if ((pxRingbuffer->pucTail - pucRead) < rbHEADER_SIZE) {
+            pucRead = pxRingbuffer->pucHead;
+        }
+    }
+    return uxItemsWaiting;
+}
+
+static void *prvGetWrappedItemByteBuf(Ringbuffer_t *pxRingbuffer,
+                                      size_t xMaxSize,
+                                      size_t xRetrievedSize,
+                                      size_t *pxItemSize)
+{
+    BaseType_t xAvail;
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        xAvail = (pxRingbuffer->pucRead != __atomic_load_n(&pxRingbuffer->pucWrite, __ATOMIC_ACQUIRE)) ? pdTRUE : pdFALSE;
+    } else {
+        xAvail = (pxRingbuffer->xItemsWaiting > 0) ? pdTRUE : pdFALSE;
+    }
+    //The read pointer only points to the head at this point if the retrieved data ended at the tail
+    if (pxRingbuffer->pucRead != pxRingbuffer->pucHead || xAvail == pdFALSE || (xMaxSize != 0 && xRetrievedSize >= xMaxSize)) {
+        return NULL;
+    }
+    return pxRingbuffer->pvGetItem(pxRingbuffer, NULL, (xMaxSize == 0) ? 0 : xMaxSize - xRetrievedSize, pxItemSize);
+}
+
+static void prvReturnBytesByteBuf(Ringbuffer_t *pxRingbuffer, size_t xSize)
+{
+    uint8_t *pucFree = pxRingbuffer->pucFree;
+    size_t xRetrievedSize;
+    if (pxRingbuffer->pucRead >= pucFree) {
+        xRetrievedSize = pxRingbuffer->pucRead - pucFree;
+    } else {
+        xRetrievedSize = pxRingbuffer->xSize - (pucFree - pxRingbuffer->pucRead);
+    }
+    if (xRetrievedSize == 0 && (pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG) && pxRingbuffer->xItemsWaiting == 0) {
+        xRetrievedSize = pxRingbuffer->xSize;   //The entire contents of a full buffer have been retrieved
+    }
+    configASSERT(xSize <= xRetrievedSize);
+
+    //Rewind the read pointer to the first byte that was not consumed
+    uint8_t *pucRead = pucFree + xSize;
+    if (pucRead >= pxRingbuffer->pucTail) {
+        pucRead -= pxRingbuffer->xSize;
+    }
+    pxRingbuffer->pucRead = pucRead;
+    if ((pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) == 0) {
+        pxRingbuffer->xItemsWaiting += xRetrievedSize - xSize;
+    }
+    if (xSize > 0) {
+        //Free the consumed bytes, i.e., up to the rewound read pointer
+        pxRingbuffer->vReturnItem(pxRingbuffer, pucFree);
+    }
+}
+
 static BaseType_t prvSendAcquireGeneric(Ringbuffer_t *pxRingbuffer,
                                         const void *pvItem,
                                         void **ppvItem,
@@ -775,6 +1236,11 @@ static BaseType_t prvSendAcquireGeneric(Ringbuffer_t *pxRingbuffer,
     BaseType_t xNotifyQueueSet = pdFALSE;
     TimeOut_t xTimeOut;
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        configASSERT(ppvItem == NULL);
+        return prvSendGenericSpsc(pxRingbuffer, pvItem, xItemSize, xTicksToWait, pdFALSE, NULL);
+    }
+
     while (xExitLoop == pdFALSE) {
         portENTER_CRITICAL(&pxRingbuffer->mux);
         if (pxRingbuffer->xCheckItemFits(pxRingbuffer, xItemSize) == pdTRUE) {
@@ -845,6 +1311,10 @@ static BaseType_t prvReceiveGeneric(Ringbuffer_t *pxRingbuffer,
 
     ESP_STATIC_ANALYZER_CHECK(!pvItem1 || !xItemSize1, pdFALSE);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return prvReceiveGenericSpsc(pxRingbuffer, pvItem1, pvItem2, xItemSize1, xItemSize2, xMaxSize, xTicksToWait);
+    }
+
     while (xExitLoop == pdFALSE) {
         portENTER_CRITICAL(&pxRingbuffer->mux);
         if (prvCheckItemAvail(pxRingbuffer) == pdTRUE) {
@@ -853,6 +1323,10 @@ static BaseType_t prvReceiveGeneric(Ringbuffer_t *pxRingbuffer,
             if (pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) {
                 //Read up to xMaxSize bytes from byte buffer
                 *pvItem1 = pxRingbuffer->pvGetItem(pxRingbuffer, NULL, xMaxSize, xItemSize1);
+                if (pvItem2 != NULL && xItemSize2 != NULL) {
+                    //Also read the data that wrapped around
+                    *pvItem2 = prvGetWrappedItemByteBuf(pxRingbuffer, xMaxSize, *xItemSize1, xItemSize2);
+                }
             } else {
                 //Get (first) item from no-split/allow-split buffers
                 *pvItem1 = pxRingbuffer->pvGetItem(pxRingbuffer, &xIsSplit, 0, xItemSize1);
@@ -907,12 +1381,21 @@ static BaseType_t prvReceiveGenericFromISR(Ringbuffer_t *pxRingbuffer,
 
     ESP_STATIC_ANALYZER_CHECK(!pvItem1 || !xItemSize1, pdFALSE);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        //Never blocks, thus never enters a critical section
+        return prvReceiveGenericSpsc(pxRingbuffer, pvItem1, pvItem2, xItemSize1, xItemSize2, xMaxSize, 0);
+    }
+
     portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
     if (prvCheckItemAvail(pxRingbuffer) == pdTRUE) {
         BaseType_t xIsSplit = pdFALSE;
         if (pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) {
             //Read up to xMaxSize bytes from byte buffer
             *pvItem1 = pxRingbuffer->pvGetItem(pxRingbuffer, NULL, xMaxSize, xItemSize1);
+            if (pvItem2 != NULL && xItemSize2 != NULL) {
+                //Also read the data that wrapped around
+                *pvItem2 = prvGetWrappedItemByteBuf(pxRingbuffer, xMaxSize, *xItemSize1, xItemSize2);
+            }
         } else {
             //Get (first) item from no-split/allow-split buffers
             *pvItem1 = pxRingbuffer->pvGetItem(pxRingbuffer, &xIsSplit, 0, xItemSize1);
@@ -937,15 +1420,153 @@ static BaseType_t prvReceiveGenericFromISR(Ringbuffer_t *pxRingbuffer,
     return xReturn;
 }
 
+static inline BaseType_t prvCheckReadySpsc(Ringbuffer_t *pxRingbuffer, UBaseType_t uxWaitFlag, size_t xItemSize)
+{
+    if (uxWaitFlag == rbSPSC_SEND_WAITING_FLAG) {
+        return pxRingbuffer->xCheckItemFits(pxRingbuffer, xItemSize);
+    }
+    return prvCheckItemAvailSpsc(pxRingbuffer);
+}
+
+static BaseType_t prvWaitSpsc(Ringbuffer_t *pxRingbuffer,
+                              UBaseType_t uxWaitFlag,
+                              size_t xItemSize,
+                              TickType_t xTicksToWait)
+{
+    List_t *pxTasksWaiting = (uxWaitFlag == rbSPSC_SEND_WAITING_FLAG) ? &pxRingbuffer->xTasksWaitingToSend : &pxRingbuffer->xTasksWaitingToReceive;
+    BaseType_t xTimedOut = pdFALSE;
+    BaseType_t xEntryTimeSet = pdFALSE;
+    TimeOut_t xTimeOut;
+
+    //The buffer is usually neither full nor empty, in which case no critical section is entered
+    while (prvCheckReadySpsc(pxRingbuffer, uxWaitFlag, xItemSize) == pdFALSE) {
+        if (xTicksToWait == (TickType_t) 0 || xTimedOut == pdTRUE) {
+            return pdFALSE;
+        }
+
+        portENTER_CRITICAL(&pxRingbuffer->mux);
+        if (xEntryTimeSet == pdFALSE) {
+            //This is our first block. Set entry time
+            vTaskInternalSetTimeOutState(&xTimeOut);
+            xEntryTimeSet = pdTRUE;
+        }
+        /*
+         * Announce the wait before checking the buffer again. Together with the
+         * fence in prvNotifySpsc(), either the other side sees the flag and
+         * unblocks us, or we see its update here and don't block.
+         */
+        __atomic_store_n(&pxRingbuffer->uxRingbufferFlags, pxRingbuffer->uxRingbufferFlags | uxWaitFlag, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (prvCheckReadySpsc(pxRingbuffer, uxWaitFlag, xItemSize) == pdTRUE) {
+            __atomic_store_n(&pxRingbuffer->uxRingbufferFlags, pxRingbuffer->uxRingbufferFlags & ~uxWaitFlag, __ATOMIC_RELAXED);
+        } else if (xTaskCheckForTimeOut(&xTimeOut, &xTicksToWait) == pdFALSE) {
+            //Not timed out yet. Block the current task. The flag is cleared by the task that unblocks us
+            vTaskPlaceOnEventList(pxTasksWaiting, xTicksToWait);
+            portYIELD_WITHIN_API();
+        } else {
+            //We have timed out. Check the buffer one last time
+            __atomic_store_n(&pxRingbuffer->uxRingbufferFlags, pxRingbuffer->uxRingbufferFlags & ~uxWaitFlag, __ATOMIC_RELAXED);
+            xTimedOut = pdTRUE;
+        }
+        portEXIT_CRITICAL(&pxRingbuffer->mux);
+    }
+
+    return pdTRUE;
+}
+
+static void prvNotifySpsc(Ringbuffer_t *pxRingbuffer,
+                          UBaseType_t uxWaitFlag,
+                          BaseType_t xFromISR,
+                          BaseType_t *pxHigherPriorityTaskWoken)
+{
+    List_t *pxTasksWaiting = (uxWaitFlag == rbSPSC_SEND_WAITING_FLAG) ? &pxRingbuffer->xTasksWaitingToSend : &pxRingbuffer->xTasksWaitingToReceive;
+
+    //Order the pointer update that was just published before the check of the flag, see prvWaitSpsc()
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if ((__atomic_load_n(&pxRingbuffer->uxRingbufferFlags, __ATOMIC_RELAXED) & uxWaitFlag) == 0) {
+        return;
+    }
+
+    if (xFromISR == pdTRUE) {
+        portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
+        __atomic_store_n(&pxRingbuffer->uxRingbufferFlags, pxRingbuffer->uxRingbufferFlags & ~uxWaitFlag, __ATOMIC_RELAXED);
+        if (listLIST_IS_EMPTY(pxTasksWaiting) == pdFALSE) {
+            if (xTaskRemoveFromEventList(pxTasksWaiting) == pdTRUE) {
+                //The unblocked task will preempt us. Record that a context switch is required.
+                if (pxHigherPriorityTaskWoken != NULL) {
+                    *pxHigherPriorityTaskWoken = pdTRUE;
+                }
+            }
+        }
+        portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
+    } else {
+        portENTER_CRITICAL(&pxRingbuffer->mux);
+        __atomic_store_n(&pxRingbuffer->uxRingbufferFlags, pxRingbuffer->uxRingbufferFlags & ~uxWaitFlag, __ATOMIC_RELAXED);
+        if (listLIST_IS_EMPTY(pxTasksWaiting) == pdFALSE) {
+            if (xTaskRemoveFromEventList(pxTasksWaiting) == pdTRUE) {
+                //The unblocked task will preempt us. Trigger a yield here.
+                portYIELD_WITHIN_API();
+            }
+        }
+        portEXIT_CRITICAL(&pxRingbuffer->mux);
+    }
+}
+
+static BaseType_t prvSendGenericSpsc(Ringbuffer_t *pxRingbuffer,
+                                     const void *pvItem,
+                                     size_t xItemSize,
+                                     TickType_t xTicksToWait,
+                                     BaseType_t xFromISR,
+                                     BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (prvWaitSpsc(pxRingbuffer, rbSPSC_SEND_WAITING_FLAG, xItemSize, xTicksToWait) == pdFALSE) {
+        return pdFALSE;
+    }
+    pxRingbuffer->vCopyItem(pxRingbuffer, pvItem, xItemSize);
+
+    if (pxRingbuffer->xQueueSet) {
+        //If ring buffer was added to a queue set, notify the queue set
+        if (xFromISR == pdTRUE) {
+            xQueueSendFromISR((QueueHandle_t)pxRingbuffer->xQueueSet, (QueueSetMemberHandle_t *)&pxRingbuffer, pxHigherPriorityTaskWoken);
+        } else {
+            xQueueSend((QueueHandle_t)pxRingbuffer->xQueueSet, (QueueSetMemberHandle_t *)&pxRingbuffer, 0);
+        }
+    } else {
+        //If a task was waiting for data to arrive on the ring buffer, unblock it
+        prvNotifySpsc(pxRingbuffer, rbSPSC_RECV_WAITING_FLAG, xFromISR, pxHigherPriorityTaskWoken);
+    }
+    return pdTRUE;
+}
+
+static BaseType_t prvReceiveGenericSpsc(Ringbuffer_t *pxRingbuffer,
+                                        void **pvItem1,
+                                        void **pvItem2,
+                                        size_t *xItemSize1,
+                                        size_t *xItemSize2,
+                                        size_t xMaxSize,
+                                        TickType_t xTicksToWait)
+{
+    if (prvWaitSpsc(pxRingbuffer, rbSPSC_RECV_WAITING_FLAG, 0, xTicksToWait) == pdFALSE) {
+        return pdFALSE;
+    }
+    *pvItem1 = pxRingbuffer->pvGetItem(pxRingbuffer, NULL, xMaxSize, xItemSize1);
+    if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && pvItem2 != NULL && xItemSize2 != NULL) {
+        //Also read the data that wrapped around
+        *pvItem2 = prvGetWrappedItemByteBuf(pxRingbuffer, xMaxSize, *xItemSize1, xItemSize2);
+    }
+    return pdTRUE;
+}
+
 // ------------------------------------------------ Public Functions ---------------------------------------------------
 
 RingbufHandle_t xRingbufferCreate(size_t xBufferSize, RingbufferType_t xBufferType)
 {
     configASSERT(xBufferSize > 0);
-    configASSERT(xBufferType < RINGBUF_TYPE_MAX);
+    configASSERT(rbBASE_TYPE(xBufferType) < RINGBUF_TYPE_MAX);
+    configASSERT(!(xBufferType & RINGBUF_TYPE_SPSC) || rbBASE_TYPE(xBufferType) != RINGBUF_TYPE_ALLOWSPLIT);
 
     //Allocate memory
-    if (xBufferType != RINGBUF_TYPE_BYTEBUF) {
+    if (rbBASE_TYPE(xBufferType) != RINGBUF_TYPE_BYTEBUF) {
         xBufferSize = rbALIGN_SIZE(xBufferSize);    //xBufferSize is rounded up for no-split/allow-split buffers
     }
     Ringbuffer_t *pxNewRingbuffer = calloc(1, sizeof(Ringbuffer_t));
@@ -976,9 +1597,10 @@ RingbufHandle_t xRingbufferCreateStatic(size_t xBufferSize,
 {
     //Check arguments
     configASSERT(xBufferSize > 0);
-    configASSERT(xBufferType < RINGBUF_TYPE_MAX);
+    configASSERT(rbBASE_TYPE(xBufferType) < RINGBUF_TYPE_MAX);
+    configASSERT(!(xBufferType & RINGBUF_TYPE_SPSC) || rbBASE_TYPE(xBufferType) != RINGBUF_TYPE_ALLOWSPLIT);
     configASSERT(pucRingbufferStorage != NULL && pxStaticRingbuffer != NULL);
-    if (xBufferType != RINGBUF_TYPE_BYTEBUF) {
+    if (rbBASE_TYPE(xBufferType) != RINGBUF_TYPE_BYTEBUF) {
         //No-split/allow-split buffer sizes must be 32-bit aligned
         configASSERT(rbCHECK_ALIGNED(xBufferSize));
     }
@@ -996,7 +1618,7 @@ BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, s
     //Check arguments
     configASSERT(pxRingbuffer);
     configASSERT(ppvItem != NULL);
-    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0); //Send acquire currently only supported in NoSplit buffers
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG | rbSPSC_FLAG)) == 0); //Send acquire currently only supported in NoSplit buffers
 
     *ppvItem = NULL;
     if (xItemSize > pxRingbuffer->xMaxItemSize) {
@@ -1014,7 +1636,7 @@ BaseType_t xRingbufferSendComplete(RingbufHandle_t xRingbuffer, void *pvItem)
     //Check arguments
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
-    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG | rbSPSC_FLAG)) == 0);
 
     portENTER_CRITICAL(&pxRingbuffer->mux);
     prvSendItemDoneNoSplit(pxRingbuffer, pvItem);
@@ -1076,6 +1698,9 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer,
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && xItemSize == 0) {
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return prvSendGenericSpsc(pxRingbuffer, pvItem, xItemSize, 0, pdTRUE, pxHigherPriorityTaskWoken);
+    }
 
     portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
     if (pxRingbuffer->xCheckItemFits(xRingbuffer, xItemSize) == pdTRUE) {
@@ -1214,12 +1839,72 @@ void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemS
     }
 }
 
+UBaseType_t xRingbufferReceiveVector(RingbufHandle_t xRingbuffer,
+                                     RingbufferVector_t *pxVectors,
+                                     UBaseType_t uxMaxVectors,
+                                     size_t xMaxSize,
+                                     TickType_t xTicksToWait)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+
+    //Check arguments
+    configASSERT(pxRingbuffer && pxVectors && uxMaxVectors > 0);
+    configASSERT(pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG);    //This function should only be called for byte buffers
+
+    //Attempt to retrieve up to xMaxSize bytes, including the data that wrapped around if there is room for a second region
+    void *pvTempItem2 = NULL;
+    size_t xTempSize2;
+    if (prvReceiveGeneric(pxRingbuffer, &pxVectors[0].pvData, (uxMaxVectors > 1) ? &pvTempItem2 : NULL,
+                          &pxVectors[0].xLength, &xTempSize2, xMaxSize, xTicksToWait) == pdFALSE) {
+        return 0;
+    }
+    if (pvTempItem2 == NULL) {
+        return 1;
+    }
+    pxVectors[1].pvData = pvTempItem2;
+    pxVectors[1].xLength = xTempSize2;
+    return 2;
+}
+
+UBaseType_t xRingbufferReceiveVectorFromISR(RingbufHandle_t xRingbuffer,
+                                            RingbufferVector_t *pxVectors,
+                                            UBaseType_t uxMaxVectors,
+                                            size_t xMaxSize)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+
+    //Check arguments
+    configASSERT(pxRingbuffer && pxVectors && uxMaxVectors > 0);
+    configASSERT(pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG);    //This function should only be called for byte buffers
+
+    //Attempt to retrieve up to xMaxSize bytes, including the data that wrapped around if there is room for a second region
+    void *pvTempItem2 = NULL;
+    size_t xTempSize2;
+    if (prvReceiveGenericFromISR(pxRingbuffer, &pxVectors[0].pvData, (uxMaxVectors > 1) ? &pvTempItem2 : NULL,
+                                 &pxVectors[0].xLength, &xTempSize2, xMaxSize) == pdFALSE) {
+        return 0;
+    }
+    if (pvTempItem2 == NULL) {
+        return 1;
+    }
+    pxVectors[1].pvData = pvTempItem2;
+    pxVectors[1].xLength = xTempSize2;
+    return 2;
+}
+
 void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
+        //If a task was waiting for space to send, unblock it
+        prvNotifySpsc(pxRingbuffer, rbSPSC_SEND_WAITING_FLAG, pdFALSE, NULL);
+        return;
+    }
+
     portENTER_CRITICAL(&pxRingbuffer->mux);
     pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
     //If a task was waiting for space to send, unblock it immediately.
@@ -1238,6 +1923,13 @@ void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, Bas
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
+        //If a task was waiting for space to send, unblock it
+        prvNotifySpsc(pxRingbuffer, rbSPSC_SEND_WAITING_FLAG, pdTRUE, pxHigherPriorityTaskWoken);
+        return;
+    }
+
     portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
     pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
     //If a task was waiting for space to send, unblock it immediately.
@@ -1252,6 +1944,58 @@ void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, Bas
     portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
 }
 
+void vRingbufferReturnBytes(RingbufHandle_t xRingbuffer, size_t xSize)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG);    //This function should only be called for byte buffers
+
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvReturnBytesByteBuf(pxRingbuffer, xSize);
+        //If a task was waiting for space to send, unblock it
+        prvNotifySpsc(pxRingbuffer, rbSPSC_SEND_WAITING_FLAG, pdFALSE, NULL);
+        return;
+    }
+
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    prvReturnBytesByteBuf(pxRingbuffer, xSize);
+    //If a task was waiting for space to send, unblock it immediately.
+    if (xSize > 0 && listLIST_IS_EMPTY(&pxRingbuffer->xTasksWaitingToSend) == pdFALSE) {
+        if (xTaskRemoveFromEventList(&pxRingbuffer->xTasksWaitingToSend) == pdTRUE) {
+            //The unblocked task will preempt us. Trigger a yield here.
+            portYIELD_WITHIN_API();
+        }
+    }
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+}
+
+void vRingbufferReturnBytesFromISR(RingbufHandle_t xRingbuffer, size_t xSize, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG);    //This function should only be called for byte buffers
+
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvReturnBytesByteBuf(pxRingbuffer, xSize);
+        //If a task was waiting for space to send, unblock it
+        prvNotifySpsc(pxRingbuffer, rbSPSC_SEND_WAITING_FLAG, pdTRUE, pxHigherPriorityTaskWoken);
+        return;
+    }
+
+    portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
+    prvReturnBytesByteBuf(pxRingbuffer, xSize);
+    //If a task was waiting for space to send, unblock it immediately.
+    if (xSize > 0 && listLIST_IS_EMPTY(&pxRingbuffer->xTasksWaitingToSend) == pdFALSE) {
+        if (xTaskRemoveFromEventList(&pxRingbuffer->xTasksWaitingToSend) == pdTRUE) {
+            //The unblocked task will preempt us. Record that a context switch is required.
+            if (pxHigherPriorityTaskWoken != NULL) {
+                *pxHigherPriorityTaskWoken = pdTRUE;
+            }
+        }
+    }
+    portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
+}
+
 esp_err_t vRingbufferReset(RingbufHandle_t xRingbuffer)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
@@ -1387,7 +2131,7 @@ void vRingbufferGetInfo(RingbufHandle_t xRingbuffer,
         *uxAcquire = (UBaseType_t)(pxRingbuffer->pucAcquire - pxRingbuffer->pucHead);
     }
     if (uxItemsWaiting != NULL) {
-        *uxItemsWaiting = (UBaseType_t)(pxRingbuffer->xItemsWaiting);
+        *uxItemsWaiting = prvGetItemsWaiting(pxRingbuffer);
     }
     portEXIT_CRITICAL(&pxRingbuffer->mux);
 }
@@ -1406,7 +2150,7 @@ void xRingbufferPrintInfo(RingbufHandle_t xRingbuffer)
            (int32_t)(pxRingbuffer->pucFree - pxRingbuffer->pucHead),
            (int32_t)(pxRingbuffer->pucWrite - pxRingbuffer->pucHead),
            (int32_t)(pxRingbuffer->pucAcquire - pxRingbuffer->pucHead),
-           (int32_t)pxRingbuffer->xItemsWaiting,
+           (int32_t)prvGetItemsWaiting(pxRingbuffer),
            RingbufferFlags);
 
     if (RingbufferFlags) {
@@ -1425,6 +2169,9 @@ void xRingbufferPrintInfo(RingbufHandle_t xRingbuffer)
         if (RingbufferFlags & rbUSING_QUEUE_SET) {
             printf(" [USING_QUEUE_SET]");
         }
+        if (RingbufferFlags & rbSPSC_FLAG) {
+            printf(" [SPSC]");
+        }
     }
     printf(" ]\n  Items:\n");
 
@@ -1497,7 +2244,7 @@ RingbufHandle_t xRingbufferCreateWithCaps(size_t xBufferSize, RingbufferType_t x
     uint8_t *pucRingbufferStorage;
 
     //Allocate memory
-    if (xBufferType != RINGBUF_TYPE_BYTEBUF) {
+    if (rbBASE_TYPE(xBufferType) != RINGBUF_TYPE_BYTEBUF) {
         xBufferSize = rbALIGN_SIZE(xBufferSize);    //xBufferSize is rounded up for no-split/allow-split buffers
     }
 
@@ -21,6 +21,11 @@
 #include "unity.h"
 #include "esp_rom_sys.h"
 #include "esp_task.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#else
+#include "esp_timer.h"
+#endif
 
 #include "test_functions.h"
 
@@ -1377,3 +1382,360 @@ TEST_CASE("Test ring buffer reset unblocks sender ", "[esp_ringbuf][linux]")
     vRingbufferDelete(rb);
     vTaskDelay(1);
 }
+
+/* ----------------------------------- Test SPSC ring buffers --------------------------------------
+ * SPSC no-split: Fill the buffer until it's full, then receive and return the items out of order.
+ *                Repeat with items of different sizes, so that the buffer wraps around at different
+ *                positions.
+ * SPSC byte buffer: Test the full buffer and the single retrieval limits of byte buffers
+ * SPSC producer/consumer: Send continuous data between a sending and a receiving task that block
+ *                         on the full or empty buffer
+ */
+
+TEST_CASE("Test SPSC no-split ring buffer", "[esp_ringbuf][linux]")
+{
+    RingbufHandle_t rb = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT | RINGBUF_TYPE_SPSC);
+    TEST_ASSERT_MESSAGE(rb != NULL, "Failed to create ring buffer");
+    const size_t max_item_size = xRingbufferGetMaxItemSize(rb);
+    TEST_ASSERT_EQUAL(((BUFFER_SIZE / 2) & ~0x3) - ITEM_HDR_SIZE, max_item_size);
+    TEST_ASSERT_EQUAL(max_item_size, xRingbufferGetCurFreeSize(rb));
+
+    uint8_t data[BUFFER_SIZE];
+    void *items[BUFFER_SIZE / ITEM_HDR_SIZE];
+    size_t sent_bytes = 0;
+    size_t rec_bytes = 0;
+    for (size_t item_size = 0; item_size <= max_item_size; item_size++) {
+        //Fill the buffer, the free size must match whether an item still fits
+        int num_items = 0;
+        while (true) {
+            size_t free_size = xRingbufferGetCurFreeSize(rb);
+            memset(data, (uint8_t)sent_bytes, item_size);
+            if (xRingbufferSend(rb, data, item_size, 0) == pdFALSE) {
+                TEST_ASSERT(free_size < item_size || free_size == 0);
+                break;
+            }
+            TEST_ASSERT(free_size >= item_size);
+            sent_bytes++;
+            num_items++;
+        }
+        TEST_ASSERT_GREATER_THAN(0, num_items);
+        UBaseType_t items_waiting;
+        vRingbufferGetInfo(rb, NULL, NULL, NULL, NULL, &items_waiting);
+        TEST_ASSERT_EQUAL(num_items, items_waiting);
+
+        //Receive all items in order, then return them in reverse order
+        for (int i = 0; i < num_items; i++) {
+            size_t size;
+            items[i] = xRingbufferReceive(rb, &size, 0);
+            TEST_ASSERT_NOT_NULL(items[i]);
+            TEST_ASSERT_EQUAL(item_size, size);
+            for (size_t j = 0; j < size; j++) {
+                TEST_ASSERT_EQUAL((uint8_t)rec_bytes, ((uint8_t *)items[i])[j]);
+            }
+            rec_bytes++;
+        }
+        size_t size;
+        TEST_ASSERT_NULL(xRingbufferReceive(rb, &size, 0));
+        for (int i = num_items - 1; i >= 0; i--) {
+            vRingbufferReturnItem(rb, items[i]);
+        }
+        TEST_ASSERT_EQUAL(max_item_size, xRingbufferGetCurFreeSize(rb));
+    }
+
+    //Send acquire is not supported, but the buffer can be reset
+    TEST_ASSERT_EQUAL(ESP_OK, vRingbufferReset(rb));
+    TEST_ASSERT_EQUAL(max_item_size, xRingbufferGetCurFreeSize(rb));
+    vRingbufferDelete(rb);
+}
+
+TEST_CASE("Test SPSC byte buffer", "[esp_ringbuf][linux]")
+{
+    RingbufHandle_t rb = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF | RINGBUF_TYPE_SPSC);
+    TEST_ASSERT_MESSAGE(rb != NULL, "Failed to create ring buffer");
+    //One byte always stays unused
+    TEST_ASSERT_EQUAL(BUFFER_SIZE - 1, xRingbufferGetMaxItemSize(rb));
+    TEST_ASSERT_EQUAL(BUFFER_SIZE - 1, xRingbufferGetCurFreeSize(rb));
+
+    uint8_t data[BUFFER_SIZE];
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        data[i] = i;
+    }
+    TEST_ASSERT_EQUAL(pdFALSE, xRingbufferSend(rb, data, BUFFER_SIZE, 0));
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSend(rb, data, BUFFER_SIZE - 1, 0));
+    TEST_ASSERT_EQUAL(0, xRingbufferGetCurFreeSize(rb));
+    TEST_ASSERT_EQUAL(pdFALSE, xRingbufferSend(rb, data, 1, 0));
+
+    //Data must be returned before it can be retrieved again
+    size_t size;
+    uint8_t *item = xRingbufferReceiveUpTo(rb, &size, 0, SMALL_ITEM_SIZE);
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_EQUAL(SMALL_ITEM_SIZE, size);
+    TEST_ASSERT_EQUAL_MEMORY(data, item, size);
+    TEST_ASSERT_NULL(xRingbufferReceive(rb, &size, 0));
+    TEST_ASSERT_EQUAL(0, xRingbufferGetCurFreeSize(rb));
+    vRingbufferReturnItem(rb, item);
+    TEST_ASSERT_EQUAL(SMALL_ITEM_SIZE, xRingbufferGetCurFreeSize(rb));
+
+    //Wrap around, the data is retrieved up to the end of the buffer first
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSend(rb, data, SMALL_ITEM_SIZE, 0));
+    item = xRingbufferReceive(rb, &size, 0);
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_EQUAL(BUFFER_SIZE - SMALL_ITEM_SIZE, size);
+    TEST_ASSERT_EQUAL_MEMORY(data + SMALL_ITEM_SIZE, item, BUFFER_SIZE - SMALL_ITEM_SIZE - 1);
+    TEST_ASSERT_EQUAL(0, item[size - 1]);
+    vRingbufferReturnItem(rb, item);
+    item = xRingbufferReceive(rb, &size, 0);
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_EQUAL(SMALL_ITEM_SIZE - 1, size);
+    TEST_ASSERT_EQUAL_MEMORY(data + 1, item, size);
+    vRingbufferReturnItem(rb, item);
+    TEST_ASSERT_NULL(xRingbufferReceive(rb, &size, 0));
+    TEST_ASSERT_EQUAL(BUFFER_SIZE - 1, xRingbufferGetCurFreeSize(rb));
+
+    vRingbufferDelete(rb);
+}
+
+#define SPSC_TEST_ITERATIONS        50
+
+static void spsc_send_task(void *args)
+{
+    RingbufHandle_t buffer = ((task_args_t *)args)->buffer;
+    size_t max_item_size = xRingbufferGetMaxItemSize(buffer);
+
+    for (int iter = 0; iter < SPSC_TEST_ITERATIONS; iter++) {
+        size_t bytes_sent = 0;
+        while (bytes_sent < CONT_DATA_LEN) {
+            size_t item_size = rand() % (max_item_size + 1);
+            if (item_size + bytes_sent > CONT_DATA_LEN) {
+                item_size = CONT_DATA_LEN - bytes_sent;
+            }
+            TEST_ASSERT_MESSAGE(xRingbufferSend(buffer, &continuous_data[bytes_sent], item_size, portMAX_DELAY) == pdTRUE, "Failed to send an item");
+            bytes_sent += item_size;
+        }
+    }
+    xSemaphoreGive(tx_done);
+    vTaskDelete(NULL);
+}
+
+static void spsc_rec_task(void *args)
+{
+    RingbufHandle_t buffer = ((task_args_t *)args)->buffer;
+
+    for (int iter = 0; iter < SPSC_TEST_ITERATIONS; iter++) {
+        size_t bytes_rec = 0;
+        while (bytes_rec < CONT_DATA_LEN) {
+            size_t item_size;
+            char *item;
+            if (((task_args_t *)args)->type & RINGBUF_TYPE_BYTEBUF) {
+                item = (char *)xRingbufferReceiveUpTo(buffer, &item_size, portMAX_DELAY, CONT_DATA_LEN - bytes_rec);
+            } else {
+                item = (char *)xRingbufferReceive(buffer, &item_size, portMAX_DELAY);
+            }
+            TEST_ASSERT_MESSAGE(item != NULL, "Failed to receive an item");
+            TEST_ASSERT_MESSAGE(memcmp(item, &continuous_data[bytes_rec], item_size) == 0, "Received data is corrupted");
+            bytes_rec += item_size;
+            vRingbufferReturnItem(buffer, item);
+        }
+        TEST_ASSERT_MESSAGE(bytes_rec == CONT_DATA_LEN, "Total length of received data is incorrect");
+    }
+    xSemaphoreGive(rx_done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Test SPSC ring buffer producer/consumer", "[esp_ringbuf][linux]")
+{
+    const RingbufferType_t types[] = { RINGBUF_TYPE_NOSPLIT | RINGBUF_TYPE_SPSC, RINGBUF_TYPE_BYTEBUF | RINGBUF_TYPE_SPSC };
+    tx_done = xSemaphoreCreateBinary();
+    rx_done = xSemaphoreCreateBinary();
+    TEST_ASSERT(tx_done != NULL && rx_done != NULL);
+    srand(SRAND_SEED);
+
+    for (int i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        task_args_t task_args;
+        task_args.buffer = xRingbufferCreate(CONT_DATA_TEST_BUFF_LEN, types[i]);
+        task_args.type = types[i];
+        TEST_ASSERT_MESSAGE(task_args.buffer != NULL, "Failed to create ring buffer");
+
+        for (int prior_mod = -1; prior_mod < 2; prior_mod++) {  //Test different relative priorities
+            xTaskCreatePinnedToCore(spsc_send_task, "send tsk", 2048, (void *)&task_args, ESP_TASK_MAIN_PRIO + 1 + prior_mod, NULL, 0);
+            xTaskCreatePinnedToCore(spsc_rec_task, "rec tsk", 2048, (void *)&task_args, ESP_TASK_MAIN_PRIO + 1, NULL, 0);
+            xSemaphoreTake(tx_done, portMAX_DELAY);
+            xSemaphoreTake(rx_done, portMAX_DELAY);
+            size_t size;
+            TEST_ASSERT_NULL(xRingbufferReceive(task_args.buffer, &size, 0));
+            vTaskDelay(5);  //Allow idle to clean up
+        }
+        vRingbufferDelete(task_args.buffer);
+    }
+    vSemaphoreDelete(tx_done);
+    vSemaphoreDelete(rx_done);
+}
+
+/* ---------------------------------- Test ring buffer throughput ----------------------------------
+ * Streams data through a byte buffer, once as a regular buffer and once as a SPSC buffer:
+ * - from a single task, which sends and receives without blocking
+ * - between a sending and a receiving task, which block on the full or empty buffer
+ */
+
+#define THROUGHPUT_BUFFER_SIZE      4096
+#define THROUGHPUT_CHUNK_SIZE       64
+#define THROUGHPUT_TOTAL_SIZE       (1024 * 1024)
+
+static uint8_t throughput_chunk[THROUGHPUT_CHUNK_SIZE];
+
+static int64_t throughput_time_us(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    //esp_timer is not implemented on linux
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#else
+    return esp_timer_get_time();
+#endif
+}
+
+static void throughput_send_task(void *args)
+{
+    RingbufHandle_t buffer = (RingbufHandle_t)args;
+    for (size_t sent = 0; sent < THROUGHPUT_TOTAL_SIZE; sent += THROUGHPUT_CHUNK_SIZE) {
+        TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSend(buffer, throughput_chunk, THROUGHPUT_CHUNK_SIZE, portMAX_DELAY));
+    }
+    xSemaphoreGive(tx_done);
+    vTaskDelete(NULL);
+}
+
+static void throughput_rec_task(void *args)
+{
+    RingbufHandle_t buffer = (RingbufHandle_t)args;
+    for (size_t received = 0; received < THROUGHPUT_TOTAL_SIZE;) {
+        size_t size;
+        void *data = xRingbufferReceive(buffer, &size, portMAX_DELAY);
+        TEST_ASSERT_NOT_NULL(data);
+        received += size;
+        vRingbufferReturnItem(buffer, data);
+    }
+    xSemaphoreGive(rx_done);
+    vTaskDelete(NULL);
+}
+
+static void measure_throughput(RingbufferType_t type, const char *name)
+{
+    RingbufHandle_t buffer = xRingbufferCreate(THROUGHPUT_BUFFER_SIZE, type);
+    TEST_ASSERT_MESSAGE(buffer != NULL, "Failed to create ring buffer");
+
+    int64_t start = throughput_time_us();
+    for (size_t sent = 0; sent < THROUGHPUT_TOTAL_SIZE; sent += THROUGHPUT_CHUNK_SIZE) {
+        size_t size;
+        TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSend(buffer, throughput_chunk, THROUGHPUT_CHUNK_SIZE, 0));
+        void *data = xRingbufferReceive(buffer, &size, 0);
+        TEST_ASSERT_NOT_NULL(data);
+        vRingbufferReturnItem(buffer, data);
+        if (size < THROUGHPUT_CHUNK_SIZE) {
+            //The data wrapped around the end of the buffer
+            data = xRingbufferReceive(buffer, &size, 0);
+            TEST_ASSERT_NOT_NULL(data);
+            vRingbufferReturnItem(buffer, data);
+        }
+    }
+    int64_t single_task_us = throughput_time_us() - start;
+
+    start = throughput_time_us();
+    xTaskCreatePinnedToCore(throughput_send_task, "send tsk", 2048, buffer, ESP_TASK_MAIN_PRIO + 1, NULL, 0);
+    xTaskCreatePinnedToCore(throughput_rec_task, "rec tsk", 2048, buffer, ESP_TASK_MAIN_PRIO + 1, NULL, 0);
+    xSemaphoreTake(tx_done, portMAX_DELAY);
+    xSemaphoreTake(rx_done, portMAX_DELAY);
+    int64_t two_tasks_us = throughput_time_us() - start;
+
+    printf("%s byte buffer: %d bytes in %d byte chunks, single task %.2f MB/s, two tasks %.2f MB/s\n",
+           name, THROUGHPUT_TOTAL_SIZE, THROUGHPUT_CHUNK_SIZE,
+           (double)THROUGHPUT_TOTAL_SIZE / single_task_us, (double)THROUGHPUT_TOTAL_SIZE / two_tasks_us);
+    vTaskDelay(5);  //Allow idle to clean up
+    vRingbufferDelete(buffer);
+}
+
+TEST_CASE("Test ring buffer throughput", "[esp_ringbuf][linux]")
+{
+    tx_done = xSemaphoreCreateBinary();
+    rx_done = xSemaphoreCreateBinary();
+    TEST_ASSERT(tx_done != NULL && rx_done != NULL);
+
+    measure_throughput(RINGBUF_TYPE_BYTEBUF, "Regular");
+    measure_throughput(RINGBUF_TYPE_BYTEBUF | RINGBUF_TYPE_SPSC, "SPSC");
+
+    vSemaphoreDelete(tx_done);
+    vSemaphoreDelete(rx_done);
+}
+
+static void test_vector_receive(RingbufferType_t type)
+{
+    RingbufHandle_t rb = xRingbufferCreate(BUFFER_SIZE, type);
+    TEST_ASSERT_MESSAGE(rb != NULL, "Failed to create ring buffer");
+    size_t max_size = xRingbufferGetMaxItemSize(rb);
+    RingbufferVector_t vec[3];
+    size_t size;
+
+    uint8_t data[BUFFER_SIZE];
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        data[i] = i;
+    }
+    TEST_ASSERT_EQUAL(0, xRingbufferReceiveVector(rb, vec, 3, 0, 0));
+
+    //Move the read and write pointers away from the head so that the data wraps around
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSend(rb, data, SMALL_ITEM_SIZE, 0));
+    TEST_ASSERT_EQUAL(1, xRingbufferReceiveVector(rb, vec, 3, 0, 0));
+    TEST_ASSERT_EQUAL(SMALL_ITEM_SIZE, vec[0].xLength);
+    vRingbufferReturnBytes(rb, SMALL_ITEM_SIZE);
+
+    //Fill the buffer, both regions are retrieved in a single call
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSend(rb, data, max_size, 0));
+    TEST_ASSERT_EQUAL(2, xRingbufferReceiveVector(rb, vec, 3, 0, 0));
+    TEST_ASSERT_EQUAL(BUFFER_SIZE - SMALL_ITEM_SIZE, vec[0].xLength);
+    TEST_ASSERT_EQUAL(max_size - vec[0].xLength, vec[1].xLength);
+    TEST_ASSERT_EQUAL_MEMORY(data, vec[0].pvData, vec[0].xLength);
+    TEST_ASSERT_EQUAL_MEMORY(data + vec[0].xLength, vec[1].pvData, vec[1].xLength);
+    //Data must be returned before it can be retrieved again
+    TEST_ASSERT_NULL(xRingbufferReceive(rb, &size, 0));
+
+    //Return part of the data, the rest is retrieved again by the next call
+    size_t consumed = vec[0].xLength + 3;
+    vRingbufferReturnBytes(rb, consumed);
+    TEST_ASSERT_EQUAL(consumed, xRingbufferGetCurFreeSize(rb));
+    TEST_ASSERT_EQUAL(1, xRingbufferReceiveVector(rb, vec, 3, 2, 0));
+    TEST_ASSERT_EQUAL(2, vec[0].xLength);
+    TEST_ASSERT_EQUAL_MEMORY(data + consumed, vec[0].pvData, vec[0].xLength);
+    vRingbufferReturnBytes(rb, 0);
+    TEST_ASSERT_EQUAL(consumed, xRingbufferGetCurFreeSize(rb));
+    TEST_ASSERT_EQUAL(1, xRingbufferReceiveVector(rb, vec, 3, 0, 0));
+    TEST_ASSERT_EQUAL(max_size - consumed, vec[0].xLength);
+    TEST_ASSERT_EQUAL_MEMORY(data + consumed, vec[0].pvData, vec[0].xLength);
+    vRingbufferReturnItem(rb, vec[0].pvData);
+    TEST_ASSERT_EQUAL(max_size, xRingbufferGetCurFreeSize(rb));
+
+    //Wrapped data is left for the next call if there is no room for a second region or xMaxSize is reached
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSend(rb, data, max_size - 1, 0));
+    TEST_ASSERT_EQUAL(1, xRingbufferReceiveVector(rb, vec, 1, 0, 0));
+    size_t first_size = vec[0].xLength;
+    TEST_ASSERT_LESS_THAN(max_size - 1, first_size);
+    vRingbufferReturnBytes(rb, 0);
+    TEST_ASSERT_EQUAL(1, xRingbufferReceiveVector(rb, vec, 2, first_size, 0));
+    TEST_ASSERT_EQUAL(first_size, vec[0].xLength);
+    vRingbufferReturnBytes(rb, 0);
+    TEST_ASSERT_EQUAL(2, xRingbufferReceiveVector(rb, vec, 2, first_size + 1, 0));
+    TEST_ASSERT_EQUAL(1, vec[1].xLength);
+    vRingbufferReturnBytes(rb, first_size + 1);
+    TEST_ASSERT_EQUAL(1, xRingbufferReceiveVector(rb, vec, 2, 0, 0));
+    TEST_ASSERT_EQUAL(max_size - 1 - first_size - 1, vec[0].xLength);
+    TEST_ASSERT_EQUAL_MEMORY(data + first_size + 1, vec[0].pvData, vec[0].xLength);
+    vRingbufferReturnBytes(rb, vec[0].xLength);
+    TEST_ASSERT_EQUAL(0, xRingbufferReceiveVector(rb, vec, 2, 0, 0));
+    TEST_ASSERT_EQUAL(max_size, xRingbufferGetCurFreeSize(rb));
+
+    vRingbufferDelete(rb);
+}
+
+TEST_CASE("Test byte buffer vectored receive and partial return", "[esp_ringbuf][linux]")
+{
+    test_vector_receive(RINGBUF_TYPE_BYTEBUF);
+    test_vector_receive(RINGBUF_TYPE_BYTEBUF | RINGBUF_TYPE_SPSC);
+}
@@ -43,6 +43,10 @@
 #include "esp_trace.h"
 #endif
 
+#if CONFIG_LOG_ASYNC
+#include "esp_private/log_async.h"
+#endif
+
 #if !CONFIG_ESP_SYSTEM_PANIC_SILENT_REBOOT
 #include "hal/uart_hal.h"
 #endif
@@ -432,6 +436,22 @@ void esp_panic_handler(panic_info_t *info)
 
     panic_print_str("\r\n");
 
+#if CONFIG_LOG_ASYNC && !CONFIG_ESP_SYSTEM_PANIC_SILENT_REBOOT
+    // Log messages still queued by the asynchronous writer are printed after the panic information,
+    // so that the latter is not lost if writing them fails
+    esp_panic_handler_feed_wdts();
+    static bool s_flushing_log = false;
+    if (s_flushing_log) {
+        panic_print_str("Re-entered log flush! Exception happened while writing buffered log messages!\r\n");
+    } else {
+        s_flushing_log = true;
+        panic_print_str("Buffered log messages:\r\n");
+        esp_log_async_panic_flush();
+        panic_print_str("\r\n");
+        s_flushing_log = false;
+    }
+#endif
+
 #if CONFIG_ESP_TRACE_ENABLE
     esp_panic_handler_feed_wdts();
     esp_trace_panic_handler(info);
@@ -401,6 +401,12 @@ void heap_caps_get_info( multi_heap_info_t *info, uint32_t caps )
             info->allocated_blocks += hinfo.allocated_blocks;
             info->free_blocks += hinfo.free_blocks;
             info->total_blocks += hinfo.total_blocks;
+#if HEAP_USE_MAGAZINES
+            for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+                info->cached_bytes += heap->magazines[core].cached_bytes;
+                info->cached_blocks += heap->magazines[core].cached_blocks;
+            }
+#endif
         }
     }
 }
@@ -419,12 +425,16 @@ void heap_caps_print_heap_info( uint32_t caps )
             printf("    largest_free_block %d alloc_blocks %d free_blocks %d total_blocks %d\n",
                    info.largest_free_block, info.allocated_blocks,
                    info.free_blocks, info.total_blocks);
+            heap_caps_pool_print_info(heap);
         }
     }
     printf("  Totals:\n");
     heap_caps_get_info(&info, caps);
 
     printf("    free %d allocated %d min_free %d largest_free_block %d\n", info.total_free_bytes, info.total_allocated_bytes, info.minimum_free_bytes, info.largest_free_block);
+#if HEAP_USE_MAGAZINES
+    printf("    cached in magazines %d bytes in %d blocks\n", info.cached_bytes, info.cached_blocks);
+#endif
 }
 
 bool heap_caps_check_integrity(uint32_t caps, bool print_errors)
@@ -597,6 +607,10 @@ __attribute__((noinline)) static bool heap_caps_walker(void *block_ptr, size_t b
 {
     walker_data_t *walker_data = (walker_data_t*)user_data;
 
+    if (block_used && heap_caps_pool_holds_block(walker_data->heap, block_ptr, block_size)) {
+        return true;
+    }
+
     walker_heap_into_t heap_info = {
         (intptr_t)walker_data->heap->start,
         (intptr_t)walker_data->heap->end
@@ -621,6 +635,7 @@ void heap_caps_walk(uint32_t caps, heap_caps_walker_cb_t walker_func, void *user
             && (all_heaps || (get_all_caps(heap) & caps) == caps)) {
             walker_data_t walker_data = {user_data, walker_func, heap};
             multi_heap_walk(heap->heap, heap_caps_walker, &walker_data);
+            heap_caps_pool_walk(heap, walker_func, user_data);
         }
     }
 }
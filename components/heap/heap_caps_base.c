@@ -10,8 +10,12 @@
 #include <sys/param.h>
 #include "esp_attr.h"
 #include "multi_heap.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "heap_private.h"
+#if CONFIG_HEAP_SAMPLING
+#include "heap_sampler_internal.h"
+#endif
 #if CONFIG_HEAP_TASK_TRACKING
 #include "esp_heap_task_info.h"
 #include "esp_heap_task_info_internal.h"
@@ -61,12 +65,74 @@ HEAP_IRAM_ATTR static void *dram_alloc_to_iram_addr(void *addr, size_t len)
     return iptr + 1;
 }
 
+#if HEAP_USE_MAGAZINES
+/* The magazine of the current core is protected by its own lock, which is only contended when another core
+   flushes it. If the task migrates to the other core while taking the lock, the magazine of that core is used,
+   which is still correct. */
+HEAP_IRAM_ATTR static void *heap_magazine_alloc(heap_t *heap, size_t size)
+{
+    if (size > MULTI_HEAP_MAGAZINE_MAX_SIZE) {
+        return NULL;
+    }
+    multi_heap_magazine_t *mag = &heap->magazines[xPortGetCoreID()];
+    MULTI_HEAP_LOCK(&mag->lock);
+    void *ret = multi_heap_magazine_get(mag, size);
+    MULTI_HEAP_UNLOCK(&mag->lock);
+    return ret;
+}
+
+HEAP_IRAM_ATTR static bool heap_magazine_free(heap_t *heap, void *ptr)
+{
+    size_t block_size = multi_heap_get_allocated_size(heap->heap, ptr);
+    multi_heap_magazine_t *mag = &heap->magazines[xPortGetCoreID()];
+    MULTI_HEAP_LOCK(&mag->lock);
+    bool cached = multi_heap_magazine_put(mag, ptr, block_size);
+    MULTI_HEAP_UNLOCK(&mag->lock);
+    return cached;
+}
+
+HEAP_IRAM_ATTR static size_t heap_magazines_flush(heap_t *heap)
+{
+    size_t freed = 0;
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        multi_heap_magazine_t *mag = &heap->magazines[core];
+        MULTI_HEAP_LOCK(&mag->lock);
+        void *block;
+        while ((block = multi_heap_magazine_take(mag)) != NULL) {
+            freed += multi_heap_get_allocated_size(heap->heap, block);
+            multi_heap_free(heap->heap, block);
+        }
+        MULTI_HEAP_UNLOCK(&mag->lock);
+    }
+    return freed;
+}
+#endif // HEAP_USE_MAGAZINES
+
+HEAP_IRAM_ATTR size_t heap_caps_flush_magazines(void)
+{
+    size_t freed = 0;
+#if HEAP_USE_MAGAZINES
+    heap_t *heap;
+    SLIST_FOREACH(heap, &registered_heaps, next) {
+        if (heap->heap != NULL) {
+            freed += heap_magazines_flush(heap);
+        }
+    }
+#endif
+    return freed;
+}
+
 HEAP_IRAM_ATTR void heap_caps_free( void *ptr)
 {
     if (ptr == NULL) {
         return;
     }
 
+#if CONFIG_HEAP_SAMPLING
+    //Before the block is freed, so that it can't be allocated and sampled again in between
+    heap_sampler_on_free(ptr);
+#endif
+
     if ((!esp_dram_match_iram() && esp_ptr_in_diram_iram(ptr)) ||
         (!esp_rtc_dram_match_rtc_iram() && esp_ptr_in_rtc_iram_fast(ptr))) {
         //Memory allocated here is actually allocated in the DRAM alias region and
@@ -83,16 +149,29 @@ HEAP_IRAM_ATTR void heap_caps_free( void *ptr)
     heap_caps_update_per_task_info_free(heap, ptr);
 #endif
 
-    multi_heap_free(heap->heap, block_owner_ptr);
+#if HEAP_USE_MAGAZINES
+    if (!heap_magazine_free(heap, block_owner_ptr))
+#endif
+    {
+        multi_heap_free(heap->heap, block_owner_ptr);
+    }
 
     CALL_HOOK(esp_heap_trace_free_hook, ptr);
 }
 
-HEAP_IRAM_ATTR static inline void *aligned_or_unaligned_alloc(multi_heap_handle_t heap, size_t size, size_t alignment, size_t offset) {
+HEAP_IRAM_ATTR static inline void *aligned_or_unaligned_alloc(heap_t *heap, size_t size, size_t alignment, size_t offset) {
     if (alignment<=UNALIGNED_MEM_ALIGNMENT_BYTES) { //alloc and friends align to 32-bit by default
-        return multi_heap_malloc(heap, size);
+#if HEAP_USE_MAGAZINES
+        void *ret = heap_magazine_alloc(heap, size);
+        if (ret != NULL) {
+            return ret;
+        }
+        //Allocate the whole size class, so that the block can be reused from the magazine once freed
+        size = multi_heap_magazine_round_size(size);
+#endif
+        return multi_heap_malloc(heap->heap, size);
     } else {
-        return multi_heap_aligned_alloc_offs(heap, size, alignment, offset);
+        return multi_heap_aligned_alloc_offs(heap->heap, size, alignment, offset);
     }
 }
 
@@ -139,6 +218,10 @@ HEAP_IRAM_ATTR NOINLINE_ATTR void *heap_caps_aligned_alloc_base(size_t alignment
         size = (size + 3) & (~3); // int overflow checked above
     }
 
+#if HEAP_USE_MAGAZINES
+    bool flushed = false;
+retry:
+#endif
     for (int prio = 0; prio < SOC_MEMORY_TYPE_NO_PRIOS; prio++) {
         //Iterate over heaps and check capabilities at this priority
         heap_t *heap;
@@ -159,7 +242,7 @@ HEAP_IRAM_ATTR NOINLINE_ATTR void *heap_caps_aligned_alloc_base(size_t alignment
                         //This is special, insofar that what we're going to get back is a DRAM address. If so,
                         //we need to 'invert' it (lowest address in DRAM == highest address in IRAM and vice-versa) and
                         //add a pointer to the DRAM equivalent before the address we're going to return.
-                        ret = aligned_or_unaligned_alloc(heap->heap, MULTI_HEAP_ADD_BLOCK_OWNER_SIZE(size) + 4,
+                        ret = aligned_or_unaligned_alloc(heap, MULTI_HEAP_ADD_BLOCK_OWNER_SIZE(size) + 4,
                                                         alignment, MULTI_HEAP_BLOCK_OWNER_SIZE());  // int overflow checked above
                         if (ret != NULL) {
 #if CONFIG_HEAP_TASK_TRACKING
@@ -173,11 +256,14 @@ HEAP_IRAM_ATTR NOINLINE_ATTR void *heap_caps_aligned_alloc_base(size_t alignment
                             ret = MULTI_HEAP_ADD_BLOCK_OWNER_OFFSET(ret);
                             uint32_t *iptr = dram_alloc_to_iram_addr(ret, size + 4);  // int overflow checked above
                             CALL_HOOK(esp_heap_trace_alloc_hook, iptr, size, caps);
+#if CONFIG_HEAP_SAMPLING
+                            heap_sampler_on_alloc(iptr, size);
+#endif
                             return iptr;
                         }
                     } else {
                         //Just try to alloc, nothing special.
-                        ret = aligned_or_unaligned_alloc(heap->heap, MULTI_HEAP_ADD_BLOCK_OWNER_SIZE(size),
+                        ret = aligned_or_unaligned_alloc(heap, MULTI_HEAP_ADD_BLOCK_OWNER_SIZE(size),
                                                         alignment, MULTI_HEAP_BLOCK_OWNER_SIZE());
                         if (ret != NULL) {
 #if CONFIG_HEAP_TASK_TRACKING
@@ -190,6 +276,9 @@ HEAP_IRAM_ATTR NOINLINE_ATTR void *heap_caps_aligned_alloc_base(size_t alignment
                             MULTI_HEAP_SET_BLOCK_OWNER(ret);
                             ret = MULTI_HEAP_ADD_BLOCK_OWNER_OFFSET(ret);
                             CALL_HOOK(esp_heap_trace_alloc_hook, ret, size, caps);
+#if CONFIG_HEAP_SAMPLING
+                            heap_sampler_on_alloc(ret, size);
+#endif
                             return ret;
                         }
                     }
@@ -198,6 +287,16 @@ HEAP_IRAM_ATTR NOINLINE_ATTR void *heap_caps_aligned_alloc_base(size_t alignment
         }
     }
 
+#if HEAP_USE_MAGAZINES
+    //The blocks cached in the magazines may be what's missing, return them to their heaps and try once more.
+    if (!flushed) {
+        flushed = true;
+        if (heap_caps_flush_magazines() > 0) {
+            goto retry;
+        }
+    }
+#endif
+
     //Nothing usable found.
     return NULL;
 }
@@ -277,6 +376,10 @@ HEAP_IRAM_ATTR NOINLINE_ATTR void *heap_caps_realloc_base( void *ptr, size_t siz
         TaskHandle_t old_task = MULTI_HEAP_GET_BLOCK_OWNER(ptr);
 #endif
 
+#if CONFIG_HEAP_SAMPLING
+        heap_sampler_on_free(MULTI_HEAP_ADD_BLOCK_OWNER_OFFSET(ptr));
+#endif
+
         void *r = multi_heap_realloc(heap->heap, ptr, MULTI_HEAP_ADD_BLOCK_OWNER_SIZE(size));
         if (r != NULL) {
             MULTI_HEAP_SET_BLOCK_OWNER(r);
@@ -292,6 +395,9 @@ HEAP_IRAM_ATTR NOINLINE_ATTR void *heap_caps_realloc_base( void *ptr, size_t siz
 
             r = MULTI_HEAP_ADD_BLOCK_OWNER_OFFSET(r);
             CALL_HOOK(esp_heap_trace_alloc_hook, r, size, caps);
+#if CONFIG_HEAP_SAMPLING
+            heap_sampler_on_alloc(r, size);
+#endif
             return r;
         }
     }
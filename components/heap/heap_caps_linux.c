@@ -12,6 +12,9 @@
 
 #include "esp_attr.h"
 #include "esp_heap_caps.h"
+#if CONFIG_HEAP_SAMPLING
+#include "heap_sampler_internal.h"
+#endif
 
 #ifdef CONFIG_HEAP_ABORT_WHEN_ALLOCATION_FAILS
 #include "esp_system.h"
@@ -54,6 +57,9 @@ static void *heap_caps_malloc_base( size_t size, uint32_t caps)
     if (!ptr && size > 0) {
         heap_caps_alloc_failed(size, caps, __func__);
     }
+#if CONFIG_HEAP_SAMPLING
+    heap_sampler_on_alloc(ptr, size);
+#endif
 
     return ptr;
 }
@@ -84,6 +90,9 @@ void *heap_caps_malloc_prefer( size_t size, size_t num, ... )
 
 static void *heap_caps_realloc_base( void *ptr, size_t size, uint32_t caps)
 {
+#if CONFIG_HEAP_SAMPLING
+    heap_sampler_on_free(ptr);
+#endif
     void *new_ptr = realloc(ptr, size);
     if (new_ptr == NULL && size > 0) {
         heap_caps_alloc_failed(size, caps, __func__);
@@ -93,6 +102,9 @@ static void *heap_caps_realloc_base( void *ptr, size_t size, uint32_t caps)
     // same as the original pointer or a new pointer if the memory was moved.
     // We return the new pointer, which may be the same as the original pointer.
     ptr = new_ptr;
+#if CONFIG_HEAP_SAMPLING
+    heap_sampler_on_alloc(ptr, size);
+#endif
 
     return ptr;
 }
@@ -114,6 +126,9 @@ void *heap_caps_realloc_prefer( void *ptr, size_t size, size_t num, ... )
 
 void heap_caps_free( void *ptr)
 {
+#if CONFIG_HEAP_SAMPLING
+    heap_sampler_on_free(ptr);
+#endif
     free(ptr);
 }
 
@@ -125,7 +140,11 @@ static void *heap_caps_calloc_base( size_t n, size_t size, uint32_t caps)
         return NULL;
     }
 
-    return calloc(n, size);
+    void *ptr = calloc(n, size);
+#if CONFIG_HEAP_SAMPLING
+    heap_sampler_on_alloc(ptr, size_bytes);
+#endif
+    return ptr;
 }
 
 void *heap_caps_calloc( size_t n, size_t size, uint32_t caps)
@@ -175,6 +194,11 @@ void heap_caps_print_heap_info( uint32_t caps )
     printf("No heap summary available when building for the linux target");
 }
 
+size_t heap_caps_flush_magazines(void)
+{
+    return 0;
+}
+
 bool heap_caps_check_integrity(uint32_t caps, bool print_errors)
 {
     return true;
@@ -215,6 +239,9 @@ void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
     if (!ptr && size > 0) {
         heap_caps_alloc_failed(size, caps, __func__);
     }
+#if CONFIG_HEAP_SAMPLING
+    heap_sampler_on_alloc(ptr, size);
+#endif
 
     return ptr;
 }
@@ -0,0 +1,205 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <assert.h>
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_caps_pool.h"
+#include "multi_heap_pool.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <pthread.h>
+#else
+#include "heap_private.h"
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+/* There are no registered heaps on Linux, pools are only locked */
+typedef pthread_mutex_t pool_lock_t;
+#define POOL_LOCK_INIT(lock)    pthread_mutex_init(lock, NULL)
+#define POOL_LOCK(lock)         pthread_mutex_lock(lock)
+#define POOL_UNLOCK(lock)       pthread_mutex_unlock(lock)
+#define POOL_LOCK_DELETE(lock)  pthread_mutex_destroy(lock)
+#else
+typedef multi_heap_lock_t pool_lock_t;
+#define POOL_LOCK_INIT(lock)    MULTI_HEAP_LOCK_INIT(lock)
+#define POOL_LOCK(lock)         MULTI_HEAP_LOCK(lock)
+#define POOL_UNLOCK(lock)       MULTI_HEAP_UNLOCK(lock)
+#define POOL_LOCK_DELETE(lock)
+#endif
+
+struct heap_caps_pool {
+    pool_lock_t lock;
+    multi_heap_pool_t pool;
+#if !CONFIG_IDF_TARGET_LINUX
+    heap_t *heap;                      ///< Heap the pool is allocated from
+    SLIST_ENTRY(heap_caps_pool) next;
+#endif
+};
+
+#define POOL_HEADER_SIZE ((sizeof(struct heap_caps_pool) + MULTI_HEAP_POOL_ALIGN - 1) & ~(MULTI_HEAP_POOL_ALIGN - 1))
+
+#if !CONFIG_IDF_TARGET_LINUX
+/* All pools, so that they can be walked and printed along with the heap they are allocated from */
+static SLIST_HEAD(pool_ll, heap_caps_pool) registered_pools = SLIST_HEAD_INITIALIZER(registered_pools);
+static multi_heap_lock_t registered_pools_lock = MULTI_HEAP_LOCK_STATIC_INITIALIZER;
+#endif
+
+heap_caps_pool_handle_t heap_caps_pool_create(size_t obj_size, uint32_t caps, size_t count)
+{
+    size_t pool_size = multi_heap_pool_required_size(obj_size, count);
+    if (pool_size == 0 || pool_size > SIZE_MAX - POOL_HEADER_SIZE) {
+        return NULL;
+    }
+
+    heap_caps_pool_handle_t pool = heap_caps_aligned_alloc(MULTI_HEAP_POOL_ALIGN, POOL_HEADER_SIZE + pool_size, caps);
+    if (pool == NULL) {
+        return NULL;
+    }
+    bool ok = multi_heap_pool_init(&pool->pool, (uint8_t *)pool + POOL_HEADER_SIZE, obj_size, count);
+    assert(ok);
+    (void)ok;
+    POOL_LOCK_INIT(&pool->lock);
+
+#if !CONFIG_IDF_TARGET_LINUX
+    pool->heap = find_containing_heap(pool);
+    MULTI_HEAP_LOCK(&registered_pools_lock);
+    SLIST_INSERT_HEAD(&registered_pools, pool, next);
+    MULTI_HEAP_UNLOCK(&registered_pools_lock);
+#endif
+    return pool;
+}
+
+void heap_caps_pool_delete(heap_caps_pool_handle_t pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+#if !CONFIG_IDF_TARGET_LINUX
+    MULTI_HEAP_LOCK(&registered_pools_lock);
+    SLIST_REMOVE(&registered_pools, pool, heap_caps_pool, next);
+    MULTI_HEAP_UNLOCK(&registered_pools_lock);
+#endif
+    POOL_LOCK_DELETE(&pool->lock);
+    heap_caps_free(pool);
+}
+
+HEAP_IRAM_ATTR void *heap_caps_pool_alloc(heap_caps_pool_handle_t pool)
+{
+    assert(pool != NULL);
+    POOL_LOCK(&pool->lock);
+    void *ret = multi_heap_pool_alloc(&pool->pool);
+    POOL_UNLOCK(&pool->lock);
+    return ret;
+}
+
+HEAP_IRAM_ATTR void heap_caps_pool_free(heap_caps_pool_handle_t pool, void *ptr)
+{
+    assert(pool != NULL);
+    if (ptr == NULL) {
+        return;
+    }
+    POOL_LOCK(&pool->lock);
+    bool freed = multi_heap_pool_free(&pool->pool, ptr);
+    POOL_UNLOCK(&pool->lock);
+    assert(freed && "invalid or double free of a pool object");
+    (void)freed;
+}
+
+HEAP_IRAM_ATTR void heap_caps_pool_get_info(heap_caps_pool_handle_t pool, heap_caps_pool_info_t *info)
+{
+    assert(pool != NULL && info != NULL);
+    POOL_LOCK(&pool->lock);
+    info->obj_size = pool->pool.obj_size;
+    info->slot_size = pool->pool.stride;
+    info->count = pool->pool.count;
+    info->free_count = pool->pool.free_count;
+    info->minimum_free_count = pool->pool.minimum_free_count;
+    POOL_UNLOCK(&pool->lock);
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+/* Copies the statistics of the n-th pool allocated from a heap, returns false if there are fewer pools */
+static bool heap_caps_pool_get_nth_info(heap_t *heap, size_t n, const void **start, heap_caps_pool_info_t *info)
+{
+    bool found = false;
+    heap_caps_pool_handle_t pool;
+    MULTI_HEAP_LOCK(&registered_pools_lock);
+    SLIST_FOREACH(pool, &registered_pools, next) {
+        if (pool->heap == heap && n-- == 0) {
+            *start = pool->pool.start;
+            heap_caps_pool_get_info(pool, info);
+            found = true;
+            break;
+        }
+    }
+    MULTI_HEAP_UNLOCK(&registered_pools_lock);
+    return found;
+}
+
+void heap_caps_pool_print_info(heap_t *heap)
+{
+    /* printf() can block, so it is not called with the lock held */
+    const void *start;
+    heap_caps_pool_info_t info;
+    for (size_t n = 0; heap_caps_pool_get_nth_info(heap, n, &start, &info); n++) {
+        printf("    pool at %p object size %d used %d of %d min_free %d\n",
+               start, info.obj_size, info.count - info.free_count, info.count, info.minimum_free_count);
+    }
+}
+
+bool heap_caps_pool_holds_block(heap_t *heap, const void *block_ptr, size_t block_size)
+{
+    bool found = false;
+    heap_caps_pool_handle_t pool;
+    MULTI_HEAP_LOCK(&registered_pools_lock);
+    SLIST_FOREACH(pool, &registered_pools, next) {
+        if (pool->heap == heap && (const uint8_t *)pool >= (const uint8_t *)block_ptr
+                && (const uint8_t *)pool < (const uint8_t *)block_ptr + block_size) {
+            found = true;
+            break;
+        }
+    }
+    MULTI_HEAP_UNLOCK(&registered_pools_lock);
+    return found;
+}
+
+typedef struct {
+    heap_caps_walker_cb_t cb_func;
+    void *opaque_ptr;
+    walker_heap_into_t heap_info;
+} pool_walker_data_t;
+
+static bool heap_caps_pool_walker(void *slot, size_t size, bool used, void *user_data)
+{
+    pool_walker_data_t *walker_data = (pool_walker_data_t *)user_data;
+    walker_block_info_t block_info = {
+        slot,
+        size,
+        used
+    };
+    return walker_data->cb_func(walker_data->heap_info, block_info, walker_data->opaque_ptr);
+}
+
+void heap_caps_pool_walk(heap_t *heap, heap_caps_walker_cb_t walker_func, void *user_data)
+{
+    heap_caps_pool_handle_t pool;
+    MULTI_HEAP_LOCK(&registered_pools_lock);
+    SLIST_FOREACH(pool, &registered_pools, next) {
+        if (pool->heap == heap) {
+            pool_walker_data_t walker_data = {
+                walker_func,
+                user_data,
+                { (intptr_t)pool->pool.start, (intptr_t)pool->pool.end }
+            };
+            POOL_LOCK(&pool->lock);
+            multi_heap_pool_walk(&pool->pool, heap_caps_pool_walker, &walker_data);
+            POOL_UNLOCK(&pool->lock);
+        }
+    }
+    MULTI_HEAP_UNLOCK(&registered_pools_lock);
+}
+#endif // !CONFIG_IDF_TARGET_LINUX
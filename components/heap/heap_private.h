@@ -12,6 +12,11 @@
 #include "multi_heap_platform.h"
 #include "sys/queue.h"
 #include "esp_attr.h"
+#include "esp_heap_caps.h"
+#if CONFIG_HEAP_MAGAZINES && defined(MULTI_HEAP_FREERTOS)
+#include "multi_heap_magazine.h"
+#define HEAP_USE_MAGAZINES 1
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +38,9 @@ typedef struct heap_t_ {
     intptr_t end;
     multi_heap_lock_t heap_mux;
     multi_heap_handle_t heap;
+#if HEAP_USE_MAGAZINES
+    multi_heap_magazine_t magazines[CONFIG_FREERTOS_NUMBER_OF_CORES]; ///< Cached small free blocks, one set per core
+#endif
     SLIST_ENTRY(heap_t_) next;
 } heap_t;
 
@@ -82,6 +90,25 @@ FORCE_INLINE_ATTR heap_t *find_containing_heap(void *ptr )
     return NULL;
 }
 
+#if HEAP_USE_MAGAZINES
+/* Initialize the magazines of a heap which is being registered */
+FORCE_INLINE_ATTR void heap_magazines_init(heap_t *heap)
+{
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        multi_heap_magazine_init(&heap->magazines[core]);
+    }
+}
+#endif
+
+/* Print the usage of the pools allocated from a heap, see heap_caps_pool.c */
+void heap_caps_pool_print_info(heap_t *heap);
+
+/* Check whether a block of a heap holds a pool, heap_caps_walk() lists the objects of the pool instead */
+bool heap_caps_pool_holds_block(heap_t *heap, const void *block_ptr, size_t block_size);
+
+/* Call walker_func for each object of the pools allocated from a heap */
+void heap_caps_pool_walk(heap_t *heap, heap_caps_walker_cb_t walker_func, void *user_data);
+
 /*
  Because we don't want to add _another_ known allocation method to the stack of functions to trace wrt memory tracing,
  these are declared private. The libc malloc()/realloc() implementation also calls these, so they are declared
@@ -0,0 +1,463 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_sampler.h"
+#include "heap_sampler_internal.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <pthread.h>
+#include <execinfo.h>
+#include <time.h>
+#else
+#include "freertos/FreeRTOS.h"
+#include "esp_cpu.h"
+#include "esp_memory_utils.h"
+#endif
+
+/*
+ Sampling follows the tcmalloc heap profiler: every allocated byte is sampled with the probability 1/interval,
+ which is implemented by counting down the allocated bytes from a distance drawn from an exponential distribution.
+ Allocations which aren't sampled only pay for the countdown.
+
+ Sampled allocations are aggregated per call stack in 'callsites'. Sampled allocations which weren't freed yet are
+ kept in the 'live' hash table, so that their frees can be subtracted from the in-use totals. Every free has to
+ check whether the pointer was sampled: 'live_filter' counts the live samples per hash bucket and is read without
+ the lock, the lock is only taken and the table probed when the bucket of the pointer is not empty.
+
+ All tables are static and bounded, the sampler never allocates memory.
+*/
+
+#ifdef CONFIG_HEAP_SAMPLING_MAX_CALLSITES
+#define MAX_CALLSITES       CONFIG_HEAP_SAMPLING_MAX_CALLSITES
+#define MAX_LIVE_SAMPLES    CONFIG_HEAP_SAMPLING_MAX_LIVE_SAMPLES
+#define STACK_DEPTH         CONFIG_HEAP_SAMPLING_STACK_DEPTH
+#else
+#define MAX_CALLSITES       64
+#define MAX_LIVE_SAMPLES    256
+#define STACK_DEPTH         8
+#endif
+
+/* Both hash tables are kept at most half full */
+#define CALLSITE_SLOTS      (MAX_CALLSITES * 2)
+#define LIVE_SLOTS          (MAX_LIVE_SAMPLES * 2)
+#define NO_CALLSITE         UINT16_MAX
+
+_Static_assert(MAX_CALLSITES < NO_CALLSITE, "too many callsites");
+
+typedef struct {
+    uint32_t hash;
+    uint32_t depth;
+    void *callers[STACK_DEPTH];
+    size_t alloc_count;
+    size_t alloc_bytes;
+    size_t inuse_count;
+    size_t inuse_bytes;
+} callsite_t;
+
+typedef struct {
+    void *ptr;                  ///< NULL if the slot is empty
+    size_t size;
+    uint16_t callsite;          ///< Index into s_callsites
+} live_sample_t;
+
+typedef struct {
+    int64_t countdown;          ///< Bytes left until the next sample
+    uint32_t generation;        ///< s_generation when countdown was drawn
+} countdown_t;
+
+volatile bool heap_sampler_running;
+
+static size_t s_interval;
+static uint32_t s_generation;
+static uint32_t s_rng_state = 0x2545F491;
+static heap_sampler_stats_t s_stats;
+
+static callsite_t s_callsites[MAX_CALLSITES];
+static uint16_t s_callsite_index[CALLSITE_SLOTS];
+static live_sample_t s_live[LIVE_SLOTS];
+static volatile uint16_t s_live_filter[LIVE_SLOTS];
+
+#if CONFIG_IDF_TARGET_LINUX
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+#define SAMPLER_LOCK()      pthread_mutex_lock(&s_lock)
+#define SAMPLER_UNLOCK()    pthread_mutex_unlock(&s_lock)
+
+/* One countdown per thread, as tcmalloc */
+static __thread countdown_t s_countdown;
+#define CURRENT_COUNTDOWN() (&s_countdown)
+#else
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+#define SAMPLER_LOCK()      portENTER_CRITICAL_SAFE(&s_lock)
+#define SAMPLER_UNLOCK()    portEXIT_CRITICAL_SAFE(&s_lock)
+
+/* One countdown per core. If a task is preempted while updating the countdown of its core, an update can be lost,
+   which only shifts the next sample a little. */
+static countdown_t s_countdown[portNUM_PROCESSORS];
+#define CURRENT_COUNTDOWN() (&s_countdown[xPortGetCoreID()])
+#endif
+
+/* Map a 32-bit hash to [0, n) without a division */
+static inline uint32_t reduce(uint32_t hash, uint32_t n)
+{
+    return ((uint64_t)hash * n) >> 32;
+}
+
+static inline uint32_t ptr_hash(const void *ptr)
+{
+    return (uint32_t)(((uintptr_t)ptr >> 2) * 0x9E3779B1u);
+}
+
+static HEAP_IRAM_ATTR uint32_t next_random(void)
+{
+    uint32_t x = s_rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_rng_state = x;
+    return x;
+}
+
+/* -log2(x / 2^32) in Q16 fixed point for x > 0, computed with the binary logarithm algorithm so that drawing
+   a sample distance doesn't need the FPU, which can't be used from an ISR. */
+static HEAP_IRAM_ATTR uint32_t neg_log2_q16(uint32_t x)
+{
+    int msb = 31 - __builtin_clz(x);
+    uint32_t m = x << (31 - msb); // mantissa in [1, 2) as Q31
+    uint32_t frac = 0;
+    for (int bit = 15; bit >= 0; bit--) {
+        uint64_t sq = (uint64_t)m * m; // Q62
+        if (sq >= (1ULL << 63)) {
+            m = sq >> 32;
+            frac |= 1u << bit;
+        } else {
+            m = sq >> 31;
+        }
+    }
+    return ((uint32_t)(32 - msb) << 16) - frac;
+}
+
+/* Distance to the next sample, exponentially distributed with the mean s_interval */
+static HEAP_IRAM_ATTR int64_t next_sample_distance(void)
+{
+    uint32_t u = next_random(); // never 0
+    const uint64_t ln2_q16 = 45426;
+    int64_t distance = ((uint64_t)s_interval * neg_log2_q16(u) * ln2_q16) >> 32;
+    return distance > 0 ? distance : 1;
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+
+/* Frames of get_callers() and heap_sampler_record_alloc() */
+#define SKIP_FRAMES 2
+
+static __attribute__((noinline)) uint32_t get_callers(void **callers)
+{
+    void *frames[STACK_DEPTH + SKIP_FRAMES];
+    int n = backtrace(frames, STACK_DEPTH + SKIP_FRAMES);
+    if (n <= SKIP_FRAMES) {
+        return 0;
+    }
+    memcpy(callers, frames + SKIP_FRAMES, (n - SKIP_FRAMES) * sizeof(void *));
+    return n - SKIP_FRAMES;
+}
+
+#elif CONFIG_IDF_TARGET_ARCH_XTENSA
+
+/* __builtin_return_address needs a constant argument, so the frames are read by an unrolled sequence.
+   Frame 0 is the caller of heap_sampler_record_alloc(). */
+#define GET_FRAME(N) do {                                               \
+        if (STACK_DEPTH == N) {                                         \
+            return N;                                                   \
+        }                                                               \
+        callers[N] = __builtin_return_address(N + 2);                   \
+        if (!esp_ptr_executable(callers[N])) {                          \
+            return N;                                                   \
+        }                                                               \
+    } while(0)
+
+static HEAP_IRAM_ATTR __attribute__((noinline)) uint32_t get_callers(void **callers)
+{
+    GET_FRAME(0);
+    GET_FRAME(1);
+    GET_FRAME(2);
+    GET_FRAME(3);
+    GET_FRAME(4);
+    GET_FRAME(5);
+    GET_FRAME(6);
+    GET_FRAME(7);
+    GET_FRAME(8);
+    GET_FRAME(9);
+    GET_FRAME(10);
+    GET_FRAME(11);
+    GET_FRAME(12);
+    GET_FRAME(13);
+    GET_FRAME(14);
+    GET_FRAME(15);
+    return 16;
+}
+
+#else // RISC-V, frame pointers are required by Kconfig
+
+extern uint32_t esp_fp_get_callers(uint32_t frame, void** callers, void** stacks, uint32_t depth);
+
+static HEAP_IRAM_ATTR __attribute__((noinline)) uint32_t get_callers(void **callers)
+{
+    uint32_t fp = (uint32_t) __builtin_frame_address(0);
+    return esp_fp_get_callers(fp, callers, NULL, STACK_DEPTH);
+}
+
+#endif
+
+/* Find the callsite of a call stack or add it, called with the lock held.
+   Returns NO_CALLSITE if the table is full. */
+static HEAP_IRAM_ATTR uint16_t find_callsite(void **callers, uint32_t depth)
+{
+    uint32_t hash = 0x811C9DC5;
+    for (uint32_t i = 0; i < depth; i++) {
+        hash = (hash ^ (uint32_t)(uintptr_t)callers[i]) * 0x01000193;
+    }
+    hash |= 1;
+
+    for (uint32_t slot = reduce(hash, CALLSITE_SLOTS);; slot = (slot + 1) % CALLSITE_SLOTS) {
+        uint16_t index = s_callsite_index[slot];
+        if (index == NO_CALLSITE) {
+            if (s_stats.callsites == MAX_CALLSITES) {
+                return NO_CALLSITE;
+            }
+            index = s_stats.callsites++;
+            callsite_t *cs = &s_callsites[index];
+            memset(cs, 0, sizeof(*cs));
+            cs->hash = hash;
+            cs->depth = depth;
+            memcpy(cs->callers, callers, depth * sizeof(void *));
+            s_callsite_index[slot] = index;
+            return index;
+        }
+        callsite_t *cs = &s_callsites[index];
+        if (cs->hash == hash && cs->depth == depth && memcmp(cs->callers, callers, depth * sizeof(void *)) == 0) {
+            return index;
+        }
+    }
+}
+
+/* Add a live sample, called with the lock held. Returns false if the table is full. */
+static HEAP_IRAM_ATTR bool add_live_sample(void *ptr, size_t size, uint16_t callsite)
+{
+    if (s_stats.live_samples == MAX_LIVE_SAMPLES) {
+        return false;
+    }
+    uint32_t hash = ptr_hash(ptr);
+    uint32_t slot = reduce(hash, LIVE_SLOTS);
+    while (s_live[slot].ptr != NULL) {
+        slot = (slot + 1) % LIVE_SLOTS;
+    }
+    s_live[slot] = (live_sample_t) {
+        .ptr = ptr,
+        .size = size,
+        .callsite = callsite,
+    };
+    s_live_filter[reduce(hash, LIVE_SLOTS)]++;
+    s_stats.live_samples++;
+    return true;
+}
+
+/* Remove the live sample of 'ptr' if there is one, called with the lock held */
+static HEAP_IRAM_ATTR void remove_live_sample(void *ptr)
+{
+    uint32_t hash = ptr_hash(ptr);
+    uint32_t slot = reduce(hash, LIVE_SLOTS);
+    while (s_live[slot].ptr != ptr) {
+        if (s_live[slot].ptr == NULL) {
+            return;
+        }
+        slot = (slot + 1) % LIVE_SLOTS;
+    }
+
+    callsite_t *cs = &s_callsites[s_live[slot].callsite];
+    cs->inuse_count--;
+    cs->inuse_bytes -= s_live[slot].size;
+    s_live_filter[reduce(hash, LIVE_SLOTS)]--;
+    s_stats.live_samples--;
+
+    /* Backward shift deletion, so that the probe sequences of the following entries stay unbroken */
+    uint32_t hole = slot;
+    for (uint32_t next = (hole + 1) % LIVE_SLOTS; s_live[next].ptr != NULL; next = (next + 1) % LIVE_SLOTS) {
+        uint32_t home = reduce(ptr_hash(s_live[next].ptr), LIVE_SLOTS);
+        /* the entry can move to the hole if its home isn't cyclically in (hole, next] */
+        bool home_after_hole = (next > hole) ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!home_after_hole) {
+            s_live[hole] = s_live[next];
+            hole = next;
+        }
+    }
+    s_live[hole].ptr = NULL;
+}
+
+HEAP_IRAM_ATTR void heap_sampler_record_alloc(void *ptr, size_t size)
+{
+    countdown_t *countdown = CURRENT_COUNTDOWN();
+    if (countdown->generation != s_generation) {
+        countdown->generation = s_generation;
+        countdown->countdown = next_sample_distance();
+    }
+    countdown->countdown -= size;
+    if (countdown->countdown > 0) {
+        return;
+    }
+    countdown->countdown = next_sample_distance();
+
+    void *callers[STACK_DEPTH];
+    uint32_t depth = get_callers(callers);
+
+    SAMPLER_LOCK();
+    if (heap_sampler_running) {
+        s_stats.samples++;
+        uint16_t callsite = find_callsite(callers, depth);
+        if (callsite == NO_CALLSITE) {
+            s_stats.dropped_samples++;
+        } else {
+            callsite_t *cs = &s_callsites[callsite];
+            cs->alloc_count++;
+            cs->alloc_bytes += size;
+            if (add_live_sample(ptr, size, callsite)) {
+                cs->inuse_count++;
+                cs->inuse_bytes += size;
+            } else {
+                s_stats.dropped_samples++;
+            }
+        }
+    }
+    SAMPLER_UNLOCK();
+}
+
+HEAP_IRAM_ATTR void heap_sampler_record_free(void *ptr)
+{
+    /* A pointer can't be sampled and freed concurrently, so if its bucket is empty now it isn't sampled */
+    if (s_live_filter[reduce(ptr_hash(ptr), LIVE_SLOTS)] == 0) {
+        return;
+    }
+    SAMPLER_LOCK();
+    remove_live_sample(ptr);
+    SAMPLER_UNLOCK();
+}
+
+esp_err_t heap_sampler_start(size_t sample_interval)
+{
+    if (sample_interval == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    SAMPLER_LOCK();
+    if (heap_sampler_running) {
+        SAMPLER_UNLOCK();
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.sample_interval = sample_interval;
+    s_interval = sample_interval;
+    memset(s_callsite_index, 0xFF, sizeof(s_callsite_index));
+    memset(s_live, 0, sizeof(s_live));
+    memset((void *)s_live_filter, 0, sizeof(s_live_filter));
+#if CONFIG_IDF_TARGET_LINUX
+    s_rng_state ^= (uint32_t)time(NULL);
+#else
+    s_rng_state ^= esp_cpu_get_cycle_count();
+#endif
+    if (s_rng_state == 0) {
+        s_rng_state = 0x2545F491;
+    }
+    s_generation++;
+    heap_sampler_running = true;
+    SAMPLER_UNLOCK();
+    return ESP_OK;
+}
+
+esp_err_t heap_sampler_stop(void)
+{
+    SAMPLER_LOCK();
+    if (!heap_sampler_running) {
+        SAMPLER_UNLOCK();
+        return ESP_ERR_INVALID_STATE;
+    }
+    heap_sampler_running = false;
+    /* The live samples can't be tracked anymore, make the frees skip the lookup */
+    memset(s_live, 0, sizeof(s_live));
+    memset((void *)s_live_filter, 0, sizeof(s_live_filter));
+    s_stats.live_samples = 0;
+    SAMPLER_UNLOCK();
+    return ESP_OK;
+}
+
+esp_err_t heap_sampler_get_stats(heap_sampler_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    SAMPLER_LOCK();
+    *stats = s_stats;
+    SAMPLER_UNLOCK();
+    return ESP_OK;
+}
+
+esp_err_t heap_sampler_dump(FILE *stream)
+{
+    if (stream == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t inuse_count = 0, inuse_bytes = 0, alloc_count = 0, alloc_bytes = 0;
+    SAMPLER_LOCK();
+    size_t callsites = s_stats.callsites;
+    size_t interval = s_interval;
+    for (size_t i = 0; i < callsites; i++) {
+        inuse_count += s_callsites[i].inuse_count;
+        inuse_bytes += s_callsites[i].inuse_bytes;
+        alloc_count += s_callsites[i].alloc_count;
+        alloc_bytes += s_callsites[i].alloc_bytes;
+    }
+    SAMPLER_UNLOCK();
+
+    fprintf(stream, "heap profile: %lu: %lu [%lu: %lu] @ heap_v2/%lu\n",
+            (unsigned long)inuse_count, (unsigned long)inuse_bytes,
+            (unsigned long)alloc_count, (unsigned long)alloc_bytes, (unsigned long)interval);
+
+    /* Copy one callsite at a time, so that the lock isn't held while writing to the stream */
+    for (size_t i = 0; i < callsites; i++) {
+        callsite_t cs;
+        SAMPLER_LOCK();
+        cs = s_callsites[i];
+        SAMPLER_UNLOCK();
+
+        fprintf(stream, "%lu: %lu [%lu: %lu] @",
+                (unsigned long)cs.inuse_count, (unsigned long)cs.inuse_bytes,
+                (unsigned long)cs.alloc_count, (unsigned long)cs.alloc_bytes);
+        for (uint32_t f = 0; f < cs.depth; f++) {
+            fprintf(stream, " 0x%" PRIxPTR, (uintptr_t)cs.callers[f]);
+        }
+        fputc('\n', stream);
+    }
+
+#if CONFIG_IDF_TARGET_LINUX
+    /* pprof needs the mappings to resolve the addresses of a position-independent executable */
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (maps != NULL) {
+        char line[256];
+        fputs("\nMAPPED_LIBRARIES:\n", stream);
+        while (fgets(line, sizeof(line), maps) != NULL) {
+            fputs(line, stream);
+        }
+        fclose(maps);
+    }
+#endif
+
+    fflush(stream);
+    return ferror(stream) ? ESP_FAIL : ESP_OK;
+}
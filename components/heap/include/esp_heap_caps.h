@@ -298,6 +298,18 @@ void heap_caps_get_info( multi_heap_info_t *info, uint32_t caps );
  */
 void heap_caps_print_heap_info( uint32_t caps );
 
+/**
+ * @brief Return all free blocks cached in the per-core magazines to their heaps.
+ *
+ * With CONFIG_HEAP_MAGAZINES enabled, small blocks freed with heap_caps_free() are kept in a per-core
+ * cache of their heap and reused by the next allocations of the same size class. The cached blocks
+ * are flushed automatically when an allocation fails, this function can be called to flush them
+ * explicitly, e.g. before measuring the free heap size or the fragmentation.
+ *
+ * @return Number of the bytes returned to the heaps. Always 0 if CONFIG_HEAP_MAGAZINES is disabled.
+ */
+size_t heap_caps_flush_magazines(void);
+
 /**
  * @brief Check integrity of all heap memory in the system.
  *
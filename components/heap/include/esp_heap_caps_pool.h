@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "esp_heap_caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Handle of a fixed-size object pool
+ */
+typedef struct heap_caps_pool *heap_caps_pool_handle_t;
+
+/**
+ * @brief Statistics of a fixed-size object pool, see heap_caps_pool_get_info()
+ */
+typedef struct {
+    size_t obj_size;           ///< Size of the objects, as passed to heap_caps_pool_create()
+    size_t slot_size;          ///< Memory used by each object in the pool, obj_size rounded up to 8 bytes
+    size_t count;              ///< Number of objects the pool holds
+    size_t free_count;         ///< Number of objects currently free
+    size_t minimum_free_count; ///< Lifetime minimum of free_count
+} heap_caps_pool_info_t;
+
+/**
+ * @brief Create a pool of objects of the same size.
+ *
+ * The memory of all objects is allocated at once from the heaps with the given capabilities.
+ * Objects allocated from the pool carry no per-block header, heap_caps_pool_alloc() and heap_caps_pool_free()
+ * take constant time and don't fragment the heap.
+ *
+ * Objects are aligned to 8 bytes. The objects of a pool are listed by heap_caps_walk() in place of the heap block
+ * which holds the pool, with the start and end of the pool as heap information, and heap_caps_print_heap_info()
+ * prints the usage of each pool. With heap tracing enabled, objects allocated from a pool are recorded like other allocations.
+ *
+ * @param obj_size Size of each object in bytes
+ * @param caps     Bitwise OR of MALLOC_CAP_* flags indicating the type of memory to allocate the pool from
+ * @param count    Number of objects the pool holds
+ *
+ * @return Handle of the pool, or NULL if obj_size or count are 0 or if the memory can't be allocated
+ */
+heap_caps_pool_handle_t heap_caps_pool_create(size_t obj_size, uint32_t caps, size_t count);
+
+/**
+ * @brief Delete a pool and free its memory.
+ *
+ * All objects of the pool become invalid, whether they were freed or not.
+ *
+ * @param pool Handle of the pool, may be NULL
+ */
+void heap_caps_pool_delete(heap_caps_pool_handle_t pool);
+
+/**
+ * @brief Allocate an object from a pool.
+ *
+ * The object is aligned to 4 bytes. This function can be called from an ISR.
+ *
+ * @param pool Handle of the pool
+ *
+ * @return Pointer to the object, or NULL if all objects of the pool are allocated
+ */
+void *heap_caps_pool_alloc(heap_caps_pool_handle_t pool);
+
+/**
+ * @brief Return an object to its pool.
+ *
+ * This function can be called from an ISR. Freeing a pointer which isn't an allocated object of the pool
+ * triggers an assertion.
+ *
+ * @param pool Handle of the pool the object was allocated from
+ * @param ptr  Pointer to the object, may be NULL
+ */
+void heap_caps_pool_free(heap_caps_pool_handle_t pool, void *ptr);
+
+/**
+ * @brief Get the statistics of a pool.
+ *
+ * @param pool Handle of the pool
+ * @param info Pointer to a structure which will be filled with the statistics of the pool
+ */
+void heap_caps_pool_get_info(heap_caps_pool_handle_t pool, heap_caps_pool_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
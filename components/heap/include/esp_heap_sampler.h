@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Statistics of the heap sampling profiler, see heap_sampler_get_stats()
+ */
+typedef struct {
+    size_t sample_interval;    ///< Mean number of allocated bytes between two samples
+    size_t samples;            ///< Number of allocations sampled since heap_sampler_start()
+    size_t dropped_samples;    ///< Number of sampled allocations which didn't fit into the callsite or live sample tables
+    size_t callsites;          ///< Number of distinct call stacks recorded
+    size_t live_samples;       ///< Number of sampled allocations which weren't freed yet
+} heap_sampler_stats_t;
+
+/**
+ * @brief Start sampling heap allocations.
+ *
+ * Roughly one allocation every 'sample_interval' allocated bytes is sampled: the distance between two samples
+ * is drawn from an exponential distribution, so that an allocation of 'size' bytes is sampled with the probability
+ * 1 - exp(-size / sample_interval). The call stack of each sampled allocation is recorded, and the samples are
+ * aggregated per call stack in a table of CONFIG_HEAP_SAMPLING_MAX_CALLSITES entries. Sampled allocations
+ * which are freed are subtracted from the in-use totals of their call stack.
+ *
+ * All previously recorded samples are cleared.
+ *
+ * @param sample_interval Mean number of bytes between two samples. Larger values lower the overhead and the
+ *                        accuracy of the profile.
+ *
+ * @return
+ *  - ESP_OK on success
+ *  - ESP_ERR_INVALID_ARG if sample_interval is 0
+ *  - ESP_ERR_INVALID_STATE if the sampler is already running
+ */
+esp_err_t heap_sampler_start(size_t sample_interval);
+
+/**
+ * @brief Stop sampling heap allocations.
+ *
+ * The recorded samples are kept and can still be dumped. Frees of sampled allocations are not tracked anymore.
+ *
+ * @return
+ *  - ESP_OK on success
+ *  - ESP_ERR_INVALID_STATE if the sampler isn't running
+ */
+esp_err_t heap_sampler_stop(void);
+
+/**
+ * @brief Get the statistics of the sampler.
+ *
+ * @param[out] stats Statistics
+ *
+ * @return
+ *  - ESP_OK on success
+ *  - ESP_ERR_INVALID_ARG if stats is NULL
+ */
+esp_err_t heap_sampler_get_stats(heap_sampler_stats_t *stats);
+
+/**
+ * @brief Write the recorded samples as a heap profile which can be read by pprof.
+ *
+ * The profile uses the legacy text format of the gperftools heap profiler ("heap_v2"), pprof scales the
+ * sampled counts back to estimates of the actual allocations:
+ *
+ *     heap profile: <in-use objects>: <in-use bytes> [<allocated objects>: <allocated bytes>] @ heap_v2/<interval>
+ *     <in-use objects>: <in-use bytes> [<allocated objects>: <allocated bytes>] @ <pc> <pc> ...
+ *
+ * The program counters are symbolized by pprof using the application ELF file, e.g.
+ * ``go tool pprof build/app.elf heap.prof``. On the Linux target, the memory mappings of the process are
+ * appended so that pprof can resolve the addresses of position-independent executables.
+ *
+ * Recording continues while the profile is written.
+ *
+ * @param stream Stream to write the profile to, e.g. stdout or a file
+ *
+ * @return
+ *  - ESP_OK on success
+ *  - ESP_ERR_INVALID_ARG if stream is NULL
+ *  - ESP_FAIL if writing to the stream failed
+ */
+esp_err_t heap_sampler_dump(FILE *stream);
+
+#ifdef __cplusplus
+}
+#endif
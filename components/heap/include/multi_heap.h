@@ -168,6 +168,8 @@ typedef struct {
     size_t allocated_blocks;      ///<  Number of (variable size) blocks allocated in the heap.
     size_t free_blocks;           ///<  Number of (variable size) free blocks in the heap.
     size_t total_blocks;          ///<  Total number of (variable size) blocks in the heap.
+    size_t cached_bytes;          ///<  Bytes of the free blocks held in heap_caps magazines. Included in total_allocated_bytes. Always 0 for multi_heap_get_info().
+    size_t cached_blocks;         ///<  Number of the free blocks held in heap_caps magazines. Included in allocated_blocks. Always 0 for multi_heap_get_info().
 } multi_heap_info_t;
 
 /** @brief Return metadata about a given heap
@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "multi_heap_magazine.h"
+
+/* Header written into the free blocks held by a magazine */
+struct multi_heap_magazine_block {
+    multi_heap_magazine_block_t *next;
+    size_t size;
+};
+
+/* Usable sizes of the size classes. A block is cached in the largest class it can hold,
+   an allocation is served from the smallest class which holds its size. */
+static const uint16_t s_class_size[MULTI_HEAP_MAGAZINE_CLASSES] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+
+_Static_assert(sizeof(multi_heap_magazine_block_t) <= 16, "block header must fit into the smallest size class");
+
+static inline int class_for_size(size_t size)
+{
+    for (int c = 0; c < MULTI_HEAP_MAGAZINE_CLASSES; c++) {
+        if (size <= s_class_size[c]) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+/* The heap may hand out a block slightly larger than requested when the rest is too small to be split off,
+   such a block is cached in the class it fills, which may be the next one. */
+static inline int class_for_block(size_t block_size)
+{
+    if (block_size < s_class_size[0] || block_size >= (size_t)MULTI_HEAP_MAGAZINE_MAX_SIZE + s_class_size[0]) {
+        return -1;
+    }
+    int c = MULTI_HEAP_MAGAZINE_CLASSES - 1;
+    while (s_class_size[c] > block_size) {
+        c--;
+    }
+    return c;
+}
+
+void multi_heap_magazine_init(multi_heap_magazine_t *mag)
+{
+    memset(mag->blocks, 0, sizeof(mag->blocks));
+    memset(mag->count, 0, sizeof(mag->count));
+    mag->cached_bytes = 0;
+    mag->cached_blocks = 0;
+#ifdef MULTI_HEAP_FREERTOS
+    MULTI_HEAP_LOCK_INIT(&mag->lock);
+#endif
+}
+
+size_t multi_heap_magazine_round_size(size_t size)
+{
+    int c = class_for_size(size);
+    return (c < 0) ? size : s_class_size[c];
+}
+
+void *multi_heap_magazine_get(multi_heap_magazine_t *mag, size_t size)
+{
+    int c = class_for_size(size);
+    if (c < 0) {
+        return NULL;
+    }
+    /* A block allocated for this class may have ended up in the next one, see class_for_block() */
+    if (mag->blocks[c] == NULL) {
+        if (c + 1 == MULTI_HEAP_MAGAZINE_CLASSES || mag->blocks[c + 1] == NULL) {
+            return NULL;
+        }
+        c++;
+    }
+
+    multi_heap_magazine_block_t *block = mag->blocks[c];
+    mag->blocks[c] = block->next;
+    mag->count[c]--;
+    mag->cached_bytes -= block->size;
+    mag->cached_blocks--;
+    return block;
+}
+
+bool multi_heap_magazine_put(multi_heap_magazine_t *mag, void *p, size_t block_size)
+{
+    int c = class_for_block(block_size);
+    if (c < 0 || mag->count[c] >= MULTI_HEAP_MAGAZINE_DEPTH) {
+        return false;
+    }
+
+    multi_heap_magazine_block_t *block = (multi_heap_magazine_block_t *)p;
+    block->next = mag->blocks[c];
+    block->size = block_size;
+    mag->blocks[c] = block;
+    mag->count[c]++;
+    mag->cached_bytes += block_size;
+    mag->cached_blocks++;
+    return true;
+}
+
+void *multi_heap_magazine_take(multi_heap_magazine_t *mag)
+{
+    for (int c = 0; c < MULTI_HEAP_MAGAZINE_CLASSES; c++) {
+        if (mag->blocks[c] != NULL) {
+            return multi_heap_magazine_get(mag, s_class_size[c]);
+        }
+    }
+    return NULL;
+}
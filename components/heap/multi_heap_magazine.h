@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "multi_heap_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A magazine caches free blocks of small size classes in front of a heap, so that small
+   allocations and frees can be served without taking the heap's lock and without going through TLSF.
+
+   The cached blocks stay allocated from the heap's point of view. They are kept in one singly linked
+   list per size class, the list is threaded through the free blocks themselves.
+
+   The functions in this file don't lock, the owner of the magazine has to ensure exclusive access.
+   heap_caps keeps one magazine per core and heap, see heap_private.h.
+*/
+
+#define MULTI_HEAP_MAGAZINE_CLASSES   8
+#define MULTI_HEAP_MAGAZINE_MAX_SIZE  256 /* Largest size which is served by a magazine */
+
+#ifdef CONFIG_HEAP_MAGAZINE_DEPTH
+#define MULTI_HEAP_MAGAZINE_DEPTH     CONFIG_HEAP_MAGAZINE_DEPTH
+#else
+#define MULTI_HEAP_MAGAZINE_DEPTH     8 /* Maximum number of blocks cached per size class */
+#endif
+
+typedef struct multi_heap_magazine_block multi_heap_magazine_block_t;
+
+typedef struct {
+#ifdef MULTI_HEAP_FREERTOS
+    multi_heap_lock_t lock;       ///< Lock of the owner, not used by the functions below
+#endif
+    multi_heap_magazine_block_t *blocks[MULTI_HEAP_MAGAZINE_CLASSES];
+    uint8_t count[MULTI_HEAP_MAGAZINE_CLASSES];
+    size_t cached_bytes;          ///< Sum of the sizes of the cached blocks
+    size_t cached_blocks;         ///< Number of the cached blocks
+} multi_heap_magazine_t;
+
+/** @brief Initialize an empty magazine */
+void multi_heap_magazine_init(multi_heap_magazine_t *mag);
+
+/** @brief Round an allocation size up to its size class
+ *
+ * Blocks allocated from the heap with the rounded size can be cached and then serve any
+ * later allocation of the same size class.
+ *
+ * @return Size of the class of 'size', or 'size' if it is larger than MULTI_HEAP_MAGAZINE_MAX_SIZE.
+ */
+size_t multi_heap_magazine_round_size(size_t size);
+
+/** @brief Take a cached block which can hold at least 'size' bytes
+ *
+ * @return Pointer to the block, or NULL if the size class of 'size' is empty or 'size' is larger than
+ *         MULTI_HEAP_MAGAZINE_MAX_SIZE. The block has to be allocated from the heap then.
+ */
+void *multi_heap_magazine_get(multi_heap_magazine_t *mag, size_t size);
+
+/** @brief Cache a block which is being freed
+ *
+ * @param block_size Size of the block as returned by multi_heap_get_allocated_size()
+ * @return true if the block was cached, false if it has to be freed to the heap because
+ *         its size class is full or it is too small or too large to be cached.
+ */
+bool multi_heap_magazine_put(multi_heap_magazine_t *mag, void *p, size_t block_size);
+
+/** @brief Take any cached block, used to flush the magazine into its heap
+ *
+ * @return Pointer to the block, or NULL if the magazine is empty
+ */
+void *multi_heap_magazine_take(multi_heap_magazine_t *mag);
+
+#ifdef __cplusplus
+}
+#endif
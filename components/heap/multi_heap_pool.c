@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "multi_heap_pool.h"
+
+/* Written into the free slots */
+struct multi_heap_pool_slot {
+    multi_heap_pool_slot_t *next;
+};
+
+static inline size_t pool_stride(size_t obj_size)
+{
+    if (obj_size < sizeof(multi_heap_pool_slot_t)) {
+        obj_size = sizeof(multi_heap_pool_slot_t);
+    }
+    return (obj_size + MULTI_HEAP_POOL_ALIGN - 1) & ~(MULTI_HEAP_POOL_ALIGN - 1);
+}
+
+static inline size_t pool_bitmap_words(size_t count)
+{
+    return (count + 31) / 32;
+}
+
+static inline size_t slot_index(const multi_heap_pool_t *pool, const void *p)
+{
+    return ((const uint8_t *)p - pool->start) / pool->stride;
+}
+
+static inline bool slot_used(const multi_heap_pool_t *pool, size_t index)
+{
+    return (pool->used[index / 32] >> (index % 32)) & 1;
+}
+
+size_t multi_heap_pool_required_size(size_t obj_size, size_t count)
+{
+    if (obj_size == 0 || count == 0) {
+        return 0;
+    }
+    size_t stride = pool_stride(obj_size);
+    if (stride < obj_size || count > (SIZE_MAX - pool_bitmap_words(count) * sizeof(uint32_t)) / stride) {
+        return 0;
+    }
+    return stride * count + pool_bitmap_words(count) * sizeof(uint32_t);
+}
+
+bool multi_heap_pool_init(multi_heap_pool_t *pool, void *mem, size_t obj_size, size_t count)
+{
+    if (pool == NULL || mem == NULL || ((uintptr_t)mem & (MULTI_HEAP_POOL_ALIGN - 1)) != 0
+            || multi_heap_pool_required_size(obj_size, count) == 0) {
+        return false;
+    }
+
+    pool->obj_size = obj_size;
+    pool->stride = pool_stride(obj_size);
+    pool->count = count;
+    pool->start = mem;
+    pool->end = pool->start + pool->stride * count;
+    pool->used = (uint32_t *)pool->end;
+    memset(pool->used, 0, pool_bitmap_words(count) * sizeof(uint32_t));
+
+    /* Thread the free list in address order, so that the first allocations are adjacent */
+    multi_heap_pool_slot_t **link = &pool->free_list;
+    for (uint8_t *p = pool->start; p < pool->end; p += pool->stride) {
+        *link = (multi_heap_pool_slot_t *)p;
+        link = &(*link)->next;
+    }
+    *link = NULL;
+
+    pool->free_count = count;
+    pool->minimum_free_count = count;
+    return true;
+}
+
+void *multi_heap_pool_alloc(multi_heap_pool_t *pool)
+{
+    multi_heap_pool_slot_t *slot = pool->free_list;
+    if (slot == NULL) {
+        return NULL;
+    }
+    pool->free_list = slot->next;
+
+    size_t index = slot_index(pool, slot);
+    pool->used[index / 32] |= 1u << (index % 32);
+    pool->free_count--;
+    if (pool->free_count < pool->minimum_free_count) {
+        pool->minimum_free_count = pool->free_count;
+    }
+    return slot;
+}
+
+bool multi_heap_pool_free(multi_heap_pool_t *pool, void *p)
+{
+    if (!multi_heap_pool_contains(pool, p)) {
+        return false;
+    }
+    size_t index = slot_index(pool, p);
+    if (pool->start + index * pool->stride != (uint8_t *)p || !slot_used(pool, index)) {
+        return false;
+    }
+
+    pool->used[index / 32] &= ~(1u << (index % 32));
+    multi_heap_pool_slot_t *slot = (multi_heap_pool_slot_t *)p;
+    slot->next = pool->free_list;
+    pool->free_list = slot;
+    pool->free_count++;
+    return true;
+}
+
+void multi_heap_pool_walk(const multi_heap_pool_t *pool, multi_heap_pool_walker_cb_t walker_func, void *user_data)
+{
+    for (size_t index = 0; index < pool->count; index++) {
+        if (!walker_func(pool->start + index * pool->stride, pool->stride, slot_used(pool, index), user_data)) {
+            break;
+        }
+    }
+}
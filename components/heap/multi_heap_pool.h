@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A pool divides one memory region into slots of a fixed size. Free slots are kept in a singly linked
+   list threaded through the slots themselves, so allocating and freeing a slot is O(1) and costs no
+   per-object header. A bitmap placed after the slots records which slots are in use, it is used to
+   catch invalid and double frees and to walk the pool.
+
+   The functions in this file don't lock, heap_caps_pool.c wraps them with a lock per pool.
+*/
+
+/* Alignment of the slots, enough for any scalar object and for the free list pointer kept in free slots */
+#define MULTI_HEAP_POOL_ALIGN 8
+
+typedef struct multi_heap_pool_slot multi_heap_pool_slot_t;
+
+typedef struct {
+    uint8_t *start;                    ///< First slot
+    uint8_t *end;                      ///< End of the last slot
+    uint32_t *used;                    ///< One bit per slot, set if the slot is allocated
+    size_t obj_size;                   ///< Size requested at initialization
+    size_t stride;                     ///< Distance between two slots
+    size_t count;                      ///< Number of slots
+    size_t free_count;                 ///< Number of free slots
+    size_t minimum_free_count;         ///< Lifetime minimum of free_count
+    multi_heap_pool_slot_t *free_list; ///< Next slot to allocate
+} multi_heap_pool_t;
+
+/** @brief Callback called for each slot by multi_heap_pool_walk
+ *
+ * @return true to continue walking the pool, false to stop
+ */
+typedef bool (*multi_heap_pool_walker_cb_t)(void *slot, size_t size, bool used, void *user_data);
+
+/** @brief Size of the memory region needed by a pool of 'count' objects of 'obj_size' bytes
+ *
+ * @return Size in bytes, or 0 if the size overflows
+ */
+size_t multi_heap_pool_required_size(size_t obj_size, size_t count);
+
+/** @brief Initialize a pool in a memory region of at least multi_heap_pool_required_size() bytes
+ *
+ * @param mem Start of the region, must be aligned to MULTI_HEAP_POOL_ALIGN bytes.
+ * @return true on success, false if the arguments are invalid
+ */
+bool multi_heap_pool_init(multi_heap_pool_t *pool, void *mem, size_t obj_size, size_t count);
+
+/** @brief Allocate one slot
+ *
+ * @return Pointer to the slot, or NULL if all slots are allocated
+ */
+void *multi_heap_pool_alloc(multi_heap_pool_t *pool);
+
+/** @brief Free a slot returned by multi_heap_pool_alloc()
+ *
+ * @return false if 'p' isn't an allocated slot of the pool, the pool is left unchanged then.
+ */
+bool multi_heap_pool_free(multi_heap_pool_t *pool, void *p);
+
+/** @brief Check whether a pointer lies within the slots of a pool */
+static inline bool multi_heap_pool_contains(const multi_heap_pool_t *pool, const void *p)
+{
+    return (const uint8_t *)p >= pool->start && (const uint8_t *)p < pool->end;
+}
+
+/** @brief Call 'walker_func' for every slot of the pool, in address order */
+void multi_heap_pool_walk(const multi_heap_pool_t *pool, multi_heap_pool_walker_cb_t walker_func, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Set while the sampler runs, checked before calling into it so that the allocation functions
+   only pay for a load and a branch when the sampler is stopped. */
+extern volatile bool heap_sampler_running;
+
+/* Account an allocation of 'size' bytes at 'ptr', sampled or not. Called by the allocation functions. */
+void heap_sampler_record_alloc(void *ptr, size_t size);
+
+/* Account a free of 'ptr'. Called by the free functions. */
+void heap_sampler_record_free(void *ptr);
+
+FORCE_INLINE_ATTR void heap_sampler_on_alloc(void *ptr, size_t size)
+{
+    if (heap_sampler_running && ptr != NULL) {
+        heap_sampler_record_alloc(ptr, size);
+    }
+}
+
+FORCE_INLINE_ATTR void heap_sampler_on_free(void *ptr)
+{
+    if (heap_sampler_running && ptr != NULL) {
+        heap_sampler_record_free(ptr);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
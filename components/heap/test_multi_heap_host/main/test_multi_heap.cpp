@@ -8,12 +8,22 @@
 #include "multi_heap.h"
 
 #include "../multi_heap_config.h"
+#include "../multi_heap_magazine.h"
+#include "../multi_heap_pool.h"
+#include "esp_heap_sampler.h"
+#include "heap_sampler_internal.h"
 #include "../tlsf/include/tlsf.h"
 #include "../tlsf/tlsf_block_functions.h"
 #include "../tlsf/tlsf_control_functions.h"
 
 #include <string.h>
 #include <assert.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 /* The functions __malloc__ and __free__ are used to call the libc
  * malloc and free and allocate memory from the host heap. Since the test
@@ -643,3 +653,378 @@ TEST_CASE("multi_heap poisoning detection", "[multi_heap]")
         REQUIRE(is_heap_ok == true);
     }
 }
+
+/* Blocks cached in a magazine are served to allocations of the same size class and
+ * go back to the heap unchanged when the magazine is flushed.
+ */
+TEST_CASE("multi_heap magazine caches and flushes small blocks", "[multi_heap][magazine]")
+{
+    uint8_t heapdata[8 * 1024];
+    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+    size_t free_before = multi_heap_free_size(heap);
+
+    multi_heap_magazine_t mag;
+    multi_heap_magazine_init(&mag);
+
+    /* too large blocks are never cached */
+    void *large = multi_heap_malloc(heap, MULTI_HEAP_MAGAZINE_MAX_SIZE * 2);
+    REQUIRE(large != NULL);
+    REQUIRE(!multi_heap_magazine_put(&mag, large, multi_heap_get_allocated_size(heap, large)));
+    multi_heap_free(heap, large);
+
+    const size_t sizes[] = { 1, 12, 20, 33, 60, 100, 130, 200, 256 };
+    for (size_t size : sizes) {
+        void *p = multi_heap_malloc(heap, multi_heap_magazine_round_size(size));
+        REQUIRE(p != NULL);
+        REQUIRE(multi_heap_magazine_put(&mag, p, multi_heap_get_allocated_size(heap, p)));
+
+        /* the cached block is reused by a request of the same size and holds it */
+        void *q = multi_heap_magazine_get(&mag, size);
+        REQUIRE(q == p);
+        REQUIRE(multi_heap_get_allocated_size(heap, q) >= size);
+        memset(q, 0xA5, size);
+        REQUIRE(multi_heap_magazine_put(&mag, q, multi_heap_get_allocated_size(heap, q)));
+    }
+    REQUIRE(mag.cached_blocks == sizeof(sizes) / sizeof(sizes[0]));
+    REQUIRE(mag.cached_bytes > 0);
+    REQUIRE(multi_heap_magazine_get(&mag, MULTI_HEAP_MAGAZINE_MAX_SIZE + 1) == NULL);
+
+    /* each size class holds at most MULTI_HEAP_MAGAZINE_DEPTH blocks */
+    multi_heap_magazine_t full_mag;
+    multi_heap_magazine_init(&full_mag);
+    void *blocks[MULTI_HEAP_MAGAZINE_DEPTH + 1];
+    for (int i = 0; i <= MULTI_HEAP_MAGAZINE_DEPTH; i++) {
+        blocks[i] = multi_heap_malloc(heap, 16);
+        REQUIRE(blocks[i] != NULL);
+    }
+    for (int i = 0; i < MULTI_HEAP_MAGAZINE_DEPTH; i++) {
+        REQUIRE(multi_heap_magazine_put(&full_mag, blocks[i], multi_heap_get_allocated_size(heap, blocks[i])));
+    }
+    REQUIRE(!multi_heap_magazine_put(&full_mag, blocks[MULTI_HEAP_MAGAZINE_DEPTH],
+                                     multi_heap_get_allocated_size(heap, blocks[MULTI_HEAP_MAGAZINE_DEPTH])));
+    multi_heap_free(heap, blocks[MULTI_HEAP_MAGAZINE_DEPTH]);
+
+    void *p;
+    while ((p = multi_heap_magazine_take(&mag)) != NULL) {
+        multi_heap_free(heap, p);
+    }
+    while ((p = multi_heap_magazine_take(&full_mag)) != NULL) {
+        multi_heap_free(heap, p);
+    }
+    REQUIRE(full_mag.cached_blocks == 0);
+    REQUIRE(mag.cached_blocks == 0);
+    REQUIRE(mag.cached_bytes == 0);
+    REQUIRE(multi_heap_check(heap, true));
+    REQUIRE(multi_heap_free_size(heap) == free_before);
+}
+
+/* The host build of multi_heap has no lock, so the heap lock is emulated by a mutex taken around
+ * every heap call. Each thread allocates and frees small blocks, once directly from the heap and
+ * once through a magazine of its own, as heap_caps does with one magazine per core.
+ */
+static size_t magazine_contention_run(multi_heap_handle_t heap, int threads, bool use_magazine, double *ops_per_sec)
+{
+    const int ROUNDS = 2000;
+    const int BATCH = 8;
+    std::mutex heap_lock;
+    std::atomic<size_t> lock_count(0);
+    std::atomic<bool> ok(true);
+
+    auto worker = [&](int id) {
+        multi_heap_magazine_t mag;
+        multi_heap_magazine_init(&mag);
+        void *p[BATCH];
+        for (int r = 0; r < ROUNDS; r++) {
+            for (int i = 0; i < BATCH; i++) {
+                size_t size = 16 + ((id + i) % 8) * 24;
+                p[i] = use_magazine ? multi_heap_magazine_get(&mag, size) : NULL;
+                if (p[i] == NULL) {
+                    std::lock_guard<std::mutex> guard(heap_lock);
+                    lock_count++;
+                    p[i] = multi_heap_malloc(heap, use_magazine ? multi_heap_magazine_round_size(size) : size);
+                }
+                if (p[i] == NULL) {
+                    ok = false;
+                    return;
+                }
+                memset(p[i], id, size);
+            }
+            for (int i = 0; i < BATCH; i++) {
+                if (use_magazine && multi_heap_magazine_put(&mag, p[i], multi_heap_get_allocated_size(heap, p[i]))) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> guard(heap_lock);
+                lock_count++;
+                multi_heap_free(heap, p[i]);
+            }
+        }
+        std::lock_guard<std::mutex> guard(heap_lock);
+        void *block;
+        while ((block = multi_heap_magazine_take(&mag)) != NULL) {
+            multi_heap_free(heap, block);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back(worker, t);
+    }
+    for (auto &t : pool) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    REQUIRE(ok);
+    *ops_per_sec = (2.0 * threads * ROUNDS * BATCH) / seconds;
+    return lock_count;
+}
+
+TEST_CASE("multi_heap magazine reduces heap lock acquisitions", "[multi_heap][magazine]")
+{
+    const size_t HEAP_SIZE = 64 * 1024;
+    uint8_t *heapdata = (uint8_t *)__malloc__(HEAP_SIZE);
+    REQUIRE(heapdata != NULL);
+    multi_heap_handle_t heap = multi_heap_register(heapdata, HEAP_SIZE);
+    size_t free_before = multi_heap_free_size(heap);
+
+    for (int threads = 1; threads <= 4; threads *= 2) {
+        double direct_ops, magazine_ops;
+        size_t direct_locks = magazine_contention_run(heap, threads, false, &direct_ops);
+        size_t magazine_locks = magazine_contention_run(heap, threads, true, &magazine_ops);
+        printf("[MAGAZINE] %d threads: heap lock taken %zu times, %.0f ops/s without magazines, "
+               "%zu times, %.0f ops/s with magazines\n",
+               threads, direct_locks, direct_ops, magazine_locks, magazine_ops);
+        REQUIRE(magazine_locks * 10 < direct_locks);
+    }
+
+    REQUIRE(multi_heap_check(heap, true));
+    REQUIRE(multi_heap_free_size(heap) == free_before);
+    __free__(heapdata);
+}
+
+static bool count_used_slots(void *slot, size_t size, bool used, void *user_data)
+{
+    if (used) {
+        (*(size_t *)user_data)++;
+    }
+    return true;
+}
+
+/* A pool placed in a block of a multi_heap, as heap_caps_pool_create() does */
+TEST_CASE("multi_heap pool allocates fixed-size objects", "[multi_heap][pool]")
+{
+    uint8_t heapdata[8 * 1024];
+    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+    size_t free_before = multi_heap_free_size(heap);
+
+    const size_t OBJ_SIZE = 22;
+    const size_t COUNT = 70;
+    REQUIRE(multi_heap_pool_required_size(0, COUNT) == 0);
+    REQUIRE(multi_heap_pool_required_size(OBJ_SIZE, 0) == 0);
+    REQUIRE(multi_heap_pool_required_size(SIZE_MAX / 2, 4) == 0);
+
+    size_t pool_size = multi_heap_pool_required_size(OBJ_SIZE, COUNT);
+    void *mem = multi_heap_malloc(heap, pool_size);
+    REQUIRE(mem != NULL);
+    multi_heap_pool_t pool;
+    REQUIRE(!multi_heap_pool_init(&pool, (uint8_t *)mem + 1, OBJ_SIZE, COUNT));
+    REQUIRE(multi_heap_pool_init(&pool, mem, OBJ_SIZE, COUNT));
+
+    void *objs[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        objs[i] = multi_heap_pool_alloc(&pool);
+        REQUIRE(objs[i] != NULL);
+        REQUIRE(((uintptr_t)objs[i] & (MULTI_HEAP_POOL_ALIGN - 1)) == 0);
+        REQUIRE(multi_heap_pool_contains(&pool, objs[i]));
+        REQUIRE(multi_heap_pool_contains(&pool, (uint8_t *)objs[i] + OBJ_SIZE - 1));
+        memset(objs[i], i, OBJ_SIZE);
+    }
+    REQUIRE(multi_heap_pool_alloc(&pool) == NULL);
+    REQUIRE(pool.free_count == 0);
+    REQUIRE(pool.minimum_free_count == 0);
+    for (size_t i = 0; i < COUNT; i++) {
+        for (size_t j = 0; j < OBJ_SIZE; j++) {
+            REQUIRE(((uint8_t *)objs[i])[j] == (uint8_t)i);
+        }
+    }
+    REQUIRE(multi_heap_check(heap, true));
+
+    size_t used = 0;
+    multi_heap_pool_walk(&pool, count_used_slots, &used);
+    REQUIRE(used == COUNT);
+
+    /* invalid frees leave the pool unchanged */
+    REQUIRE(!multi_heap_pool_free(&pool, (uint8_t *)objs[3] + 4));
+    REQUIRE(!multi_heap_pool_free(&pool, heapdata));
+    REQUIRE(multi_heap_pool_free(&pool, objs[3]));
+    REQUIRE(!multi_heap_pool_free(&pool, objs[3]));
+
+    /* the most recently freed object is reused first */
+    REQUIRE(multi_heap_pool_alloc(&pool) == objs[3]);
+
+    for (size_t i = 0; i < COUNT; i += 2) {
+        REQUIRE(multi_heap_pool_free(&pool, objs[i]));
+    }
+    used = 0;
+    multi_heap_pool_walk(&pool, count_used_slots, &used);
+    REQUIRE(used == COUNT / 2);
+    for (size_t i = 1; i < COUNT; i += 2) {
+        REQUIRE(multi_heap_pool_free(&pool, objs[i]));
+    }
+    REQUIRE(pool.free_count == COUNT);
+    REQUIRE(pool.minimum_free_count == 0);
+
+    multi_heap_free(heap, mem);
+    REQUIRE(multi_heap_free_size(heap) == free_before);
+}
+
+/* The same region holds more pool objects than heap blocks of the same size,
+ * as pool objects carry no block header.
+ */
+TEST_CASE("multi_heap pool has no per-object overhead", "[multi_heap][pool]")
+{
+    uint8_t heapdata[8 * 1024];
+    const size_t OBJ_SIZE = 24;
+    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+
+    void *blocks[sizeof(heapdata) / OBJ_SIZE];
+    size_t heap_count = 0;
+    while ((blocks[heap_count] = multi_heap_malloc(heap, OBJ_SIZE)) != NULL) {
+        heap_count++;
+    }
+    for (size_t i = 0; i < heap_count; i++) {
+        multi_heap_free(heap, blocks[i]);
+    }
+
+    multi_heap_info_t info;
+    multi_heap_get_info(heap, &info);
+    size_t region = info.largest_free_block;
+    size_t pool_count = heap_count;
+    while (multi_heap_pool_required_size(OBJ_SIZE, pool_count + 1) <= region) {
+        pool_count++;
+    }
+    printf("[POOL] %zu objects of %zu bytes from the heap, %zu from a pool\n", heap_count, OBJ_SIZE, pool_count);
+    REQUIRE(pool_count > heap_count);
+}
+
+/* The sampler is driven directly here, as heap_caps_malloc() and heap_caps_free() do */
+static __attribute__((noinline)) void *sampled_malloc(size_t size)
+{
+    void *p = __malloc__(size);
+    heap_sampler_on_alloc(p, size);
+    return p;
+}
+
+static __attribute__((noinline)) void sampled_free(void *p)
+{
+    heap_sampler_on_free(p);
+    __free__(p);
+}
+
+static __attribute__((noinline)) void sampler_callsite_small(void **objs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        objs[i] = sampled_malloc(64);
+    }
+}
+
+static __attribute__((noinline)) void sampler_callsite_large(void **objs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        objs[i] = sampled_malloc(4096);
+    }
+}
+
+/* Read the in-use bytes of the callsite allocating objects of 'obj_size' from a heap_v2 profile,
+ * scaled back as pprof does.
+ */
+static double sampler_estimate_inuse(const char *profile, size_t obj_size, size_t interval)
+{
+    double estimate = 0;
+    const char *line = strchr(profile, '\n') + 1;
+    unsigned long inuse_count, inuse_bytes, alloc_count, alloc_bytes;
+    while (sscanf(line, "%lu: %lu [%lu: %lu] @", &inuse_count, &inuse_bytes, &alloc_count, &alloc_bytes) == 4) {
+        if (alloc_count > 0 && alloc_bytes / alloc_count == obj_size) {
+            double scale = 1 / (1 - exp(-(double)obj_size / interval));
+            estimate += inuse_bytes * scale;
+        }
+        line = strchr(line, '\n') + 1;
+    }
+    return estimate;
+}
+
+TEST_CASE("heap sampler estimates the memory in use per callsite", "[heap_sampler]")
+{
+    const size_t INTERVAL = 8192;
+    const size_t SMALL_COUNT = 12000;
+    const size_t LARGE_COUNT = 200;
+    static void *small[SMALL_COUNT];
+    static void *large[LARGE_COUNT];
+
+    REQUIRE(heap_sampler_start(0) == ESP_ERR_INVALID_ARG);
+    REQUIRE(heap_sampler_stop() == ESP_ERR_INVALID_STATE);
+    REQUIRE(heap_sampler_start(INTERVAL) == ESP_OK);
+    REQUIRE(heap_sampler_start(INTERVAL) == ESP_ERR_INVALID_STATE);
+
+    sampler_callsite_small(small, SMALL_COUNT);
+    sampler_callsite_large(large, LARGE_COUNT);
+    /* only half of the large objects stay in use */
+    for (size_t i = 0; i < LARGE_COUNT; i += 2) {
+        sampled_free(large[i]);
+    }
+
+    heap_sampler_stats_t stats;
+    REQUIRE(heap_sampler_get_stats(&stats) == ESP_OK);
+    REQUIRE(stats.sample_interval == INTERVAL);
+    REQUIRE(stats.dropped_samples == 0);
+    REQUIRE(stats.callsites == 2);
+    REQUIRE(stats.live_samples < stats.samples);
+
+    char *profile = NULL;
+    size_t profile_size = 0;
+    FILE *stream = open_memstream(&profile, &profile_size);
+    REQUIRE(heap_sampler_dump(stream) == ESP_OK);
+    fclose(stream);
+    REQUIRE(strncmp(profile, "heap profile: ", 14) == 0);
+    REQUIRE(strstr(profile, "@ heap_v2/8192\n") != NULL);
+    REQUIRE(strstr(profile, "MAPPED_LIBRARIES:") != NULL);
+
+    double small_estimate = sampler_estimate_inuse(profile, 64, INTERVAL);
+    double large_estimate = sampler_estimate_inuse(profile, 4096, INTERVAL);
+    double small_actual = SMALL_COUNT * 64.0;
+    double large_actual = LARGE_COUNT / 2 * 4096.0;
+    printf("[HEAP_SAMPLER] %zu samples, in use: small %.0f estimated %.0f, large %.0f estimated %.0f\n",
+           stats.samples, small_actual, small_estimate, large_actual, large_estimate);
+    REQUIRE(fabs(small_estimate - small_actual) < small_actual * 0.4);
+    REQUIRE(fabs(large_estimate - large_actual) < large_actual * 0.4);
+    __free__(profile);
+
+    for (size_t i = 0; i < SMALL_COUNT; i++) {
+        sampled_free(small[i]);
+    }
+    for (size_t i = 1; i < LARGE_COUNT; i += 2) {
+        sampled_free(large[i]);
+    }
+    REQUIRE(heap_sampler_get_stats(&stats) == ESP_OK);
+    REQUIRE(stats.live_samples == 0);
+    REQUIRE(heap_sampler_stop() == ESP_OK);
+}
+
+TEST_CASE("heap sampler overhead on allocations which aren't sampled", "[heap_sampler]")
+{
+    const int ROUNDS = 200000;
+    auto run = [&]() {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            sampled_free(sampled_malloc(32 + (i & 63)));
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+    };
+
+    double stopped_ns = run();
+    REQUIRE(heap_sampler_start(512 * 1024) == ESP_OK);
+    double running_ns = run();
+    REQUIRE(heap_sampler_stop() == ESP_OK);
+    printf("[HEAP_SAMPLER] malloc+free %.1f ns with the sampler stopped, %.1f ns with the sampler running\n",
+           stopped_ns, running_ns);
+}
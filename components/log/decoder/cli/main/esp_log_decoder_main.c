@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "esp_err.h"
+#include "esp_log_decoder.h"
+
+#define READ_CHUNK_SIZE (256 * 1024)
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-b BOOTLOADER_ELF] [--no-color] [--stats] APP_ELF [INPUT]\n\n"
+            "Decode the binary log output of an application to text.\n"
+            "INPUT is a file holding the raw output of the chip, standard input is read if it is missing or '-'.\n", name);
+}
+
+static void write_output(const char *data, size_t len, void *arg)
+{
+    fwrite(data, 1, len, (FILE *)arg);
+}
+
+int main(int argc, char **argv)
+{
+    const char *app_elf = NULL;
+    const char *bootloader_elf = NULL;
+    const char *input_path = NULL;
+    bool colors = true;
+    bool print_stats = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            bootloader_elf = argv[++i];
+        } else if (strcmp(argv[i], "--no-color") == 0) {
+            colors = false;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            print_stats = true;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return 2;
+        } else if (app_elf == NULL) {
+            app_elf = argv[i];
+        } else if (input_path == NULL) {
+            input_path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (app_elf == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int input = STDIN_FILENO;
+    if (input_path != NULL && strcmp(input_path, "-") != 0) {
+        input = open(input_path, O_RDONLY);
+        if (input < 0) {
+            perror(input_path);
+            return 1;
+        }
+    }
+
+    esp_log_decoder_config_t config = {
+        .app_elf = app_elf,
+        .bootloader_elf = bootloader_elf,
+        .output = write_output,
+        .output_arg = stdout,
+        .colors = colors,
+    };
+    esp_log_decoder_handle_t decoder;
+    esp_err_t err = esp_log_decoder_create(&config, &decoder);
+    if (err != ESP_OK) {
+        fprintf(stderr, "Can't load the ELF files: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+
+    uint8_t *chunk = malloc(READ_CHUNK_SIZE);
+    if (chunk == NULL) {
+        esp_log_decoder_delete(decoder);
+        return 1;
+    }
+    ssize_t len;
+    // read() returns what is available, so that the messages of a live stream are shown as they arrive
+    while ((len = read(input, chunk, READ_CHUNK_SIZE)) > 0) {
+        esp_log_decoder_feed(decoder, chunk, len);
+        fflush(stdout);
+    }
+    esp_log_decoder_finish(decoder);
+    fflush(stdout);
+    free(chunk);
+
+    if (print_stats) {
+        esp_log_decoder_stats_t stats;
+        esp_log_decoder_get_stats(decoder, &stats);
+        fprintf(stderr, "packets: %" PRIu64 ", CRC errors: %" PRIu64 ", malformed: %" PRIu64
+                ", unresolved addresses: %" PRIu64 ", other bytes: %" PRIu64 "\n",
+                stats.packets, stats.crc_errors, stats.malformed, stats.unresolved, stats.text_bytes);
+    }
+    esp_log_decoder_delete(decoder);
+    if (input != STDIN_FILENO) {
+        close(input);
+    }
+    if (len < 0) {
+        perror("read");
+        return 1;
+    }
+    return 0;
+}
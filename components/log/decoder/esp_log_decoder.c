@@ -0,0 +1,785 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * This file implements the host decoder of the binary log format produced by
+ * log_format_binary.c. A packet is laid out as follows, multi-byte values
+ * being big-endian:
+ *
+ * [0]          Application identifier: 1 - bootloader, 2 - application.
+ * [1, 2]       Control: length of the whole packet (10 bits), log level
+ *              (3 bits), 64-bit timestamp flag (1 bit), version (2 bits).
+ * [...]        Format string, then tag: an address of the size of a pointer
+ *              if the string is in the ELF file (0 for NULL), otherwise an
+ *              embedded string: 1 - length as a 16-bit value (its first byte
+ *              is 0xFC..0xFF), followed by MAX(length, 2) bytes.
+ * [4 or 8]     Timestamp.
+ * [...]        Arguments, whose types follow from the format string: 32-bit
+ *              and 64-bit values, and strings (%s) sent as above.
+ * [last]       CRC8 (polynomial 0x07) of the previous bytes.
+ *
+ * The stream is scanned for bytes which look like a packet header. A packet is
+ * accepted once all its bytes are received and its CRC8 matches, otherwise the
+ * first byte is written as text and the scan restarts at the next byte. This
+ * way the decoder resynchronizes after a corrupted packet and passes through
+ * text output interleaved with the packets (e.g. ROM or bootloader output).
+ *
+ * The decoded text is accumulated in an output buffer, which is flushed at the
+ * end of esp_log_decoder_feed(), so the output function is called once per
+ * chunk rather than once per message.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log_decoder.h"
+
+#define APP_ID_BOOTLOADER       1
+#define APP_ID_APPLICATION      2
+#define HEADER_LEN              3
+#define MAX_PACKET_LEN          1023
+#define EMBEDDED_STR_MIN_BYTE   0xFC
+#define OUTPUT_BUFFER_LEN       (64 * 1024)
+#define BYTES_PER_LINE          16
+#define BUFFER_FORMAT_PREFIX    "__ESP_BUFFER_"
+
+typedef struct {
+    uint64_t addr;
+    uint64_t size;
+    const char *data;
+} elf_section_t;
+
+typedef struct {
+    char *file;
+    elf_section_t *sections;    // sorted by address
+    size_t num_sections;
+    unsigned pointer_size;
+} elf_t;
+
+typedef struct {
+    const char *str;            // NULL for a NULL pointer
+    size_t len;
+    bool unresolved;            // the address isn't in the ELF file, str is the address as text
+} str_t;
+
+struct esp_log_decoder {
+    elf_t elf[2];               // indexed by application identifier - 1
+    esp_log_decoder_output_t output;
+    void *output_arg;
+    bool colors;
+    uint8_t pending[MAX_PACKET_LEN];    // start of an incomplete packet from the previous chunk
+    size_t pending_len;
+    char *out;
+    size_t out_len;
+    unsigned out_flushes;
+    char str_arg[MAX_PACKET_LEN + 1];   // zero terminated string argument, for conversions with flags
+    esp_log_decoder_stats_t stats;
+};
+
+static const char s_lvl_name[] = { '?', 'E', 'W', 'I', 'D', 'V' };
+
+static const char *const s_lvl_color[] = {
+    "", "\033[0;31m", "\033[0;33m", "\033[0;32m", "", "",
+};
+
+static uint8_t s_crc8_table[256];
+
+static void init_crc8_table(void)
+{
+    for (int i = 0; i < 256; i++) {
+        uint8_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+        }
+        s_crc8_table[i] = crc;
+    }
+}
+
+static uint8_t crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc = s_crc8_table[crc ^ data[i]];
+    }
+    return crc;
+}
+
+/* ELF loading */
+
+static uint64_t read_le(const char *p, unsigned size)
+{
+    uint64_t value = 0;
+    for (unsigned i = 0; i < size; i++) {
+        value |= (uint64_t)(uint8_t)p[i] << (8 * i);
+    }
+    return value;
+}
+
+static int compare_sections(const void *a, const void *b)
+{
+    const elf_section_t *sa = a;
+    const elf_section_t *sb = b;
+    return (sa->addr > sb->addr) - (sa->addr < sb->addr);
+}
+
+static esp_err_t load_elf(const char *path, elf_t *elf)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    elf->file = malloc(file_size > 0 ? file_size : 1);
+    if (elf->file == NULL) {
+        goto exit;
+    }
+    if (file_size < 0x40 || fread(elf->file, 1, file_size, f) != (size_t)file_size) {
+        ret = ESP_ERR_INVALID_VERSION;
+        goto exit;
+    }
+    const char *h = elf->file;
+    bool is_64 = h[4] == 2;
+    if (memcmp(h, "\x7f" "ELF", 4) != 0 || (h[4] != 1 && h[4] != 2) || h[5] != 1 /* little-endian */) {
+        ret = ESP_ERR_INVALID_VERSION;
+        goto exit;
+    }
+    elf->pointer_size = is_64 ? 8 : 4;
+    uint64_t shoff = is_64 ? read_le(h + 0x28, 8) : read_le(h + 0x20, 4);
+    unsigned shentsize = read_le(h + (is_64 ? 0x3A : 0x2E), 2);
+    unsigned shnum = read_le(h + (is_64 ? 0x3C : 0x30), 2);
+    if (shoff + (uint64_t)shentsize * shnum > (uint64_t)file_size) {
+        ret = ESP_ERR_INVALID_VERSION;
+        goto exit;
+    }
+    elf->sections = calloc(shnum ? shnum : 1, sizeof(elf_section_t));
+    if (elf->sections == NULL) {
+        goto exit;
+    }
+    for (unsigned i = 0; i < shnum; i++) {
+        const char *sh = h + shoff + (uint64_t)i * shentsize;
+        uint32_t type = read_le(sh + 4, 4);
+        uint64_t flags = is_64 ? read_le(sh + 8, 8) : read_le(sh + 8, 4);
+        uint64_t addr = is_64 ? read_le(sh + 16, 8) : read_le(sh + 12, 4);
+        uint64_t offset = is_64 ? read_le(sh + 24, 8) : read_le(sh + 16, 4);
+        uint64_t size = is_64 ? read_le(sh + 32, 8) : read_le(sh + 20, 4);
+        // SHT_PROGBITS sections with SHF_ALLOC, this includes the NOLOAD sections kept in the ELF file
+        if (type != 1 || !(flags & 0x2) || size == 0 || offset + size > (uint64_t)file_size) {
+            continue;
+        }
+        elf->sections[elf->num_sections++] = (elf_section_t) {
+            .addr = addr, .size = size, .data = h + offset,
+        };
+    }
+    qsort(elf->sections, elf->num_sections, sizeof(elf_section_t), compare_sections);
+    ret = ESP_OK;
+exit:
+    fclose(f);
+    return ret;
+}
+
+static void free_elf(elf_t *elf)
+{
+    free(elf->sections);
+    free(elf->file);
+}
+
+static bool resolve_addr(const elf_t *elf, uint64_t addr, const char **data, size_t *max_len)
+{
+    size_t lo = 0;
+    size_t hi = elf->num_sections;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const elf_section_t *s = &elf->sections[mid];
+        if (addr < s->addr) {
+            hi = mid;
+        } else if (addr >= s->addr + s->size) {
+            lo = mid + 1;
+        } else {
+            *data = s->data + (addr - s->addr);
+            *max_len = s->size - (addr - s->addr);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Output */
+
+static void flush_output(esp_log_decoder_handle_t dec)
+{
+    if (dec->out_len > 0) {
+        dec->output(dec->out, dec->out_len, dec->output_arg);
+        dec->out_len = 0;
+        dec->out_flushes++;
+    }
+}
+
+static inline void out_write(esp_log_decoder_handle_t dec, const char *data, size_t len)
+{
+    if (dec->out_len + len > OUTPUT_BUFFER_LEN) {
+        flush_output(dec);
+        if (len > OUTPUT_BUFFER_LEN) {
+            dec->output(data, len, dec->output_arg);
+            return;
+        }
+    }
+    memcpy(dec->out + dec->out_len, data, len);
+    dec->out_len += len;
+}
+
+static inline void out_char(esp_log_decoder_handle_t dec, char c)
+{
+    if (dec->out_len == OUTPUT_BUFFER_LEN) {
+        flush_output(dec);
+    }
+    dec->out[dec->out_len++] = c;
+}
+
+static void out_printf(esp_log_decoder_handle_t dec, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void out_printf(esp_log_decoder_handle_t dec, const char *format, ...)
+{
+    char buf[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len > 0) {
+        out_write(dec, buf, len < (int)sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+    }
+}
+
+static void out_u64(esp_log_decoder_handle_t dec, uint64_t value)
+{
+    char buf[20];
+    int i = sizeof(buf);
+    do {
+        buf[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    out_write(dec, &buf[i], sizeof(buf) - i);
+}
+
+static void out_prefix(esp_log_decoder_handle_t dec, unsigned level, uint64_t timestamp, const str_t *tag)
+{
+    if (dec->colors) {
+        out_write(dec, s_lvl_color[level], strlen(s_lvl_color[level]));
+    }
+    out_char(dec, s_lvl_name[level]);
+    out_write(dec, " (", 2);
+    out_u64(dec, timestamp);
+    out_write(dec, ") ", 2);
+    if (tag->str) {
+        out_write(dec, tag->str, tag->len);
+        out_write(dec, ": ", 2);
+    }
+}
+
+static void out_line_end(esp_log_decoder_handle_t dec, unsigned level)
+{
+    if (dec->colors && s_lvl_color[level][0] != '\0') {
+        out_write(dec, "\033[0m", 4);
+    }
+    out_char(dec, '\n');
+}
+
+/* Packet parsing */
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    const elf_t *elf;
+    bool error;
+    char unresolved[3][24];     // text of unresolved addresses: format, tag and the current argument
+    unsigned num_unresolved;
+} reader_t;
+
+static uint64_t read_be(reader_t *r, unsigned size)
+{
+    if ((size_t)(r->end - r->p) < size) {
+        r->error = true;
+        return 0;
+    }
+    uint64_t value = 0;
+    for (unsigned i = 0; i < size; i++) {
+        value = (value << 8) | r->p[i];
+    }
+    r->p += size;
+    return value;
+}
+
+/* Reads a string sent by output_pointer(). buffer_len is the length of a buffer argument, 0 for strings. */
+static str_t read_str(esp_log_decoder_handle_t dec, reader_t *r, size_t buffer_len)
+{
+    str_t s = { NULL, 0, false };
+    if (r->p < r->end && *r->p >= EMBEDDED_STR_MIN_BYTE) {
+        int16_t neg_len = (int16_t)read_be(r, 2);
+        size_t len = 1 - neg_len;
+        size_t bytes = len < 2 ? 2 : len;
+        if ((size_t)(r->end - r->p) < bytes) {
+            r->error = true;
+            return s;
+        }
+        s.str = (const char *)r->p;
+        s.len = len;
+        r->p += bytes;
+        return s;
+    }
+    uint64_t addr = read_be(r, r->elf->pointer_size);
+    if (r->error || addr == 0) {
+        return s;
+    }
+    const char *data;
+    size_t max_len;
+    if (!resolve_addr(r->elf, addr, &data, &max_len)) {
+        dec->stats.unresolved++;
+        char *text = r->unresolved[r->num_unresolved < 2 ? r->num_unresolved++ : 2];
+        s.len = snprintf(text, sizeof(r->unresolved[0]), "<0x%" PRIx64 "?>", addr);
+        s.str = text;
+        s.unresolved = true;
+        return s;
+    }
+    s.str = data;
+    s.len = buffer_len ? (buffer_len < max_len ? buffer_len : max_len) : strnlen(data, max_len);
+    return s;
+}
+
+typedef enum {
+    ARG_NONE,
+    ARG_32BITS,
+    ARG_64BITS,
+    ARG_DOUBLE,
+    ARG_STRING,
+} arg_type_t;
+
+typedef struct {
+    const char *start;          // '%'
+    size_t spec_len;            // up to and including the conversion character
+    const char *flags_end;      // end of flags, width and precision
+    char conversion;
+    arg_type_t type;
+} conversion_t;
+
+/* Finds the next conversion in [*format, end), the argument types follow the rules of ESP_LOG_ARGS_TYPE() */
+static bool next_conversion(const char **format, const char *end, conversion_t *conv)
+{
+    const char *f = *format;
+    while (f < end) {
+        const char *percent = memchr(f, '%', end - f);
+        if (percent == NULL || percent + 1 >= end) {
+            break;
+        }
+        f = percent + 1;
+        if (*f == '%') {
+            f++;
+            continue;
+        }
+        while (f < end && strchr("-+ #0123456789.", *f) && *f) {
+            f++;
+        }
+        const char *flags_end = f;
+        int longs = 0;
+        while (f < end && strchr("hlLqjzt", *f) && *f) {
+            if (*f == 'l' || *f == 'q' || *f == 'j' || *f == 'L') {
+                longs += (*f == 'l') ? 1 : 2;
+            }
+            f++;
+        }
+        if (f >= end) {
+            break;
+        }
+        conv->start = percent;
+        conv->flags_end = flags_end;
+        conv->conversion = *f++;
+        conv->spec_len = f - percent;
+        switch (conv->conversion) {
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            conv->type = ARG_DOUBLE;
+            break;
+        case 's':
+            conv->type = ARG_STRING;
+            break;
+        default:
+            conv->type = longs >= 2 ? ARG_64BITS : ARG_32BITS;
+            break;
+        }
+        *format = f;
+        return true;
+    }
+    *format = end;
+    return false;
+}
+
+/* Formats a single conversion, with the length modifiers replaced by the ones of the host type */
+static void out_conversion(esp_log_decoder_handle_t dec, const conversion_t *conv, uint64_t value, const str_t *str)
+{
+    char spec[64];
+    size_t flags_len = conv->flags_end - conv->start;
+    if (flags_len + 4 > sizeof(spec)) {
+        out_write(dec, conv->start, conv->spec_len);
+        return;
+    }
+    memcpy(spec, conv->start, flags_len);
+    char *s = spec + flags_len;
+    switch (conv->type) {
+    case ARG_DOUBLE: {
+        double d;
+        memcpy(&d, &value, sizeof(d));
+        *s++ = conv->conversion;
+        *s = '\0';
+        out_printf(dec, spec, d);
+        break;
+    }
+    case ARG_STRING:
+        if (str->str == NULL) {
+            out_write(dec, "(null)", 6);
+        } else if (flags_len == 1) {
+            out_write(dec, str->str, str->len);
+        } else {
+            memcpy(dec->str_arg, str->str, str->len);
+            dec->str_arg[str->len] = '\0';
+            *s++ = 's';
+            *s = '\0';
+            out_printf(dec, spec, dec->str_arg);
+        }
+        break;
+    case ARG_64BITS:
+        *s++ = 'l';
+        *s++ = 'l';
+        *s++ = conv->conversion;
+        *s = '\0';
+        out_printf(dec, spec, (long long)value);
+        break;
+    default:
+        if (conv->conversion == 'p') {
+            out_printf(dec, "0x%" PRIx32, (uint32_t)value);
+            break;
+        }
+        if (conv->conversion == 'c') {
+            out_char(dec, (char)value);
+            break;
+        }
+        if (conv->conversion == 'n') {
+            break;
+        }
+        // keep the h and hh modifiers, they truncate the value
+        for (const char *m = conv->flags_end; m < conv->start + conv->spec_len - 1; m++) {
+            if (*m == 'h') {
+                *s++ = 'h';
+            }
+        }
+        *s++ = conv->conversion;
+        *s = '\0';
+        out_printf(dec, spec, (int)(uint32_t)value);
+        break;
+    }
+}
+
+static void out_buffer(esp_log_decoder_handle_t dec, const char *format, unsigned level, uint64_t timestamp,
+                       const str_t *tag, const str_t *buffer, uint32_t address)
+{
+    const uint8_t *data = (const uint8_t *)buffer->str;
+    bool hex = strncmp(format, BUFFER_FORMAT_PREFIX "HEX_", sizeof(BUFFER_FORMAT_PREFIX "HEX_") - 1) == 0;
+    bool hexdump = strncmp(format, BUFFER_FORMAT_PREFIX "HEXDUMP_", sizeof(BUFFER_FORMAT_PREFIX "HEXDUMP_") - 1) == 0;
+    for (size_t offset = 0; offset < buffer->len; offset += BYTES_PER_LINE) {
+        size_t n = buffer->len - offset < BYTES_PER_LINE ? buffer->len - offset : BYTES_PER_LINE;
+        out_prefix(dec, level, timestamp, tag);
+        if (hexdump) {
+            out_printf(dec, "0x%08" PRIx32 " ", (uint32_t)(address + offset));
+            for (size_t i = 0; i < BYTES_PER_LINE; i++) {
+                out_write(dec, (i & 7) == 0 ? "  " : " ", (i & 7) == 0 ? 2 : 1);
+                if (i < n) {
+                    out_printf(dec, "%02x", data[offset + i]);
+                } else {
+                    out_write(dec, "  ", 2);
+                }
+            }
+            out_write(dec, "  |", 3);
+            for (size_t i = 0; i < n; i++) {
+                uint8_t c = data[offset + i];
+                out_char(dec, (c >= 32 && c <= 126) ? c : '.');
+            }
+            out_char(dec, '|');
+        } else if (hex) {
+            for (size_t i = 0; i < n; i++) {
+                out_printf(dec, i ? " %02x" : "%02x", data[offset + i]);
+            }
+        } else {
+            out_write(dec, (const char *)&data[offset], n);
+        }
+        out_line_end(dec, level);
+    }
+}
+
+static bool decode_packet(esp_log_decoder_handle_t dec, const uint8_t *packet, size_t len)
+{
+    unsigned app_id = packet[0];
+    uint16_t control = (packet[1] << 8) | packet[2];
+    unsigned level = (control >> 10) & 0x7;
+    bool time_64bits = (control >> 13) & 0x1;
+    reader_t r = {
+        .p = packet + HEADER_LEN,
+        .end = packet + len - 1, // CRC8
+        .elf = &dec->elf[app_id - 1],
+        .error = false,
+    };
+    str_t format = read_str(dec, &r, 0);
+    str_t tag = read_str(dec, &r, 0);
+    uint64_t timestamp = read_be(&r, time_64bits ? 8 : 4);
+    if (r.error) {
+        return false;
+    }
+    if (format.str == NULL || format.unresolved) {
+        // the types of the arguments are unknown, output the address of the format string only
+        out_prefix(dec, level, timestamp, &tag);
+        if (format.str) {
+            out_write(dec, format.str, format.len);
+        }
+        out_line_end(dec, level);
+        return true;
+    }
+    if (format.len >= sizeof(BUFFER_FORMAT_PREFIX) - 1 && memcmp(format.str, BUFFER_FORMAT_PREFIX, sizeof(BUFFER_FORMAT_PREFIX) - 1) == 0) {
+        // esp_log_buffer_xxx(): length, buffer and address of the buffer
+        uint32_t buffer_len = read_be(&r, 4);
+        str_t buffer = read_str(dec, &r, buffer_len ? buffer_len : 1);
+        uint32_t address = read_be(&r, 4);
+        if (r.error || r.p != r.end) {
+            return false;
+        }
+        if (buffer_len == 0) {
+            return true;
+        }
+        out_buffer(dec, format.str, level, timestamp, &tag, &buffer, address);
+        return true;
+    }
+    // the message is written while it is parsed, keep enough room to rewind it if the packet turns out to be malformed
+    if (dec->out_len > OUTPUT_BUFFER_LEN / 2) {
+        flush_output(dec);
+    }
+    size_t out_start = dec->out_len;
+    unsigned out_flushes = dec->out_flushes;
+    out_prefix(dec, level, timestamp, &tag);
+    const char *f = format.str;
+    const char *format_end = format.str + format.len;
+    const char *literal = f;
+    conversion_t conv;
+    while (next_conversion(&f, format_end, &conv)) {
+        // literal text, with "%%" reduced to "%"
+        for (const char *l = literal; l < conv.start;) {
+            const char *pp = memchr(l, '%', conv.start - l);
+            const char *stop = pp ? pp + 1 : conv.start;
+            out_write(dec, l, stop - l);
+            l = pp ? pp + 2 : conv.start;
+        }
+        literal = f;
+        uint64_t value = 0;
+        str_t str = { NULL, 0, false };
+        if (conv.type == ARG_STRING) {
+            str = read_str(dec, &r, 0);
+        } else {
+            value = read_be(&r, conv.type == ARG_32BITS ? 4 : 8);
+        }
+        if (r.error) {
+            break;
+        }
+        out_conversion(dec, &conv, value, &str);
+    }
+    for (const char *l = literal; l < format_end;) {
+        const char *pp = memchr(l, '%', format_end - l);
+        const char *stop = pp ? pp + 1 : format_end;
+        out_write(dec, l, stop - l);
+        l = pp ? pp + 2 : format_end;
+    }
+    out_line_end(dec, level);
+    if (r.error || r.p != r.end) {
+        if (dec->out_flushes == out_flushes) {
+            dec->out_len = out_start;
+        }
+        return false;
+    }
+    return true;
+}
+
+/* Stream scanning */
+
+static inline bool is_app_id(uint8_t b)
+{
+    return b == APP_ID_BOOTLOADER || b == APP_ID_APPLICATION;
+}
+
+typedef enum {
+    SCAN_TEXT,          // the first byte isn't the start of a packet
+    SCAN_INCOMPLETE,    // more bytes are needed
+    SCAN_PACKET,        // a valid packet of the returned length starts at the first byte
+} scan_result_t;
+
+static scan_result_t scan_packet(esp_log_decoder_handle_t dec, const uint8_t *data, size_t avail, size_t *packet_len)
+{
+    if (!is_app_id(data[0])) {
+        return SCAN_TEXT;
+    }
+    if (avail < HEADER_LEN) {
+        return SCAN_INCOMPLETE;
+    }
+    uint16_t control = (data[1] << 8) | data[2];
+    size_t len = control & 0x3FF;
+    unsigned level = (control >> 10) & 0x7;
+    unsigned version = control >> 14;
+    unsigned min_len = HEADER_LEN + 2 + 2 + 4 + 1;
+    if (version != 0 || level == 0 || level > 5 || len < min_len) {
+        return SCAN_TEXT;
+    }
+    if (avail < len) {
+        return SCAN_INCOMPLETE;
+    }
+    if (crc8(data, len - 1) != data[len - 1]) {
+        dec->stats.crc_errors++;
+        return SCAN_TEXT;
+    }
+    *packet_len = len;
+    return SCAN_PACKET;
+}
+
+/* Processes the bytes, returns the number of bytes consumed. Bytes of an incomplete packet at the end are not consumed. */
+static size_t process(esp_log_decoder_handle_t dec, const uint8_t *data, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len) {
+        // write the text up to the next byte which can start a packet
+        size_t text_start = pos;
+        while (pos < len && !is_app_id(data[pos])) {
+            pos++;
+        }
+        if (pos > text_start) {
+            out_write(dec, (const char *)&data[text_start], pos - text_start);
+            dec->stats.text_bytes += pos - text_start;
+            continue;
+        }
+        size_t packet_len;
+        switch (scan_packet(dec, &data[pos], len - pos, &packet_len)) {
+        case SCAN_INCOMPLETE:
+            return pos;
+        case SCAN_PACKET:
+            if (decode_packet(dec, &data[pos], packet_len)) {
+                dec->stats.packets++;
+                pos += packet_len;
+                break;
+            }
+            dec->stats.malformed++;
+        // fall through
+        case SCAN_TEXT:
+        default:
+            out_char(dec, data[pos++]);
+            dec->stats.text_bytes++;
+            break;
+        }
+    }
+    return pos;
+}
+
+esp_err_t esp_log_decoder_create(const esp_log_decoder_config_t *config, esp_log_decoder_handle_t *ret_decoder)
+{
+    if (config == NULL || config->output == NULL || ret_decoder == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_log_decoder_handle_t dec = calloc(1, sizeof(*dec));
+    if (dec == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    dec->out = malloc(OUTPUT_BUFFER_LEN);
+    if (dec->out == NULL) {
+        goto err;
+    }
+    dec->output = config->output;
+    dec->output_arg = config->output_arg;
+    dec->colors = config->colors;
+    const char *paths[2] = { config->bootloader_elf, config->app_elf };
+    for (int i = 0; i < 2; i++) {
+        dec->elf[i].pointer_size = 4;
+        if (paths[i] != NULL) {
+            ret = load_elf(paths[i], &dec->elf[i]);
+            if (ret != ESP_OK) {
+                goto err;
+            }
+        }
+    }
+    init_crc8_table();
+    *ret_decoder = dec;
+    return ESP_OK;
+err:
+    esp_log_decoder_delete(dec);
+    return ret;
+}
+
+void esp_log_decoder_feed(esp_log_decoder_handle_t decoder, const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+    // complete the pending packet with the start of the chunk, then process the chunk in place
+    while (decoder->pending_len > 0 && len > 0) {
+        size_t n = sizeof(decoder->pending) - decoder->pending_len;
+        n = n < len ? n : len;
+        memcpy(&decoder->pending[decoder->pending_len], bytes, n);
+        size_t total = decoder->pending_len + n;
+        size_t consumed = process(decoder, decoder->pending, total);
+        if (consumed < decoder->pending_len) {
+            // still incomplete, or a new packet started within the pending bytes
+            size_t left = total - consumed;
+            memmove(decoder->pending, &decoder->pending[consumed], left);
+            decoder->pending_len = left;
+            bytes += n;
+            len -= n;
+            continue;
+        }
+        // the pending bytes are consumed, continue in the chunk itself
+        bytes += consumed - decoder->pending_len;
+        len -= consumed - decoder->pending_len;
+        decoder->pending_len = 0;
+    }
+    if (len > 0) {
+        size_t consumed = process(decoder, bytes, len);
+        memcpy(decoder->pending, &bytes[consumed], len - consumed);
+        decoder->pending_len = len - consumed;
+    }
+    flush_output(decoder);
+}
+
+void esp_log_decoder_finish(esp_log_decoder_handle_t decoder)
+{
+    // the pending bytes don't form a complete packet, write the first one as text and rescan the others
+    while (decoder->pending_len > 0) {
+        out_char(decoder, decoder->pending[0]);
+        decoder->stats.text_bytes++;
+        size_t left = decoder->pending_len - 1;
+        memmove(decoder->pending, &decoder->pending[1], left);
+        size_t consumed = process(decoder, decoder->pending, left);
+        memmove(decoder->pending, &decoder->pending[consumed], left - consumed);
+        decoder->pending_len = left - consumed;
+    }
+    flush_output(decoder);
+}
+
+void esp_log_decoder_get_stats(esp_log_decoder_handle_t decoder, esp_log_decoder_stats_t *stats)
+{
+    *stats = decoder->stats;
+}
+
+void esp_log_decoder_delete(esp_log_decoder_handle_t decoder)
+{
+    if (decoder == NULL) {
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        free_elf(&decoder->elf[i]);
+    }
+    free(decoder->out);
+    free(decoder);
+}
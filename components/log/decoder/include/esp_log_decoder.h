@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Decoder of the binary log format (CONFIG_LOG_MODE_BINARY), for hosts.
+ *
+ * The decoder takes the raw byte stream output by the chip, in chunks of any size, and writes the log messages as
+ * text, formatted like the text log mode does. Format strings, tags and string arguments which the chip sends as
+ * addresses are read from the ELF file of the application (or of the bootloader). Bytes which are not part of a
+ * valid packet, such as ROM output or packets with a CRC error, are written unchanged and the decoder resynchronizes
+ * on the next valid packet.
+ */
+typedef struct esp_log_decoder *esp_log_decoder_handle_t;
+
+/**
+ * @brief Function receiving the decoded text.
+ *
+ * @param data Text, not zero terminated
+ * @param len  Length of the text
+ * @param arg  User argument from esp_log_decoder_config_t
+ */
+typedef void (*esp_log_decoder_output_t)(const char *data, size_t len, void *arg);
+
+/**
+ * @brief Configuration of the decoder.
+ */
+typedef struct {
+    const char *app_elf;                /*!< Path of the ELF file of the application, or NULL */
+    const char *bootloader_elf;         /*!< Path of the ELF file of the bootloader, or NULL */
+    esp_log_decoder_output_t output;    /*!< Function receiving the decoded text */
+    void *output_arg;                   /*!< User argument passed to output */
+    bool colors;                        /*!< Color the messages by level, as CONFIG_LOG_COLORS does */
+} esp_log_decoder_config_t;
+
+/**
+ * @brief Statistics of the decoder.
+ */
+typedef struct {
+    uint64_t packets;           /*!< Number of decoded packets */
+    uint64_t crc_errors;        /*!< Number of packets dropped because of a CRC error */
+    uint64_t malformed;         /*!< Number of packets dropped because their contents don't match their format string */
+    uint64_t unresolved;        /*!< Number of addresses which were not found in the ELF file */
+    uint64_t text_bytes;        /*!< Number of bytes which were not part of a packet, written unchanged */
+} esp_log_decoder_stats_t;
+
+/**
+ * @brief Create a decoder.
+ *
+ * The ELF files are loaded into memory. The size of the pointers sent by the chip is taken from the class of the ELF
+ * file (4 bytes if no ELF file is given).
+ *
+ * @param config Configuration
+ * @param[out] ret_decoder Handle of the created decoder
+ *
+ * @return
+ *  - ESP_OK on success
+ *  - ESP_ERR_INVALID_ARG if an argument is NULL
+ *  - ESP_ERR_NOT_FOUND if an ELF file can't be read
+ *  - ESP_ERR_INVALID_VERSION if an ELF file isn't a little-endian ELF file
+ *  - ESP_ERR_NO_MEM if out of memory
+ */
+esp_err_t esp_log_decoder_create(const esp_log_decoder_config_t *config, esp_log_decoder_handle_t *ret_decoder);
+
+/**
+ * @brief Decode a chunk of the stream.
+ *
+ * Packets may span several chunks. The decoded text is passed to the output function before returning, except for
+ * the bytes of an incomplete packet at the end of the chunk, which are kept until the next call.
+ *
+ * @param decoder Decoder handle
+ * @param data    Chunk of the stream
+ * @param len     Length of the chunk
+ */
+void esp_log_decoder_feed(esp_log_decoder_handle_t decoder, const void *data, size_t len);
+
+/**
+ * @brief Signal the end of the stream.
+ *
+ * The bytes of an incomplete packet kept by the decoder are written unchanged.
+ *
+ * @param decoder Decoder handle
+ */
+void esp_log_decoder_finish(esp_log_decoder_handle_t decoder);
+
+/**
+ * @brief Get the statistics of the decoder.
+ *
+ * @param decoder Decoder handle
+ * @param[out] stats Statistics since the decoder was created
+ */
+void esp_log_decoder_get_stats(esp_log_decoder_handle_t decoder, esp_log_decoder_stats_t *stats);
+
+/**
+ * @brief Delete a decoder.
+ *
+ * @param decoder Decoder handle
+ */
+void esp_log_decoder_delete(esp_log_decoder_handle_t decoder);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,298 @@
+/* Binary log decoder unit tests
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <cstdio>
+#include <cstring>
+#include <regex>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_log_decoder.h"
+#include "sdkconfig.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace std;
+
+static const char *TEST_TAG = "test";
+
+/* The messages are encoded by the log component, which outputs the packets to stdout on Linux */
+class BinaryLogCapture {
+public:
+    BinaryLogCapture()
+    {
+        fflush(stdout);
+        file = tmpfile();
+        REQUIRE(file != nullptr);
+        saved_stdout = dup(STDOUT_FILENO);
+        dup2(fileno(file), STDOUT_FILENO);
+    }
+
+    ~BinaryLogCapture()
+    {
+        restore();
+        fclose(file);
+    }
+
+    vector<uint8_t> get()
+    {
+        restore();
+        vector<uint8_t> data;
+        rewind(file);
+        uint8_t chunk[4096];
+        size_t len;
+        while ((len = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            data.insert(data.end(), chunk, chunk + len);
+        }
+        return data;
+    }
+
+private:
+    void restore()
+    {
+        if (saved_stdout >= 0) {
+            fflush(stdout);
+            dup2(saved_stdout, STDOUT_FILENO);
+            close(saved_stdout);
+            saved_stdout = -1;
+        }
+    }
+
+    FILE *file;
+    int saved_stdout;
+};
+
+struct Decoder {
+    Decoder()
+    {
+        esp_log_decoder_config_t config = {
+            .app_elf = "/proc/self/exe",
+            .bootloader_elf = nullptr,
+            .output = output_to_string,
+            .output_arg = &text,
+            .colors = false,
+        };
+        REQUIRE(esp_log_decoder_create(&config, &handle) == ESP_OK);
+    }
+
+    ~Decoder()
+    {
+        esp_log_decoder_delete(handle);
+    }
+
+    string decode(const vector<uint8_t> &data, size_t chunk_size = SIZE_MAX)
+    {
+        for (size_t pos = 0; pos < data.size(); pos += chunk_size) {
+            esp_log_decoder_feed(handle, &data[pos], min(chunk_size, data.size() - pos));
+        }
+        esp_log_decoder_finish(handle);
+        // the timestamps depend on when the test runs
+        return regex_replace(text, regex("\\([0-9]+\\) "), "(0) ");
+    }
+
+    esp_log_decoder_stats_t stats()
+    {
+        esp_log_decoder_stats_t stats;
+        esp_log_decoder_get_stats(handle, &stats);
+        return stats;
+    }
+
+    static void output_to_string(const char *data, size_t len, void *arg)
+    {
+        static_cast<string *>(arg)->append(data, len);
+    }
+
+    esp_log_decoder_handle_t handle;
+    string text;
+};
+
+static vector<uint8_t> log_messages()
+{
+    BinaryLogCapture capture;
+    ESP_LOGE(TEST_TAG, "first message");
+    ESP_LOGW(TEST_TAG, "second message %d", 2);
+    ESP_LOGI(TEST_TAG, "third message %s", "three");
+    return capture.get();
+}
+
+static const char *LOG_MESSAGES_TEXT = "E (0) test: first message\n"
+                                       "W (0) test: second message 2\n"
+                                       "I (0) test: third message three\n";
+
+TEST_CASE("decoded messages match the text log format")
+{
+    char runtime_str[16];
+    strcpy(runtime_str, "runtime");
+    uint8_t buffer[20];
+    for (unsigned i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = 'a' + i;
+    }
+    buffer[3] = 0;
+
+    // Floating-point arguments are not covered: on x86-64, the encoder can't take them from va_list as 64-bit
+    // integers, as the ABI passes them in other registers than the integers.
+    BinaryLogCapture capture;
+    ESP_LOGI(TEST_TAG, "no arguments");
+    ESP_LOGW(TEST_TAG, "int %d unsigned %u hex %x HEX %08X", -5, 7u, 0xabcdu, 0x12u);
+    ESP_LOGE(TEST_TAG, "64-bit %lld %llu %llx", -1234567890123LL, 42ULL, 0x123456789abcULL);
+    ESP_LOGV(TEST_TAG, "char %c strings %s %s", 'x', "rodata", runtime_str);
+    ESP_LOGD(TEST_TAG, "widths [%5d] [%-4d] [%08llx] [%5s] [%-6s] [%.3s] 100%%", 42, 7, 0xabcULL, "ab", "cd", runtime_str);
+    ESP_LOGI("other_tag", "mixed %d %lld %s %c", 1, 2LL, "three", '5');
+    ESP_LOG_BUFFER_HEX(TEST_TAG, buffer, sizeof(buffer));
+    ESP_LOG_BUFFER_CHAR(TEST_TAG, "printable text which spans two lines", 36);
+    ESP_LOG_BUFFER_HEXDUMP(TEST_TAG, buffer, sizeof(buffer), ESP_LOG_INFO);
+    vector<uint8_t> data = capture.get();
+
+    Decoder decoder;
+    string text = decoder.decode(data);
+    string expected = "I (0) test: no arguments\n"
+                      "W (0) test: int -5 unsigned 7 hex abcd HEX 00000012\n"
+                      "E (0) test: 64-bit -1234567890123 42 123456789abc\n"
+                      "V (0) test: char x strings rodata runtime\n"
+                      "D (0) test: widths [   42] [7   ] [00000abc] [   ab] [cd    ] [run] 100%\n"
+                      "I (0) other_tag: mixed 1 2 three 5\n"
+                      "I (0) test: 61 62 63 00 65 66 67 68 69 6a 6b 6c 6d 6e 6f 70\n"
+                      "I (0) test: 71 72 73 74\n"
+                      "I (0) test: printable text w\n"
+                      "I (0) test: hich spans two l\n"
+                      "I (0) test: ines\n";
+    CHECK(text.substr(0, expected.size()) == expected);
+    CHECK(regex_search(text, regex("I \\(0\\) test: 0x[0-9a-f]{8}   61 62 63 00 65 66 67 68  69 6a 6b 6c 6d 6e 6f 70  \\|abc.efghijklmnop\\|\n"
+                                   "I \\(0\\) test: 0x[0-9a-f]{8}   71 72 73 74                                       \\|qrst\\|\n$")));
+
+    esp_log_decoder_stats_t stats = decoder.stats();
+    CHECK(stats.packets == 9);
+    CHECK(stats.crc_errors == 0);
+    CHECK(stats.malformed == 0);
+    CHECK(stats.unresolved == 0);
+    CHECK(stats.text_bytes == 0);
+}
+
+TEST_CASE("messages are decoded when the stream is fed in small chunks")
+{
+    vector<uint8_t> data = log_messages();
+    for (size_t chunk_size : { 1, 2, 7, 13 }) {
+        Decoder decoder;
+        CHECK(decoder.decode(data, chunk_size) == LOG_MESSAGES_TEXT);
+        CHECK(decoder.stats().packets == 3);
+    }
+}
+
+TEST_CASE("text between packets is passed through")
+{
+    vector<uint8_t> data = log_messages();
+    const string rom_output = "ets Jun  8 2016 00:22:57\n";
+    data.insert(data.begin(), rom_output.begin(), rom_output.end());
+
+    Decoder decoder;
+    CHECK(decoder.decode(data) == rom_output + LOG_MESSAGES_TEXT);
+    CHECK(decoder.stats().text_bytes == rom_output.size());
+    CHECK(decoder.stats().packets == 3);
+}
+
+TEST_CASE("decoder resynchronizes after a corrupted packet")
+{
+    vector<uint8_t> first = log_messages();
+    vector<uint8_t> second = log_messages();
+    // corrupt the format string address of the first packet of the second stream
+    vector<uint8_t> data = first;
+    second[5] ^= 0x40;
+    data.insert(data.end(), second.begin(), second.end());
+
+    Decoder decoder;
+    string text = decoder.decode(data);
+    CHECK(text.substr(0, strlen(LOG_MESSAGES_TEXT)) == LOG_MESSAGES_TEXT);
+    // the bytes of the corrupted packet are output as they are, the next packets are decoded
+    const string tail = "W (0) test: second message 2\n"
+                        "I (0) test: third message three\n";
+    CHECK(text.size() > strlen(LOG_MESSAGES_TEXT) + tail.size());
+    CHECK(text.substr(text.size() - tail.size()) == tail);
+    esp_log_decoder_stats_t stats = decoder.stats();
+    CHECK(stats.packets == 5);
+    CHECK(stats.crc_errors >= 1);
+}
+
+TEST_CASE("truncated packet is output as text when the stream ends")
+{
+    vector<uint8_t> data = log_messages();
+    data.resize(data.size() - 3);
+
+    Decoder decoder;
+    string text = decoder.decode(data);
+    const string head = "E (0) test: first message\n"
+                        "W (0) test: second message 2\n";
+    CHECK(text.substr(0, head.size()) == head);
+    CHECK(decoder.stats().packets == 2);
+    CHECK(decoder.stats().text_bytes > 0);
+}
+
+TEST_CASE("decoder can't be created without a valid ELF file")
+{
+    esp_log_decoder_handle_t handle;
+    esp_log_decoder_config_t config = {
+        .app_elf = "/nonexistent/app.elf",
+        .bootloader_elf = nullptr,
+        .output = Decoder::output_to_string,
+        .output_arg = nullptr,
+        .colors = false,
+    };
+    CHECK(esp_log_decoder_create(&config, &handle) == ESP_ERR_NOT_FOUND);
+    config.app_elf = "/proc/self/cmdline";
+    CHECK(esp_log_decoder_create(&config, &handle) == ESP_ERR_INVALID_VERSION);
+    config.output = nullptr;
+    CHECK(esp_log_decoder_create(&config, &handle) == ESP_ERR_INVALID_ARG);
+}
+
+TEST_CASE("decoder throughput")
+{
+    vector<uint8_t> messages;
+    {
+        BinaryLogCapture capture;
+        for (int i = 0; i < 1000; i++) {
+            ESP_LOGI(TEST_TAG, "message %d of %s, value %lld", i, "throughput test", i * 1000000LL);
+            ESP_LOGW(TEST_TAG, "value 0x%08x", (unsigned)i);
+        }
+        messages = capture.get();
+    }
+    vector<uint8_t> data;
+    while (data.size() < 64 * 1024 * 1024) {
+        data.insert(data.end(), messages.begin(), messages.end());
+    }
+
+    esp_log_decoder_handle_t handle;
+    size_t text_len = 0;
+    esp_log_decoder_config_t config = {
+        .app_elf = "/proc/self/exe",
+        .bootloader_elf = nullptr,
+        .output = [](const char *data, size_t len, void *arg) {
+            *static_cast<size_t *>(arg) += len;
+        },
+        .output_arg = &text_len,
+        .colors = true,
+    };
+    REQUIRE(esp_log_decoder_create(&config, &handle) == ESP_OK);
+    auto start = chrono::steady_clock::now();
+    for (size_t pos = 0; pos < data.size(); pos += 4096) {
+        esp_log_decoder_feed(handle, &data[pos], min((size_t)4096, data.size() - pos));
+    }
+    esp_log_decoder_finish(handle);
+    auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    esp_log_decoder_stats_t stats;
+    esp_log_decoder_get_stats(handle, &stats);
+    esp_log_decoder_delete(handle);
+
+    double mb_per_s = (double)data.size() / elapsed;
+    cout << "Decoded " << data.size() << " bytes (" << stats.packets << " packets) to " << text_len
+         << " bytes of text in " << elapsed << " us, " << mb_per_s << " MB/s" << endl;
+    CHECK(stats.crc_errors == 0);
+    CHECK(stats.text_bytes == 0);
+    CHECK(mb_per_s > 50);
+}
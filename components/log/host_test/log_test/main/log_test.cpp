@@ -9,11 +9,18 @@
 #include <cstdio>
 #include <regex>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <array>
+#include <utility>
 #include "esp_rom_sys.h"
 #include "esp_log.h"
 #include "esp_private/log_util.h"
 #include "esp_private/log_timestamp.h"
 #include "sdkconfig.h"
+#if CONFIG_LOG_ASYNC
+#include "esp_log_async.h"
+#endif
 
 #include <catch2/catch_test_macros.hpp>
 
@@ -224,6 +231,127 @@ TEST_CASE("changing log level")
 }
 #endif // CONFIG_LOG_DYNAMIC_LEVEL_CONTROL
 
+#if CONFIG_LOG_DYNAMIC_LEVEL_CONTROL && !CONFIG_LOG_TAG_LEVEL_IMPL_NONE
+static const int MANY_TAGS_NUM = 200;
+static char s_many_tags[MANY_TAGS_NUM][16];
+static std::atomic<int> s_many_tags_count;
+
+// A call site per tag, as with a TAG per source file
+template <int N>
+static void log_many_tags_site()
+{
+    ESP_LOGI(s_many_tags[N], "message from tag %d", N);
+}
+
+template <int... N>
+static constexpr std::array<void (*)(), sizeof...(N)> make_many_tags_sites(std::integer_sequence<int, N...>)
+{
+    return { log_many_tags_site<N>... };
+}
+
+static const auto s_many_tags_sites = make_many_tags_sites(std::make_integer_sequence<int, MANY_TAGS_NUM>());
+
+static int count_many_tags_vprintf(const char *format, va_list args)
+{
+    if (strstr(format, "message from tag") != nullptr) {
+        s_many_tags_count++;
+    }
+    return 0;
+}
+
+static void init_many_tags()
+{
+    for (int i = 0; i < MANY_TAGS_NUM; i++) {
+        snprintf(s_many_tags[i], sizeof(s_many_tags[i]), "many_tag_%d", i);
+    }
+}
+
+TEST_CASE("changing log level of many tags")
+{
+    BasicLogFixture fix(ESP_LOG_INFO);
+    vprintf_like_t old_vprintf = esp_log_set_vprintf(count_many_tags_vprintf);
+    init_many_tags();
+
+    // set the level of half of the tags before their first use
+    for (int i = 0; i < MANY_TAGS_NUM; i += 2) {
+        esp_log_level_set(s_many_tags[i], ESP_LOG_WARN);
+    }
+    s_many_tags_count = 0;
+    for (auto site : s_many_tags_sites) {
+        site();
+    }
+    CHECK(s_many_tags_count == MANY_TAGS_NUM / 2);
+
+    // and of the other half after their first use, through a copy of the name
+    for (int i = 1; i < MANY_TAGS_NUM; i += 2) {
+        std::string name(s_many_tags[i]);
+        esp_log_level_set(name.c_str(), ESP_LOG_WARN);
+    }
+    s_many_tags_count = 0;
+    for (auto site : s_many_tags_sites) {
+        site();
+    }
+    CHECK(s_many_tags_count == 0);
+    CHECK(esp_log_level_get(s_many_tags[1]) == ESP_LOG_WARN);
+
+    esp_log_level_set("*", ESP_LOG_INFO);
+    s_many_tags_count = 0;
+    for (auto site : s_many_tags_sites) {
+        site();
+    }
+    CHECK(s_many_tags_count == MANY_TAGS_NUM);
+    CHECK(esp_log_level_get(s_many_tags[1]) == ESP_LOG_INFO);
+
+    esp_log_set_vprintf(old_vprintf);
+}
+
+TEST_CASE("tag level check performance with many tags")
+{
+    BasicLogFixture fix(ESP_LOG_INFO);
+    vprintf_like_t old_vprintf = esp_log_set_vprintf(count_many_tags_vprintf);
+    init_many_tags();
+    for (int i = 0; i < MANY_TAGS_NUM; i++) {
+        esp_log_level_set(s_many_tags[i], ESP_LOG_WARN);
+    }
+#if CONFIG_LOG_TAG_LEVEL_IMPL_INTERNED
+    const char *impl = "interned";
+#elif CONFIG_LOG_TAG_LEVEL_IMPL_CACHE_AND_LINKED_LIST
+    const char *impl = "cache + linked list";
+#else
+    const char *impl = "linked list";
+#endif
+    using clock = std::chrono::steady_clock;
+    const int rounds = 500;
+
+    // all messages are filtered out by the tag level, so only the level check is measured
+    s_many_tags_count = 0;
+    auto start = clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (auto site : s_many_tags_sites) {
+            site();
+        }
+    }
+    auto elapsed = clock::now() - start;
+    CHECK(s_many_tags_count == 0);
+    printf("%s, %d tags: %.1f ns per filtered ESP_LOGI call\n", impl, MANY_TAGS_NUM,
+           std::chrono::duration<double, std::nano>(elapsed).count() / (rounds * MANY_TAGS_NUM));
+
+    int levels_sum = 0;
+    start = clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < MANY_TAGS_NUM; i++) {
+            levels_sum += esp_log_level_get(s_many_tags[i]);
+        }
+    }
+    elapsed = clock::now() - start;
+    CHECK(levels_sum == rounds * MANY_TAGS_NUM * ESP_LOG_WARN);
+    printf("%s, %d tags: %.1f ns per esp_log_level_get call\n", impl, MANY_TAGS_NUM,
+           std::chrono::duration<double, std::nano>(elapsed).count() / (rounds * MANY_TAGS_NUM));
+
+    esp_log_set_vprintf(old_vprintf);
+}
+#endif // CONFIG_LOG_DYNAMIC_LEVEL_CONTROL && !CONFIG_LOG_TAG_LEVEL_IMPL_NONE
+
 TEST_CASE("log buffer")
 {
     PrintFixture fix(ESP_LOG_INFO);
@@ -521,3 +649,145 @@ TEST_CASE("esp_log TAG can be NULL")
     fix.reset_buffer();
 }
 #endif // ESP_LOG_VERSION == 2
+
+#if CONFIG_LOG_ASYNC
+TEST_CASE("async log writes the queued messages")
+{
+    PrintFixture fix(ESP_LOG_INFO);
+    REQUIRE(esp_log_async_start() == ESP_OK);
+    CHECK(esp_log_async_start() == ESP_ERR_INVALID_STATE);
+
+    char name[16] = "stack buffer";
+    void *ptr = &fix;
+    ESP_LOGI(TEST_TAG, "s=%s d=%d ld=%ld lld=%lld u=%" PRIu32 " x=%08x",
+             name, -5, -123456789L, 1234567890123LL, (uint32_t)4000000000UL, 0xbeef);
+    strcpy(name, "overwritten");
+    ESP_LOGI(TEST_TAG, "f=%.3f p=%p w=[%*d] prec=[%.*s] c=%c z=%zu %%", 3.14159, ptr, 6, 42, 3, "abcdef", 'Z', (size_t)77);
+    ESP_LOGW(TEST_TAG, "null=%s", (const char *)NULL);
+    ESP_LOGE(TEST_TAG, "no arguments");
+    REQUIRE(esp_log_async_flush(1000) == ESP_OK);
+
+    char expected[128];
+    snprintf(expected, sizeof(expected), "I " TIMESTAMP_FORMAT "test: f=3.142 p=%p w=\\[    42\\] prec=\\[abc\\] c=Z z=77 %%\n", ptr);
+    string output = fix.get_print_buffer_string();
+    const std::regex first_print("^I " TIMESTAMP_FORMAT "test: s=stack buffer d=-5 ld=-123456789 lld=1234567890123 u=4000000000 x=0000beef\n",
+                                 std::regex::ECMAScript);
+    CHECK(regex_search(output, first_print) == true);
+    CHECK(regex_search(output, std::regex(expected, std::regex::ECMAScript)) == true);
+    CHECK(output.find("test: null=(null)\n") != string::npos);
+    CHECK(output.find("test: no arguments\n") != string::npos);
+    CHECK(output.find("null=") < output.find("no arguments"));
+
+    esp_log_async_stats_t stats;
+    esp_log_async_get_stats(&stats);
+    CHECK(stats.queued == 4);
+    CHECK(stats.dropped == 0);
+    CHECK(stats.synchronous == 0);
+    CHECK(stats.max_used > 0);
+
+    // Arguments larger than CONFIG_LOG_ASYNC_ARGS_SIZE are written synchronously
+    fix.reset_buffer();
+    string long_string(CONFIG_LOG_ASYNC_ARGS_SIZE, 'a');
+    ESP_LOGI(TEST_TAG, "%s", long_string.c_str());
+    CHECK(fix.get_print_buffer_string().find(long_string) != string::npos);
+    esp_log_async_get_stats(&stats);
+    CHECK(stats.synchronous == 1);
+
+    // Messages longer than the line of the writer task once formatted are written synchronously, not truncated
+    fix.reset_buffer();
+    ESP_LOGI(TEST_TAG, "[%300d] %.200f", 7, 0.5);
+    ESP_LOGI(TEST_TAG, "%f", 1e300);
+    string output_long = fix.get_print_buffer_string();
+    CHECK(output_long.find(string(299, ' ') + "7] 0.5" + string(199, '0') + "\n") != string::npos);
+    CHECK(output_long.find("test: 1000000000000000052504760255204420248704468") != string::npos);
+    esp_log_async_get_stats(&stats);
+    CHECK(stats.synchronous == 3);
+    CHECK(stats.queued == 4);
+
+    CHECK(esp_log_async_stop() == ESP_OK);
+    CHECK(esp_log_async_stop() == ESP_ERR_INVALID_STATE);
+    CHECK(esp_log_async_flush(0) == ESP_ERR_INVALID_STATE);
+}
+
+static std::atomic<bool> s_output_blocked;
+static std::atomic<int> s_output_count;
+
+static int blocking_vprintf(const char *format, va_list args)
+{
+    while (s_output_blocked) {
+    }
+    char line[256];
+    s_output_count++;
+    return vsnprintf(line, sizeof(line), format, args);
+}
+
+TEST_CASE("async log counts messages dropped while the buffer is full")
+{
+    BasicLogFixture fix(ESP_LOG_INFO);
+    vprintf_like_t old_vprintf = esp_log_set_vprintf(blocking_vprintf);
+    s_output_blocked = true;
+    s_output_count = 0;
+    REQUIRE(esp_log_async_start() == ESP_OK);
+
+    const int count = CONFIG_LOG_ASYNC_BUFFER_SIZE / 16;
+    for (int i = 0; i < count; i++) {
+        ESP_LOGI(TEST_TAG, "message %d", i);
+    }
+    esp_log_async_stats_t stats;
+    esp_log_async_get_stats(&stats);
+    CHECK(stats.dropped > 0);
+    CHECK(stats.queued + stats.dropped == count);
+    CHECK(stats.max_used <= CONFIG_LOG_ASYNC_BUFFER_SIZE);
+
+    s_output_blocked = false;
+    CHECK(esp_log_async_flush(1000) == ESP_OK);
+    CHECK(esp_log_async_stop() == ESP_OK);
+    // The writer outputs each message in three parts (prefix, message, end of line), plus the warning about dropped messages
+    CHECK(s_output_count == 3 * (stats.queued + 1));
+    esp_log_set_vprintf(old_vprintf);
+}
+
+static int discard_vprintf(const char *format, va_list args)
+{
+    char line[256];
+    return vsnprintf(line, sizeof(line), format, args);
+}
+
+TEST_CASE("async log latency and throughput")
+{
+    BasicLogFixture fix(ESP_LOG_INFO);
+    vprintf_like_t old_vprintf = esp_log_set_vprintf(discard_vprintf);
+    using clock = std::chrono::steady_clock;
+    const int bursts = 200;
+    const int burst_len = 32; // fits into the buffer, so that no message is dropped
+
+    auto run = [&](bool async) {
+        clock::duration in_calls {};
+        auto start = clock::now();
+        for (int b = 0; b < bursts; b++) {
+            auto burst_start = clock::now();
+            for (int i = 0; i < burst_len; i++) {
+                ESP_LOGI(TEST_TAG, "burst %d message %d value %f %s", b, i, i * 0.5, "text");
+            }
+            in_calls += clock::now() - burst_start;
+            if (async) {
+                REQUIRE(esp_log_async_flush(1000) == ESP_OK);
+            }
+        }
+        auto total = clock::now() - start;
+        double ns_per_call = std::chrono::duration<double, std::nano>(in_calls).count() / (bursts * burst_len);
+        double msg_per_s = bursts * burst_len / std::chrono::duration<double>(total).count();
+        printf("%s: %.0f ns per call, %.0f messages/s\n", async ? "async" : "sync", ns_per_call, msg_per_s);
+    };
+
+    run(false);
+    REQUIRE(esp_log_async_start() == ESP_OK);
+    run(true);
+    esp_log_async_stats_t stats;
+    esp_log_async_get_stats(&stats);
+    CHECK(esp_log_async_stop() == ESP_OK);
+    CHECK(stats.queued == bursts * burst_len);
+    CHECK(stats.dropped == 0);
+    esp_log_set_vprintf(old_vprintf);
+}
+#endif // CONFIG_LOG_ASYNC
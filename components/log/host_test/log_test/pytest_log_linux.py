@@ -18,9 +18,11 @@ from pytest_embedded_idf.utils import idf_parametrize
         'v2_rtos_timestamp',
         'v2_system_full_timestamp',
         'v2_system_timestamp',
+        'v2_async',
         'tag_level_linked_list',
         'tag_level_linked_list_and_array_cache',
         'tag_level_none',
+        'tag_level_interned',
     ],
     indirect=True,
 )
@@ -154,9 +154,9 @@ void esp_log_va(esp_log_config_t config, const char *tag, const char *format, va
 /// runtime macro to output logs at a specified configs. Also check the level with ``LOG_LOCAL_LEVEL``.
 #if ESP_LOG_VERSION == 2
 #if defined(__cplusplus) && (__cplusplus >  201703L)
-#define ESP_LOG_LEVEL_LOCAL(configs, tag, format, ...) do { if (ESP_LOG_ENABLED(configs)) { ESP_LOG_LEVEL(configs, tag, format __VA_OPT__(,) __VA_ARGS__); } } while(0)
+#define ESP_LOG_LEVEL_LOCAL(configs, tag, format, ...) do { if (ESP_LOG_ENABLED(configs) && ESP_LOG_TAG_ENABLED(configs, tag)) { ESP_LOG_LEVEL((configs) | ESP_LOG_TAG_CHECKED_CONFIGS, tag, format __VA_OPT__(,) __VA_ARGS__); } } while(0)
 #else // !(defined(__cplusplus) && (__cplusplus >  201703L))
-#define ESP_LOG_LEVEL_LOCAL(configs, tag, format, ...) do { if (ESP_LOG_ENABLED(configs)) { ESP_LOG_LEVEL(configs, tag, format, ##__VA_ARGS__); } } while(0)
+#define ESP_LOG_LEVEL_LOCAL(configs, tag, format, ...) do { if (ESP_LOG_ENABLED(configs) && ESP_LOG_TAG_ENABLED(configs, tag)) { ESP_LOG_LEVEL((configs) | ESP_LOG_TAG_CHECKED_CONFIGS, tag, format, ##__VA_ARGS__); } } while(0)
 #endif // !(defined(__cplusplus) && (__cplusplus >  201703L))
 #else // ESP_LOG_VERSION == 1
 #if defined(__cplusplus) && (__cplusplus >  201703L)
@@ -13,6 +13,9 @@
 #include "esp_macros.h"
 #include "esp_log_config.h"
 #include "sdkconfig.h"
+#ifdef __cplusplus
+#include <type_traits>
+#endif
 
 /**
  * @file esp_log_args.h
@@ -232,10 +235,11 @@ extern "C++" {
         constexpr static unsigned long long log_type = ESP_LOG_ARGS_TYPE_32BITS;
     };
 
+    // Arrays, such as string literals, are passed to esp_log() as pointers
     template<typename T>
     constexpr unsigned long long ESP_LOG_DETECT_TYPE(const T &)
     {
-        return EspLogArgType<T>::log_type;
+        return EspLogArgType<typename std::decay<T>::type>::log_type;
     }
 }
 #endif // __cplusplus
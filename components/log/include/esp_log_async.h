@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_LOG_ASYNC || __DOXYGEN__
+
+/**
+ * @brief Statistics of the asynchronous log writer, see esp_log_async_get_stats()
+ */
+typedef struct {
+    uint32_t queued;        ///< Number of messages queued since esp_log_async_start()
+    uint32_t dropped;       ///< Number of messages dropped because the buffer of the calling core was full
+    uint32_t synchronous;   ///< Number of messages written synchronously because they couldn't be deferred
+    uint32_t max_used;      ///< Maximum number of bytes used in the buffer of any core
+} esp_log_async_stats_t;
+
+/**
+ * @brief Start deferring log output to a background task.
+ *
+ * Once started, ESP_LOGx calls only copy the tag and format string pointers, the timestamp and the raw values of
+ * the arguments into a lock-free buffer of the calling core (CONFIG_LOG_ASYNC_BUFFER_SIZE bytes per core), and
+ * return. A task of priority CONFIG_LOG_ASYNC_TASK_PRIORITY formats the messages and writes them with the
+ * vprintf-like function set by esp_log_set_vprintf(), in timestamp order.
+ *
+ * The contents of string arguments (``%s``) are copied when the message is queued, so they may point to buffers
+ * which go out of scope. The tag and the format string must remain valid until the message is written, which
+ * holds for string literals. Messages whose arguments don't fit into CONFIG_LOG_ASYNC_ARGS_SIZE bytes or which
+ * use unsupported conversions (``%n``, ``L``) are written synchronously, as are messages logged from constrained
+ * environments (ISR, cache disabled, scheduler not running).
+ *
+ * Messages which may be longer than 255 characters once formatted, as estimated from the format string and the
+ * arguments, are written synchronously too, so they are never truncated. If the buffer is full, the message is
+ * dropped and the number of dropped messages is reported by the writer task as a warning.
+ *
+ * If a panic occurs, the buffered messages are written by the panic handler after the panic information.
+ *
+ * @return
+ *  - ESP_OK on success
+ *  - ESP_ERR_INVALID_STATE if the asynchronous writer is already running
+ *  - ESP_ERR_NO_MEM if the writer task can't be created
+ */
+esp_err_t esp_log_async_start(void);
+
+/**
+ * @brief Stop deferring log output.
+ *
+ * The buffered messages are written, the writer task is deleted and subsequent messages are written synchronously.
+ *
+ * @return
+ *  - ESP_OK on success
+ *  - ESP_ERR_INVALID_STATE if the asynchronous writer isn't running
+ */
+esp_err_t esp_log_async_stop(void);
+
+/**
+ * @brief Wait until all buffered messages have been written.
+ *
+ * Must not be called from the writer task itself, e.g. from a vprintf-like function.
+ *
+ * @param timeout_ms Maximum time to wait, in milliseconds
+ *
+ * @return
+ *  - ESP_OK if all messages queued before the call have been written
+ *  - ESP_ERR_INVALID_STATE if the asynchronous writer isn't running
+ *  - ESP_ERR_TIMEOUT if messages are still buffered after timeout_ms
+ */
+esp_err_t esp_log_async_flush(uint32_t timeout_ms);
+
+/**
+ * @brief Get the statistics of the asynchronous writer.
+ *
+ * @param[out] stats Statistics, summed over the buffers of all cores
+ */
+void esp_log_async_get_stats(esp_log_async_stats_t *stats);
+
+#endif // CONFIG_LOG_ASYNC || __DOXYGEN__
+
+#ifdef __cplusplus
+}
+#endif
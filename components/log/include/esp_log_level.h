@@ -179,6 +179,56 @@ void esp_log_level_set(const char* tag, esp_log_level_t level);
  */
 esp_log_level_t esp_log_level_get(const char* tag);
 
+/** @cond */
+#if CONFIG_LOG_TAG_LEVEL_IMPL_INTERNED && !NON_OS_BUILD
+/**
+ * @brief Per call site binding of a tag to its interned ID (CONFIG_LOG_TAG_LEVEL_IMPL_INTERNED).
+ *
+ * A slot is zero-initialized (unbound) and bound once, to the first non-NULL tag used at the call site.
+ */
+typedef struct {
+    const char *tag;    /*!< Tag pointer the slot is bound to, NULL if unbound */
+    uint16_t id;        /*!< Index of the tag in esp_log_tag_levels, 0 if unbound */
+} esp_log_tag_slot_t;
+
+/**
+ * @brief Levels of the interned tags, indexed by the tag ID. Index 0 holds the default level.
+ */
+extern uint8_t esp_log_tag_levels[];
+
+/**
+ * @brief Intern the tag, bind the slot to it if the slot is unbound, and return the level of the tag.
+ *
+ * Slow path of esp_log_tag_slot_get_level(). If the tag can't be interned, e.g. when the lock isn't obtained in time,
+ * the slot stays unbound and the default level is returned.
+ */
+esp_log_level_t esp_log_tag_slot_bind(esp_log_tag_slot_t *slot, const char *tag);
+
+/**
+ * @brief Get the level of the tag, using the ID the call site slot is bound to.
+ */
+__attribute__((always_inline))
+static inline esp_log_level_t esp_log_tag_slot_get_level(esp_log_tag_slot_t *slot, const char *tag)
+{
+    // The binding stores the ID before the tag, so a matching tag guarantees a valid ID.
+    // An unbound slot matches only a NULL tag, which gets the default level at index 0.
+    if (__builtin_expect(__atomic_load_n(&slot->tag, __ATOMIC_ACQUIRE) == tag, 1)) {
+        return (esp_log_level_t) esp_log_tag_levels[slot->id];
+    }
+    return esp_log_tag_slot_bind(slot, tag);
+}
+
+/// Check the tag level at the call site, using a static slot per call site
+#define ESP_LOG_TAG_ENABLED(configs, tag) (ESP_LOG_CONSTRAINED_ENV || (__extension__({ \
+    static esp_log_tag_slot_t __esp_log_tag_slot; \
+    esp_log_tag_slot_get_level(&__esp_log_tag_slot, (tag)) >= ESP_LOG_GET_LEVEL(configs);})))
+#define ESP_LOG_TAG_CHECKED_CONFIGS ESP_LOG_CONFIG_TAG_CHECKED
+#else
+#define ESP_LOG_TAG_ENABLED(configs, tag) (1)
+#define ESP_LOG_TAG_CHECKED_CONFIGS (0)
+#endif // CONFIG_LOG_TAG_LEVEL_IMPL_INTERNED && !NON_OS_BUILD
+/** @endcond */
+
 #ifdef __cplusplus
 }
 #endif
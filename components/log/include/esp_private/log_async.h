@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_private/log_message.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_LOG_ASYNC
+
+#if CONFIG_IDF_TARGET_LINUX
+#define ESP_LOG_ASYNC_NUM_BUFFERS  1
+#else
+#define ESP_LOG_ASYNC_NUM_BUFFERS  CONFIG_FREERTOS_NUMBER_OF_CORES
+#endif
+
+/* The writer task also polls the buffers at this interval, for messages whose notification it missed */
+#define ESP_LOG_ASYNC_IDLE_WAIT_MS  10
+
+/**
+ * @brief Queue a log message for the asynchronous writer.
+ *
+ * @param message Log message, its arguments are left untouched.
+ *
+ * @return true if the message was queued or dropped, false if it must be written synchronously.
+ */
+bool esp_log_async_write(esp_log_msg_t *message);
+
+/**
+ * @brief Write all buffered messages from the panic handler.
+ *
+ * Messages are written with esp_rom_vprintf() as the output of the application may no longer be usable.
+ */
+void esp_log_async_panic_flush(void);
+
+/**
+ * @brief Write the buffered messages.
+ *
+ * Called by the writer task.
+ *
+ * @return true if at least one message was written.
+ */
+bool esp_log_async_drain(void);
+
+/**
+ * @brief Create the writer task, which calls esp_log_async_drain() until esp_log_async_task_delete() is called.
+ */
+esp_err_t esp_log_async_task_create(void);
+
+/**
+ * @brief Delete the writer task, waiting for it to finish writing the current message.
+ */
+void esp_log_async_task_delete(void);
+
+/**
+ * @brief Wake up the writer task if it waits for messages.
+ */
+void esp_log_async_task_notify(void);
+
+/**
+ * @brief Check if the caller is the writer task.
+ */
+bool esp_log_async_task_is_current(void);
+
+/**
+ * @brief Block the caller briefly, to let the writer task run.
+ */
+void esp_log_async_task_wait(void);
+
+/**
+ * @brief Get the index of the buffer the calling task should queue messages into.
+ */
+unsigned esp_log_async_buffer_index(void);
+
+#endif // CONFIG_LOG_ASYNC
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,6 +7,8 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -105,6 +107,21 @@ void esp_log_util_set_cache_enabled_cb(esp_log_cache_enabled_t func);
  */
 bool esp_log_util_is_constrained(void);
 
+#if CONFIG_IDF_TARGET_LINUX
+/**
+ * @brief Get the link-time address of a string in the read-only data of the executable.
+ *
+ * Used by the binary log format to send such strings as addresses the host decoder resolves from the ELF file,
+ * as the executable may be loaded at any address (PIE).
+ *
+ * @param addr Run-time address.
+ * @param[out] elf_addr Address in the ELF file.
+ *
+ * @return true if the address is in a read-only segment of the executable, false otherwise.
+ */
+bool esp_log_util_get_elf_addr(uintptr_t addr, uintptr_t *elf_addr);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <assert.h>
+#include "esp_private/log_async.h"
+
+static pthread_t s_thread;
+static bool s_thread_valid = false;
+static bool s_thread_run = false;
+static bool s_notified = false;
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+
+static void *log_async_thread(void *arg)
+{
+    (void)arg;
+    while (__atomic_load_n(&s_thread_run, __ATOMIC_ACQUIRE)) {
+        if (esp_log_async_drain()) {
+            continue;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += ESP_LOG_ASYNC_IDLE_WAIT_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&s_mutex);
+        while (!s_notified && __atomic_load_n(&s_thread_run, __ATOMIC_ACQUIRE)) {
+            if (pthread_cond_timedwait(&s_cond, &s_mutex, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        s_notified = false;
+        pthread_mutex_unlock(&s_mutex);
+    }
+    return NULL;
+}
+
+esp_err_t esp_log_async_task_create(void)
+{
+    __atomic_store_n(&s_thread_run, true, __ATOMIC_RELEASE);
+    if (pthread_create(&s_thread, NULL, log_async_thread, NULL) != 0) {
+        __atomic_store_n(&s_thread_run, false, __ATOMIC_RELEASE);
+        return ESP_ERR_NO_MEM;
+    }
+    s_thread_valid = true;
+    return ESP_OK;
+}
+
+void esp_log_async_task_delete(void)
+{
+    __atomic_store_n(&s_thread_run, false, __ATOMIC_RELEASE);
+    esp_log_async_task_notify();
+    int ret = pthread_join(s_thread, NULL);
+    assert(ret == 0);
+    (void)ret;
+    s_thread_valid = false;
+}
+
+void esp_log_async_task_notify(void)
+{
+    pthread_mutex_lock(&s_mutex);
+    s_notified = true;
+    pthread_cond_signal(&s_cond);
+    pthread_mutex_unlock(&s_mutex);
+}
+
+bool esp_log_async_task_is_current(void)
+{
+    return s_thread_valid && pthread_equal(pthread_self(), s_thread);
+}
+
+void esp_log_async_task_wait(void)
+{
+    struct timespec delay = {
+        .tv_sec = 0,
+        .tv_nsec = 20000,
+    };
+    nanosleep(&delay, NULL);
+}
+
+unsigned esp_log_async_buffer_index(void)
+{
+    return 0;
+}
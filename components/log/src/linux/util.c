@@ -1,12 +1,76 @@
 /*
- * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2024-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <stdbool.h>
+#include <stdint.h>
+#include "esp_private/log_util.h"
+#include "sdkconfig.h"
 
 bool esp_log_util_is_constrained(void)
 {
     return false;
 }
+
+#if CONFIG_LOG_MODE_BINARY_EN && defined(__linux__)
+#include <link.h>
+#include <pthread.h>
+
+#define MAX_RODATA_SEGMENTS 4
+
+typedef struct {
+    uintptr_t start;
+    uintptr_t end;
+} segment_t;
+
+static segment_t s_rodata_segments[MAX_RODATA_SEGMENTS];
+static unsigned s_num_rodata_segments;
+static uintptr_t s_load_bias;
+static pthread_once_t s_rodata_once = PTHREAD_ONCE_INIT;
+
+static int find_rodata_segments(struct dl_phdr_info *info, size_t size, void *arg)
+{
+    (void)size;
+    (void)arg;
+    // The first object is the executable
+    s_load_bias = info->dlpi_addr;
+    for (int i = 0; i < info->dlpi_phnum && s_num_rodata_segments < MAX_RODATA_SEGMENTS; i++) {
+        const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+        if (phdr->p_type == PT_LOAD && phdr->p_flags == PF_R) {
+            s_rodata_segments[s_num_rodata_segments].start = info->dlpi_addr + phdr->p_vaddr;
+            s_rodata_segments[s_num_rodata_segments].end = info->dlpi_addr + phdr->p_vaddr + phdr->p_memsz;
+            s_num_rodata_segments++;
+        }
+    }
+    return 1;
+}
+
+static void init_rodata_segments(void)
+{
+    dl_iterate_phdr(find_rodata_segments, NULL);
+}
+
+bool esp_log_util_get_elf_addr(uintptr_t addr, uintptr_t *elf_addr)
+{
+    pthread_once(&s_rodata_once, init_rodata_segments);
+    for (unsigned i = 0; i < s_num_rodata_segments; i++) {
+        if (addr >= s_rodata_segments[i].start && addr < s_rodata_segments[i].end) {
+            *elf_addr = addr - s_load_bias;
+            return true;
+        }
+    }
+    return false;
+}
+#else
+bool esp_log_util_get_elf_addr(uintptr_t addr, uintptr_t *elf_addr)
+{
+    (void)addr;
+    (void)elf_addr;
+    return false;
+}
+#endif // CONFIG_LOG_MODE_BINARY_EN && defined(__linux__)
@@ -18,6 +18,7 @@
 #include "esp_private/log_print.h"
 #include "esp_private/log_message.h"
 #include "esp_private/log_format.h"
+#include "esp_private/log_async.h"
 #include "esp_log_write.h"
 #include "esp_rom_sys.h"
 #include "sdkconfig.h"
@@ -51,7 +52,7 @@ void __attribute__((optimize("-O3"))) esp_log_va(esp_log_config_t config, const
             timestamp = esp_log_timestamp64(config.opts.constrained_env);
         }
 #if !ESP_LOG_CONSTRAINED_ENV
-        if (!config.opts.constrained_env && tag != NULL && !esp_log_is_tag_loggable(config.opts.log_level, tag)) {
+        if (!config.opts.constrained_env && !config.opts.tag_checked && tag != NULL && !esp_log_is_tag_loggable(config.opts.log_level, tag)) {
             return;
         }
 #endif
@@ -63,6 +64,12 @@ void __attribute__((optimize("-O3"))) esp_log_va(esp_log_config_t config, const
             .arg_types = NULL,
         };
         va_copy(message.args, args);
+#if CONFIG_LOG_ASYNC && !NON_OS_BUILD
+        if (!config.opts.constrained_env && esp_log_async_write(&message)) {
+            va_end(message.args);
+            return;
+        }
+#endif // CONFIG_LOG_ASYNC && !NON_OS_BUILD
 #if ESP_LOG_MODE_BINARY_EN
         if (config.opts.binary_mode) {
             message.arg_types = va_arg(message.args, const char *);
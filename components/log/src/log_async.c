@@ -0,0 +1,625 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log_config.h"
+#include "esp_log_level.h"
+#include "esp_log_timestamp.h"
+#include "esp_log_async.h"
+#include "esp_private/log_async.h"
+#include "esp_private/log_format.h"
+#include "esp_private/log_message.h"
+#include "esp_private/log_timestamp.h"
+#include "sdkconfig.h"
+
+/*
+ * Each core has its own buffer of variable-length records. Records are reserved by advancing the head of the buffer
+ * with a compare-and-swap, so tasks and cores never wait for each other, and published by writing the header word
+ * of the record last. Only the writer task consumes records: it writes the oldest committed record among all buffers,
+ * clears it and advances the tail. As cleared memory never looks like a committed header, the writer stops at a
+ * record which is still being filled in.
+ *
+ * A record holds the raw values of the arguments as read with va_arg(). The format string is parsed once when the
+ * message is queued, to know the type of each argument, and once more by the writer, which formats each conversion
+ * with snprintf().
+ */
+
+_Static_assert((CONFIG_LOG_ASYNC_BUFFER_SIZE & (CONFIG_LOG_ASYNC_BUFFER_SIZE - 1)) == 0,
+               "CONFIG_LOG_ASYNC_BUFFER_SIZE must be a power of two");
+
+#define BUFFER_MASK             (CONFIG_LOG_ASYNC_BUFFER_SIZE - 1)
+#define RECORD_ALIGN            8
+#define RECORD_COMMITTED        (1UL << 31)
+#define RECORD_PADDING          (1UL << 30)
+#define RECORD_LEN_MASK         0xFFFF
+#define ALIGN_UP(n, align)      (((n) + (align) - 1) & ~((size_t)(align) - 1))
+
+#define STR_NULL                0xFFFF  // length of a NULL string argument
+#define MAX_SPEC_LEN            16      // longest conversion specification which is deferred, e.g. "%-+08.12lld"
+#define LINE_SIZE               256     // longest formatted message, without the level, timestamp and tag
+#define MAX_DOUBLE_LEN          24      // longest floating-point conversion without width or precision
+#define MAX_FIXED_DOUBLE        1e15    // largest magnitude of a '%f' value which is deferred
+#define NUMBER_LEN(type)        (3 * sizeof(type) + 2)  // longest conversion of an integer of this type, in octal
+
+typedef struct {
+    uint32_t header;            // length of the record | RECORD_* flags, written last
+    esp_log_config_t config;
+    const char *tag;
+    const char *format;
+    uint64_t timestamp;
+    uint8_t args[];
+} log_record_t;
+
+typedef struct {
+    uint32_t head;              // reserved by the callers of esp_log_async_write()
+    uint32_t tail;              // advanced by the writer task
+    uint32_t queued;
+    uint32_t dropped;
+    uint32_t synchronous;
+    uint32_t max_used;
+    uint8_t data[CONFIG_LOG_ASYNC_BUFFER_SIZE] __attribute__((aligned(RECORD_ALIGN)));
+} log_async_buffer_t;
+
+typedef enum {
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_INTMAX,
+    ARG_PTRDIFF,
+    ARG_PTR,
+    ARG_DOUBLE,
+    ARG_STR,
+    ARG_UNSUPPORTED,
+} arg_type_t;
+
+typedef struct {
+    const char *start;          // '%'
+    const char *end;            // past the conversion character
+    arg_type_t type;
+    uint8_t stars;              // number of '*' width and precision arguments preceding the value
+    bool star_precision;        // the precision is the last '*' argument
+    int width;                  // literal width, 0 if none
+    int precision;              // literal precision, -1 if none
+} conversion_t;
+
+static log_async_buffer_t s_buffers[ESP_LOG_ASYNC_NUM_BUFFERS];
+static bool s_running;
+static uint32_t s_dropped_reported;
+static char s_line[LINE_SIZE];
+
+static bool next_conversion(const char **format, conversion_t *conv)
+{
+    const char *p = *format;
+    while (*p) {
+        if (*p++ != '%') {
+            continue;
+        }
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+        conv->start = p - 1;
+        conv->stars = 0;
+        conv->star_precision = false;
+        conv->width = 0;
+        conv->precision = -1;
+
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+            p++;
+        }
+        if (*p == '*') {
+            conv->stars++;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                conv->width = conv->width * 10 + (*p++ - '0');
+            }
+        }
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                conv->stars++;
+                conv->star_precision = true;
+                p++;
+            } else {
+                conv->precision = 0;
+                while (*p >= '0' && *p <= '9') {
+                    conv->precision = conv->precision * 10 + (*p++ - '0');
+                }
+            }
+        }
+
+        int longs = 0;
+        char modifier = 0;
+        while (1) {
+            if (*p == 'l') {
+                longs++;
+            } else if (*p == 'z' || *p == 'j' || *p == 't' || *p == 'L' || *p == 'q') {
+                modifier = *p;
+            } else if (*p != 'h') {
+                break;
+            }
+            p++;
+        }
+
+        switch (*p) {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            if (longs == 1) {
+                conv->type = ARG_LONG;
+            } else if (longs >= 2 || modifier == 'q') {
+                conv->type = ARG_LLONG;
+            } else if (modifier == 'z') {
+                conv->type = ARG_SIZE;
+            } else if (modifier == 'j') {
+                conv->type = ARG_INTMAX;
+            } else if (modifier == 't') {
+                conv->type = ARG_PTRDIFF;
+            } else {
+                conv->type = ARG_INT;
+            }
+            break;
+        case 'c':
+            conv->type = ARG_INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            conv->type = (modifier == 'L') ? ARG_UNSUPPORTED : ARG_DOUBLE;
+            break;
+        case 's':
+            conv->type = (longs != 0) ? ARG_UNSUPPORTED : ARG_STR;
+            break;
+        case 'p':
+            conv->type = ARG_PTR;
+            break;
+        default: // '%n', wide strings and malformed specifications
+            conv->type = ARG_UNSUPPORTED;
+            break;
+        }
+        if (*p) {
+            p++;
+        }
+        conv->end = p;
+        *format = p;
+        return true;
+    }
+    *format = p;
+    return false;
+}
+
+static bool put_arg(uint8_t *args, size_t *len, const void *value, size_t size)
+{
+    size_t offset = ALIGN_UP(*len, size);
+    if (offset + size > CONFIG_LOG_ASYNC_ARGS_SIZE) {
+        return false;
+    }
+    memcpy(&args[offset], value, size);
+    *len = offset + size;
+    return true;
+}
+
+static const uint8_t *get_arg(const uint8_t *args, size_t *len, size_t size)
+{
+    size_t offset = ALIGN_UP(*len, size);
+    *len = offset + size;
+    return &args[offset];
+}
+
+#define PUT_ARG(type) ({ type v = va_arg(ap, type); put_arg(args, len, &v, sizeof(v)); })
+
+/*
+ * Copy the arguments of the message into 'args', returns false if they can't be deferred.
+ *
+ * The messages which may not fit into LINE_SIZE once formatted aren't deferred either, so the writer never
+ * truncates them. Their length is estimated from the format string and the arguments without formatting them.
+ */
+static bool encode_args(const char *format, va_list ap, uint8_t *args, size_t *len)
+{
+    size_t line_len = 0;
+    const char *literal = format;
+    conversion_t conv;
+    while (next_conversion(&format, &conv)) {
+        if (conv.type == ARG_UNSUPPORTED || conv.end - conv.start > MAX_SPEC_LEN) {
+            return false;
+        }
+        int star = 0;
+        size_t width = conv.width;
+        for (int i = 0; i < conv.stars; i++) {
+            star = va_arg(ap, int);
+            if (!put_arg(args, len, &star, sizeof(star))) {
+                return false;
+            }
+            if (i == 0 && !(conv.stars == 1 && conv.star_precision)) {
+                width = (star < 0) ? 0U - (unsigned)star : (unsigned)star;
+            }
+        }
+        int precision = conv.star_precision ? star : conv.precision;
+        size_t value_len = (precision > 0) ? precision : 0;
+        bool ok;
+        switch (conv.type) {
+        case ARG_INT:       ok = PUT_ARG(int); value_len += NUMBER_LEN(int); break;
+        case ARG_LONG:      ok = PUT_ARG(long); value_len += NUMBER_LEN(long); break;
+        case ARG_LLONG:     ok = PUT_ARG(long long); value_len += NUMBER_LEN(long long); break;
+        case ARG_SIZE:      ok = PUT_ARG(size_t); value_len += NUMBER_LEN(size_t); break;
+        case ARG_INTMAX:    ok = PUT_ARG(intmax_t); value_len += NUMBER_LEN(intmax_t); break;
+        case ARG_PTRDIFF:   ok = PUT_ARG(ptrdiff_t); value_len += NUMBER_LEN(ptrdiff_t); break;
+        case ARG_PTR:       ok = PUT_ARG(void *); value_len += NUMBER_LEN(void *); break;
+        case ARG_DOUBLE: {
+            double v = va_arg(ap, double);
+            char conversion = conv.end[-1];
+            if (conversion == 'f' || conversion == 'F') {
+                // The integer part of a fixed-point value is printed in full
+                if ((v < 0 ? -v : v) >= MAX_FIXED_DOUBLE) {
+                    return false;
+                }
+                value_len += (precision < 0) ? 6 : 0;
+            }
+            value_len += MAX_DOUBLE_LEN;
+            ok = put_arg(args, len, &v, sizeof(v));
+            break;
+        }
+        case ARG_STR: {
+            const char *str = va_arg(ap, const char *);
+            if (*len + sizeof(uint16_t) + 1 > CONFIG_LOG_ASYNC_ARGS_SIZE) {
+                return false;
+            }
+            size_t room = CONFIG_LOG_ASYNC_ARGS_SIZE - *len - sizeof(uint16_t) - 1;
+            uint16_t str_len = STR_NULL;
+            if (str != NULL) {
+                size_t max_len = (precision >= 0 && (size_t)precision <= room) ? (size_t)precision : room + 1;
+                str_len = strnlen(str, max_len);
+                if (str_len > room) {
+                    return false; // written synchronously rather than truncated
+                }
+            }
+            memcpy(&args[*len], &str_len, sizeof(str_len));
+            *len += sizeof(str_len);
+            if (str != NULL) {
+                memcpy(&args[*len], str, str_len);
+                args[*len + str_len] = '\0';
+                *len += str_len + 1;
+            }
+            value_len = (str != NULL) ? str_len : sizeof("(null)") - 1;
+            ok = true;
+            break;
+        }
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok) {
+            return false;
+        }
+        line_len += (conv.start - literal) + ((width > value_len) ? width : value_len);
+        if (line_len >= LINE_SIZE) {
+            return false;
+        }
+        literal = conv.end;
+    }
+    return line_len + strlen(literal) < LINE_SIZE;
+}
+
+#define FORMAT_ARG(type) ({ type v; memcpy(&v, get_arg(args, &len, sizeof(v)), sizeof(v)); snprintf(out, room, spec, v); })
+
+/* Format a queued message into 'line', the counterpart of encode_args() */
+static void format_args(const char *format, const uint8_t *args, char *line, size_t size)
+{
+    size_t pos = 0;
+    size_t len = 0;
+    const char *literal = format;
+    conversion_t conv;
+    while (pos < size - 1) {
+        bool more = next_conversion(&format, &conv);
+        const char *literal_end = more ? conv.start : format;
+        for (const char *p = literal; p < literal_end && pos < size - 1; p++) {
+            line[pos++] = *p;
+            if (p[0] == '%' && p[1] == '%') {
+                p++;
+            }
+        }
+        if (!more || pos >= size - 1) {
+            break;
+        }
+        literal = conv.end;
+
+        char spec[MAX_SPEC_LEN + 2 * 11 + 1];
+        size_t spec_len = 0;
+        for (const char *p = conv.start; p < conv.end; p++) {
+            if (*p == '*') {
+                int star;
+                memcpy(&star, get_arg(args, &len, sizeof(star)), sizeof(star));
+                spec_len += sprintf(&spec[spec_len], "%d", star);
+            } else {
+                spec[spec_len++] = *p;
+            }
+        }
+        spec[spec_len] = '\0';
+
+        char *out = &line[pos];
+        size_t room = size - pos;
+        int ret;
+        switch (conv.type) {
+        case ARG_INT:       ret = FORMAT_ARG(int); break;
+        case ARG_LONG:      ret = FORMAT_ARG(long); break;
+        case ARG_LLONG:     ret = FORMAT_ARG(long long); break;
+        case ARG_SIZE:      ret = FORMAT_ARG(size_t); break;
+        case ARG_INTMAX:    ret = FORMAT_ARG(intmax_t); break;
+        case ARG_PTRDIFF:   ret = FORMAT_ARG(ptrdiff_t); break;
+        case ARG_PTR:       ret = FORMAT_ARG(void *); break;
+        case ARG_DOUBLE:    ret = FORMAT_ARG(double); break;
+        case ARG_STR: {
+            uint16_t str_len;
+            memcpy(&str_len, &args[len], sizeof(str_len));
+            len += sizeof(str_len);
+            const char *str = NULL;
+            if (str_len != STR_NULL) {
+                str = (const char *)&args[len];
+                len += str_len + 1;
+            }
+            ret = snprintf(out, room, spec, str);
+            break;
+        }
+        default:
+            ret = 0;
+            break;
+        }
+        if (ret > 0) {
+            pos += ((size_t)ret < room) ? (size_t)ret : room - 1;
+        }
+    }
+    line[pos] = '\0';
+}
+
+static bool buffer_reserve(log_async_buffer_t *buffer, uint32_t len, uint32_t *pos, bool *was_empty)
+{
+    uint32_t head = __atomic_load_n(&buffer->head, __ATOMIC_RELAXED);
+    uint32_t tail, padding, new_head;
+    do {
+        tail = __atomic_load_n(&buffer->tail, __ATOMIC_ACQUIRE);
+        uint32_t offset = head & BUFFER_MASK;
+        // A record never wraps around the end of the buffer, the remaining space is skipped instead
+        padding = (offset + len > CONFIG_LOG_ASYNC_BUFFER_SIZE) ? CONFIG_LOG_ASYNC_BUFFER_SIZE - offset : 0;
+        new_head = head + padding + len;
+        if (new_head - tail > CONFIG_LOG_ASYNC_BUFFER_SIZE) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&buffer->head, &head, new_head, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    if (padding) {
+        uint32_t *padding_header = (uint32_t *)&buffer->data[head & BUFFER_MASK];
+        __atomic_store_n(padding_header, padding | RECORD_PADDING | RECORD_COMMITTED, __ATOMIC_RELEASE);
+    }
+    uint32_t used = new_head - tail;
+    if (used > __atomic_load_n(&buffer->max_used, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&buffer->max_used, used, __ATOMIC_RELAXED);
+    }
+    *was_empty = (head == tail);
+    *pos = (head + padding) & BUFFER_MASK;
+    return true;
+}
+
+/* Oldest record of the buffer, NULL if the buffer is empty or the record isn't committed yet */
+static log_record_t *buffer_peek(log_async_buffer_t *buffer)
+{
+    while (1) {
+        uint32_t tail = buffer->tail;
+        if (tail == __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE)) {
+            return NULL;
+        }
+        log_record_t *record = (log_record_t *)&buffer->data[tail & BUFFER_MASK];
+        uint32_t header = __atomic_load_n(&record->header, __ATOMIC_ACQUIRE);
+        if (!(header & RECORD_COMMITTED)) {
+            return NULL;
+        }
+        if (!(header & RECORD_PADDING)) {
+            return record;
+        }
+        uint32_t len = header & RECORD_LEN_MASK;
+        memset(record, 0, len);
+        __atomic_store_n(&buffer->tail, tail + len, __ATOMIC_RELEASE);
+    }
+}
+
+static void buffer_release(log_async_buffer_t *buffer, log_record_t *record)
+{
+    uint32_t len = record->header & RECORD_LEN_MASK;
+    memset(record, 0, len);
+    __atomic_store_n(&buffer->tail, buffer->tail + len, __ATOMIC_RELEASE);
+}
+
+static void log_async_output(esp_log_config_t config, const char *tag, uint64_t timestamp, const char *format, ...)
+{
+    esp_log_msg_t message = {
+        .config = config,
+        .tag = tag,
+        .format = format,
+        .timestamp = timestamp,
+        .arg_types = NULL,
+    };
+    va_start(message.args, format);
+    esp_log_format(&message);
+    va_end(message.args);
+}
+
+static void report_dropped(bool panic)
+{
+    uint32_t dropped = 0;
+    for (int i = 0; i < ESP_LOG_ASYNC_NUM_BUFFERS; i++) {
+        dropped += __atomic_load_n(&s_buffers[i].dropped, __ATOMIC_RELAXED);
+    }
+    if (dropped == s_dropped_reported) {
+        return;
+    }
+    esp_log_config_t config = {
+        .opts = {
+            .log_level = ESP_LOG_WARN,
+            .constrained_env = panic,
+            .require_formatting = true,
+            .dis_color = ESP_LOG_COLOR_DISABLED,
+            .dis_timestamp = ESP_LOG_TIMESTAMP_DISABLED,
+            .binary_mode = false,
+            .reserved = 0,
+        }
+    };
+    log_async_output(config, "log", esp_log_timestamp64(panic), "%" PRIu32 " messages dropped, the buffer was full",
+                     dropped - s_dropped_reported);
+    s_dropped_reported = dropped;
+}
+
+/* Write the oldest queued message, returns false if there is none */
+static bool drain_one(bool panic)
+{
+    log_async_buffer_t *buffer = NULL;
+    log_record_t *record = NULL;
+    for (int i = 0; i < ESP_LOG_ASYNC_NUM_BUFFERS; i++) {
+        log_record_t *candidate = buffer_peek(&s_buffers[i]);
+        if (candidate != NULL && (record == NULL || candidate->timestamp < record->timestamp)) {
+            buffer = &s_buffers[i];
+            record = candidate;
+        }
+    }
+    if (record == NULL) {
+        return false;
+    }
+    format_args(record->format, record->args, s_line, sizeof(s_line));
+    esp_log_config_t config = record->config;
+    config.opts.constrained_env = panic;
+    log_async_output(config, record->tag, record->timestamp, "%s", s_line);
+    buffer_release(buffer, record);
+    return true;
+}
+
+bool esp_log_async_write(esp_log_msg_t *message)
+{
+    if (!__atomic_load_n(&s_running, __ATOMIC_RELAXED)) {
+        return false;
+    }
+    log_async_buffer_t *buffer = &s_buffers[esp_log_async_buffer_index()];
+
+    uint8_t args[CONFIG_LOG_ASYNC_ARGS_SIZE] __attribute__((aligned(RECORD_ALIGN)));
+    size_t args_len = 0;
+    va_list ap;
+    va_copy(ap, message->args);
+    bool deferred = encode_args(message->format, ap, args, &args_len);
+    va_end(ap);
+    if (!deferred) {
+        __atomic_fetch_add(&buffer->synchronous, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    uint32_t len = ALIGN_UP(sizeof(log_record_t) + args_len, RECORD_ALIGN);
+    uint32_t pos;
+    bool was_empty;
+    if (!buffer_reserve(buffer, len, &pos, &was_empty)) {
+        __atomic_fetch_add(&buffer->dropped, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+    log_record_t *record = (log_record_t *)&buffer->data[pos];
+    record->config = message->config;
+    record->tag = message->tag;
+    record->format = message->format;
+    record->timestamp = message->timestamp;
+    memcpy(record->args, args, args_len);
+    __atomic_store_n(&record->header, len | RECORD_COMMITTED, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&buffer->queued, 1, __ATOMIC_RELAXED);
+
+    if (was_empty) {
+        esp_log_async_task_notify();
+    }
+    return true;
+}
+
+bool esp_log_async_drain(void)
+{
+    bool written = false;
+    while (drain_one(false)) {
+        written = true;
+    }
+    report_dropped(false);
+    return written;
+}
+
+void esp_log_async_panic_flush(void)
+{
+    while (drain_one(true)) {
+    }
+    report_dropped(true);
+}
+
+esp_err_t esp_log_async_start(void)
+{
+    if (__atomic_load_n(&s_running, __ATOMIC_ACQUIRE)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (int i = 0; i < ESP_LOG_ASYNC_NUM_BUFFERS; i++) {
+        s_buffers[i].queued = 0;
+        s_buffers[i].dropped = 0;
+        s_buffers[i].synchronous = 0;
+        s_buffers[i].max_used = 0;
+    }
+    s_dropped_reported = 0;
+    esp_err_t err = esp_log_async_task_create();
+    if (err != ESP_OK) {
+        return err;
+    }
+    __atomic_store_n(&s_running, true, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+esp_err_t esp_log_async_stop(void)
+{
+    if (!__atomic_exchange_n(&s_running, false, __ATOMIC_ACQ_REL)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_log_async_task_delete();
+    esp_log_async_drain();
+    return ESP_OK;
+}
+
+esp_err_t esp_log_async_flush(uint32_t timeout_ms)
+{
+    if (!__atomic_load_n(&s_running, __ATOMIC_ACQUIRE) || esp_log_async_task_is_current()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t heads[ESP_LOG_ASYNC_NUM_BUFFERS];
+    for (int i = 0; i < ESP_LOG_ASYNC_NUM_BUFFERS; i++) {
+        heads[i] = __atomic_load_n(&s_buffers[i].head, __ATOMIC_ACQUIRE);
+    }
+    esp_log_async_task_notify();
+    uint32_t start = esp_log_timestamp();
+    while (1) {
+        bool flushed = true;
+        for (int i = 0; i < ESP_LOG_ASYNC_NUM_BUFFERS; i++) {
+            flushed &= (int32_t)(__atomic_load_n(&s_buffers[i].tail, __ATOMIC_ACQUIRE) - heads[i]) >= 0;
+        }
+        if (flushed) {
+            return ESP_OK;
+        }
+        if (esp_log_timestamp() - start >= timeout_ms) {
+            return ESP_ERR_TIMEOUT;
+        }
+        esp_log_async_task_wait();
+    }
+}
+
+void esp_log_async_get_stats(esp_log_async_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < ESP_LOG_ASYNC_NUM_BUFFERS; i++) {
+        stats->queued += __atomic_load_n(&s_buffers[i].queued, __ATOMIC_RELAXED);
+        stats->dropped += __atomic_load_n(&s_buffers[i].dropped, __ATOMIC_RELAXED);
+        stats->synchronous += __atomic_load_n(&s_buffers[i].synchronous, __ATOMIC_RELAXED);
+        uint32_t max_used = __atomic_load_n(&s_buffers[i].max_used, __ATOMIC_RELAXED);
+        if (max_used > stats->max_used) {
+            stats->max_used = max_used;
+        }
+    }
+}
@@ -26,7 +26,8 @@
 #define IS_LOCATED_IN_NOLOAD_SECTION(addr) (((addr) & 0xFF000000) == 0x00000000)
 
 #if CONFIG_IDF_TARGET_LINUX
-#define PRESENT_IN_ELF(addr) (false)
+// The executable may be loaded at any address, so strings in its read-only data are sent as link-time addresses
+#define PRESENT_IN_ELF(addr) (esp_log_util_get_elf_addr((addr), &(addr)))
 #else // !CONFIG_IDF_TARGET_LINUX
 #if BOOTLOADER_BUILD
 #define PRESENT_IN_ELF(addr) ( \
@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * This file implements interned log tags. Each distinct tag string gets a dense
+ * numeric ID the first time it is used, either by a log call site or by
+ * esp_log_level_set(). The levels of the interned tags are stored in the
+ * esp_log_tag_levels array, indexed by ID.
+ *
+ * Every ESP_LOGx call site owns a static esp_log_tag_slot_t, which is bound to
+ * the tag pointer and its ID on the first call (esp_log_tag_slot_bind()). The
+ * following calls compare the tag pointer with the one of the slot and read the
+ * level byte at the ID, without locking (esp_log_tag_slot_get_level()).
+ *
+ * The tag names are copied, and found by their contents in an open addressing
+ * hash table. The hash table is only used under the log lock: when a call site
+ * is bound, when the level of a tag is set and when the level of a tag is
+ * requested by esp_log_level_get() or by the log calls which don't go through
+ * a call site slot (esp_log_write(), ESP_LOG_LEVEL()). Interned tags are never
+ * removed, so that the IDs stored in the slots stay valid.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log_level.h"
+#include "esp_private/log_lock.h"
+#include "esp_private/log_util.h"
+#include "log_interned.h"
+#include "sdkconfig.h"
+
+#define MAX_TAGS    (CONFIG_LOG_TAG_LEVEL_INTERNED_MAX_TAGS)
+// At most half of the hash table is used, which keeps the probe sequences short and always finds an empty entry
+#define HASH_SIZE   (2 * MAX_TAGS)
+
+uint8_t esp_log_tag_levels[MAX_TAGS + 1] = { CONFIG_LOG_DEFAULT_LEVEL };
+
+static const char *s_tag_names[MAX_TAGS + 1];   // indexed by ID, s_tag_names[0] is unused
+static uint16_t s_hash_table[HASH_SIZE];        // IDs of the tags, 0 for empty entries
+static uint16_t s_num_tags;
+
+static inline uint32_t tag_hash(const char *tag)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*tag) {
+        hash = (hash ^ (uint8_t)*tag++) * 16777619u;
+    }
+    return hash;
+}
+
+/* Returns the ID of the tag, or 0 with the hash table index to insert it at */
+static uint16_t find_tag(const char *tag, uint32_t *insert_index)
+{
+    uint32_t index = tag_hash(tag) % HASH_SIZE;
+    uint16_t id;
+    while ((id = s_hash_table[index]) != 0) {
+        if (strcmp(s_tag_names[id], tag) == 0) {
+            return id;
+        }
+        index = (index + 1) % HASH_SIZE;
+    }
+    *insert_index = index;
+    return 0;
+}
+
+/* Returns the ID of the tag, interning it with the given level if needed. Returns 0 if the tag can't be interned. */
+static uint16_t intern_tag(const char *tag, esp_log_level_t level)
+{
+    uint32_t insert_index;
+    uint16_t id = find_tag(tag, &insert_index);
+    if (id != 0 || s_num_tags == MAX_TAGS) {
+        return id;
+    }
+    char *name = strdup(tag);
+    if (name == NULL) {
+        return 0;
+    }
+    id = ++s_num_tags;
+    s_tag_names[id] = name;
+    esp_log_tag_levels[id] = level;
+    s_hash_table[insert_index] = id;
+    return id;
+}
+
+esp_log_level_t esp_log_tag_slot_bind(esp_log_tag_slot_t *slot, const char *tag)
+{
+    esp_log_level_t level = esp_log_get_default_level();
+    if (tag == NULL || esp_log_util_is_constrained() || esp_log_impl_lock_timeout() == false) {
+        return level;
+    }
+    uint16_t id = intern_tag(tag, level);
+    if (id != 0) {
+        level = (esp_log_level_t) esp_log_tag_levels[id];
+        if (slot->tag == NULL) {
+            // Publish the ID before the tag, see esp_log_tag_slot_get_level()
+            slot->id = id;
+            __atomic_store_n(&slot->tag, tag, __ATOMIC_RELEASE);
+        }
+    }
+    esp_log_impl_unlock();
+    return level;
+}
+
+bool esp_log_interned_set_level(const char *tag, esp_log_level_t level)
+{
+    uint16_t id = intern_tag(tag, level);
+    if (id == 0) {
+        return false;
+    }
+    esp_log_tag_levels[id] = level;
+    return true;
+}
+
+bool esp_log_interned_get_level(const char *tag, esp_log_level_t *level)
+{
+    uint32_t insert_index;
+    uint16_t id = find_tag(tag, &insert_index);
+    if (id == 0) {
+        return false;
+    }
+    *level = (esp_log_level_t) esp_log_tag_levels[id];
+    return true;
+}
+
+void esp_log_interned_reset(esp_log_level_t level)
+{
+    memset(esp_log_tag_levels, level, s_num_tags + 1);
+}
@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include <stdbool.h>
+#include "esp_log_level.h"
+
+/**
+ * @brief Set the log level for a specific log tag, interning the tag if it
+ * isn't interned yet.
+ *
+ * Must be called with the log lock held.
+ *
+ * @param tag The log tag for which to set the log level.
+ * @param level The log level to be set for the specified log tag.
+ * @return true   If the log level was successfully set or updated,
+ *         false  If the tag table is full or memory for the tag name can't be allocated.
+ */
+bool esp_log_interned_set_level(const char *tag, esp_log_level_t level);
+
+/**
+ * @brief Get the log level for a specific log tag, without interning it.
+ *
+ * Must be called with the log lock held.
+ *
+ * @param tag The log tag for which to retrieve the log level.
+ * @param level Pointer to a variable where the retrieved log level will be
+ * stored.
+ * @return true  if the tag is interned and its level was retrieved,
+ *         false if the tag is not interned.
+ */
+bool esp_log_interned_get_level(const char *tag, esp_log_level_t *level);
+
+/**
+ * @brief Set the level of all interned tags and the default level of the call
+ * sites with a NULL tag.
+ *
+ * The interned tags are kept, as call sites may be bound to their IDs.
+ * Must be called with the log lock held.
+ *
+ * @param level The log level to be set for all tags.
+ */
+void esp_log_interned_reset(esp_log_level_t level);
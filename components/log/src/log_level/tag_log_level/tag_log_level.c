@@ -18,6 +18,10 @@
 #include "linked_list/log_linked_list.h"
 #endif
 
+#if CONFIG_LOG_TAG_LEVEL_IMPL_INTERNED
+#include "interned/log_interned.h"
+#endif
+
 #if CONFIG_LOG_TAG_LEVEL_CACHE_ARRAY || CONFIG_LOG_TAG_LEVEL_CACHE_BINARY_MIN_HEAP
 #define CACHE_ENABLED 1
 #include "cache/log_cache.h"
@@ -37,6 +41,15 @@ static inline void log_level_set(const char *tag, esp_log_level_t level)
         return;
     }
     esp_log_impl_lock();
+#if CONFIG_LOG_TAG_LEVEL_IMPL_INTERNED
+    // for wildcard tag, set the level of all interned tags, they keep their IDs
+    if (strcmp(tag, "*") == 0) {
+        esp_log_set_default_level(level);
+        esp_log_interned_reset(level);
+    } else {
+        esp_log_interned_set_level(tag, level);
+    }
+#else
     // for wildcard tag, remove all linked list items and clear the cache
     if (strcmp(tag, "*") == 0) {
         esp_log_set_default_level(level);
@@ -52,6 +65,7 @@ static inline void log_level_set(const char *tag, esp_log_level_t level)
         }
 #endif
     }
+#endif // !CONFIG_LOG_TAG_LEVEL_IMPL_INTERNED
     esp_log_impl_unlock();
 }
 
@@ -68,7 +82,9 @@ static esp_log_level_t log_level_get(const char *tag, bool timeout)
     } else {
         esp_log_impl_lock();
     }
-#if CACHE_ENABLED
+#if CONFIG_LOG_TAG_LEVEL_IMPL_INTERNED
+    esp_log_interned_get_level(tag, &level_for_tag);
+#elif CACHE_ENABLED
     bool cache_miss = !esp_log_cache_get_level(tag, &level_for_tag);
     if (cache_miss) {
         esp_log_linked_list_get_level(tag, &level_for_tag);
@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_private/log_async.h"
+#include "sdkconfig.h"
+
+static TaskHandle_t s_task = NULL;
+static volatile bool s_task_run = false;
+
+static void log_async_task(void *arg)
+{
+    (void)arg;
+    while (s_task_run) {
+        if (!esp_log_async_drain()) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ESP_LOG_ASYNC_IDLE_WAIT_MS));
+        }
+    }
+    s_task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t esp_log_async_task_create(void)
+{
+    s_task_run = true;
+    if (xTaskCreate(log_async_task, "log_async", CONFIG_LOG_ASYNC_TASK_STACK_SIZE, NULL,
+                    CONFIG_LOG_ASYNC_TASK_PRIORITY, &s_task) != pdPASS) {
+        s_task_run = false;
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void esp_log_async_task_delete(void)
+{
+    s_task_run = false;
+    while (s_task != NULL) {
+        xTaskNotifyGive(s_task);
+        vTaskDelay(1);
+    }
+}
+
+void esp_log_async_task_notify(void)
+{
+    TaskHandle_t task = s_task;
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+bool esp_log_async_task_is_current(void)
+{
+    return s_task != NULL && xTaskGetCurrentTaskHandle() == s_task;
+}
+
+void esp_log_async_task_wait(void)
+{
+    // The writer task usually has a lower priority than the caller, so yielding isn't enough
+    vTaskDelay(1);
+}
+
+unsigned esp_log_async_buffer_index(void)
+{
+    return esp_cpu_get_core_id();
+}
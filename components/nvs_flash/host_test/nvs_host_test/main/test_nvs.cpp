@@ -18,8 +18,11 @@
 #include <string.h>
 #include <string>
 #include <random>
+#include <vector>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <chrono>
 #include "test_fixtures.hpp"
 #include "spi_flash_mmap.h"
 
@@ -336,9 +339,9 @@ TEST_CASE("Page validates blob size", "[nvs]")
 
 class HashListTestHelper : public nvs::HashList {
 public:
-    size_t getBlockCount()
+    size_t getCapacity()
     {
-        return mBlockList.size();
+        return mCapacity;
     }
 };
 
@@ -346,9 +349,9 @@ TEST_CASE("HashList is cleaned up as soon as items are erased", "[nvs]")
 {
     // TC verifies that HashList is cleaned up as soon as items are erased.
     // The test verifies following:
-    // - adding items increases the block count
-    // - removing items decreases the block count
-    // - adding items again after removing them increases the block count again
+    // - adding items increases the capacity
+    // - removing items releases the memory
+    // - adding items again after removing them increases the capacity again
     // - removing items in the same order works
 
     HashListTestHelper hashlist;
@@ -361,13 +364,14 @@ TEST_CASE("HashList is cleaned up as soon as items are erased", "[nvs]")
         nvs::Item item(1, nvs::ItemType::U32, 1, key);
         hashlist.insert(item, i);
     }
-    INFO("Added " << count << " items, " << hashlist.getBlockCount() << " blocks");
+    INFO("Added " << count << " items, " << hashlist.getCapacity() << " nodes allocated");
     // Remove them in reverse order
     for (size_t i = count; i > 0; --i) {
         // Make sure that the element existed before it's erased
         CHECK(hashlist.erase(i - 1) == true);
     }
-    CHECK(hashlist.getBlockCount() == 0);
+    CHECK(hashlist.getCapacity() == 0);
+    CHECK(hashlist.getHeapUsage() == 0);
     // Add again
     for (size_t i = 0; i < count; ++i) {
         char key[16];
@@ -375,12 +379,13 @@ TEST_CASE("HashList is cleaned up as soon as items are erased", "[nvs]")
         nvs::Item item(1, nvs::ItemType::U32, 1, key);
         hashlist.insert(item, i);
     }
-    INFO("Added " << count << " items, " << hashlist.getBlockCount() << " blocks");
+    INFO("Added " << count << " items, " << hashlist.getCapacity() << " nodes allocated");
     // Remove them in the same order
     for (size_t i = 0; i < count; ++i) {
         CHECK(hashlist.erase(i) == true);
     }
-    CHECK(hashlist.getBlockCount() == 0);
+    CHECK(hashlist.getCapacity() == 0);
+    CHECK(hashlist.getHeapUsage() == 0);
 }
 
 TEST_CASE("can init PageManager in empty flash", "[nvs]")
@@ -2184,6 +2189,168 @@ TEST_CASE("Reading multi-page blobs", "[nvs]")
     TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
 }
 
+// Concatenates the spans of a view, returns the number of spans
+static size_t read_blob_view(nvs_blob_view_t view, std::vector<uint8_t>& out)
+{
+    const nvs_blob_span_t* spans = nullptr;
+    size_t span_count = 0;
+    out.clear();
+    TEST_ESP_OK(nvs_blob_view_get_spans(view, &spans, &span_count));
+    for (size_t i = 0; i < span_count; ++i) {
+        const uint8_t* data = static_cast<const uint8_t*>(spans[i].data);
+        out.insert(out.end(), data, data + spans[i].size);
+    }
+    return span_count;
+}
+
+TEST_CASE("nvs_get_blob_view maps blobs and strings without copying", "[nvs][blob_view]")
+{
+    // TC verifies that views of blob and string values point to the memory mapped partition.
+    // The test verifies following:
+    // - a multi-page blob is returned as one span per chunk, in order
+    // - strings and empty blobs are returned as a single span
+    // - a view of an overwritten blob returns the new value
+    // - missing keys and invalid arguments are reported without creating a view
+
+    TEST_ESP_OK(nvs_flash_erase_partition(TEST_DEFAULT_PARTITION_NAME));
+    TEST_ESP_OK(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME));
+
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open_from_partition(TEST_DEFAULT_PARTITION_NAME, "viewTest", NVS_READWRITE, &handle));
+
+    std::vector<uint8_t> blob(nvs::Page::CHUNK_MAX_SIZE * 2 + 100);
+    for (size_t i = 0; i < blob.size(); ++i) {
+        blob[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    const char str[] = "calibration v1";
+    TEST_ESP_OK(nvs_set_blob(handle, "calib", blob.data(), blob.size()));
+    TEST_ESP_OK(nvs_set_str(handle, "name", str));
+    TEST_ESP_OK(nvs_set_blob(handle, "empty", blob.data(), 0));
+
+    nvs_blob_view_t view;
+    std::vector<uint8_t> data;
+    TEST_ESP_OK(nvs_get_blob_view(handle, "calib", &view));
+    CHECK(nvs_blob_view_is_mapped(view));
+    CHECK(read_blob_view(view, data) >= 3);
+    CHECK(data == blob);
+    nvs_release_blob_view(view);
+
+    TEST_ESP_OK(nvs_get_str_view(handle, "name", &view));
+    CHECK(nvs_blob_view_is_mapped(view));
+    CHECK(read_blob_view(view, data) == 1);
+    CHECK(data.size() == sizeof(str));
+    CHECK(memcmp(data.data(), str, sizeof(str)) == 0);
+    nvs_release_blob_view(view);
+
+    TEST_ESP_OK(nvs_get_blob_view(handle, "empty", &view));
+    CHECK(read_blob_view(view, data) == 1);
+    CHECK(data.empty());
+    nvs_release_blob_view(view);
+
+    blob.resize(500);
+    blob[0] ^= 0xff;
+    TEST_ESP_OK(nvs_set_blob(handle, "calib", blob.data(), blob.size()));
+    TEST_ESP_OK(nvs_get_blob_view(handle, "calib", &view));
+    CHECK(read_blob_view(view, data) == 1);
+    CHECK(data == blob);
+    nvs_release_blob_view(view);
+
+    view = reinterpret_cast<nvs_blob_view_t>(&data);
+    TEST_ESP_ERR(nvs_get_blob_view(handle, "missing", &view), ESP_ERR_NVS_NOT_FOUND);
+    CHECK(view == nullptr);
+    TEST_ESP_ERR(nvs_get_str_view(handle, "calib", &view), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(nvs_get_blob_view(handle, nullptr, &view), ESP_ERR_INVALID_ARG);
+    TEST_ESP_ERR(nvs_get_blob_view(handle, "calib", nullptr), ESP_ERR_INVALID_ARG);
+    nvs_release_blob_view(nullptr);
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
+}
+
+// Partition which refuses memory mapping, like encrypted partitions or block devices do
+class NVSUnmappablePartitionTestHelper : public NVSPartitionTestHelper {
+public:
+    NVSUnmappablePartitionTestHelper(const char *part_name) : NVSPartitionTestHelper(part_name) { }
+
+    esp_err_t mmap(size_t src_offset, size_t size, const void** out_ptr, uint32_t* out_handle) override
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+};
+
+static void check_storage_item_views(NVSPartitionTestHelper& h, bool expect_mapped)
+{
+    // a blob in the format without blob index, written directly to the first page
+    uint8_t legacy[100];
+    memset(legacy, 0x5a, sizeof(legacy));
+    {
+        nvs::Page p;
+        TEST_ESP_OK(p.load(&h, 0));
+        TEST_ESP_OK(p.writeItem(1, nvs::ItemType::BLOB, "legacy", legacy, sizeof(legacy)));
+    }
+
+    nvs::Storage storage(&h);
+    TEST_ESP_OK(storage.init(0, h.get_sectors()));
+
+    std::vector<uint8_t> blob(nvs::Page::CHUNK_MAX_SIZE + 1000, 0xa5);
+    TEST_ESP_OK(storage.writeItem(1, nvs::ItemType::BLOB, "blob", blob.data(), blob.size(), TEST_DEFAULT_PURGE_AFTER_ERASE));
+
+    std::vector<uint8_t> data;
+    {
+        nvs_opaque_blob_view_t view;
+        TEST_ESP_OK(storage.getItemView(1, nvs::ItemType::BLOB, "blob", view));
+        CHECK(nvs_blob_view_is_mapped(&view) == expect_mapped);
+        CHECK(read_blob_view(&view, data) == (expect_mapped ? 2 : 1));
+        CHECK(data == blob);
+    }
+    {
+        nvs_opaque_blob_view_t view;
+        TEST_ESP_OK(storage.getItemView(1, nvs::ItemType::BLOB, "legacy", view));
+        CHECK(nvs_blob_view_is_mapped(&view) == expect_mapped);
+        CHECK(read_blob_view(&view, data) == 1);
+        CHECK(data == std::vector<uint8_t>(legacy, legacy + sizeof(legacy)));
+    }
+    {
+        nvs_opaque_blob_view_t view;
+        TEST_ESP_ERR(storage.getItemView(1, nvs::ItemType::BLOB, "missing", view), ESP_ERR_NVS_NOT_FOUND);
+    }
+}
+
+TEST_CASE("blob view maps the data if the partition supports it", "[nvs][blob_view]")
+{
+    NVSPartitionTestHelper h(TEST_DEFAULT_PARTITION_NAME);
+    check_storage_item_views(h, true);
+}
+
+TEST_CASE("blob view falls back to a copy if the partition can't be mapped", "[nvs][blob_view]")
+{
+    NVSUnmappablePartitionTestHelper h(TEST_DEFAULT_PARTITION_NAME);
+    check_storage_item_views(h, false);
+}
+
+TEST_CASE("blob view of a corrupted chunk is not returned", "[nvs][blob_view]")
+{
+    // TC verifies that the CRC of mapped data is checked the same way as for copied data
+    NVSPartitionTestHelper h(TEST_DEFAULT_PARTITION_NAME);
+    nvs::Storage storage(&h);
+    TEST_ESP_OK(storage.init(0, h.get_sectors()));
+
+    const char str[] = "some string value";
+    TEST_ESP_OK(storage.writeItem(1, nvs::ItemType::SZ, "str", str, sizeof(str), TEST_DEFAULT_PURGE_AFTER_ERASE));
+
+    // flip a bit in the data entry following the header of the string, which is the first entry of the first page
+    uint8_t entry[32];
+    const size_t data_offset = NVS_CONST_PAGE_ENTRY_DATA_OFFSET + nvs::Page::ENTRY_SIZE;
+    TEST_ESP_OK(h.read_raw(data_offset, entry, sizeof(entry)));
+    entry[0] &= 0xfe;
+    TEST_ESP_OK(h.write_raw(data_offset, entry, sizeof(entry)));
+
+    nvs_opaque_blob_view_t view;
+    TEST_ESP_ERR(storage.getItemView(1, nvs::ItemType::SZ, "str", view), ESP_ERR_NVS_NOT_FOUND);
+    size_t size;
+    TEST_ESP_ERR(storage.getItemDataSize(1, nvs::ItemType::SZ, "str", size), ESP_ERR_NVS_NOT_FOUND);
+}
+
 TEST_CASE("Modification of values for Multi-page blobs are supported", "[nvs]")
 {
     // TC verifies that NVS API works as expected when modifying multi-page blobs.
@@ -5521,6 +5688,515 @@ TEST_CASE("nvs multiple write with same key float then double", "[nvs]")
     TEST_ESP_OK(nvs_flash_deinit_partition(TEST_3SEC_PARTITION_NAME));
 }
 
+// Writes the profile used by the batch tests, generation selects the old or the new values
+static void set_batch_test_profile(nvs_handle_t handle, uint8_t generation, bool batched)
+{
+    char key[16];
+    char str[41];
+    uint8_t blob[40];
+
+    for (uint32_t i = 0; i < 20; ++i) {
+        snprintf(key, sizeof(key), "k%02u", static_cast<unsigned>(i));
+        const uint32_t value = i * 10 + generation;
+        if (batched) {
+            TEST_ESP_OK(nvs_batch_set(handle, NVS_TYPE_U32, key, &value, sizeof(value)));
+        } else {
+            TEST_ESP_OK(nvs_set_u32(handle, key, value));
+        }
+    }
+    // data entries starting with 0xffffffff must not stop the recovery of an interrupted batch
+    for (uint32_t i = 0; i < 5; ++i) {
+        snprintf(key, sizeof(key), "s%u", static_cast<unsigned>(i));
+        memset(str, 0xff, sizeof(str));
+        str[sizeof(str) - 2] = '0' + generation;
+        str[sizeof(str) - 1] = 0;
+        if (batched) {
+            TEST_ESP_OK(nvs_batch_set(handle, NVS_TYPE_STR, key, str, 0));
+        } else {
+            TEST_ESP_OK(nvs_set_str(handle, key, str));
+        }
+    }
+    for (uint32_t i = 0; i < 5; ++i) {
+        snprintf(key, sizeof(key), "b%u", static_cast<unsigned>(i));
+        memset(blob, 0xff, sizeof(blob));
+        blob[sizeof(blob) - 1] = generation;
+        if (batched) {
+            TEST_ESP_OK(nvs_batch_set(handle, NVS_TYPE_BLOB, key, blob, sizeof(blob)));
+        } else {
+            TEST_ESP_OK(nvs_set_blob(handle, key, blob, sizeof(blob)));
+        }
+    }
+}
+
+// Returns the generation of the profile if all values belong to the same one, 0 otherwise
+static uint8_t get_batch_test_profile_generation(nvs_handle_t handle)
+{
+    char key[16];
+    char str[41];
+    uint8_t blob[40];
+    size_t size;
+    uint8_t generation = 0;
+
+    auto check = [&generation](uint8_t found) -> bool {
+        if (generation == 0) {
+            generation = found;
+        }
+        return generation == found;
+    };
+
+    for (uint32_t i = 0; i < 20; ++i) {
+        snprintf(key, sizeof(key), "k%02u", static_cast<unsigned>(i));
+        uint32_t value;
+        if (nvs_get_u32(handle, key, &value) != ESP_OK || !check(value - i * 10)) {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < 5; ++i) {
+        snprintf(key, sizeof(key), "s%u", static_cast<unsigned>(i));
+        size = sizeof(str);
+        if (nvs_get_str(handle, key, str, &size) != ESP_OK || !check(str[sizeof(str) - 2] - '0')) {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < 5; ++i) {
+        snprintf(key, sizeof(key), "b%u", static_cast<unsigned>(i));
+        size = sizeof(blob);
+        if (nvs_get_blob(handle, key, blob, &size) != ESP_OK || !check(blob[sizeof(blob) - 1])) {
+            return 0;
+        }
+    }
+    return generation;
+}
+
+TEST_CASE("nvs batch stages values and writes them on commit", "[nvs][batch]")
+{
+    TEST_ESP_OK(nvs_flash_erase_partition(TEST_DEFAULT_PARTITION_NAME));
+    TEST_ESP_OK(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME));
+
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open_from_partition(TEST_DEFAULT_PARTITION_NAME, "batch", NVS_READWRITE, &handle));
+
+    // staging requires a batch in progress
+    uint8_t u8 = 1;
+    TEST_ESP_ERR(nvs_batch_set(handle, NVS_TYPE_U8, "u8", &u8, sizeof(u8)), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_ERR(nvs_batch_commit(handle), ESP_ERR_NVS_INVALID_STATE);
+
+    TEST_ESP_OK(nvs_batch_begin(handle));
+    TEST_ESP_ERR(nvs_batch_begin(handle), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_ERR(nvs_batch_set(handle, NVS_TYPE_ANY, "u8", &u8, sizeof(u8)), ESP_ERR_INVALID_ARG);
+    TEST_ESP_ERR(nvs_batch_set(handle, NVS_TYPE_U8, "u8", &u8, sizeof(uint16_t)), ESP_ERR_INVALID_ARG);
+    TEST_ESP_ERR(nvs_batch_set(handle, NVS_TYPE_U8, "a_very_long_key_name", &u8, sizeof(u8)), ESP_ERR_NVS_KEY_TOO_LONG);
+
+    // the values of the batch have to fit into a single page
+    static uint8_t big[nvs::Page::CHUNK_MAX_SIZE];
+    TEST_ESP_ERR(nvs_batch_set(handle, NVS_TYPE_BLOB, "big", big, sizeof(big)), ESP_ERR_NVS_VALUE_TOO_LONG);
+
+    set_batch_test_profile(handle, 1, true);
+    // staging the same key again replaces the staged value
+    TEST_ESP_OK(nvs_batch_set(handle, NVS_TYPE_U8, "u8", &u8, sizeof(u8)));
+    u8 = 2;
+    TEST_ESP_OK(nvs_batch_set(handle, NVS_TYPE_U8, "u8", &u8, sizeof(u8)));
+
+    // staged values are not visible before the commit
+    TEST_ESP_ERR(nvs_get_u8(handle, "u8", &u8), ESP_ERR_NVS_NOT_FOUND);
+    CHECK(get_batch_test_profile_generation(handle) == 0);
+
+    TEST_ESP_OK(nvs_batch_commit(handle));
+    TEST_ESP_OK(nvs_get_u8(handle, "u8", &u8));
+    CHECK(u8 == 2);
+    CHECK(get_batch_test_profile_generation(handle) == 1);
+
+    // update existing values, the type of a key may change within the batch as well
+    TEST_ESP_OK(nvs_batch_begin(handle));
+    set_batch_test_profile(handle, 2, true);
+    const char str[] = "now a string";
+    TEST_ESP_OK(nvs_batch_set(handle, NVS_TYPE_STR, "u8", str, 0));
+    TEST_ESP_OK(nvs_batch_commit(handle));
+    CHECK(get_batch_test_profile_generation(handle) == 2);
+    TEST_ESP_ERR(nvs_get_u8(handle, "u8", &u8), ESP_ERR_NVS_NOT_FOUND);
+    char out[sizeof(str)];
+    size_t size = sizeof(out);
+    TEST_ESP_OK(nvs_get_str(handle, "u8", out, &size));
+    CHECK(strcmp(out, str) == 0);
+
+    // an aborted batch leaves the storage untouched
+    nvs_stats_t before;
+    nvs_stats_t after;
+    TEST_ESP_OK(nvs_get_stats(TEST_DEFAULT_PARTITION_NAME, &before));
+    TEST_ESP_OK(nvs_batch_begin(handle));
+    set_batch_test_profile(handle, 3, true);
+    TEST_ESP_OK(nvs_batch_abort(handle));
+    TEST_ESP_ERR(nvs_batch_abort(handle), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_OK(nvs_get_stats(TEST_DEFAULT_PARTITION_NAME, &after));
+    CHECK(get_batch_test_profile_generation(handle) == 2);
+    CHECK(before.used_entries == after.used_entries);
+
+    // only the old values are erased, the values written by the batch remain after re-initialization
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
+    TEST_ESP_OK(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME));
+    TEST_ESP_OK(nvs_open_from_partition(TEST_DEFAULT_PARTITION_NAME, "batch", NVS_READWRITE, &handle));
+    CHECK(get_batch_test_profile_generation(handle) == 2);
+    TEST_ESP_OK(nvs_get_stats(TEST_DEFAULT_PARTITION_NAME, &after));
+    CHECK(before.used_entries == after.used_entries);
+    nvs_close(handle);
+
+    // read only handles can't stage values
+    TEST_ESP_OK(nvs_open_from_partition(TEST_DEFAULT_PARTITION_NAME, "batch", NVS_READONLY, &handle));
+    TEST_ESP_ERR(nvs_batch_begin(handle), ESP_ERR_NVS_READ_ONLY);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
+}
+
+TEST_CASE("nvs batch commit is all-or-nothing across power loss", "[nvs][batch]")
+{
+    // TC emulates power loss at every flash word written by the commit and checks that after re-initialization
+    // either all old or all new values of the batch are present.
+    // The old values are placed on the page of the batch as well as on the preceding page.
+    for (bool crossPage : {false, true}) {
+        bool committed = false;
+        for (size_t failAfter = 0; !committed; ++failAfter) {
+            TEST_ESP_OK(nvs_flash_erase_partition(TEST_DEFAULT_PARTITION_NAME));
+            TEST_ESP_OK(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME));
+
+            nvs_handle_t handle;
+            TEST_ESP_OK(nvs_open_from_partition(TEST_DEFAULT_PARTITION_NAME, "batch", NVS_READWRITE, &handle));
+            set_batch_test_profile(handle, 1, false);
+            if (crossPage) {
+                // leaves less space on the page than the batch needs
+                static char filler[2000];
+                memset(filler, 'f', sizeof(filler) - 1);
+                TEST_ESP_OK(nvs_set_str(handle, "filler", filler));
+            }
+
+            TEST_ESP_OK(nvs_batch_begin(handle));
+            set_batch_test_profile(handle, 2, true);
+            NVSPartitionTestHelper::fail_after(failAfter, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+            committed = (nvs_batch_commit(handle) == ESP_OK);
+            NVSPartitionTestHelper::fail_after(SIZE_MAX, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+            nvs_close(handle);
+            TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
+
+            TEST_ESP_OK(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME));
+            TEST_ESP_OK(nvs_open_from_partition(TEST_DEFAULT_PARTITION_NAME, "batch", NVS_READWRITE, &handle));
+            const uint8_t generation = get_batch_test_profile_generation(handle);
+            INFO("power loss after " << failAfter << " words, cross page " << crossPage);
+            CHECK(generation != 0);
+            if (committed) {
+                CHECK(generation == 2);
+            }
+            nvs_close(handle);
+            TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
+        }
+    }
+}
+
+TEST_CASE("benchmark batch commit against individual writes", "[nvs][batch]")
+{
+    // TC compares the flash operations needed to update a profile of 30 keys
+    size_t ops[2][3];
+    uint64_t time[2];
+    for (bool batched : {false, true}) {
+        TEST_ESP_OK(nvs_flash_erase_partition(TEST_DEFAULT_PARTITION_NAME));
+        TEST_ESP_OK(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME));
+
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open_from_partition(TEST_DEFAULT_PARTITION_NAME, "batch", NVS_READWRITE, &handle));
+        set_batch_test_profile(handle, 1, false);
+
+        NVSPartitionTestHelper::clear_stats();
+        if (batched) {
+            TEST_ESP_OK(nvs_batch_begin(handle));
+            set_batch_test_profile(handle, 2, true);
+            TEST_ESP_OK(nvs_batch_commit(handle));
+        } else {
+            set_batch_test_profile(handle, 2, false);
+        }
+        ops[batched][0] = NVSPartitionTestHelper::get_read_ops();
+        ops[batched][1] = NVSPartitionTestHelper::get_write_ops();
+        ops[batched][2] = NVSPartitionTestHelper::get_erase_ops();
+        time[batched] = NVSPartitionTestHelper::get_total_time();
+
+        CHECK(get_batch_test_profile_generation(handle) == 2);
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
+    }
+
+    // the batch writes all entries at once and alters their states word by word
+    CHECK(ops[true][1] < ops[false][1]);
+
+    s_perf << "Update of 30 keys: individual writes " << time[false] << " us (" << ops[false][2] << "E " << ops[false][1] << "W " << ops[false][0] << "R), "
+           << "batch " << time[true] << " us (" << ops[true][2] << "E " << ops[true][1] << "W " << ops[true][0] << "R)" << std::endl;
+}
+
+struct CompactionRunStats {
+    size_t maxSetTime = 0;
+    size_t maxMoveStepTime = 0;
+    size_t maxStepEraseOps = 0;
+    size_t setsWithErase = 0;
+    size_t steps = 0;
+};
+
+static void run_compaction_workload(bool compact, size_t budget, CompactionRunStats& stats)
+{
+    const size_t SETTING_KEY_COUNT = 40;
+    const size_t COUNTER_KEY_COUNT = 8;
+    const size_t SETTING_UPDATE_PERIOD = 16;
+    const size_t WRITES = 3000;
+    std::vector<size_t> settingGeneration(SETTING_KEY_COUNT, 0);
+    char key[16];
+    char value[64];
+
+    TEST_ESP_OK(nvs_flash_erase_partition(TEST_DEFAULT_PARTITION_NAME));
+    TEST_ESP_OK(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME));
+
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open_from_partition(TEST_DEFAULT_PARTITION_NAME, "compact", NVS_READWRITE, &handle));
+
+    // Longer living strings are spread over all the pages, these have to be moved whenever a page is reclaimed
+    for (size_t i = 0; i < SETTING_KEY_COUNT; ++i) {
+        snprintf(key, sizeof(key), "setting_%u", static_cast<unsigned>(i));
+        snprintf(value, sizeof(value), "value of setting %u, generation 0", static_cast<unsigned>(i));
+        TEST_ESP_OK(nvs_set_str(handle, key, value));
+    }
+
+    for (size_t i = 0; i < WRITES; ++i) {
+        NVSPartitionTestHelper::clear_stats();
+        if (i % SETTING_UPDATE_PERIOD == 0) {
+            size_t setting = (i / SETTING_UPDATE_PERIOD) % SETTING_KEY_COUNT;
+            ++settingGeneration[setting];
+            snprintf(key, sizeof(key), "setting_%u", static_cast<unsigned>(setting));
+            snprintf(value, sizeof(value), "value of setting %u, generation %u", static_cast<unsigned>(setting),
+                     static_cast<unsigned>(settingGeneration[setting]));
+            TEST_ESP_OK(nvs_set_str(handle, key, value));
+        } else {
+            snprintf(key, sizeof(key), "cnt_%u", static_cast<unsigned>(i % COUNTER_KEY_COUNT));
+            TEST_ESP_OK(nvs_set_u32(handle, key, static_cast<uint32_t>(i)));
+        }
+        stats.maxSetTime = std::max(stats.maxSetTime, NVSPartitionTestHelper::get_total_time());
+        if (NVSPartitionTestHelper::get_erase_ops() > 0) {
+            ++stats.setsWithErase;
+        }
+
+        if (compact) {
+            NVSPartitionTestHelper::clear_stats();
+            esp_err_t err = nvs_compact_step(TEST_DEFAULT_PARTITION_NAME, budget);
+            CHECK((err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND));
+            if (err == ESP_OK) {
+                ++stats.steps;
+                if (NVSPartitionTestHelper::get_erase_ops() == 0) {
+                    stats.maxMoveStepTime = std::max(stats.maxMoveStepTime, NVSPartitionTestHelper::get_total_time());
+                }
+                stats.maxStepEraseOps = std::max(stats.maxStepEraseOps, NVSPartitionTestHelper::get_erase_ops());
+            }
+        }
+    }
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
+
+    // No item may be lost or duplicated by moving it
+    TEST_ESP_OK(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME));
+    TEST_ESP_OK(nvs_open_from_partition(TEST_DEFAULT_PARTITION_NAME, "compact", NVS_READONLY, &handle));
+    for (size_t i = 0; i < COUNTER_KEY_COUNT; ++i) {
+        snprintf(key, sizeof(key), "cnt_%u", static_cast<unsigned>(i));
+        size_t last = WRITES - 1;
+        while (last % COUNTER_KEY_COUNT != i || last % SETTING_UPDATE_PERIOD == 0) {
+            --last;
+        }
+        uint32_t counter;
+        TEST_ESP_OK(nvs_get_u32(handle, key, &counter));
+        CHECK(counter == last);
+    }
+    for (size_t i = 0; i < SETTING_KEY_COUNT; ++i) {
+        char expected[64];
+        size_t length = sizeof(value);
+        snprintf(key, sizeof(key), "setting_%u", static_cast<unsigned>(i));
+        snprintf(expected, sizeof(expected), "value of setting %u, generation %u", static_cast<unsigned>(i),
+                 static_cast<unsigned>(settingGeneration[i]));
+        TEST_ESP_OK(nvs_get_str(handle, key, value, &length));
+        CHECK(strcmp(value, expected) == 0);
+    }
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
+}
+
+TEST_CASE("incremental compaction keeps page erases out of the foreground writes", "[nvs][compact]")
+{
+    // TC verifies that calling nvs_compact_step() between the writes bounds the latency of the writes.
+    // Without the compaction the writes have to reclaim a page synchronously from time to time, i.e. to copy
+    // all the items of a page and to erase it. With the compaction no write erases a page and the worst write
+    // is considerably faster. A compaction step either moves the items within the budget or erases one page.
+    const size_t BUDGET = 8;
+
+    CompactionRunStats syncStats;
+    run_compaction_workload(false, BUDGET, syncStats);
+    CHECK(syncStats.setsWithErase > 0);
+
+    CompactionRunStats compactStats;
+    run_compaction_workload(true, BUDGET, compactStats);
+    CHECK(compactStats.steps > 0);
+    CHECK(compactStats.setsWithErase == 0);
+    CHECK(compactStats.maxSetTime * 2 < syncStats.maxSetTime);
+    CHECK(compactStats.maxStepEraseOps == 1);
+    CHECK(compactStats.maxMoveStepTime * 2 < syncStats.maxSetTime);
+
+    s_perf << "Worst write latency with " << syncStats.setsWithErase << " synchronous page reclaims: " << syncStats.maxSetTime
+           << " us, with incremental compaction (budget " << BUDGET << ", " << compactStats.steps << " steps): "
+           << compactStats.maxSetTime << " us, worst step moving items " << compactStats.maxMoveStepTime << " us" << std::endl;
+}
+
+TEST_CASE("nvs_compact_step reports invalid arguments and idle partitions", "[nvs][compact]")
+{
+    TEST_ESP_ERR(nvs_compact_step(TEST_DEFAULT_PARTITION_NAME, 8), ESP_ERR_NVS_NOT_INITIALIZED);
+
+    TEST_ESP_OK(nvs_flash_erase_partition(TEST_DEFAULT_PARTITION_NAME));
+    TEST_ESP_OK(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME));
+    TEST_ESP_ERR(nvs_compact_step(TEST_DEFAULT_PARTITION_NAME, 0), ESP_ERR_INVALID_ARG);
+    // An empty partition has enough free pages
+    TEST_ESP_ERR(nvs_compact_step(TEST_DEFAULT_PARTITION_NAME, 8), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME));
+}
+
+#ifdef CONFIG_NVS_GLOBAL_KEY_INDEX
+// Exposes both lookup paths of the Storage, the partition-wide key index and the per-page search
+class KeyIndexStorageTestHelper : public nvs::Storage {
+public:
+    KeyIndexStorageTestHelper(nvs::Partition *partition) : nvs::Storage(partition) { }
+
+    esp_err_t findIndexed(uint8_t nsIndex, nvs::ItemType datatype, const char* key, nvs::Page* &page, size_t &itemIndex)
+    {
+        nvs::Item item;
+        return findItem(nsIndex, datatype, key, page, item, nvs::Page::CHUNK_ANY, nvs::VerOffset::VER_ANY, &itemIndex);
+    }
+
+    esp_err_t findPerPage(uint8_t nsIndex, nvs::ItemType datatype, const char* key, nvs::Page* &page, size_t &itemIndex)
+    {
+        nvs::Item item;
+        for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
+            size_t tmpItemIndex = 0;
+            if (it->findItem(nsIndex, datatype, key, tmpItemIndex, item) == ESP_OK) {
+                page = it;
+                itemIndex = tmpItemIndex;
+                return ESP_OK;
+            }
+        }
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    const nvs::KeyIndex& getKeyIndex()
+    {
+        return mPageManager.getKeyIndex();
+    }
+};
+
+TEST_CASE("key index stays in sync with pages on write, erase and page reclaim", "[nvs][key_index]")
+{
+    // TC verifies that the partition-wide key index resolves every key to the same page and entry as the per-page search
+    // after the keys were overwritten, erased and relocated by the page reclaim.
+    NVSPartitionTestHelper h(TEST_DEFAULT_PARTITION_NAME);
+    const bool purgeAfterErase = TEST_DEFAULT_PURGE_AFTER_ERASE;
+    const size_t KEY_COUNT = 200;
+    char key[16];
+
+    {
+        KeyIndexStorageTestHelper storage(&h);
+        TEST_ESP_OK(storage.init(0, h.get_sectors()));
+
+        // Overwriting the keys several times forces the reclaim of pages
+        for (uint32_t round = 0; round < 8; ++round) {
+            for (size_t i = 0; i < KEY_COUNT; ++i) {
+                snprintf(key, sizeof(key), "key_%u", static_cast<unsigned>(i));
+                TEST_ESP_OK(storage.writeItem(1, key, static_cast<uint32_t>(i + round), purgeAfterErase));
+            }
+            for (size_t i = round; i < KEY_COUNT; i += 16) {
+                snprintf(key, sizeof(key), "key_%u", static_cast<unsigned>(i));
+                TEST_ESP_OK(storage.eraseItem(1, key, purgeAfterErase));
+            }
+        }
+        CHECK(storage.getKeyIndex().isValid());
+
+        for (size_t i = 0; i < KEY_COUNT; ++i) {
+            snprintf(key, sizeof(key), "key_%u", static_cast<unsigned>(i));
+            nvs::Page* indexedPage = nullptr;
+            nvs::Page* scannedPage = nullptr;
+            size_t indexedItemIndex = 0;
+            size_t scannedItemIndex = 0;
+            esp_err_t indexedErr = storage.findIndexed(1, nvs::ItemType::U32, key, indexedPage, indexedItemIndex);
+            esp_err_t scannedErr = storage.findPerPage(1, nvs::ItemType::U32, key, scannedPage, scannedItemIndex);
+            CAPTURE(i);
+            CHECK(indexedErr == scannedErr);
+            if (indexedErr == ESP_OK) {
+                CHECK(indexedPage == scannedPage);
+                CHECK(indexedItemIndex == scannedItemIndex);
+            }
+        }
+    }
+
+    // The index rebuilt during the load has to deliver the same results
+    KeyIndexStorageTestHelper storage(&h);
+    TEST_ESP_OK(storage.init(0, h.get_sectors()));
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+        snprintf(key, sizeof(key), "key_%u", static_cast<unsigned>(i));
+        uint32_t value;
+        const bool erasedInLastRound = (i >= 7) && ((i - 7) % 16 == 0);
+        CAPTURE(i);
+        TEST_ESP_ERR(storage.readItem(1, key, value), erasedInLastRound ? ESP_ERR_NVS_NOT_FOUND : ESP_OK);
+        if (!erasedInLastRound) {
+            CHECK(value == i + 7);
+        }
+    }
+}
+
+TEST_CASE("benchmark key index lookup against per-page lookup", "[nvs][key_index]")
+{
+    // TC measures the lookup latency of keys spread over the whole partition using the key index and the per-page search
+    NVSPartitionTestHelper h(TEST_DEFAULT_PARTITION_NAME);
+    const bool purgeAfterErase = TEST_DEFAULT_PURGE_AFTER_ERASE;
+    const size_t KEY_COUNT = 600;
+    const size_t LOOKUP_ROUNDS = 20;
+    char key[16];
+
+    KeyIndexStorageTestHelper storage(&h);
+    TEST_ESP_OK(storage.init(0, h.get_sectors()));
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+        snprintf(key, sizeof(key), "cfg_%u", static_cast<unsigned>(i));
+        TEST_ESP_OK(storage.writeItem(1, key, static_cast<uint32_t>(i), purgeAfterErase));
+    }
+
+    auto measure = [&](bool indexed, size_t &readOps) -> int64_t {
+        NVSPartitionTestHelper::clear_stats();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < LOOKUP_ROUNDS; ++round) {
+            for (size_t i = 0; i < KEY_COUNT; ++i) {
+                snprintf(key, sizeof(key), "cfg_%u", static_cast<unsigned>(i));
+                nvs::Page* page = nullptr;
+                size_t itemIndex = 0;
+                esp_err_t err = indexed ? storage.findIndexed(1, nvs::ItemType::U32, key, page, itemIndex)
+                                        : storage.findPerPage(1, nvs::ItemType::U32, key, page, itemIndex);
+                REQUIRE(err == ESP_OK);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        readOps = NVSPartitionTestHelper::get_read_ops();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    };
+
+    size_t perPageReadOps = 0;
+    size_t indexedReadOps = 0;
+    int64_t perPageTime = measure(false, perPageReadOps);
+    int64_t indexedTime = measure(true, indexedReadOps);
+
+    // Both paths read the matching entry, the per-page search additionally has to read the entries of all pages
+    // preceding the one holding the key whose hash collides with the searched one. The index must never be worse.
+    CHECK(indexedReadOps <= perPageReadOps);
+
+    s_perf << "Lookup of " << KEY_COUNT << " keys x " << LOOKUP_ROUNDS << " rounds, "
+           << storage.getKeyIndex().size() << " indexed items: per-page " << perPageTime << " us (" << perPageReadOps << "R), "
+           << "key index " << indexedTime << " us (" << indexedReadOps << "R)" << std::endl;
+}
+#endif // CONFIG_NVS_GLOBAL_KEY_INDEX
+
 // Add new tests above
 // This test has to be the final one
 
@@ -8,9 +8,17 @@
 #include "nvs_flash.h"
 #include "nvs_handle_simple.hpp"
 #include "nvs_partition_manager.hpp"
+#include "nvs_page.hpp"
+#include "esp_partition.h"
+#include "sdkconfig.h"
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
 
 using namespace std;
 
@@ -195,3 +203,152 @@ TEST_CASE("NVSHandleSimple CXX api read/write blob", "[nvs cxx]")
 
     nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME);
 }
+
+#ifdef CONFIG_NVS_CONCURRENT_READS
+TEST_CASE("NVSHandleLocked CXX api concurrent reads stress", "[nvs cxx][concurrent_reads]")
+{
+    // TC reads keys from a growing number of threads while one thread keeps overwriting them.
+    // Every value carries the index of its key and a generation, the blob consists of the generation only.
+    // The readers check that no value is torn and that the generations don't go backwards,
+    // the read throughput for each thread count is printed.
+    const size_t KEY_COUNT = 32;
+    const size_t BLOB_SIZE = 64;
+    const auto MEASURE_TIME = std::chrono::milliseconds(200);
+    const size_t MAX_THREADS = 8;
+
+    REQUIRE(nvs_flash_erase_partition(TEST_DEFAULT_PARTITION_NAME) == ESP_OK);
+    REQUIRE(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME) == ESP_OK);
+
+    esp_err_t result;
+    shared_ptr<nvs::NVSHandle> writer = nvs::open_nvs_handle_from_partition(TEST_DEFAULT_PARTITION_NAME, "stress", NVS_READWRITE, &result);
+    REQUIRE(result == ESP_OK);
+
+    char key[16];
+    uint8_t blob[BLOB_SIZE];
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+        snprintf(key, sizeof(key), "key_%u", static_cast<unsigned>(i));
+        REQUIRE(writer->set_item(key, static_cast<uint32_t>(i)) == ESP_OK);
+    }
+    memset(blob, 0, sizeof(blob));
+    REQUIRE(writer->set_blob("blob", blob, sizeof(blob)) == ESP_OK);
+    REQUIRE(writer->commit() == ESP_OK);
+
+    vector<shared_ptr<nvs::NVSHandle>> readers;
+    for (size_t i = 0; i < MAX_THREADS; ++i) {
+        readers.push_back(nvs::open_nvs_handle_from_partition(TEST_DEFAULT_PARTITION_NAME, "stress", NVS_READONLY, &result));
+        REQUIRE(result == ESP_OK);
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> errors(0);
+    std::atomic<size_t> writes(0);
+    std::thread writerThread([&]() {
+        char writerKey[16];
+        uint8_t writerBlob[BLOB_SIZE];
+        for (uint32_t generation = 1; !stop.load(); ++generation) {
+            size_t i = generation % KEY_COUNT;
+            snprintf(writerKey, sizeof(writerKey), "key_%u", static_cast<unsigned>(i));
+            if (writer->set_item(writerKey, (generation << 8) | static_cast<uint32_t>(i)) != ESP_OK) {
+                ++errors;
+            }
+            if (i == 0) {
+                memset(writerBlob, generation & 0xff, sizeof(writerBlob));
+                if (writer->set_blob("blob", writerBlob, sizeof(writerBlob)) != ESP_OK) {
+                    ++errors;
+                }
+            }
+            ++writes;
+            // occasional writes, the readers are the hot path
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    for (size_t threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+        std::atomic<size_t> reads(0);
+        std::atomic<bool> measuring(true);
+        vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                char readerKey[16];
+                uint8_t readerBlob[BLOB_SIZE];
+                uint32_t lastGeneration[KEY_COUNT] = {};
+                size_t count = 0;
+                for (size_t n = t; measuring.load(); ++n) {
+                    size_t i = n % KEY_COUNT;
+                    snprintf(readerKey, sizeof(readerKey), "key_%u", static_cast<unsigned>(i));
+                    uint32_t value;
+                    if (readers[t]->get_item(readerKey, value) != ESP_OK || (value & 0xff) != i
+                            || (value >> 8) < lastGeneration[i]) {
+                        ++errors;
+                    }
+                    lastGeneration[i] = value >> 8;
+                    if (i == 0) {
+                        if (readers[t]->get_blob("blob", readerBlob, sizeof(readerBlob)) != ESP_OK) {
+                            ++errors;
+                        }
+                        for (size_t b = 1; b < BLOB_SIZE; ++b) {
+                            if (readerBlob[b] != readerBlob[0]) {
+                                ++errors;
+                                break;
+                            }
+                        }
+                    }
+                    ++count;
+                }
+                reads += count;
+            });
+        }
+        std::this_thread::sleep_for(MEASURE_TIME);
+        measuring = false;
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        CHECK(reads.load() > 0);
+        cout << "Concurrent reads, " << threadCount << " thread(s): "
+             << reads.load() * 1000 / MEASURE_TIME.count() << " reads/s" << endl;
+    }
+
+    stop = true;
+    writerThread.join();
+
+    CHECK(errors.load() == 0);
+    CHECK(writes.load() > 0);
+
+    readers.clear();
+    writer.reset();
+    nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME);
+}
+
+TEST_CASE("NVSHandleLocked CXX api shared read of a corrupted entry is repeated exclusively", "[nvs cxx][concurrent_reads]")
+{
+    // A read holding the shared lock must not erase the corrupted string itself,
+    // the read is repeated holding the exclusive lock which erases it
+    REQUIRE(nvs_flash_erase_partition(TEST_DEFAULT_PARTITION_NAME) == ESP_OK);
+    REQUIRE(nvs_flash_init_partition(TEST_DEFAULT_PARTITION_NAME) == ESP_OK);
+
+    esp_err_t result;
+    shared_ptr<nvs::NVSHandle> handle = nvs::open_nvs_handle_from_partition(TEST_DEFAULT_PARTITION_NAME, "test_ns", NVS_READWRITE, &result);
+    REQUIRE(result == ESP_OK);
+
+    char str[32];
+    REQUIRE(handle->set_string("str", "some string value") == ESP_OK);
+    REQUIRE(handle->get_string("str", str, sizeof(str)) == ESP_OK);
+
+    // the first page holds the namespace entry, the header of the string and its data
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, TEST_DEFAULT_PARTITION_NAME);
+    REQUIRE(partition != nullptr);
+    uint8_t entry[nvs::Page::ENTRY_SIZE];
+    const size_t data_offset = NVS_CONST_PAGE_ENTRY_DATA_OFFSET + 2 * nvs::Page::ENTRY_SIZE;
+    REQUIRE(esp_partition_read_raw(partition, data_offset, entry, sizeof(entry)) == ESP_OK);
+    entry[0] &= 0xfe;
+    REQUIRE(esp_partition_write_raw(partition, data_offset, entry, sizeof(entry)) == ESP_OK);
+
+    CHECK(handle->get_string("str", str, sizeof(str)) == ESP_ERR_NVS_NOT_FOUND);
+    size_t size;
+    CHECK(handle->get_item_size(nvs::ItemType::SZ, "str", size) == ESP_ERR_NVS_NOT_FOUND);
+
+    handle.reset();
+    nvs_flash_deinit_partition(TEST_DEFAULT_PARTITION_NAME);
+}
+#endif // CONFIG_NVS_CONCURRENT_READS
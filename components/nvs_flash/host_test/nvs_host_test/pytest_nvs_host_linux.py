@@ -12,6 +12,8 @@ from pytest_embedded_idf.utils import idf_parametrize
         'default_set_key',
         'legacy_set_key',
         'esp_blockdev',
+        'global_key_index',
+        'concurrent_reads',
     ],
     indirect=True,
 )
@@ -6,6 +6,7 @@
 static const char* TAG = "nvs_page_host_test";
 
 #include <stdio.h>
+#include <time.h>
 #include "unity.h"
 #include "test_fixtures.hpp"
 #include "esp_log.h"
@@ -1152,6 +1153,68 @@ void test_Page_load__unknown_type_entries_erased_known_survive()
     }
 }
 
+// Fills a page with single-entry items and reports how much heap its hash list needs and how fast
+// lookups through Page::findItem and HashList::find are. The numbers are informational, the test
+// only fails if the index grows beyond one node per entry (rounded up to the allocation granularity)
+// or a lookup returns a wrong entry.
+void test_Page_hash_list__heap_usage_and_lookup_benchmark()
+{
+    NVSPageFixture fix;
+    HashList hashList;
+    static char keys[Page::ENTRY_COUNT][16];
+
+    for (size_t i = 0; i < Page::ENTRY_COUNT; ++i) {
+        snprintf(keys[i], sizeof(keys[i]), "key%u", (unsigned) i);
+        uint8_t value = (uint8_t) i;
+        TEST_ASSERT_EQUAL(ESP_OK, fix.page.writeItem(1, ItemType::U8, keys[i], &value, sizeof(value)));
+        TEST_ASSERT_EQUAL(ESP_OK, hashList.insert(Item(1, ItemType::U8, 1, keys[i]), i));
+    }
+    TEST_ASSERT_EQUAL(Page::ENTRY_COUNT, fix.page.getUsedEntryCount());
+    TEST_ASSERT_EQUAL(Page::ENTRY_COUNT, hashList.size());
+
+    const size_t heapUsage = hashList.getHeapUsage();
+    printf("hash list: %u items, %u bytes of heap in a single allocation\n",
+           (unsigned) hashList.size(), (unsigned) heapUsage);
+    TEST_ASSERT_TRUE(heapUsage <= 128 * sizeof(uint32_t));
+
+    const size_t ROUNDS = 200;
+    const Item missing(1, ItemType::U8, 1, "missing");
+    struct timespec t_start, t_end;
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < Page::ENTRY_COUNT; ++i) {
+            TEST_ASSERT_EQUAL(i, hashList.find(0, Item(1, ItemType::U8, 1, keys[i])));
+        }
+        TEST_ASSERT_EQUAL(SIZE_MAX, hashList.find(0, missing));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    const double hashListNs = ((t_end.tv_sec - t_start.tv_sec) * 1e9 + (t_end.tv_nsec - t_start.tv_nsec))
+                              / (ROUNDS * (Page::ENTRY_COUNT + 1));
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < Page::ENTRY_COUNT; ++i) {
+            size_t itemIndex = 0;
+            Item item;
+            TEST_ASSERT_EQUAL(ESP_OK, fix.page.findItem(1, ItemType::U8, keys[i], itemIndex, item));
+            TEST_ASSERT_EQUAL(i, itemIndex);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    const double findItemNs = ((t_end.tv_sec - t_start.tv_sec) * 1e9 + (t_end.tv_nsec - t_start.tv_nsec))
+                              / (ROUNDS * Page::ENTRY_COUNT);
+
+    printf("hash list: %.1f ns per HashList::find, %.1f ns per Page::findItem\n", hashListNs, findItemNs);
+
+    // the memory is released as soon as the last item is gone
+    for (size_t i = 0; i < Page::ENTRY_COUNT; ++i) {
+        TEST_ASSERT_TRUE(hashList.erase(i));
+    }
+    TEST_ASSERT_EQUAL(0, hashList.size());
+    TEST_ASSERT_EQUAL(0, hashList.getHeapUsage());
+}
+
 int main(int argc, char **argv)
 {
 #define TEMPORARILY_DISABLED(x)
@@ -1224,6 +1287,7 @@ int main(int argc, char **argv)
     RUN_TEST(test_Page_readItem__double_as_float_type_mismatch);
     RUN_TEST(test_Page_eraseItem__float_success);
     RUN_TEST(test_Page_load__unknown_type_entries_erased_known_survive);
+    RUN_TEST(test_Page_hash_list__heap_usage_and_lookup_benchmark);
     int failures = UNITY_END();
     return failures;
 }
@@ -129,6 +129,19 @@ typedef struct {
  */
 typedef struct nvs_opaque_iterator_t *nvs_iterator_t;
 
+/**
+ * @brief Contiguous fragment of a value returned by nvs_get_blob_view and nvs_get_str_view
+ */
+typedef struct {
+    const void *data;   /*!< Start of the fragment, NULL if size is 0 */
+    size_t size;        /*!< Size of the fragment in bytes */
+} nvs_blob_span_t;
+
+/**
+ * Opaque pointer type representing a read-only view of a blob or string value
+ */
+typedef struct nvs_opaque_blob_view_t *nvs_blob_view_t;
+
 /**
  * @brief      Open non-volatile storage with a given namespace from the default NVS partition
  *
@@ -544,6 +557,89 @@ esp_err_t nvs_get_str (nvs_handle_t handle, const char* key, char* out_value, si
 esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length);
 /**@}*/
 
+/**
+ * @brief      get a read-only view of a blob value without copying it
+ *
+ * If the partition can be memory mapped (not encrypted, not backed by a block device), the data
+ * of the blob is mapped from flash using esp_partition_mmap and no buffer is allocated for it.
+ * A blob written by nvs_set_blob may be split into chunks stored on different pages, the view
+ * then holds one span per chunk, in order. The CRC of every chunk is verified the same way as
+ * by nvs_get_blob. If the partition can't be mapped, or the blob is inconsistent, the value is
+ * copied into a single heap buffer instead and the view holds one span pointing to it.
+ *
+ * The mapped data is the content of the flash. It only stays valid until the next write or erase
+ * operation on the same partition, as these may change or erase the pages the view points to.
+ * Release the view using \c nvs_release_blob_view as soon as the data isn't needed any more,
+ * and before the partition is deinitialized.
+ *
+ * \code{c}
+ * // Example (without error checking) of hashing a large calibration blob in place
+ * nvs_blob_view_t view;
+ * nvs_get_blob_view(my_handle, "calibration", &view);
+ * const nvs_blob_span_t *spans;
+ * size_t span_count;
+ * nvs_blob_view_get_spans(view, &spans, &span_count);
+ * for (size_t i = 0; i < span_count; i++) {
+ *     hash_update(&ctx, spans[i].data, spans[i].size);
+ * }
+ * nvs_release_blob_view(view);
+ * \endcode
+ *
+ * @param[in]  handle    Handle obtained from nvs_open function.
+ * @param[in]  key       Key name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+ * @param[out] out_view  Set to the view if successful (return code is zero), NULL otherwise.
+ *
+ * @return
+ *             - ESP_OK if the view was created successfully
+ *             - ESP_FAIL if there is an internal error; most likely due to corrupted
+ *               NVS partition (only if NVS assertion checks are disabled)
+ *             - ESP_ERR_NVS_NOT_FOUND if the requested key doesn't exist
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_NAME if key name doesn't satisfy constraints
+ *             - ESP_ERR_INVALID_ARG if key or out_view is NULL
+ *             - ESP_ERR_NO_MEM if memory for the view could not be allocated
+ */
+esp_err_t nvs_get_blob_view(nvs_handle_t handle, const char* key, nvs_blob_view_t* out_view);
+
+/**
+ * @brief      get a read-only view of a string value without copying it
+ *
+ * This function behaves the same as \c nvs_get_blob_view, except for the data type.
+ * A string is never split, so the view holds a single span. Its size includes the zero terminator.
+ */
+esp_err_t nvs_get_str_view(nvs_handle_t handle, const char* key, nvs_blob_view_t* out_view);
+
+/**
+ * @brief      get the spans of a view
+ *
+ * @param[in]  view            View obtained from nvs_get_blob_view or nvs_get_str_view.
+ * @param[out] out_spans       Set to the array of spans, valid until the view is released.
+ * @param[out] out_span_count  Set to the number of spans in the array.
+ *
+ * @return
+ *             - ESP_OK if the spans were returned successfully
+ *             - ESP_ERR_INVALID_ARG if any of the parameters is NULL
+ */
+esp_err_t nvs_blob_view_get_spans(nvs_blob_view_t view, const nvs_blob_span_t** out_spans, size_t* out_span_count);
+
+/**
+ * @brief      check if the data of a view is memory mapped from flash
+ *
+ * @param[in]  view  View obtained from nvs_get_blob_view or nvs_get_str_view.
+ *
+ * @return     true if the spans point to the memory mapped flash, false if they point to a heap copy
+ */
+bool nvs_blob_view_is_mapped(nvs_blob_view_t view);
+
+/**
+ * @brief      release a view
+ *
+ * Unmaps the data of the view or frees its copy. The spans of the view must not be used afterwards.
+ *
+ * @param[in]  view  View obtained from nvs_get_blob_view or nvs_get_str_view, NULL is ignored.
+ */
+void nvs_release_blob_view(nvs_blob_view_t view);
+
 /**
  * @brief      Lookup key-value pair with given key name.
  *
@@ -637,6 +733,82 @@ esp_err_t nvs_purge_all(nvs_handle_t handle);
  */
 esp_err_t nvs_commit(nvs_handle_t handle);
 
+/**
+ * @brief      Start staging a batch of key-value pairs
+ *
+ * Values passed to \c nvs_batch_set after this call are kept in RAM and are not visible to the
+ * \c nvs_get_* functions until \c nvs_batch_commit is called. The commit writes all staged values
+ * into contiguous entries of a single page, so either all of them or none of them are present
+ * after a power loss.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *                     Handles that were opened read only cannot be used.
+ *
+ * @return
+ *             - ESP_OK if the batch was started
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_READ_ONLY if storage handle was opened as read only
+ *             - ESP_ERR_NVS_INVALID_STATE if a batch is already in progress on this handle
+ */
+esp_err_t nvs_batch_begin(nvs_handle_t handle);
+
+/**
+ * @brief      Stage a value in the batch started by \c nvs_batch_begin
+ *
+ * Staging a key which is already part of the batch replaces the staged value.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ * @param[in]  type    Type of the value. NVS_TYPE_ANY is not allowed.
+ * @param[in]  key     Key name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+ * @param[in]  value   The value to stage. It is copied, the buffer may be reused after the call.
+ * @param[in]  length  Size of the value in bytes. For the integer and floating point types it has to
+ *                     match the size of the type. It is ignored for NVS_TYPE_STR, where the length of
+ *                     the zero-terminated string is used.
+ *
+ * @return
+ *             - ESP_OK if the value was staged
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no batch is in progress on this handle
+ *             - ESP_ERR_NVS_KEY_TOO_LONG if the key name is too long
+ *             - ESP_ERR_INVALID_ARG if the type or the length is not valid
+ *             - ESP_ERR_NVS_VALUE_TOO_LONG if the staged values don't fit into a single page
+ *             - ESP_ERR_NO_MEM if memory to stage the value could not be allocated
+ */
+esp_err_t nvs_batch_set(nvs_handle_t handle, nvs_type_t type, const char* key, const void* value, size_t length);
+
+/**
+ * @brief      Write all values staged since \c nvs_batch_begin and end the batch
+ *
+ * The batch ends regardless of the result, staged values are discarded if the commit fails.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *
+ * @return
+ *             - ESP_OK if all values were written
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no batch is in progress on this handle
+ *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space in the
+ *               underlying storage to save the values
+ *             - ESP_ERR_NVS_REMOVE_FAILED if the new values were written, but some of the old
+ *               values could not be erased because flash write operation has failed. The update
+ *               will be finished after re-initialization of nvs, provided that flash operation
+ *               doesn't fail again.
+ *             - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_batch_commit(nvs_handle_t handle);
+
+/**
+ * @brief      Discard all values staged since \c nvs_batch_begin and end the batch
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *
+ * @return
+ *             - ESP_OK if the batch was discarded
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no batch is in progress on this handle
+ */
+esp_err_t nvs_batch_abort(nvs_handle_t handle);
+
 /**
  * @brief      Close the storage handle and free any allocated resources
  *
@@ -696,6 +868,35 @@ typedef struct {
  */
 esp_err_t nvs_get_stats(const char *part_name, nvs_stats_t *nvs_stats);
 
+/**
+ * @brief      Perform one bounded step of the incremental page compaction.
+ *
+ * When the last free pages of a partition are used up, NVS normally reclaims a full page inside of the
+ * nvs_set_* or nvs_commit call which needs it: all the items of that page are copied to a new page and the page
+ * is erased, which makes the worst case of a write much longer than the average one.
+ * Calling this function periodically, e.g. from a low priority task, moves the items of the page with
+ * the most erased entries in small steps and erases the page once it is empty. This keeps enough free pages
+ * around so that the writes don't have to reclaim a page themselves.
+ *
+ * A step either moves the items within the budget or erases one emptied page.
+ * It does nothing while the partition has enough free pages.
+ *
+ * @param[in]   part_name   Partition name NVS in the partition table.
+ *                          If pass a NULL than will use NVS_DEFAULT_PART_NAME ("nvs").
+ *
+ * @param[in]   budget      Number of entries moved by the step. Items are moved as a whole,
+ *                          so a step may move up to the span of one item more.
+ *
+ * @return
+ *             - ESP_OK if a step was performed.
+ *             - ESP_ERR_NVS_NOT_FOUND if there is nothing to compact at the moment.
+ *             - ESP_ERR_NVS_NOT_INITIALIZED if the storage driver is not initialized.
+ *             - ESP_ERR_NVS_READ_ONLY if the partition is read-only.
+ *             - ESP_ERR_INVALID_ARG if budget is 0.
+ *             - other error codes from the underlying storage driver.
+ */
+esp_err_t nvs_compact_step(const char *part_name, size_t budget);
+
 /**
  * @brief      Calculate all entries in a namespace.
  *
@@ -498,6 +498,63 @@ extern "C" esp_err_t nvs_commit(nvs_handle_t c_handle)
     return handle->commit();
 }
 
+extern "C" esp_err_t nvs_batch_begin(nvs_handle_t c_handle)
+{
+    Lock lock;
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return handle->batch_begin();
+}
+
+extern "C" esp_err_t nvs_batch_set(nvs_handle_t c_handle, nvs_type_t type, const char* key, const void* value, size_t length)
+{
+    if (key == nullptr || value == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if ((type == NVS_TYPE_FLOAT && std::isnan(*static_cast<const float*>(value)))
+            || (type == NVS_TYPE_DOUBLE && std::isnan(*static_cast<const double*>(value)))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Lock lock;
+    ESP_LOGD(TAG, "%s %s %d", __func__, key, static_cast<int>(type));
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (type == NVS_TYPE_STR) {
+        length = strlen(static_cast<const char*>(value)) + 1;
+    }
+    // blobs are stored as blob index and blob data, the handle expects the logical type
+    nvs::ItemType datatype = (type == NVS_TYPE_BLOB) ? nvs::ItemType::BLOB : static_cast<nvs::ItemType>(type);
+    return handle->batch_set(datatype, key, value, length);
+}
+
+extern "C" esp_err_t nvs_batch_commit(nvs_handle_t c_handle)
+{
+    Lock lock;
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return handle->batch_commit();
+}
+
+extern "C" esp_err_t nvs_batch_abort(nvs_handle_t c_handle)
+{
+    Lock lock;
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return handle->batch_abort();
+}
+
 extern "C" esp_err_t nvs_set_str(nvs_handle_t c_handle, const char* key, const char* value)
 {
     Lock lock;
@@ -626,6 +683,64 @@ extern "C" esp_err_t nvs_get_blob(nvs_handle_t c_handle, const char* key, void*
     return nvs_get_str_or_blob(c_handle, nvs::ItemType::BLOB, key, out_value, length);
 }
 
+static esp_err_t nvs_get_view(nvs_handle_t c_handle, nvs::ItemType type, const char* key, nvs_blob_view_t* out_view)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %s", __func__, key);
+    if (key == nullptr || out_view == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_view = nullptr;
+
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    nvs_opaque_blob_view_t* view = new (std::nothrow) nvs_opaque_blob_view_t;
+    if (view == nullptr) {
+        return ESP_ERR_NO_MEM;
+    }
+    err = handle->get_item_view(type, key, *view);
+    if (err != ESP_OK) {
+        delete view;
+        return err;
+    }
+    *out_view = view;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_get_blob_view(nvs_handle_t c_handle, const char* key, nvs_blob_view_t* out_view)
+{
+    return nvs_get_view(c_handle, nvs::ItemType::BLOB, key, out_view);
+}
+
+extern "C" esp_err_t nvs_get_str_view(nvs_handle_t c_handle, const char* key, nvs_blob_view_t* out_view)
+{
+    return nvs_get_view(c_handle, nvs::ItemType::SZ, key, out_view);
+}
+
+extern "C" esp_err_t nvs_blob_view_get_spans(nvs_blob_view_t view, const nvs_blob_span_t** out_spans, size_t* out_span_count)
+{
+    if (view == nullptr || out_spans == nullptr || out_span_count == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_spans = view->spans;
+    *out_span_count = view->spanCount;
+    return ESP_OK;
+}
+
+extern "C" bool nvs_blob_view_is_mapped(nvs_blob_view_t view)
+{
+    return view != nullptr && view->partition != nullptr;
+}
+
+extern "C" void nvs_release_blob_view(nvs_blob_view_t view)
+{
+    delete view;
+}
+
 extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats)
 {
     Lock lock;
@@ -652,6 +767,23 @@ extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats
     return pStorage->fillStats(*nvs_stats);
 }
 
+extern "C" esp_err_t nvs_compact_step(const char* part_name, size_t budget)
+{
+    Lock lock;
+    nvs::Storage* pStorage;
+
+    if (budget == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pStorage = lookup_storage_from_name((part_name == nullptr) ? NVS_DEFAULT_PART_NAME : part_name);
+    if (pStorage == nullptr) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    return pStorage->compactStep(budget);
+}
+
 extern "C" esp_err_t nvs_get_used_entry_count(nvs_handle_t c_handle, size_t* used_entries)
 {
     Lock lock;
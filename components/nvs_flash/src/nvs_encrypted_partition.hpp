@@ -66,6 +66,17 @@ public:
      */
     esp_err_t write(size_t dst_offset, const void* src, size_t size) override;
 
+    /**
+     * Memory mapping would expose the encrypted data, so it is not supported.
+     *
+     * @return
+     *      - ESP_ERR_NOT_SUPPORTED always
+     */
+    esp_err_t mmap(size_t src_offset, size_t size, const void** out_ptr, uint32_t* out_handle) override
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
 protected:
     XTS_CONTEXT mEctxt;     // AES context for encryption
     XTS_CONTEXT mDctxt;     // AES context for decryption
@@ -25,24 +25,20 @@ esp_err_t NVSHandleLocked::set_blob(const char *key, const void* blob, size_t le
 }
 
 esp_err_t NVSHandleLocked::get_string(const char *key, char* out_str, size_t len) {
-    Lock lock;
-    return handle->get_string(key, out_str, len);
+    return locked_read([&]() { return handle->get_string(key, out_str, len); });
 }
 
 esp_err_t NVSHandleLocked::get_blob(const char *key, void* out_blob, size_t len) {
-    Lock lock;
-    return handle->get_blob(key, out_blob, len);
+    return locked_read([&]() { return handle->get_blob(key, out_blob, len); });
 }
 
 esp_err_t NVSHandleLocked::get_item_size(ItemType datatype, const char *key, size_t &size) {
-    Lock lock;
-    return handle->get_item_size(datatype, key, size);
+    return locked_read([&]() { return handle->get_item_size(datatype, key, size); });
 }
 
 esp_err_t NVSHandleLocked::find_key(const char* key, nvs_type_t &nvstype)
 {
-    Lock lock;
-    return handle->find_key(key, nvstype);
+    return locked_read([&]() { return handle->find_key(key, nvstype); });
 }
 
 esp_err_t NVSHandleLocked::erase_item(const char* key) {
@@ -66,8 +62,7 @@ esp_err_t NVSHandleLocked::commit() {
 }
 
 esp_err_t NVSHandleLocked::get_used_entry_count(size_t& usedEntries) {
-    Lock lock;
-    return handle->get_used_entry_count(usedEntries);
+    return locked_read([&]() { return handle->get_used_entry_count(usedEntries); });
 }
 
 esp_err_t NVSHandleLocked::set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize) {
@@ -76,8 +71,7 @@ esp_err_t NVSHandleLocked::set_typed_item(ItemType datatype, const char *key, co
 }
 
 esp_err_t NVSHandleLocked::get_typed_item(ItemType datatype, const char *key, void* data, size_t dataSize) {
-    Lock lock;
-    return handle->get_typed_item(datatype, key, data, dataSize);
+    return locked_read([&]() { return handle->get_typed_item(datatype, key, data, dataSize); });
 }
 
 } // namespace nvs
@@ -18,6 +18,9 @@ namespace nvs {
  *
  * @note this class becomes responsible for its internal NVSHandleSimple object, i.e. it deletes the handle object on
  * destruction
+ *
+ * @note with CONFIG_NVS_CONCURRENT_READS, the get functions of different handles run in parallel, the other
+ * functions are still serialized.
  */
 class NVSHandleLocked : public NVSHandle {
 public:
@@ -58,6 +61,26 @@ protected:
     esp_err_t get_typed_item(ItemType datatype, const char *key, void* data, size_t dataSize) override;
 
 private:
+    /**
+     * Runs a read operation of the decorated handle. With CONFIG_NVS_CONCURRENT_READS, it runs holding the SharedLock
+     * first and is repeated holding the Lock only if it would have to modify the storage.
+     */
+    template<typename ReadOperation>
+    esp_err_t locked_read(ReadOperation operation)
+    {
+#ifdef CONFIG_NVS_CONCURRENT_READS
+        {
+            SharedLock lock;
+            esp_err_t err = operation();
+            if (err != ESP_ERR_NVS_RETRY_LOCKED) {
+                return err;
+            }
+        }
+#endif
+        Lock lock;
+        return operation();
+    }
+
     NVSHandleSimple *handle;
 };
 
@@ -10,6 +10,7 @@
 namespace nvs {
 
 NVSHandleSimple::~NVSHandleSimple() {
+    mBatch.clearAndFreeNodes();
     NVSPartitionManager::get_instance()->close_handle(this);
 }
 
@@ -65,6 +66,13 @@ esp_err_t NVSHandleSimple::get_item_size(ItemType datatype, const char *key, siz
     return mStoragePtr->getItemDataSize(mNsIndex, datatype, key, size);
 }
 
+esp_err_t NVSHandleSimple::get_item_view(ItemType datatype, const char *key, nvs_opaque_blob_view_t &view)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    return mStoragePtr->getItemView(mNsIndex, datatype, key, view);
+}
+
 esp_err_t NVSHandleSimple::find_key(const char* key, nvs_type_t &nvstype)
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
@@ -113,6 +121,112 @@ esp_err_t NVSHandleSimple::commit()
     return ESP_OK;
 }
 
+esp_err_t NVSHandleSimple::batch_begin()
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
+    if (mBatchActive) return ESP_ERR_NVS_INVALID_STATE;
+
+    mBatchActive = 1;
+    mBatchEntryCount = 0;
+    return ESP_OK;
+}
+
+esp_err_t NVSHandleSimple::batch_set(ItemType datatype, const char *key, const void* data, size_t dataSize)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!mBatchActive) return ESP_ERR_NVS_INVALID_STATE;
+
+    switch (datatype) {
+    case ItemType::SZ:
+    case ItemType::BLOB:
+        break;
+    case ItemType::U8:
+    case ItemType::I8:
+    case ItemType::U16:
+    case ItemType::I16:
+    case ItemType::U32:
+    case ItemType::I32:
+    case ItemType::U64:
+    case ItemType::I64:
+    case ItemType::FLOAT:
+    case ItemType::DOUBLE:
+        // the lower nibble of the primitive types holds their size
+        if (dataSize != (static_cast<uint8_t>(datatype) & 0x0f)) return ESP_ERR_INVALID_ARG;
+        break;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (strlen(key) > Item::MAX_KEY_LENGTH) return ESP_ERR_NVS_KEY_TOO_LONG;
+
+    Storage::BatchItem* item = new (std::nothrow) Storage::BatchItem();
+    if (!item) return ESP_ERR_NO_MEM;
+
+    strncpy(item->mKey, key, sizeof(item->mKey) - 1);
+    item->mKey[sizeof(item->mKey) - 1] = 0;
+    item->mDatatype = datatype;
+    item->mDataSize = dataSize;
+    if (isVariableLengthType(datatype) && dataSize > 0) {
+        item->mVarData = new (std::nothrow) uint8_t[dataSize];
+        if (!item->mVarData) {
+            delete item;
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(item->mVarData, data, dataSize);
+    } else {
+        memcpy(item->mValue, data, dataSize);
+    }
+
+    // the staged value replaces the one staged before under the same key
+    Storage::BatchItem* replaced = nullptr;
+    for (auto it = mBatch.begin(); it != mBatch.end(); ++it) {
+        if (strncmp(it->mKey, item->mKey, sizeof(item->mKey)) == 0) {
+            replaced = &(*it);
+            break;
+        }
+    }
+
+    size_t entryCount = mBatchEntryCount + item->entryCount();
+    if (replaced) {
+        entryCount -= replaced->entryCount();
+    }
+    // all values of the batch are written into a single page
+    if (entryCount > Page::ENTRY_COUNT) {
+        delete item;
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+
+    if (replaced) {
+        mBatch.erase(replaced);
+        delete replaced;
+    }
+    mBatch.push_back(item);
+    mBatchEntryCount = entryCount;
+    return ESP_OK;
+}
+
+esp_err_t NVSHandleSimple::batch_commit()
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!mBatchActive) return ESP_ERR_NVS_INVALID_STATE;
+
+    esp_err_t err = mStoragePtr->writeBatch(mNsIndex, mBatch, mPurgeAfterErase);
+    mBatch.clearAndFreeNodes();
+    mBatchActive = 0;
+    return err;
+}
+
+esp_err_t NVSHandleSimple::batch_abort()
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!mBatchActive) return ESP_ERR_NVS_INVALID_STATE;
+
+    mBatch.clearAndFreeNodes();
+    mBatchActive = 0;
+    return ESP_OK;
+}
+
 esp_err_t NVSHandleSimple::get_used_entry_count(size_t& used_entries)
 {
     used_entries = 0;
@@ -32,7 +32,9 @@ public:
         mNsIndex(nsIndex),
         mReadOnly(readOnly),
         mPurgeAfterErase(purgeAfterErase),
-        valid(1)
+        valid(1),
+        mBatchActive(0),
+        mBatchEntryCount(0)
     { }
 
     ~NVSHandleSimple();
@@ -63,6 +65,31 @@ public:
 
     esp_err_t get_used_entry_count(size_t &usedEntries) override;
 
+    /**
+     * Fills the view with the data of a SZ or BLOB item, see nvs_get_blob_view() in nvs.h
+     */
+    esp_err_t get_item_view(ItemType datatype, const char *key, nvs_opaque_blob_view_t &view);
+
+    /**
+     * Starts staging values in RAM, see nvs_batch_begin() in nvs.h
+     */
+    esp_err_t batch_begin();
+
+    /**
+     * Stages a value of the batch. Staging a key which is already part of the batch replaces its value.
+     */
+    esp_err_t batch_set(ItemType datatype, const char *key, const void *data, size_t dataSize);
+
+    /**
+     * Writes all staged values at once and ends the batch, see Storage::writeBatch()
+     */
+    esp_err_t batch_commit();
+
+    /**
+     * Discards all staged values and ends the batch
+     */
+    esp_err_t batch_abort();
+
     esp_err_t getItemDataSize(ItemType datatype, const char *key, size_t &dataSize);
 
     void debugDump();
@@ -108,6 +135,21 @@ private:
      * Upon opening, a handle is valid. It becomes invalid if the underlying storage is de-initialized.
      */
     uint8_t valid;
+
+    /**
+     * Whether values are currently staged by batch_set() instead of being written.
+     */
+    uint8_t mBatchActive;
+
+    /**
+     * Number of page entries occupied by the staged values once they are written.
+     */
+    size_t mBatchEntryCount;
+
+    /**
+     * Values staged since batch_begin().
+     */
+    Storage::TBatchList mBatch;
 };
 
 } // nvs
@@ -3,6 +3,8 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+#include <new>
+#include <string.h>
 #include "nvs_item_hash_list.hpp"
 
 namespace nvs
@@ -10,16 +12,16 @@ namespace nvs
 
 HashList::HashList()
 {
+    static_assert(sizeof(HashListNode) == 4, "hash list node must stay packed into 32 bits");
+    static_assert(MAX_CAPACITY <= UINT8_MAX, "node positions are stored as uint8_t");
 }
 
 void HashList::clear()
 {
-    for (auto it = mBlockList.begin(); it != mBlockList.end();) {
-        auto tmp = it;
-        ++it;
-        mBlockList.erase(tmp);
-        delete static_cast<HashListBlock*>(tmp);
-    }
+    delete [] mNodes;
+    mNodes = nullptr;
+    mCapacity = 0;
+    memset(mBucketEnd, 0, sizeof(mBucketEnd));
 }
 
 HashList::~HashList()
@@ -27,84 +29,88 @@ HashList::~HashList()
     clear();
 }
 
-HashList::HashListBlock::HashListBlock()
+esp_err_t HashList::resize(size_t capacity)
 {
-    static_assert(sizeof(HashListBlock) == HashListBlock::BYTE_SIZE,
-                  "cache block size calculation incorrect");
+    HashListNode* newNodes = new (std::nothrow) HashListNode[capacity];
+    if (!newNodes) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (mNodes) {
+        memcpy(newNodes, mNodes, size() * sizeof(HashListNode));
+        delete [] mNodes;
+    }
+    mNodes = newNodes;
+    mCapacity = (uint8_t) capacity;
+    return ESP_OK;
 }
 
 esp_err_t HashList::insert(const Item& item, size_t index)
 {
     const uint32_t hash_24 = item.calculateCrc32WithoutValue() & 0xffffff;
-    // add entry to the end of last block if possible
-    if (mBlockList.size()) {
-        auto& block = mBlockList.back();
-        if (block.mCount < HashListBlock::ENTRY_COUNT) {
-            block.mNodes[block.mCount++] = HashListNode(hash_24, index);
-            return ESP_OK;
+    const size_t count = size();
+    if (count == mCapacity) {
+        if (mCapacity >= MAX_CAPACITY) {
+            return ESP_ERR_NO_MEM;
+        }
+        esp_err_t err = resize(mCapacity ? mCapacity * 2 : MIN_CAPACITY);
+        if (err != ESP_OK) {
+            return err;
         }
     }
-    // if the above failed, create a new block and add entry to it
-    HashListBlock* newBlock = new (std::nothrow) HashListBlock;
-
-    if (!newBlock) return ESP_ERR_NO_MEM;
-
-    mBlockList.push_back(newBlock);
-    newBlock->mNodes[0] = HashListNode(hash_24, index);
-    newBlock->mCount++;
 
+    // keep the nodes of the bucket ordered by entry index, entries are usually inserted in ascending order
+    const size_t bucket = bucketOf(hash_24);
+    const size_t begin = bucketBegin(bucket);
+    size_t pos = mBucketEnd[bucket];
+    while (pos > begin && mNodes[pos - 1].mIndex > index) {
+        --pos;
+    }
+    memmove(&mNodes[pos + 1], &mNodes[pos], (count - pos) * sizeof(HashListNode));
+    mNodes[pos] = HashListNode(hash_24, index);
+    for (size_t b = bucket; b < BUCKET_COUNT; ++b) {
+        ++mBucketEnd[b];
+    }
     return ESP_OK;
 }
 
 bool HashList::erase(size_t index)
 {
-    for (auto it = mBlockList.begin(); it != mBlockList.end();) {
-        bool haveEntries = false;
-        bool foundIndex = false;
-        for (size_t i = 0; i < it->mCount; ++i) {
-            if (it->mNodes[i].mIndex == index) {
-                it->mNodes[i].mIndex = 0xff;
-                foundIndex = true;
-                /* found the item and removed it */
-            }
-            if (it->mNodes[i].mIndex != 0xff) {
-                haveEntries = true;
-            }
-            if (haveEntries && foundIndex) {
-                /* item was found, and HashListBlock still has some items */
-                return true;
-            }
+    const size_t count = size();
+    size_t pos;
+    for (pos = 0; pos < count; ++pos) {
+        if (mNodes[pos].mIndex == index) {
+            break;
         }
-        /* no items left in HashListBlock, can remove */
-        if (!haveEntries) {
-            auto tmp = it;
-            ++it;
-            mBlockList.erase(tmp);
-            delete static_cast<HashListBlock*>(tmp);
-        } else {
-            ++it;
-        }
-        if (foundIndex) {
-            /* item was found and empty HashListBlock was removed */
-            return true;
+    }
+    if (pos == count) {
+        // item hasn't been present in cache
+        return false;
+    }
+
+    memmove(&mNodes[pos], &mNodes[pos + 1], (count - pos - 1) * sizeof(HashListNode));
+    for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+        if (mBucketEnd[b] > pos) {
+            --mBucketEnd[b];
         }
     }
 
-    // item hasn't been present in cache");
-    return false;
+    // give memory back as soon as the page doesn't need it, a failed shrink keeps the larger array
+    if (count == 1) {
+        clear();
+    } else if (mCapacity > MIN_CAPACITY && (count - 1) * 4 <= mCapacity) {
+        resize(mCapacity / 2);
+    }
+    return true;
 }
 
 size_t HashList::find(size_t start, const Item& item)
 {
     const uint32_t hash_24 = item.calculateCrc32WithoutValue() & 0xffffff;
-    for (auto it = mBlockList.begin(); it != mBlockList.end(); ++it) {
-        for (size_t index = 0; index < it->mCount; ++index) {
-            HashListNode& e = it->mNodes[index];
-            if (e.mIndex >= start &&
-                    e.mHash == hash_24 &&
-                    e.mIndex != 0xff) {
-                return e.mIndex;
-            }
+    const size_t bucket = bucketOf(hash_24);
+    for (size_t pos = bucketBegin(bucket); pos < mBucketEnd[bucket]; ++pos) {
+        const HashListNode& e = mNodes[pos];
+        if (e.mIndex >= start && e.mHash == hash_24) {
+            return e.mIndex;
         }
     }
     return SIZE_MAX;
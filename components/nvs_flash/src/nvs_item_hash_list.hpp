@@ -7,12 +7,19 @@
 
 #include "nvs.h"
 #include "nvs_types.hpp"
-#include "nvs_memory_management.hpp"
-#include "intrusive_list.h"
 
 namespace nvs
 {
 
+/**
+ * Per-page index mapping the 24-bit hash of namespace index, key and chunk index to entry indices.
+ *
+ * All nodes of a page live in a single heap array which grows (and shrinks) by powers of two, so a
+ * full page costs one allocation instead of a chain of blocks. The array is kept grouped by the low
+ * bits of the hash: mBucketEnd[b] holds the end of the bucket b, so a lookup only scans the few nodes
+ * sharing the bucket. Nodes within a bucket are ordered by entry index, hence find() returns the lowest
+ * matching index which is not smaller than the start index.
+ */
 class HashList
 {
 public:
@@ -24,12 +31,26 @@ public:
     size_t find(size_t start, const Item& item);
     void clear();
 
+    size_t size() const
+    {
+        return mBucketEnd[BUCKET_COUNT - 1];
+    }
+
+    size_t getHeapUsage() const
+    {
+        return mCapacity * sizeof(HashListNode);
+    }
+
 private:
     HashList(const HashList& other);
     const HashList& operator= (const HashList& rhs);
 
 protected:
 
+    static const size_t BUCKET_COUNT = 16;
+    static const size_t MIN_CAPACITY = 8;
+    static const size_t MAX_CAPACITY = 128;
+
     struct HashListNode {
         HashListNode() :
             mIndex(0xff), mHash(0)
@@ -45,18 +66,21 @@ protected:
         uint32_t mHash  : 24;
     };
 
-    struct HashListBlock : public intrusive_list_node<HashList::HashListBlock>, public ExceptionlessAllocatable {
-        HashListBlock();
+    static size_t bucketOf(uint32_t hash)
+    {
+        return hash & (BUCKET_COUNT - 1);
+    }
 
-        static const size_t BYTE_SIZE = 128;
-        static const size_t ENTRY_COUNT = (BYTE_SIZE - sizeof(intrusive_list_node<HashListBlock>) - sizeof(size_t)) / 4;
+    size_t bucketBegin(size_t bucket) const
+    {
+        return (bucket == 0) ? 0 : mBucketEnd[bucket - 1];
+    }
 
-        size_t mCount = 0;
-        HashListNode mNodes[ENTRY_COUNT];
-    };
+    esp_err_t resize(size_t capacity);
 
-    typedef intrusive_list<HashListBlock> TBlockList;
-    TBlockList mBlockList;
+    HashListNode* mNodes = nullptr;
+    uint8_t mCapacity = 0;
+    uint8_t mBucketEnd[BUCKET_COUNT] = {};
 }; // class HashList
 
 } // namespace nvs
@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "nvs_key_index.hpp"
+
+namespace nvs
+{
+
+KeyIndex::KeyIndex()
+{
+}
+
+KeyIndex::~KeyIndex()
+{
+    delete[] mSlots;
+}
+
+uint32_t KeyIndex::hashOf(const Item& item)
+{
+    // same hash as used by the HashList of the pages
+    return item.calculateCrc32WithoutValue() & 0xffffff;
+}
+
+void KeyIndex::clear()
+{
+    delete[] mSlots;
+    mSlots = nullptr;
+    mCapacity = 0;
+    mCount = 0;
+    mValid = true;
+}
+
+void KeyIndex::invalidate()
+{
+    clear();
+    mValid = false;
+}
+
+void KeyIndex::place(const Slot& slot)
+{
+    size_t pos = homeOf(slot.mHash);
+    while (mSlots[pos].mPage != nullptr) {
+        pos = (pos + 1) & (mCapacity - 1);
+    }
+    mSlots[pos] = slot;
+    ++mCount;
+}
+
+esp_err_t KeyIndex::grow()
+{
+    const size_t newCapacity = (mCapacity == 0) ? INITIAL_CAPACITY : mCapacity * 2;
+    Slot* newSlots = new (std::nothrow) Slot[newCapacity];
+    if (!newSlots) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < newCapacity; ++i) {
+        newSlots[i].mPage = nullptr;
+    }
+
+    Slot* oldSlots = mSlots;
+    const size_t oldCapacity = mCapacity;
+    mSlots = newSlots;
+    mCapacity = newCapacity;
+    mCount = 0;
+    for (size_t i = 0; i < oldCapacity; ++i) {
+        if (oldSlots[i].mPage != nullptr) {
+            place(oldSlots[i]);
+        }
+    }
+    delete[] oldSlots;
+    return ESP_OK;
+}
+
+esp_err_t KeyIndex::insert(const Item& item, Page* page, size_t index)
+{
+    if (!mValid) {
+        return ESP_OK;
+    }
+
+    // keep the load factor below 3/4 so that the probe sequences stay short
+    if ((mCount + 1) * 4 > mCapacity * 3) {
+        if (grow() != ESP_OK) {
+            // the pages are still consistent, only the lookups will fall back to the per-page search
+            invalidate();
+            return ESP_OK;
+        }
+    }
+
+    Slot slot;
+    slot.mPage = page;
+    slot.mIndex = static_cast<uint32_t>(index);
+    slot.mHash = hashOf(item);
+    place(slot);
+    return ESP_OK;
+}
+
+void KeyIndex::removeAt(size_t pos)
+{
+    const size_t mask = mCapacity - 1;
+    size_t hole = pos;
+    size_t next = pos;
+    // backward shift deletion, move the following entries of the probe sequence into the hole
+    while (true) {
+        next = (next + 1) & mask;
+        if (mSlots[next].mPage == nullptr) {
+            break;
+        }
+        const size_t home = homeOf(mSlots[next].mHash);
+        // the entry may move only if its home position is not cyclically within (hole, next]
+        const bool stays = (hole <= next) ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!stays) {
+            mSlots[hole] = mSlots[next];
+            hole = next;
+        }
+    }
+    mSlots[hole].mPage = nullptr;
+    --mCount;
+}
+
+void KeyIndex::erase(const Item& item, Page* page, size_t index)
+{
+    if (!mValid || mCount == 0) {
+        return;
+    }
+
+    const uint32_t hash = hashOf(item);
+    size_t pos = homeOf(hash);
+    while (mSlots[pos].mPage != nullptr) {
+        if (mSlots[pos].mPage == page && mSlots[pos].mIndex == index) {
+            removeAt(pos);
+            return;
+        }
+        pos = (pos + 1) & (mCapacity - 1);
+    }
+
+    // the key of the item may not match the one indexed, search the whole table
+    erase(page, index);
+}
+
+void KeyIndex::erase(Page* page, size_t index)
+{
+    if (!mValid) {
+        return;
+    }
+
+    for (size_t pos = 0; pos < mCapacity; ++pos) {
+        if (mSlots[pos].mPage == page && mSlots[pos].mIndex == index) {
+            removeAt(pos);
+            return;
+        }
+    }
+}
+
+void KeyIndex::erasePage(Page* page)
+{
+    if (!mValid) {
+        return;
+    }
+
+    size_t pos = 0;
+    while (pos < mCapacity && mCount > 0) {
+        if (mSlots[pos].mPage == page) {
+            // removeAt may shift another entry into this position, check it again
+            removeAt(pos);
+        } else {
+            ++pos;
+        }
+    }
+}
+
+bool KeyIndex::findNext(uint32_t hash, size_t& pos, Page*& page, size_t& index) const
+{
+    if (!mValid || mCount == 0) {
+        return false;
+    }
+
+    const size_t mask = mCapacity - 1;
+    pos = (pos == PROBE_START) ? homeOf(hash) : ((pos + 1) & mask);
+    // the load factor guarantees that there is at least one empty slot terminating the probe sequence
+    while (mSlots[pos].mPage != nullptr) {
+        if (mSlots[pos].mHash == hash) {
+            page = mSlots[pos].mPage;
+            index = mSlots[pos].mIndex;
+            return true;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return false;
+}
+
+} // namespace nvs
@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+#include "nvs_memory_management.hpp"
+
+namespace nvs
+{
+
+class Page;
+
+/**
+ * Partition-wide index of the items stored in all pages of a PageManager.
+ *
+ * The index is an open-addressing hash table (linear probing, backward shift deletion) keyed by the same
+ * hash of namespace index, key and chunk index which is used by the per-page HashList. Each slot maps
+ * the hash directly to the page and the entry index of the item within that page, so a lookup doesn't have
+ * to visit every page of the partition. Different keys may share the same hash, the caller has to verify the
+ * candidates returned by findNext() on the page itself.
+ *
+ * The pages keep the index in sync whenever they update their own HashList. If the table can't grow due to
+ * lack of memory, the index invalidates itself and callers fall back to the per-page lookup.
+ */
+class KeyIndex
+{
+public:
+    /**
+     * Initial value of the probe position passed to findNext()
+     */
+    static const size_t PROBE_START = SIZE_MAX;
+
+    KeyIndex();
+    ~KeyIndex();
+
+    /**
+     * Returns the key hash of the item used by insert() and findNext()
+     */
+    static uint32_t hashOf(const Item& item);
+
+    esp_err_t insert(const Item& item, Page* page, size_t index);
+
+    /**
+     * Removes the entry of the item located at the given page and index
+     */
+    void erase(const Item& item, Page* page, size_t index);
+
+    /**
+     * Removes the entry located at the given page and index, used if the item's header is not reliable
+     */
+    void erase(Page* page, size_t index);
+
+    /**
+     * Removes all entries pointing to the given page
+     */
+    void erasePage(Page* page);
+
+    /**
+     * Returns the next entry with the given hash, starting after probe position pos.
+     * Returns false if there is no further entry.
+     */
+    bool findNext(uint32_t hash, size_t& pos, Page*& page, size_t& index) const;
+
+    /**
+     * Removes all entries and makes the index valid again
+     */
+    void clear();
+
+    bool isValid() const
+    {
+        return mValid;
+    }
+
+    size_t size() const
+    {
+        return mCount;
+    }
+
+    size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+private:
+    KeyIndex(const KeyIndex& other);
+    const KeyIndex& operator= (const KeyIndex& rhs);
+
+protected:
+    struct Slot : public ExceptionlessAllocatable {
+        Page* mPage;
+        uint32_t mIndex : 8;
+        uint32_t mHash  : 24;
+    };
+
+    static const size_t INITIAL_CAPACITY = 64;
+
+    size_t homeOf(uint32_t hash) const
+    {
+        // the hash is a crc, its low bits are distributed well enough
+        return hash & (mCapacity - 1);
+    }
+
+    esp_err_t grow();
+
+    void place(const Slot& slot);
+
+    void removeAt(size_t pos);
+
+    void invalidate();
+
+    Slot* mSlots = nullptr;
+    size_t mCapacity = 0;
+    size_t mCount = 0;
+    bool mValid = true;
+}; // class KeyIndex
+
+} // namespace nvs
@@ -207,6 +207,13 @@ esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, c
         return err;
     }
 
+    if (mKeyIndex) {
+        err = mKeyIndex->insert(item, this, mNextFreeEntry);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
     if (!isVariableLengthType(datatype)) {
         memcpy(item.data, data, dataSize);
         item.crc32 = item.calculateCrc32();
@@ -248,6 +255,74 @@ esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, c
     return ESP_OK;
 }
 
+esp_err_t Page::writeItems(const Item* entries, size_t count)
+{
+    esp_err_t err;
+
+    if (mState == PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    if (mState == PageState::UNINITIALIZED) {
+        err = initialize();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    if (mState == PageState::FULL) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    NVS_ASSERT_OR_RETURN(count > 0, ESP_ERR_INVALID_ARG);
+
+    if (mNextFreeEntry == INVALID_ENTRY || mNextFreeEntry + count > ENTRY_COUNT) {
+        // page will not fit this amount of data
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    for (size_t i = 0; i < count; i += entries[i].span) {
+        NVS_ASSERT_OR_RETURN(entries[i].span > 0 && i + entries[i].span <= count, ESP_FAIL);
+
+        err = mHashList.insert(entries[i], mNextFreeEntry + i);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        if (mKeyIndex) {
+            err = mKeyIndex->insert(entries[i], this, mNextFreeEntry + i);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+
+    uint32_t phyAddr;
+    err = getEntryAddress(mNextFreeEntry, &phyAddr);
+    if (err == ESP_OK) {
+        err = mPartition->write(phyAddr, entries, count * ENTRY_SIZE);
+    }
+    if (err != ESP_OK) {
+        mState = PageState::INVALID;
+        return err;
+    }
+
+    // the state word holding the first entry is written last, it commits all items at once
+    err = alterEntryRangeState(mNextFreeEntry, mNextFreeEntry + count, EntryState::WRITTEN);
+    if (err != ESP_OK) {
+        mState = PageState::INVALID;
+        return err;
+    }
+
+    if (mFirstUsedEntry == INVALID_ENTRY) {
+        mFirstUsedEntry = mNextFreeEntry;
+    }
+
+    mUsedEntryCount += count;
+    mNextFreeEntry += count;
+    return ESP_OK;
+}
+
 // Reads the data entries of the variable length item.
 // The metadata entry is already read in the item object.
 // index is the index of the metadata entry on the page.
@@ -276,6 +351,38 @@ esp_err_t Page::readVariableLengthItemData(const Item& item, const size_t index,
         dst += willCopy;
     }
     if (Item::calculateCrc32(reinterpret_cast<uint8_t * >(data), item.varLength.dataSize) != item.varLength.dataCrc32) {
+        if (isSharedRead()) {
+            return ESP_ERR_NVS_RETRY_LOCKED;
+        }
+        rc = eraseEntryAndSpan(index, DEFAULT_PURGE_AFTER_ERASE);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t Page::mapVariableLengthItemData(const Item& item, const size_t index, const void** outData, uint32_t* outHandle)
+{
+    if (mState == PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    uint32_t phyAddr;
+    esp_err_t rc = getEntryAddress(index + 1, &phyAddr);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    rc = mPartition->mmap(phyAddr, item.varLength.dataSize, outData, outHandle);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (Item::calculateCrc32(reinterpret_cast<const uint8_t*>(*outData), item.varLength.dataSize) != item.varLength.dataCrc32) {
+        mPartition->munmap(*outHandle);
+        if (isSharedRead()) {
+            return ESP_ERR_NVS_RETRY_LOCKED;
+        }
         rc = eraseEntryAndSpan(index, DEFAULT_PURGE_AFTER_ERASE);
         if (rc != ESP_OK) {
             return rc;
@@ -479,6 +586,9 @@ esp_err_t Page::eraseEntryAndSpan(size_t index, const bool purgeAfterErase)
         }
         if (!item.checkHeaderConsistency(index)) {
             mHashList.erase(index);
+            if (mKeyIndex) {
+                mKeyIndex->erase(this, index);
+            }
             rc = alterEntryState(index, EntryState::ERASED);
             --mUsedEntryCount;
             ++mErasedEntryCount;
@@ -493,6 +603,9 @@ esp_err_t Page::eraseEntryAndSpan(size_t index, const bool purgeAfterErase)
             }
         } else {
             mHashList.erase(index);
+            if (mKeyIndex) {
+                mKeyIndex->erase(item, this, index);
+            }
             span = item.span;
             for (ptrdiff_t i = index + span - 1; i >= static_cast<ptrdiff_t>(index); --i) {
                 rc = mEntryTable.get(i, &state);
@@ -611,6 +724,13 @@ esp_err_t Page::copyItems(Page &other)
             return err;
         }
 
+        if (other.mKeyIndex) {
+            err = other.mKeyIndex->insert(entry, &other, other.mNextFreeEntry);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+
         err = other.writeEntry(entry);
         if (err != ESP_OK) {
             return err;
@@ -636,6 +756,67 @@ esp_err_t Page::copyItems(Page &other)
     return ESP_OK;
 }
 
+esp_err_t Page::moveFirstItem(Page& other, size_t& span)
+{
+    if (mFirstUsedEntry == INVALID_ENTRY) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    if (other.mState == PageState::UNINITIALIZED) {
+        auto err = other.initialize();
+        if (err != ESP_OK) {
+            return err;
+        }
+    } else if (other.mState == PageState::FULL) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    } else if (other.mState != PageState::ACTIVE) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    const size_t index = mFirstUsedEntry;
+    Item entry;
+    esp_err_t err = readEntry(index, entry);
+    if (err != ESP_OK) {
+        return err;
+    }
+    span = entry.span;
+    NVS_ASSERT_OR_RETURN(span > 0 && index + span <= ENTRY_COUNT, ESP_FAIL);
+
+    if (other.mNextFreeEntry + span > ENTRY_COUNT) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    err = other.mHashList.insert(entry, other.mNextFreeEntry);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (other.mKeyIndex) {
+        err = other.mKeyIndex->insert(entry, &other, other.mNextFreeEntry);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    err = other.writeEntry(entry);
+    if (err != ESP_OK) {
+        return err;
+    }
+    for (size_t i = index + 1; i < index + span; ++i) {
+        err = readEntry(i, entry);
+        if (err != ESP_OK) {
+            return err;
+        }
+        err = other.writeEntry(entry);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    // the data is erased together with the page, no need to purge it
+    return eraseEntryAndSpan(index, false);
+}
+
 esp_err_t Page::mLoadEntryTable()
 {
     // for states where we actually care about data in the page, read entry state table
@@ -700,28 +881,44 @@ esp_err_t Page::mLoadEntryTable()
                 return rc;
             }
             if (header != 0xffffffff) {
-                auto oldState = state;
-                rc = mEntryTable.get(mNextFreeEntry, &oldState);
+                // items written by writeItems() are complete before their states are altered,
+                // skip the data entries of such an item at once as they may start with 0xffffffff
+                size_t span = 1;
+                Item item;
+                rc = readEntry(mNextFreeEntry, item);
                 if (rc != ESP_OK) {
+                    mState = PageState::INVALID;
                     return rc;
                 }
-                err = alterEntryState(mNextFreeEntry, EntryState::ERASED);
+                if (item.checkHeaderConsistency(mNextFreeEntry) && mNextFreeEntry + item.span <= ENTRY_COUNT) {
+                    span = item.span;
+                }
+                for (size_t j = mNextFreeEntry; j < mNextFreeEntry + span; ++j) {
+                    auto oldState = state;
+                    rc = mEntryTable.get(j, &oldState);
+                    if (rc != ESP_OK) {
+                        return rc;
+                    }
+                    if (oldState == EntryState::WRITTEN) {
+                        --mUsedEntryCount;
+                    }
+                    if (oldState != EntryState::ERASED) {
+                        ++mErasedEntryCount;
+                    }
+                }
+                err = alterEntryRangeState(mNextFreeEntry, mNextFreeEntry + span, EntryState::ERASED);
                 if (err != ESP_OK) {
                     mState = PageState::INVALID;
                     return err;
                 }
                 if(DEFAULT_PURGE_AFTER_ERASE) {
-                    err = purgeEntry(mNextFreeEntry);
+                    err = purgeEntryRange(mNextFreeEntry, mNextFreeEntry + span);
                     if (err != ESP_OK) {
                         mState = PageState::INVALID;
                         return err;
                     }
                 }
-                ++mNextFreeEntry;
-                if (oldState == EntryState::WRITTEN) {
-                    --mUsedEntryCount;
-                }
-                ++mErasedEntryCount;
+                mNextFreeEntry += span;
             } else {
                 break;
             }
@@ -779,6 +976,14 @@ esp_err_t Page::mLoadEntryTable()
                 return err;
             }
 
+            if (mKeyIndex) {
+                err = mKeyIndex->insert(item, this, i);
+                if (err != ESP_OK) {
+                    mState = PageState::INVALID;
+                    return err;
+                }
+            }
+
             // search for potential duplicate item
             size_t duplicateIndex = mHashList.find(0, item);
 
@@ -861,6 +1066,14 @@ esp_err_t Page::mLoadEntryTable()
                 return err;
             }
 
+            if (mKeyIndex) {
+                err = mKeyIndex->insert(item, this, i);
+                if (err != ESP_OK) {
+                    mState = PageState::INVALID;
+                    return err;
+                }
+            }
+
             size_t span = item.span;
 
             if (isVariableLengthType(item.datatype)) {
@@ -1057,11 +1270,18 @@ esp_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, si
 
         rc = readEntry(i, item);
         if (rc != ESP_OK) {
+            if (isSharedRead()) {
+                return ESP_ERR_NVS_RETRY_LOCKED;
+            }
             mState = PageState::INVALID;
             return rc;
         }
 
         if (!item.checkHeaderConsistency(i)) {
+            // concurrent readers must not modify the page, the cleanup is left to the exclusive retry
+            if (isSharedRead()) {
+                return ESP_ERR_NVS_RETRY_LOCKED;
+            }
             rc = eraseEntryAndSpan(i, DEFAULT_PURGE_AFTER_ERASE);
             if (rc != ESP_OK) {
                 mState = PageState::INVALID;
@@ -1181,6 +1401,9 @@ esp_err_t Page::erase()
     mNextFreeEntry = INVALID_ENTRY;
     mState = PageState::UNINITIALIZED;
     mHashList.clear();
+    if (mKeyIndex) {
+        mKeyIndex->erasePage(this);
+    }
     return ESP_OK;
 }
 
@@ -9,7 +9,9 @@
 #include "nvs_types.hpp"
 #include "intrusive_list.h"
 #include "nvs_item_hash_list.hpp"
+#include "nvs_key_index.hpp"
 #include "partition.hpp"
+#include "nvs_platform.hpp"
 
 namespace nvs
 {
@@ -74,6 +76,15 @@ public:
 
     esp_err_t load(Partition *partition, uint32_t sectorNumber);
 
+    /**
+     * Attaches the partition-wide key index which is kept in sync with mHashList.
+     * Has to be called before load(), nullptr detaches the index.
+     */
+    void setKeyIndex(KeyIndex* keyIndex)
+    {
+        mKeyIndex = keyIndex;
+    }
+
     esp_err_t getSeqNumber(uint32_t& seqNumber) const;
 
     esp_err_t setSeqNumber(uint32_t seqNumber);
@@ -82,8 +93,22 @@ public:
 
     esp_err_t writeItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY);
 
+    /**
+     * Writes the prepared entries of one or more complete items with a single flash write.
+     * The entry states are altered from the last entry to the first one, so the state word holding
+     * the first entry is written last. Until then, mLoadEntryTable() erases the whole range after power loss.
+     */
+    esp_err_t writeItems(const Item* entries, size_t count);
+
     esp_err_t readVariableLengthItemData(const Item& item, const size_t index, void* data);
 
+    /**
+     * Maps the data of a variable length item read-only instead of copying it, the data entries of an item are
+     * contiguous. The CRC is checked the same way as by readVariableLengthItemData. Returns ESP_ERR_NOT_SUPPORTED
+     * if the partition can't be memory mapped. The mapping has to be released with Partition::munmap.
+     */
+    esp_err_t mapVariableLengthItemData(const Item& item, const size_t index, const void** outData, uint32_t* outHandle);
+
     esp_err_t readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
     esp_err_t cmpItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
@@ -139,6 +164,13 @@ public:
 
     esp_err_t copyItems(Page& other);
 
+    /**
+     * Copies the first item of this page to the end of the other page and erases it here afterwards, used by the
+     * incremental compaction. If power is lost in between, PageManager::load() erases the older duplicate.
+     * Returns ESP_ERR_NVS_PAGE_FULL if the item doesn't fit into the other page.
+     */
+    esp_err_t moveFirstItem(Page& other, size_t& span);
+
     esp_err_t erase();
 
     void debugDump() const;
@@ -226,6 +258,11 @@ protected:
      */
     HashList mHashList;
 
+    /**
+     * Optional index shared by all pages of the partition, see KeyIndex.
+     */
+    KeyIndex* mKeyIndex = nullptr;
+
     Partition *mPartition;
 
     static const uint32_t HEADER_OFFSET = NVS_CONST_PAGE_HEADER_OFFSET;
@@ -23,7 +23,15 @@ esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
 
     if (!mPages) return ESP_ERR_NO_MEM;
 
+#ifdef CONFIG_NVS_GLOBAL_KEY_INDEX
+    mKeyIndex.clear();
+#endif
+
     for (uint32_t i = 0; i < sectorCount; ++i) {
+#ifdef CONFIG_NVS_GLOBAL_KEY_INDEX
+        // the index is populated while the pages load their entry tables
+        mPages[i].setKeyIndex(&mKeyIndex);
+#endif
         auto err = mPages[i].load(partition, baseSector + i);
         if (err != ESP_OK) {
             return err;
@@ -57,21 +65,18 @@ esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
     }
 
     // if power went out after a new item for the given key was written,
-    // but before the old one was erased, we end up with a duplicate item
+    // but before the old one was erased, we end up with a duplicate item.
+    // Storage::writeBatch() writes several items before erasing their old values,
+    // so every item of the last page is checked, not only the last one.
     if (!partition->get_readonly()) {
         Page& lastPage = back();
-        size_t lastItemIndex = SIZE_MAX;
+        auto last = PageManager::TPageListIterator(&lastPage);
         Item item;
         size_t itemIndex = 0;
         while (lastPage.findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK) {
             itemIndex += item.span;
-            lastItemIndex = itemIndex;
-        }
 
-        if (lastItemIndex != SIZE_MAX) {
-            auto last = PageManager::TPageListIterator(&lastPage);
             TPageListIterator it;
-
             for (it = begin(); it != last; ++it) {
 
                 if ((it->state() != Page::PageState::FREEING) &&
@@ -202,6 +207,74 @@ esp_err_t PageManager::requestNewPage()
     return ESP_OK;
 }
 
+esp_err_t PageManager::compactStep(size_t maxEntries)
+{
+    if (mFreePageList.size() >= COMPACT_FREE_PAGES) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    // find the full page with the highest number of unused entries, the same as requestNewPage() does
+    TPageListIterator compactedPageIt;
+    size_t maxUnusedItems = 0;
+    for (auto it = begin(); it != end(); ++it) {
+        if (it->state() != Page::PageState::FULL || &*it == &back()) {
+            continue;
+        }
+        auto unused = Page::ENTRY_COUNT - it->getUsedEntryCount();
+        if (unused > maxUnusedItems) {
+            compactedPageIt = it;
+            maxUnusedItems = unused;
+        }
+    }
+
+    if (maxUnusedItems == 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    Page* compactedPage = compactedPageIt;
+
+    // the erase of an emptied page is a step of its own, so that a step is either one erase or a few writes
+    if (compactedPage->getUsedEntryCount() == 0) {
+        auto err = compactedPage->erase();
+        if (err != ESP_OK) {
+            return err;
+        }
+        mPageList.erase(compactedPageIt);
+        mFreePageList.push_back(compactedPage);
+        return ESP_OK;
+    }
+
+    size_t movedEntries = 0;
+    while (compactedPage->getUsedEntryCount() > 0 && movedEntries < maxEntries) {
+        size_t span = 0;
+        esp_err_t err = compactedPage->moveFirstItem(back(), span);
+        if (err == ESP_ERR_NVS_PAGE_FULL) {
+            if (back().state() != Page::PageState::FULL) {
+                err = back().markFull();
+                if (err != ESP_OK) {
+                    return err;
+                }
+            }
+            // reclaims a page the regular way if only the reserved free page is left
+            err = requestNewPage();
+            if (err != ESP_OK) {
+                return err;
+            }
+            if (compactedPage->state() != Page::PageState::FULL) {
+                // the compacted page was reclaimed by requestNewPage()
+                return ESP_OK;
+            }
+            continue;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        movedEntries += span;
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t PageManager::activatePage()
 {
     if (mFreePageList.empty()) {
@@ -7,8 +7,10 @@
 
 #include <memory>
 #include <list>
+#include "sdkconfig.h"          // For CONFIG_NVS_GLOBAL_KEY_INDEX
 #include "nvs_types.hpp"
 #include "nvs_page.hpp"
+#include "nvs_key_index.hpp"
 #include "partition.hpp"
 #include "intrusive_list.h"
 
@@ -45,6 +47,20 @@ public:
 
     esp_err_t requestNewPage();
 
+    /**
+     * Performs one step of the incremental compaction. While fewer than COMPACT_FREE_PAGES pages are free,
+     * whole items of the full page with the most unused entries are moved to the active page until at least
+     * maxEntries entries were moved. Once the page holds no items any more, the next step erases it.
+     * Returns ESP_ERR_NVS_NOT_FOUND if there is nothing to compact.
+     */
+    esp_err_t compactStep(size_t maxEntries);
+
+    /**
+     * The compaction keeps one free page more than requestNewPage() needs to activate a page
+     * without reclaiming one, so foreground writes don't have to move items.
+     */
+    static const size_t COMPACT_FREE_PAGES = 3;
+
     esp_err_t fillStats(nvs_stats_t& nvsStats);
 
     uint32_t getBaseSector()
@@ -52,6 +68,13 @@ public:
         return mBaseSector;
     }
 
+#ifdef CONFIG_NVS_GLOBAL_KEY_INDEX
+    KeyIndex& getKeyIndex()
+    {
+        return mKeyIndex;
+    }
+#endif
+
 protected:
     friend class Iterator;
 
@@ -63,6 +86,9 @@ protected:
     uint32_t mBaseSector;
     uint32_t mPageCount;
     uint32_t mSeqNumber;
+#ifdef CONFIG_NVS_GLOBAL_KEY_INDEX
+    KeyIndex mKeyIndex;
+#endif
 }; // class PageManager
 
 } // namespace nvs
@@ -106,6 +106,25 @@ esp_err_t NVSPartition::erase_range(size_t dst_offset, size_t size)
 #endif // CONFIG_NVS_FLASH_VERIFY_ERASE
 }
 
+esp_err_t NVSPartition::mmap(size_t src_offset, size_t size, const void** out_ptr, uint32_t* out_handle)
+{
+    // the mapping bypasses flash encryption, so the data would not be readable
+    if (mESPPartition->encrypted) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(mESPPartition, src_offset, size, ESP_PARTITION_MMAP_DATA, out_ptr, &handle);
+    if (err == ESP_OK) {
+        *out_handle = handle;
+    }
+    return err;
+}
+
+void NVSPartition::munmap(uint32_t handle)
+{
+    esp_partition_munmap(handle);
+}
+
 uint32_t NVSPartition::get_address()
 {
     return mESPPartition->address;
@@ -173,6 +192,16 @@ esp_err_t NVSPartition::erase_range(size_t dst_offset, size_t size)
     return mBDL->ops->erase(mBDL, dst_offset, size);
 }
 
+esp_err_t NVSPartition::mmap(size_t src_offset, size_t size, const void** out_ptr, uint32_t* out_handle)
+{
+    // BDL doesn't provide memory mapped access to the storage
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void NVSPartition::munmap(uint32_t handle)
+{
+}
+
 uint32_t NVSPartition::get_address()
 {
     // BDL cannot be used directly to get the address, as it is not a partition in the traditional sense.
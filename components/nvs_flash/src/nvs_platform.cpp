@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2024-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -7,11 +7,54 @@
 
 using namespace nvs;
 
-#if LINUX_TARGET || ESP_TEE_BUILD
+#if CONFIG_NVS_CONCURRENT_READS && !ESP_TEE_BUILD
+
+#include <shared_mutex>
+
+// Readers-writer lock, lock holders are writers, SharedLock holders are readers
+static std::shared_mutex s_lock;
+
+thread_local bool SharedLock::sHeld = false;
+
+Lock::Lock()
+{
+    s_lock.lock();
+}
+
+Lock::~Lock()
+{
+    s_lock.unlock();
+}
+
+esp_err_t Lock::init()
+{
+    return ESP_OK;
+}
+
+void Lock::uninit() {}
+
+SharedLock::SharedLock()
+{
+    s_lock.lock_shared();
+    sHeld = true;
+}
+
+SharedLock::~SharedLock()
+{
+    sHeld = false;
+    s_lock.unlock_shared();
+}
+
+#elif LINUX_TARGET || ESP_TEE_BUILD
 Lock::Lock() {}
 Lock::~Lock() {}
 esp_err_t nvs::Lock::init() {return ESP_OK;}
 void Lock::uninit() {}
+#if CONFIG_NVS_CONCURRENT_READS
+thread_local bool SharedLock::sHeld = false;
+SharedLock::SharedLock() {}
+SharedLock::~SharedLock() {}
+#endif
 #else
 
 #include "sys/lock.h"
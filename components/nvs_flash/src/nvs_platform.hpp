@@ -1,15 +1,23 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 #pragma once
 
 #include "esp_err.h"
-#ifndef LINUX_TARGET
+#include "nvs.h"
+#include "sdkconfig.h"          // For CONFIG_NVS_CONCURRENT_READS
+#if !defined(LINUX_TARGET) && !defined(CONFIG_NVS_CONCURRENT_READS)
 #include <sys/lock.h>
 #endif
 
+/**
+ * Internal error; never returned by nvs API functions.
+ * A read holding the SharedLock would have to modify the storage, it has to be repeated holding the Lock.
+ */
+#define ESP_ERR_NVS_RETRY_LOCKED            (ESP_ERR_NVS_BASE + 0xff)
+
 namespace nvs
 {
     class Lock
@@ -19,9 +27,41 @@ namespace nvs
         ~Lock();
         static esp_err_t init();
         static void uninit();
-#ifndef LINUX_TARGET
+#if !defined(LINUX_TARGET) && !defined(CONFIG_NVS_CONCURRENT_READS)
     private:
         static _lock_t mSemaphore;
 #endif
     };
+
+#ifdef CONFIG_NVS_CONCURRENT_READS
+    /**
+     * Takes the lock shared with other readers. Lock holders are excluded while it is held.
+     */
+    class SharedLock
+    {
+    public:
+        SharedLock();
+        ~SharedLock();
+
+        static bool isHeld()
+        {
+            return sHeld;
+        }
+
+    private:
+        static thread_local bool sHeld;
+    };
+#endif
+
+    /**
+     * Returns true if the calling task reads holding the SharedLock, i.e. it must not modify the storage.
+     */
+    inline bool isSharedRead()
+    {
+#ifdef CONFIG_NVS_CONCURRENT_READS
+        return SharedLock::isHeld();
+#else
+        return false;
+#endif
+    }
 } // namespace nvs
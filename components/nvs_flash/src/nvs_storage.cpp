@@ -256,6 +256,18 @@ bool Storage::isValid() const
 
 esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx, VerOffset chunkStart, size_t* itemIndex)
 {
+#ifdef CONFIG_NVS_GLOBAL_KEY_INDEX
+    // The key index can only be used if the hash of the searched item is fully specified, the same as for the HashList of the page
+    if(mPageManager.getKeyIndex().isValid()
+            && nsIndex != Page::NS_ANY && key != nullptr
+            && (datatype != ItemType::BLOB_DATA || chunkIdx != Page::CHUNK_ANY)) {
+        esp_err_t err = findItemIndexed(nsIndex, datatype, key, page, item, chunkIdx, chunkStart, itemIndex);
+        if(err != ESP_ERR_NOT_SUPPORTED) {
+            return err;
+        }
+    }
+#endif
+
     for(auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         size_t tmpItemIndex = 0;
         auto err = it->findItem(nsIndex, datatype, key, tmpItemIndex, item, chunkIdx, chunkStart);
@@ -270,6 +282,77 @@ esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key,
     return ESP_ERR_NVS_NOT_FOUND;
 }
 
+#ifdef CONFIG_NVS_GLOBAL_KEY_INDEX
+// Looks up the item using the partition-wide key index. The index only delivers candidate entries with matching hash,
+// each candidate is verified by the page itself. To keep the semantics of the linear search, the match located on the page
+// with the lowest sequence number (i.e. the first page in the page list) wins.
+// Returns ESP_ERR_NOT_SUPPORTED if the candidates don't fit into the local buffer, the caller has to use the linear search then.
+esp_err_t Storage::findItemIndexed(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx, VerOffset chunkStart, size_t* itemIndex)
+{
+    const size_t MAX_CANDIDATES = 8;
+    Page* candidatePages[MAX_CANDIDATES];
+    size_t candidateIndexes[MAX_CANDIDATES];
+    size_t candidateCount = 0;
+
+    // Collect the candidates first, the verification below may erase inconsistent entries and alter the index
+    KeyIndex& keyIndex = mPageManager.getKeyIndex();
+    const uint32_t hash = KeyIndex::hashOf(Item(nsIndex, datatype, 0, key, chunkIdx));
+    size_t pos = KeyIndex::PROBE_START;
+    Page* candidatePage;
+    size_t candidateIndex;
+    while(keyIndex.findNext(hash, pos, candidatePage, candidateIndex)) {
+        // several items of the same page may share the hash, the page search starts from the lowest one
+        size_t i;
+        for(i = 0; i < candidateCount; ++i) {
+            if(candidatePages[i] == candidatePage) {
+                candidateIndexes[i] = std::min(candidateIndexes[i], candidateIndex);
+                break;
+            }
+        }
+        if(i == candidateCount) {
+            if(candidateCount == MAX_CANDIDATES) {
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            candidatePages[candidateCount] = candidatePage;
+            candidateIndexes[candidateCount] = candidateIndex;
+            ++candidateCount;
+        }
+    }
+
+    Page* foundPage = nullptr;
+    uint32_t foundSeqNumber = 0;
+    size_t foundIndex = 0;
+    for(size_t i = 0; i < candidateCount; ++i) {
+        uint32_t seqNumber;
+        if(candidatePages[i]->getSeqNumber(seqNumber) != ESP_OK) {
+            continue;
+        }
+        if(foundPage != nullptr && seqNumber >= foundSeqNumber) {
+            continue;
+        }
+        size_t tmpItemIndex = candidateIndexes[i];
+        Item tmpItem;
+        auto err = candidatePages[i]->findItem(nsIndex, datatype, key, tmpItemIndex, tmpItem, chunkIdx, chunkStart);
+        if(err == ESP_OK) {
+            foundPage = candidatePages[i];
+            foundSeqNumber = seqNumber;
+            foundIndex = tmpItemIndex;
+            item = tmpItem;
+        }
+    }
+
+    if(foundPage == nullptr) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    page = foundPage;
+    if(itemIndex) {
+        *itemIndex = foundIndex;
+    }
+    return ESP_OK;
+}
+#endif // CONFIG_NVS_GLOBAL_KEY_INDEX
+
 esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart, const bool purgeAfterErase)
 {
     uint8_t chunkCount = 0;
@@ -595,6 +678,223 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
     return err;
 }
 
+size_t Storage::BatchItem::entryCount() const
+{
+    if(!isVariableLengthType(mDatatype)) {
+        return 1;
+    }
+    // header entry followed by the data entries, a blob is written as a single chunk followed by its index
+    size_t count = 1 + (mDataSize + Page::ENTRY_SIZE - 1) / Page::ENTRY_SIZE;
+    if(mDatatype == ItemType::BLOB) {
+        ++count;
+    }
+    return count;
+}
+
+// Encodes the item the same way as Page::writeItem() does and returns the number of entries used
+static size_t encodeBatchEntries(Item* entries, uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx = Page::CHUNK_ANY)
+{
+    if(!isVariableLengthType(datatype)) {
+        entries[0] = Item(nsIndex, datatype, 1, key, chunkIdx);
+        memcpy(entries[0].data, data, dataSize);
+        entries[0].crc32 = entries[0].calculateCrc32();
+        return 1;
+    }
+
+    const size_t span = 1 + (dataSize + Page::ENTRY_SIZE - 1) / Page::ENTRY_SIZE;
+    entries[0] = Item(nsIndex, datatype, span, key, chunkIdx);
+    entries[0].varLength.dataCrc32 = Item::calculateCrc32(static_cast<const uint8_t*>(data), dataSize);
+    entries[0].varLength.dataSize = dataSize;
+    entries[0].varLength.reserved = 0xffff;
+    entries[0].crc32 = entries[0].calculateCrc32();
+
+    if(span > 1) {
+        uint8_t* dst = entries[1].rawData;
+        std::fill_n(dst, (span - 1) * Page::ENTRY_SIZE, 0xff);
+        memcpy(dst, data, dataSize);
+    }
+    return span;
+}
+
+// All items are written into contiguous entries of the current page by a single Page::writeItems() call.
+// If power goes out before the commit, none of the new values is present after re-initialization.
+// If it goes out while the old values are erased, PageManager::load() erases the remaining ones.
+// Only BLOBs fitting into a single chunk are supported, the caller ensures that all items fit into one page.
+esp_err_t Storage::writeBatch(uint8_t nsIndex, TBatchList& items, const bool purgeAfterErase)
+{
+    if(mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    struct OldValue {
+        // page and index of the old value, page is nullptr if there is none
+        Page* page;
+        size_t index;
+        uint32_t seqNumber;
+        Item item;
+        // the new value equals the old one and is not written
+        bool unchanged;
+    };
+
+    const size_t itemCount = items.size();
+    if(itemCount == 0) {
+        return ESP_OK;
+    }
+
+    OldValue* oldValues = new (std::nothrow) OldValue[itemCount];
+    if(!oldValues) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = ESP_OK;
+    size_t entryCount = 0;
+    size_t i = 0;
+    for(auto it = items.begin(); it != items.end(); ++it, ++i) {
+        OldValue& old = oldValues[i];
+        old.page = nullptr;
+        old.unchanged = false;
+
+        // BLOB is searched as BLOB_INDEX, see writeItem()
+        const ItemType findType = (it->mDatatype == ItemType::BLOB) ? ItemType::BLOB_IDX : it->mDatatype;
+        err = findItem(nsIndex, findType, it->mKey, old.page, old.item, Page::CHUNK_ANY, VerOffset::VER_ANY, &old.index);
+        bool matchedType = (err == ESP_OK);
+#ifndef CONFIG_NVS_LEGACY_DUP_KEYS_COMPATIBILITY
+        if(err == ESP_ERR_NVS_NOT_FOUND) {
+            err = findItem(nsIndex, ItemType::ANY, it->mKey, old.page, old.item, Page::CHUNK_ANY, VerOffset::VER_ANY, &old.index);
+        }
+#endif
+        if(err == ESP_ERR_NVS_NOT_FOUND) {
+            old.page = nullptr;
+            err = ESP_OK;
+        }
+        if(err != ESP_OK) {
+            break;
+        }
+
+        if(old.page != nullptr) {
+            err = old.page->getSeqNumber(old.seqNumber);
+            if(err != ESP_OK) {
+                break;
+            }
+        }
+
+        if(matchedType) {
+            if(it->mDatatype == ItemType::BLOB) {
+                old.unchanged = (cmpMultiPageBlob(nsIndex, it->mKey, it->data(), it->mDataSize) == ESP_OK);
+            } else {
+                old.unchanged = (old.page->cmpItem(nsIndex, it->mDatatype, it->mKey, it->data(), it->mDataSize) == ESP_OK);
+            }
+        }
+
+        if(!old.unchanged) {
+            entryCount += it->entryCount();
+        }
+    }
+
+    if(err != ESP_OK || entryCount == 0) {
+        delete[] oldValues;
+        return err;
+    }
+
+    Item* entries = new (std::nothrow) Item[entryCount];
+    if(!entries) {
+        delete[] oldValues;
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t pos = 0;
+    i = 0;
+    for(auto it = items.begin(); it != items.end(); ++it, ++i) {
+        const OldValue& old = oldValues[i];
+        if(old.unchanged) {
+            continue;
+        }
+        if(it->mDatatype == ItemType::BLOB) {
+            // toggle the version of the blob, the same as writeItem() does
+            VerOffset chunkStart = VerOffset::VER_0_OFFSET;
+            if(old.page != nullptr && old.item.datatype == ItemType::BLOB_IDX
+                    && old.item.blobIndex.chunkStart == VerOffset::VER_0_OFFSET) {
+                chunkStart = VerOffset::VER_1_OFFSET;
+            }
+            pos += encodeBatchEntries(&entries[pos], nsIndex, ItemType::BLOB_DATA, it->mKey, it->data(), it->mDataSize,
+                    static_cast<uint8_t>(chunkStart));
+
+            Item blobIndex;
+            std::fill_n(blobIndex.data, sizeof(blobIndex.data), 0xff);
+            blobIndex.blobIndex.dataSize = it->mDataSize;
+            blobIndex.blobIndex.chunkCount = 1;
+            blobIndex.blobIndex.chunkStart = chunkStart;
+            pos += encodeBatchEntries(&entries[pos], nsIndex, ItemType::BLOB_IDX, it->mKey, blobIndex.data, sizeof(blobIndex.data));
+        } else {
+            pos += encodeBatchEntries(&entries[pos], nsIndex, it->mDatatype, it->mKey, it->data(), it->mDataSize);
+        }
+    }
+
+    Page& page = getCurrentPage();
+    err = page.writeItems(entries, entryCount);
+    if(err == ESP_ERR_NVS_PAGE_FULL) {
+        err = ESP_OK;
+        if(page.state() != Page::PageState::FULL) {
+            err = page.markFull();
+        }
+        if(err == ESP_OK) {
+            err = mPageManager.requestNewPage();
+        }
+        if(err == ESP_OK) {
+            err = getCurrentPage().writeItems(entries, entryCount);
+            if(err == ESP_ERR_NVS_PAGE_FULL) {
+                err = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+            }
+        }
+    }
+    delete[] entries;
+
+    if(err != ESP_OK) {
+        delete[] oldValues;
+        return err;
+    }
+
+    // The new values are committed, erase the old ones
+    i = 0;
+    for(auto it = items.begin(); it != items.end(); ++it, ++i) {
+        OldValue& old = oldValues[i];
+        if(old.unchanged || old.page == nullptr) {
+            continue;
+        }
+
+        if(old.item.datatype == ItemType::BLOB_IDX) {
+            err = eraseMultiPageBlob(nsIndex, it->mKey, purgeAfterErase, old.item.blobIndex.chunkStart);
+        } else {
+            // the page of the old value might have been relocated by requestNewPage(), see writeItem()
+            uint32_t seqNumber;
+            if((old.page->state() != Page::PageState::ACTIVE && old.page->state() != Page::PageState::FULL)
+                    || old.page->getSeqNumber(seqNumber) != ESP_OK || seqNumber != old.seqNumber) {
+                err = findItem(nsIndex, old.item.datatype, it->mKey, old.page, old.item, Page::CHUNK_ANY, VerOffset::VER_ANY, &old.index);
+            } else {
+                err = ESP_OK;
+            }
+            if(err == ESP_OK) {
+                err = old.page->eraseEntryAndSpan(old.index, purgeAfterErase);
+            }
+        }
+
+        // the remaining old values are erased during the next initialization, see PageManager::load()
+        if(err != ESP_OK) {
+            break;
+        }
+    }
+    delete[] oldValues;
+
+    if(err == ESP_ERR_FLASH_OP_FAIL) {
+        return ESP_ERR_NVS_REMOVE_FAILED;
+    }
+
+#ifdef DEBUG_STORAGE
+    debugCheck();
+#endif
+    return err;
+}
+
 esp_err_t Storage::createOrOpenNamespace(const char* nsName, bool canCreate, uint8_t& nsIndex)
 {
     if(mState != StorageState::ACTIVE) {
@@ -695,6 +995,9 @@ esp_err_t Storage::readMultiPageBlob(uint8_t nsIndex, const char* key, void* dat
     }
 
     if(err == ESP_ERR_NVS_NOT_FOUND || err == ESP_ERR_NVS_INVALID_LENGTH) {
+        if(isSharedRead()) {
+            return ESP_ERR_NVS_RETRY_LOCKED;
+        }
         // cleanup if a chunk is not found or the size is inconsistent
         eraseMultiPageBlob(nsIndex, key, Page::DEFAULT_PURGE_AFTER_ERASE);
     }
@@ -991,6 +1294,105 @@ esp_err_t Storage::getItemDataSize(uint8_t nsIndex, ItemType datatype, const cha
     return ESP_OK;
 }
 
+esp_err_t Storage::getItemView(uint8_t nsIndex, ItemType datatype, const char* key, nvs_opaque_blob_view_t& view)
+{
+    if(mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    auto err = mapItemData(nsIndex, datatype, key, view);
+    if(err == ESP_OK) {
+        return err;
+    }
+
+    // Fall back to a copy. Besides partitions which can't be mapped, this lets readItem report missing keys
+    // and clean up inconsistent blobs the same way as for regular reads.
+    view.clear();
+    size_t dataSize = 0;
+    err = getItemDataSize(nsIndex, datatype, key, dataSize);
+    if(err != ESP_OK) {
+        return err;
+    }
+    err = view.allocSpans(1);
+    if(err != ESP_OK) {
+        return err;
+    }
+    view.copy = new (std::nothrow) uint8_t[dataSize ? dataSize : 1];
+    if(!view.copy) {
+        return ESP_ERR_NO_MEM;
+    }
+    err = readItem(nsIndex, datatype, key, view.copy, dataSize);
+    if(err != ESP_OK) {
+        return err;
+    }
+    view.spans[0].data = view.copy;
+    view.spans[0].size = dataSize;
+    return ESP_OK;
+}
+
+esp_err_t Storage::mapItemData(uint8_t nsIndex, ItemType datatype, const char* key, nvs_opaque_blob_view_t& view)
+{
+    Item item;
+    Page* findPage = nullptr;
+    size_t itemIndex = 0;
+    esp_err_t err;
+    uint8_t chunkCount = 1;
+    VerOffset chunkStart = VerOffset::VER_0_OFFSET;
+    size_t dataSize = 0;
+    bool multiPage = false;
+
+    // If requested datatype is BLOB, first try to find the blob index - new format
+    // If not found, try to find the item with datatype BLOB - old format.
+    if(datatype == ItemType::BLOB) {
+        err = findItem(nsIndex, ItemType::BLOB_IDX, key, findPage, item);
+        if(err == ESP_OK) {
+            chunkCount = item.blobIndex.chunkCount;
+            chunkStart = item.blobIndex.chunkStart;
+            dataSize = item.blobIndex.dataSize;
+            multiPage = true;
+        } else if(err != ESP_ERR_NVS_NOT_FOUND) {
+            return err;
+        }
+    }
+
+    err = view.allocSpans(chunkCount);
+    if(err != ESP_OK) {
+        return err;
+    }
+    view.partition = mPartition;
+
+    size_t offset = 0;
+    for(uint8_t chunkNum = 0; chunkNum < chunkCount; chunkNum++) {
+        if(multiPage) {
+            err = findItem(nsIndex, ItemType::BLOB_DATA, key, findPage, item, static_cast<uint8_t> (chunkStart) + chunkNum, VerOffset::VER_ANY, &itemIndex);
+        } else {
+            err = findItem(nsIndex, datatype, key, findPage, item, Page::CHUNK_ANY, VerOffset::VER_ANY, &itemIndex);
+        }
+        if(err != ESP_OK) {
+            return err;
+        }
+        if(multiPage && item.varLength.dataSize > dataSize - offset) {
+            return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+
+        // an empty span has nothing to map, clear() only unmaps spans with data
+        nvs_blob_span_t& span = view.spans[chunkNum];
+        if(item.varLength.dataSize > 0) {
+            err = findPage->mapVariableLengthItemData(item, itemIndex, &span.data, &view.mmapHandles[chunkNum]);
+            if(err != ESP_OK) {
+                return err;
+            }
+            span.size = item.varLength.dataSize;
+        }
+        offset += item.varLength.dataSize;
+    }
+
+    if(multiPage && offset != dataSize) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    return ESP_OK;
+}
+
 void Storage::debugDump()
 {
     for(auto p = mPageManager.begin(); p != mPageManager.end(); ++p) {
@@ -1031,6 +1433,19 @@ esp_err_t Storage::fillStats(nvs_stats_t& nvsStats)
     return mPageManager.fillStats(nvsStats);
 }
 
+esp_err_t Storage::compactStep(size_t maxEntries)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    if (mPartition->get_readonly()) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+
+    return mPageManager.compactStep(maxEntries);
+}
+
 esp_err_t Storage::calcEntriesInNamespace(uint8_t nsIndex, size_t& usedEntries)
 {
     usedEntries = 0;
@@ -1135,6 +1550,41 @@ bool Storage::nextEntry(nvs_opaque_iterator_t* it)
 
 }
 
+esp_err_t nvs_opaque_blob_view_t::allocSpans(size_t count)
+{
+    spans = new (std::nothrow) nvs_blob_span_t[count];
+    mmapHandles = new (std::nothrow) uint32_t[count];
+    if(!spans || !mmapHandles) {
+        return ESP_ERR_NO_MEM;
+    }
+    spanCount = count;
+    for(size_t i = 0; i < count; i++) {
+        spans[i].data = nullptr;
+        spans[i].size = 0;
+    }
+    return ESP_OK;
+}
+
+void nvs_opaque_blob_view_t::clear()
+{
+    if(partition) {
+        for(size_t i = 0; i < spanCount; i++) {
+            if(spans[i].size > 0) {
+                partition->munmap(mmapHandles[i]);
+            }
+        }
+    }
+    delete [] spans;
+    delete [] mmapHandles;
+    delete [] copy;
+    partition = nullptr;
+    copy = nullptr;
+    spanCount = 0;
+    spans = nullptr;
+    mmapHandles = nullptr;
+}
+
 #if defined(SEGGER_H) && defined(GLOBAL_H)
 NVS_GUARD_SYSVIEW_MACRO_EXPANSION_POP();
 #endif
+
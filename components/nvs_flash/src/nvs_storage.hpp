@@ -55,6 +55,33 @@ class Storage : public intrusive_list_node<Storage>, public ExceptionlessAllocat
     typedef intrusive_list<BlobIndexNode> TBlobIndexList;
 
 public:
+    /**
+     * Value staged in RAM by a batch until it is written by writeBatch()
+     */
+    struct BatchItem: public intrusive_list_node<BatchItem>, public ExceptionlessAllocatable {
+        public:
+            ~BatchItem()
+            {
+                delete[] mVarData;
+            }
+
+            const void* data() const
+            {
+                return mVarData ? static_cast<const void*>(mVarData) : static_cast<const void*>(mValue);
+            }
+
+            // number of entries the item occupies on the page, including the index of a blob
+            size_t entryCount() const;
+
+            char mKey[Item::MAX_KEY_LENGTH + 1];
+            ItemType mDatatype;
+            size_t mDataSize;
+            uint8_t mValue[sizeof(Item::data)];
+            uint8_t* mVarData = nullptr;
+    };
+
+    typedef intrusive_list<BatchItem> TBatchList;
+
     ~Storage();
 
     Storage(Partition *partition) : mPartition(partition) {
@@ -77,8 +104,16 @@ public:
 
     esp_err_t getItemDataSize(uint8_t nsIndex, ItemType datatype, const char* key, size_t& dataSize);
 
+    /**
+     * Fills the view with the data of a SZ or BLOB item. The data is memory mapped if the partition supports it,
+     * otherwise it is copied into a buffer owned by the view.
+     */
+    esp_err_t getItemView(uint8_t nsIndex, ItemType datatype, const char* key, nvs_opaque_blob_view_t& view);
+
     esp_err_t eraseItem(uint8_t nsIndex, ItemType datatype, const char* key, const bool purgeAfterErase);
 
+    esp_err_t writeBatch(uint8_t nsIndex, TBatchList& items, const bool purgeAfterErase);
+
     template<typename T>
     esp_err_t writeItem(uint8_t nsIndex, const char* key, const T& value, const bool purgeAfterErase)
     {
@@ -129,6 +164,8 @@ public:
 
     esp_err_t fillStats(nvs_stats_t& nvsStats);
 
+    esp_err_t compactStep(size_t maxEntries);
+
     esp_err_t calcEntriesInNamespace(uint8_t nsIndex, size_t& usedEntries);
 
     bool findEntry(nvs_opaque_iterator_t* it, const char* name);
@@ -156,6 +193,12 @@ protected:
 
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx = Page::CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY, size_t* itemIndex = NULL);
 
+    esp_err_t mapItemData(uint8_t nsIndex, ItemType datatype, const char* key, nvs_opaque_blob_view_t& view);
+
+#ifdef CONFIG_NVS_GLOBAL_KEY_INDEX
+    esp_err_t findItemIndexed(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx, VerOffset chunkStart, size_t* itemIndex);
+#endif
+
 protected:
     Partition *mPartition;
     size_t mPageCount;
@@ -176,3 +219,21 @@ struct nvs_opaque_iterator_t
     intrusive_list<nvs::Page>::iterator page;
     nvs_entry_info_t entry_info;
 };
+
+struct nvs_opaque_blob_view_t : public ExceptionlessAllocatable
+{
+    ~nvs_opaque_blob_view_t()
+    {
+        clear();
+    }
+
+    esp_err_t allocSpans(size_t count);
+
+    void clear();
+
+    nvs::Partition *partition = nullptr;    // partition the spans are mapped from, nullptr if they point to copy
+    uint8_t *copy = nullptr;                // heap copy of the value if it couldn't be mapped
+    size_t spanCount = 0;
+    nvs_blob_span_t *spans = nullptr;
+    uint32_t *mmapHandles = nullptr;
+};
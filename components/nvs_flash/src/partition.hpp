@@ -106,6 +106,29 @@ public:
      */
     virtual esp_err_t erase_range(size_t dst_offset, size_t size) = 0;
 
+    /**
+     * Maps a range of the storage read-only into the address space of the CPU.
+     * No decryption is applied, implementations with encryption have to refuse the mapping.
+     *
+     * @param src_offset the offset in the storage to map
+     * @param size the size of the range in bytes
+     * @param out_ptr set to the address the range is mapped to
+     * @param out_handle set to the handle which has to be passed to munmap once the data isn't used any more
+     *
+     * @return
+     *      - ESP_OK on success
+     *      - ESP_ERR_NOT_SUPPORTED if the storage can't be memory mapped
+     *      - other error codes from the implementation of the storage
+     */
+    virtual esp_err_t mmap(size_t src_offset, size_t size, const void** out_ptr, uint32_t* out_handle) = 0;
+
+    /**
+     * Releases a mapping created by mmap.
+     *
+     * @param handle the handle returned by mmap
+     */
+    virtual void munmap(uint32_t handle) = 0;
+
     /**
      * Returns the RAM address of the beginning of the memory mapped storage.
      * Not available if the block device layer is enabled.